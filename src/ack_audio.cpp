@@ -0,0 +1,356 @@
+// ack_audio.cpp - Accuses de reception audio pendant STT/LLM
+#include "ack_audio.h"
+#include "audio.h"     // i2s_audio + volume
+#include "audio_stats.h"  // Underruns pendant la lecture
+#include "tts_groq.h"  // Pre-rendu des phrases
+#include <LittleFS.h>
+
+AckAudio ackAudio;
+
+// Phrases par intention (nullptr = pas de variante)
+static const char* const ACK_PHRASES[ACK_INTENT_COUNT][ACK_MAX_VARIANTS] = {
+    { "Une seconde.", "Je regarde ça.", "Hmm, voyons." },            // ACK_GENERIC
+    { "Je vérifie le cours.", "Je regarde le réseau.", nullptr },    // ACK_PRICE
+    { "D'accord, je prépare ça.", "Je m'occupe du paiement.", nullptr },  // ACK_PAYMENT
+    { "Je regarde tes mineurs.", "Je vérifie la mine.", nullptr }    // ACK_MINING
+};
+
+// Mots-cles (minuscules, sans accents) par intention
+static const char* const PRICE_KEYWORDS[] = {
+    "prix", "cours", "combien vaut", "frais", "fee", "bloc", "mempool", "euro", "dollar", nullptr
+};
+static const char* const PAYMENT_KEYWORDS[] = {
+    "envoie", "envoyer", "paye", "payer", "recevoir", "invoice", "facture", "wallet", nullptr
+};
+static const char* const MINING_KEYWORDS[] = {
+    "mine", "mineur", "hashrate", "bitaxe", "braiins", "pool", nullptr
+};
+
+#define ACK_CHUNK_SAMPLES 256  // 16 ms a 16 kHz: reactivite de la coupure
+
+AckAudio::AckAudio() {
+    initialized = false;
+    enabled = true;
+    task = nullptr;
+    pending = nullptr;
+    active = false;
+    stopRequested = false;
+    memset(earcons, 0, sizeof(earcons));
+    memset(phrases, 0, sizeof(phrases));
+    for (int i = 0; i < ACK_INTENT_COUNT; i++) {
+        lastVariant[i] = -1;
+    }
+}
+
+bool AckAudio::begin() {
+    for (int e = 0; e < EARCON_COUNT; e++) {
+        if (!generateEarcon((Earcon)e)) {
+            Serial.println("Ack: allocation earcon echouee");
+            return false;
+        }
+    }
+
+    int loaded = 0;
+    if (LittleFS.begin(true)) {
+        for (int i = 0; i < ACK_INTENT_COUNT; i++) {
+            for (int v = 0; v < ACK_MAX_VARIANTS; v++) {
+                if (ACK_PHRASES[i][v] && loadPhrase(i, v)) loaded++;
+            }
+        }
+    } else {
+        Serial.println("Ack: LittleFS indisponible - earcons seulement");
+    }
+
+    // Tache de lecture sur core 0: la loop reste bloquee dans les appels HTTPS
+    if (xTaskCreatePinnedToCore(playbackTask, "ack_audio", 4096, this, 2, &task, 0) != pdPASS) {
+        Serial.println("Ack: creation tache echouee");
+        return false;
+    }
+
+    initialized = true;
+    Serial.printf("Ack audio pret: %d earcons, %d phrases\n", EARCON_COUNT, loaded);
+    return true;
+}
+
+// ============================================================
+// Generation des earcons (sinus avec enveloppe)
+// ============================================================
+
+// Ecrit un bip dans buf a partir de offset, retourne le nouvel offset
+static size_t writeTone(int16_t* buf, size_t offset, int frequency, int durationMs, int amplitude) {
+    size_t count = (size_t)AUDIO_SAMPLE_RATE * durationMs / 1000;
+    size_t ramp = AUDIO_SAMPLE_RATE * 5 / 1000;  // 5 ms attaque/relachement
+    for (size_t i = 0; i < count; i++) {
+        float env = 1.0f;
+        if (i < ramp) env = (float)i / ramp;
+        else if (i > count - ramp) env = (float)(count - i) / ramp;
+        float t = (float)i / AUDIO_SAMPLE_RATE;
+        buf[offset + i] = frequency > 0 ? (int16_t)(amplitude * env * sin(2.0 * PI * frequency * t)) : 0;
+    }
+    return offset + count;
+}
+
+bool AckAudio::generateEarcon(Earcon earcon) {
+    // Duree totale de chaque earcon en ms
+    static const int durations[EARCON_COUNT] = { 180, 280, 300 };
+    size_t count = (size_t)AUDIO_SAMPLE_RATE * durations[earcon] / 1000;
+
+    int16_t* buf = psramFound() ? (int16_t*)ps_malloc(count * 2) : (int16_t*)malloc(count * 2);
+    if (!buf) return false;
+
+    size_t pos = 0;
+    switch (earcon) {
+        case EARCON_WAKE:  // Montee de quinte
+            pos = writeTone(buf, pos, 660, 90, 6000);
+            pos = writeTone(buf, pos, 990, 90, 6000);
+            break;
+        case EARCON_PROCESSING:  // Trois petits bips doux
+            pos = writeTone(buf, pos, 880, 60, 3000);
+            pos = writeTone(buf, pos, 0, 50, 0);
+            pos = writeTone(buf, pos, 880, 60, 3000);
+            pos = writeTone(buf, pos, 0, 50, 0);
+            pos = writeTone(buf, pos, 1175, 60, 3000);
+            break;
+        case EARCON_ERROR:  // Descente
+            pos = writeTone(buf, pos, 440, 150, 6000);
+            pos = writeTone(buf, pos, 330, 150, 6000);
+            break;
+        default:
+            break;
+    }
+
+    earcons[earcon].samples = buf;
+    earcons[earcon].count = pos;
+    return true;
+}
+
+// ============================================================
+// Phrases pre-rendues (LittleFS, PCM 16 kHz mono)
+// ============================================================
+
+void AckAudio::phrasePath(int intent, int variant, char* out, size_t len) {
+    snprintf(out, len, "%s/%d_%d.pcm", ACK_DIR, intent, variant);
+}
+
+bool AckAudio::loadPhrase(int intent, int variant) {
+    char path[32];
+    phrasePath(intent, variant, path, sizeof(path));
+    if (!LittleFS.exists(path)) return false;
+
+    File f = LittleFS.open(path, "r");
+    if (!f) return false;
+
+    size_t size = f.size();
+    int16_t* buf = psramFound() ? (int16_t*)ps_malloc(size) : (int16_t*)malloc(size);
+    if (!buf) {
+        f.close();
+        return false;
+    }
+
+    size_t n = f.read((uint8_t*)buf, size);
+    f.close();
+
+    phrases[intent][variant].samples = buf;
+    phrases[intent][variant].count = n / 2;
+    return true;
+}
+
+bool AckAudio::renderPhrase(int intent, int variant) {
+    uint8_t* wav = nullptr;
+    size_t wavSize = 0;
+    if (!getTTSWavBuffer(ACK_PHRASES[intent][variant], &wav, &wavSize) || wavSize <= 44) {
+        if (wav) free(wav);
+        return false;
+    }
+
+    uint32_t srcRate = wav[24] | (wav[25] << 8) | (wav[26] << 16) | (wav[27] << 24);
+    const int16_t* src = (const int16_t*)(wav + 44);
+    size_t srcCount = (wavSize - 44) / 2;
+
+    // Retirer le silence en debut/fin (phrase jouee instantanement)
+    const int SILENCE = 300;
+    size_t first = 0, last = srcCount;
+    while (first < srcCount && abs(src[first]) < SILENCE) first++;
+    while (last > first && abs(src[last - 1]) < SILENCE) last--;
+    if (last <= first || srcRate == 0) {
+        free(wav);
+        return false;
+    }
+
+    // Re-echantillonnage lineaire vers 16 kHz (I2S reste a la frequence du micro)
+    size_t outCount = (size_t)((uint64_t)(last - first) * AUDIO_SAMPLE_RATE / srcRate);
+    int16_t* out = psramFound() ? (int16_t*)ps_malloc(outCount * 2) : (int16_t*)malloc(outCount * 2);
+    if (!out) {
+        free(wav);
+        return false;
+    }
+    for (size_t i = 0; i < outCount; i++) {
+        float pos = (float)i * srcRate / AUDIO_SAMPLE_RATE;
+        size_t idx = first + (size_t)pos;
+        float frac = pos - (size_t)pos;
+        int16_t a = src[idx];
+        int16_t b = (idx + 1 < last) ? src[idx + 1] : a;
+        out[i] = (int16_t)(a + (b - a) * frac);
+    }
+    free(wav);
+
+    char path[32];
+    phrasePath(intent, variant, path, sizeof(path));
+    File f = LittleFS.open(path, "w");
+    if (f) {
+        f.write((const uint8_t*)out, outCount * 2);
+        f.close();
+    }
+
+    phrases[intent][variant].samples = out;
+    phrases[intent][variant].count = outCount;
+    return true;
+}
+
+void AckAudio::renderMissingPhrases() {
+    if (!initialized) return;
+
+    if (!LittleFS.exists(ACK_DIR)) {
+        LittleFS.mkdir(ACK_DIR);
+    }
+
+    int rendered = 0;
+    for (int i = 0; i < ACK_INTENT_COUNT; i++) {
+        for (int v = 0; v < ACK_MAX_VARIANTS; v++) {
+            if (!ACK_PHRASES[i][v] || phrases[i][v].samples) continue;
+            if (renderPhrase(i, v)) {
+                rendered++;
+            } else {
+                Serial.printf("Ack: rendu echoue \"%s\"\n", ACK_PHRASES[i][v]);
+                return;  // Probablement rate limit TTS: reessayer au prochain demarrage
+            }
+        }
+    }
+    if (rendered > 0) {
+        Serial.printf("Ack: %d phrases rendues et stockees\n", rendered);
+    }
+}
+
+// ============================================================
+// Choix de la phrase
+// ============================================================
+
+static bool containsAny(const String& text, const char* const* keywords) {
+    for (int i = 0; keywords[i]; i++) {
+        if (text.indexOf(keywords[i]) >= 0) return true;
+    }
+    return false;
+}
+
+AckIntent AckAudio::intentFor(const String& text) {
+    String lower = text;
+    lower.toLowerCase();
+
+    if (containsAny(lower, PAYMENT_KEYWORDS)) return ACK_PAYMENT;
+    if (containsAny(lower, MINING_KEYWORDS)) return ACK_MINING;
+    if (containsAny(lower, PRICE_KEYWORDS)) return ACK_PRICE;
+    return ACK_GENERIC;
+}
+
+// ============================================================
+// Lecture
+// ============================================================
+
+bool AckAudio::play(AckIntent intent) {
+    // Variantes disponibles pour cette intention (sinon generique)
+    int available[ACK_MAX_VARIANTS];
+    int n = 0;
+    for (int v = 0; v < ACK_MAX_VARIANTS; v++) {
+        if (phrases[intent][v].samples) available[n++] = v;
+    }
+    if (n == 0 && intent != ACK_GENERIC) return play(ACK_GENERIC);
+    if (n == 0) return playEarcon(EARCON_PROCESSING);
+
+    // Eviter de repeter la meme variante deux fois de suite
+    int pick = available[random(n)];
+    if (n > 1 && pick == lastVariant[intent]) {
+        pick = available[(random(n - 1) + 1 + pick) % n];
+    }
+    lastVariant[intent] = pick;
+
+    return startClip(&phrases[intent][pick]);
+}
+
+bool AckAudio::playEarcon(Earcon earcon) {
+    if (earcon >= EARCON_COUNT) return false;
+    return startClip(&earcons[earcon]);
+}
+
+bool AckAudio::startClip(const AckClip* clip) {
+    if (!initialized || !enabled || !clip->samples) return false;
+    if (audioManager.isRecording() || audioManager.isPlaying()) return false;
+
+    stop();
+
+    pending = clip;
+    stopRequested = false;
+    active = true;
+    xTaskNotifyGive(task);
+    return true;
+}
+
+void AckAudio::stop() {
+    if (!active) return;
+
+    stopRequested = true;
+    while (active) {
+        delay(2);
+    }
+    stopRequested = false;
+}
+
+void AckAudio::playbackTask(void* param) {
+    AckAudio* self = (AckAudio*)param;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const AckClip* clip = self->pending;
+        if (clip) {
+            audioStats.setPlaybackActive(true);
+            self->playClip(clip);
+            audioStats.setPlaybackActive(false);
+        }
+        self->active = false;
+    }
+}
+
+void AckAudio::playClip(const AckClip* clip) {
+    int16_t chunk[ACK_CHUNK_SAMPLES];
+    const int volume = audioManager.getVolume();
+    const size_t fadeSamples = AUDIO_SAMPLE_RATE * ACK_FADE_MS / 1000;
+
+    size_t pos = 0;
+    size_t fadeLeft = 0;  // > 0 pendant le fondu de coupure
+
+    while (pos < clip->count) {
+        if (stopRequested && fadeLeft == 0) {
+            // Coupure: fondu court au lieu d'un clic
+            fadeLeft = min(fadeSamples, clip->count - pos);
+        }
+
+        size_t n = min((size_t)ACK_CHUNK_SAMPLES, clip->count - pos);
+        if (fadeLeft > 0 && n > fadeLeft) n = fadeLeft;
+
+        for (size_t i = 0; i < n; i++) {
+            int32_t s = (int32_t)clip->samples[pos + i] * volume / 100;
+            if (fadeLeft > 0) {
+                s = s * (int32_t)(fadeLeft - i) / (int32_t)fadeSamples;
+            }
+            chunk[i] = (int16_t)s;
+        }
+
+        i2s_audio.write((uint8_t*)chunk, n * 2);
+        pos += n;
+
+        if (fadeLeft > 0) break;  // Fondu termine
+    }
+
+    // Purger le DMA avec du silence: pas de residu quand le TTS demarre
+    memset(chunk, 0, sizeof(chunk));
+    i2s_audio.write((uint8_t*)chunk, sizeof(chunk));
+}
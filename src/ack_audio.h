@@ -0,0 +1,87 @@
+// ack_audio.h - Accuses de reception audio pendant STT/LLM
+// Courtes phrases pre-rendues et earcons joues depuis la PSRAM pendant que
+// les appels reseau (Whisper, Claude) sont en cours, coupes des que le TTS est pret.
+#ifndef ACK_AUDIO_H
+#define ACK_AUDIO_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define ACK_MAX_VARIANTS   3       // Variantes par intention (evite la repetition)
+#define ACK_FADE_MS        12      // Fondu de sortie lors d'une coupure
+#define ACK_DIR            "/ack"  // Dossier LittleFS des phrases pre-rendues
+
+// Intention detectee dans la question (choix de la phrase)
+enum AckIntent {
+    ACK_GENERIC,    // "Une seconde..."
+    ACK_PRICE,      // Prix, frais, blocs
+    ACK_PAYMENT,    // Envoi/reception de sats
+    ACK_MINING,     // Mineurs, hashrate
+    ACK_INTENT_COUNT
+};
+
+// Sons courts generes au demarrage
+enum Earcon {
+    EARCON_WAKE,        // Wake word accepte
+    EARCON_PROCESSING,  // Audio envoye a Whisper
+    EARCON_ERROR,       // Echec
+    EARCON_COUNT
+};
+
+// Clip PCM 16 kHz mono en memoire
+struct AckClip {
+    int16_t* samples;
+    size_t count;
+};
+
+class AckAudio {
+public:
+    AckAudio();
+
+    // Genere les earcons et charge les phrases deja rendues (LittleFS)
+    bool begin();
+
+    // Rend via TTS les phrases absentes du stockage (une seule fois)
+    void renderMissingPhrases();
+
+    // Choisir l'intention a partir du texte de la question
+    AckIntent intentFor(const String& text);
+
+    // Lecture non bloquante (coupe le son en cours)
+    bool play(AckIntent intent);
+    bool playEarcon(Earcon earcon);
+
+    // Coupure propre (fondu) - bloque jusqu'a liberation de l'I2S
+    void stop();
+    bool isPlaying() { return active; }
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() { return enabled; }
+
+private:
+    bool initialized;
+    bool enabled;
+
+    AckClip earcons[EARCON_COUNT];
+    AckClip phrases[ACK_INTENT_COUNT][ACK_MAX_VARIANTS];
+    int lastVariant[ACK_INTENT_COUNT];
+
+    // Etat partage avec la tache de lecture
+    TaskHandle_t task;
+    const AckClip* volatile pending;
+    volatile bool active;
+    volatile bool stopRequested;
+
+    static void playbackTask(void* param);
+    void playClip(const AckClip* clip);
+    bool startClip(const AckClip* clip);
+
+    bool generateEarcon(Earcon earcon);
+    bool loadPhrase(int intent, int variant);
+    bool renderPhrase(int intent, int variant);
+    void phrasePath(int intent, int variant, char* out, size_t len);
+};
+
+extern AckAudio ackAudio;
+
+#endif
@@ -5,6 +5,10 @@
 #include "audio.h"
 #include "freenove_es8311.h"  // Driver Freenove avec es8311_codec_init()
 #include "rgb_led.h"          // LED RGB pour pulse audio
+#include "whisper_api.h"      // Transcription speculative pendant le VAD
+#include "corpus_recorder.h"  // Corpus audio terrain (SD)
+#include "vad.h"              // Fin de parole (commande)
+#include "audio_stats.h"      // Overruns/underruns DMA, latences
 #include <Wire.h>
 
 // Instance globale I2S
@@ -21,6 +25,9 @@ AudioManager::AudioManager() {
     recordSize = 0;
     bufferCapacity = 0;
     recordStartTime = 0;
+    speculativeSTT = false;
+    speculativePauseMs = SPECULATIVE_STT_PAUSE_MS;
+    speculativeLaunched = false;
     volume = 50;  // Volume par defaut 50%
 }
 
@@ -67,6 +74,7 @@ bool AudioManager::begin() {
         return false;
     }
     Serial.println("I2S initialise (16kHz, 16-bit, mono)");
+    audioStats.attach();
 
     // Initialiser le codec ES8311 via le driver Freenove officiel
     // Utilise l'API ESP-IDF i2c_master_write_to_device sur I2C_NUM_0
@@ -85,6 +93,12 @@ bool AudioManager::begin() {
     return true;
 }
 
+void AudioManager::setSpeculativeSTT(bool enabled, int pauseMs) {
+    speculativeSTT = enabled;
+    speculativePauseMs = pauseMs;
+    Serial.printf("STT speculatif: %s (pause %d ms)\n", enabled ? "actif" : "inactif", pauseMs);
+}
+
 void AudioManager::end() {
     if (recordBuffer) {
         free(recordBuffer);
@@ -102,10 +116,11 @@ bool AudioManager::startRecording() {
     size_t flushed = 0;
     unsigned long flushStart = millis();
     while (millis() - flushStart < 100) {
-        size_t n = i2s_audio.readBytes((char*)flushBuffer, sizeof(flushBuffer));
+        size_t n = audioStats.read(flushBuffer, sizeof(flushBuffer));
         if (n > 0) flushed += n;
         else break;
     }
+    audioStats.resync();
     if (flushed > 0) {
         Serial.printf("Buffer I2S vide: %d bytes\n", flushed);
     }
@@ -182,10 +197,11 @@ bool AudioManager::startRecordingWithVAD(int maxDurationMs, int silenceMs) {
     size_t flushed = 0;
     unsigned long flushStart = millis();
     while (millis() - flushStart < 100) {
-        size_t n = i2s_audio.readBytes((char*)flushBuffer, sizeof(flushBuffer));
+        size_t n = audioStats.read(flushBuffer, sizeof(flushBuffer));
         if (n > 0) flushed += n;
         else break;
     }
+    audioStats.resync();
     if (flushed > 0) {
         Serial.printf("Buffer I2S vide: %d bytes\n", flushed);
     }
@@ -198,66 +214,80 @@ bool AudioManager::startRecordingWithVAD(int maxDurationMs, int silenceMs) {
     Serial.printf("Max: %dms, Silence: %dms\n", maxDurationMs, silenceMs);
     Serial.println("Parlez maintenant...");
 
-    // Parametres VAD
-    const int CHUNK_SIZE = 512;  // Samples par chunk
-    const int ENERGY_THRESHOLD = 400;  // Seuil d'energie pour parole
-    const int SPEECH_FRAMES_REQUIRED = 2;  // Frames pour confirmer debut parole
-    const int silenceFramesRequired = (silenceMs * AUDIO_SAMPLE_RATE) / (CHUNK_SIZE * 1000);
+    // Detection de fin de parole (vad.cpp, rejouable sur PC)
+    CommandVad vad;
+    vad.begin(AUDIO_SAMPLE_RATE, silenceMs, speculativePauseMs);
+
+    // Une requete speculative d'un enregistrement precedent ne doit pas etre reutilisee
+    whisperAPI.cancelSpeculative();
+    speculativeLaunched = false;
 
-    int16_t samples[CHUNK_SIZE];
-    int speechFrameCount = 0;
-    int silenceFrameCount = 0;
-    bool speechStarted = false;
+    corpusRecorder.beginClip(CORPUS_COMMAND, vad.getThreshold());
+    bool endpointed = false;
+    audioStats.setCaptureActive(true);
+
+    int16_t samples[VAD_CHUNK_SAMPLES];
     unsigned long speechStartTime = 0;
 
     while (recording && (millis() - recordStartTime) < (unsigned long)maxDurationMs) {
         // Lire un chunk
-        size_t bytesRead = i2s_audio.readBytes((char*)samples, sizeof(samples));
+        size_t bytesRead = audioStats.read(samples, sizeof(samples));
         if (bytesRead == 0) {
             delay(1);
             continue;
         }
 
         size_t sampleCount = bytesRead / sizeof(int16_t);
+        VadEvent event = vad.process(samples, sampleCount);
+        int energy = vad.getEnergy();
 
-        // Calculer l'energie RMS
-        int64_t sum = 0;
-        for (size_t i = 0; i < sampleCount; i++) {
-            int32_t s = samples[i];
-            sum += s * s;
-        }
-        int energy = (int)sqrt((double)(sum / sampleCount));
-
-        bool hasSpeech = (energy > ENERGY_THRESHOLD);
-
-        if (hasSpeech) {
-            speechFrameCount++;
-            silenceFrameCount = 0;
-
-            if (!speechStarted && speechFrameCount >= SPEECH_FRAMES_REQUIRED) {
-                speechStarted = true;
+        switch (event) {
+            case VAD_EVENT_SPEECH_START:
+                audioStats.markDecision(DECISION_VAD_ONSET);
                 speechStartTime = millis();
+                corpusRecorder.logVad(VAD_SPEECH_START, energy);
                 Serial.println("Parole detectee...");
-            }
-        } else {
-            speechFrameCount = 0;
-            if (speechStarted) {
-                silenceFrameCount++;
-            }
+                break;
+            case VAD_EVENT_PAUSE:
+                corpusRecorder.logVad(VAD_PAUSE, energy);
+                break;
+            case VAD_EVENT_RESUME:
+                corpusRecorder.logVad(VAD_RESUME, energy);
+                break;
+            default:
+                break;
+        }
+
+        // Reprise de parole: la transcription speculative est obsolete
+        if (vad.isSpeech() && speculativeLaunched) {
+            whisperAPI.cancelSpeculative();
+            speculativeLaunched = false;
         }
 
         // Stocker l'audio si on a detecte de la parole
-        if (speechStarted || speechFrameCount > 0) {
+        if (vad.shouldStore()) {
             if (recordSize + bytesRead < bufferCapacity) {
                 memcpy(recordBuffer + recordSize, samples, bytesRead);
                 recordSize += bytesRead;
             }
         }
 
+        // Pause courte: lancer Whisper pendant que la capture continue.
+        // Si la requete precedente (annulee) n'est pas terminee, on reessaie a la frame suivante.
+        if (speculativeSTT && !speculativeLaunched && vad.inTentativePause()) {
+            speculativeLaunched = whisperAPI.startSpeculative(recordBuffer, recordSize);
+            if (speculativeLaunched) {
+                corpusRecorder.logVad(VAD_SPECULATIVE, energy);
+            }
+        }
+
         // Fin de parole detectee (silence apres parole)
-        if (speechStarted && silenceFrameCount >= silenceFramesRequired) {
+        if (event == VAD_EVENT_END) {
+            audioStats.markDecision(DECISION_VAD_END);
             unsigned long duration = millis() - speechStartTime;
             Serial.printf("Fin parole detectee apres %lu ms\n", duration);
+            corpusRecorder.logVad(VAD_END, energy);
+            endpointed = true;
             break;
         }
 
@@ -265,6 +295,12 @@ bool AudioManager::startRecordingWithVAD(int maxDurationMs, int silenceMs) {
     }
 
     recording = false;
+    audioStats.setCaptureActive(false);
+
+    if (!endpointed) {
+        corpusRecorder.logVad(VAD_TIMEOUT, 0);
+    }
+    corpusRecorder.captureAudio(recordBuffer, recordSize);
 
     // Analyser l'enregistrement
     if (recordSize > 0) {
@@ -339,6 +375,8 @@ bool AudioManager::playAudio(const uint8_t* data, size_t length) {
             i2s_audio.setPins(PIN_I2S_BCLK, PIN_I2S_WS, PIN_I2S_DOUT, PIN_I2S_DIN, PIN_I2S_MCLK);
             i2s_audio.begin(I2S_MODE_STD, sampleRate, I2S_DATA_BIT_WIDTH_16BIT,
                            I2S_SLOT_MODE_MONO, I2S_STD_SLOT_LEFT);
+            audioStats.attach();
+            audioStats.setPlaybackActive(true);
 
             // Ecrire les samples PCM avec volume par chunks
             const uint8_t* pcmData = data + 44;
@@ -380,16 +418,19 @@ bool AudioManager::playAudio(const uint8_t* data, size_t length) {
             Serial.printf("Lecture terminee: %d bytes joues\n", offset);
 
             // Remettre I2S au sample rate original (16kHz pour le micro)
+            audioStats.setPlaybackActive(false);
             i2s_audio.end();
             delay(10);
             i2s_audio.setPins(PIN_I2S_BCLK, PIN_I2S_WS, PIN_I2S_DOUT, PIN_I2S_DIN, PIN_I2S_MCLK);
             i2s_audio.begin(I2S_MODE_STD, AUDIO_SAMPLE_RATE, I2S_DATA_BIT_WIDTH_16BIT,
                            I2S_SLOT_MODE_MONO, I2S_STD_SLOT_LEFT);
+            audioStats.attach();
         }
         Serial.println("Lecture WAV terminee");
     } else {
         // Données PCM brutes - écrire directement avec volume
         Serial.println("Lecture PCM brut...");
+        audioStats.setPlaybackActive(true);
         size_t offset = 0;
         const size_t chunkSize = 1024;
         int16_t tempBuffer[512];
@@ -424,6 +465,7 @@ bool AudioManager::playAudio(const uint8_t* data, size_t length) {
 
         // Eteindre LED apres lecture
         rgbLed.off();
+        audioStats.setPlaybackActive(false);
         Serial.printf("PCM joue: %d bytes\n", offset);
     }
 
@@ -21,6 +21,12 @@ public:
     bool isRecording() { return recording; }
     int getRecordingDuration();
 
+    // Transcription speculative: lance Whisper des une pause courte pendant l'enregistrement VAD
+    void setSpeculativeSTT(bool enabled, int pauseMs = SPECULATIVE_STT_PAUSE_MS);
+    bool isSpeculativeSTTEnabled() { return speculativeSTT; }
+    // true si une requete speculative couvre l'enregistrement courant
+    bool hasSpeculativeSTT() { return speculativeLaunched; }
+
     // Lecture (via ES8311 DAC)
     bool playAudio(const uint8_t* data, size_t length);
     bool isPlaying() { return playing; }
@@ -61,6 +67,10 @@ private:
 
     unsigned long recordStartTime;
 
+    bool speculativeSTT;
+    int speculativePauseMs;
+    bool speculativeLaunched;
+
     int volume;  // Volume 0-100, defaut 50
 };
 
@@ -0,0 +1,219 @@
+// audio_stats.cpp - Instrumentation I2S: overruns/underruns DMA et latences
+#include "audio_stats.h"
+#include "audio.h"
+#include <esp_timer.h>
+
+AudioStats audioStats;
+
+static const char* const DECISION_NAMES[DECISION_COUNT] = {
+    "wake_onset", "wake_end", "wake_ok", "vad_onset", "vad_end"
+};
+
+AudioStats::AudioStats() {
+    attached = false;
+    captureActive = false;
+    playbackActive = false;
+    portMUX_INITIALIZE(&mux);
+    lastPeriodic = 0;
+    reset();
+}
+
+void AudioStats::reset() {
+    portENTER_CRITICAL(&mux);
+    rxFrames = 0;
+    rxOverruns = 0;
+    rxOverrunsIdle = 0;
+    txFrames = 0;
+    txUnderruns = 0;
+    dmaBytes = 0;
+    droppedBytes = 0;
+    stampNext = 0;
+    memset(stamps, 0, sizeof(stamps));
+    portEXIT_CRITICAL(&mux);
+
+    readOffset = 0;
+    lastReadFrameUs = 0;
+    maxReadLagUs = 0;
+    memset(latency, 0, sizeof(latency));
+}
+
+// ============================================================
+// Callbacks ISR du driver I2S
+// ============================================================
+
+bool IRAM_ATTR AudioStats::onRecv(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx) {
+    AudioStats* self = (AudioStats*)ctx;
+
+    portENTER_CRITICAL_ISR(&self->mux);
+    self->rxFrames++;
+    self->dmaBytes += event->size;
+    DmaStamp& s = self->stamps[self->stampNext % AUDIO_STATS_STAMPS];
+    s.endOffset = self->dmaBytes;
+    s.timeUs = esp_timer_get_time();
+    self->stampNext++;
+    portEXIT_CRITICAL_ISR(&self->mux);
+    return false;
+}
+
+bool IRAM_ATTR AudioStats::onRecvOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx) {
+    AudioStats* self = (AudioStats*)ctx;
+
+    // Le plus ancien buffer non lu est ecrase: ces echantillons sont perdus
+    portENTER_CRITICAL_ISR(&self->mux);
+    self->droppedBytes += event->size;
+    if (self->captureActive) {
+        self->rxOverruns++;
+    } else {
+        self->rxOverrunsIdle++;
+    }
+    portEXIT_CRITICAL_ISR(&self->mux);
+    return false;
+}
+
+bool IRAM_ATTR AudioStats::onSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx) {
+    AudioStats* self = (AudioStats*)ctx;
+    self->txFrames++;
+    return false;
+}
+
+bool IRAM_ATTR AudioStats::onSendOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx) {
+    AudioStats* self = (AudioStats*)ctx;
+
+    // Aucun buffer rempli par l'application: le DMA rejoue du silence
+    if (self->playbackActive) {
+        self->txUnderruns++;
+    }
+    return false;
+}
+
+bool AudioStats::attach() {
+    i2s_chan_handle_t rx = i2s_audio.rxChan();
+    i2s_chan_handle_t tx = i2s_audio.txChan();
+
+    // L'enregistrement des callbacks exige un canal desactive
+    if (rx) {
+        i2s_event_callbacks_t cbs = {};
+        cbs.on_recv = onRecv;
+        cbs.on_recv_q_ovf = onRecvOverflow;
+        i2s_channel_disable(rx);
+        esp_err_t err = i2s_channel_register_event_callback(rx, &cbs, this);
+        i2s_channel_enable(rx);
+        if (err != ESP_OK) {
+            Serial.printf("AudioStats: callbacks RX refuses (%d)\n", err);
+            return false;
+        }
+    }
+    if (tx) {
+        i2s_event_callbacks_t cbs = {};
+        cbs.on_sent = onSent;
+        cbs.on_send_q_ovf = onSendOverflow;
+        i2s_channel_disable(tx);
+        esp_err_t err = i2s_channel_register_event_callback(tx, &cbs, this);
+        i2s_channel_enable(tx);
+        if (err != ESP_OK) {
+            Serial.printf("AudioStats: callbacks TX refuses (%d)\n", err);
+            return false;
+        }
+    }
+
+    // Nouveau canal: les offsets repartent de zero
+    portENTER_CRITICAL(&mux);
+    dmaBytes = 0;
+    droppedBytes = 0;
+    stampNext = 0;
+    portEXIT_CRITICAL(&mux);
+    readOffset = 0;
+
+    attached = true;
+    return true;
+}
+
+// ============================================================
+// Cote lecteur
+// ============================================================
+
+int64_t AudioStats::frameTimeForOffset(uint32_t offset) {
+    int64_t result = 0;
+
+    portENTER_CRITICAL(&mux);
+    uint32_t count = stampNext < AUDIO_STATS_STAMPS ? stampNext : AUDIO_STATS_STAMPS;
+    // Du plus ancien au plus recent: premier buffer qui contient l'offset
+    for (uint32_t i = 0; i < count; i++) {
+        const DmaStamp& s = stamps[(stampNext - count + i) % AUDIO_STATS_STAMPS];
+        if ((int32_t)(s.endOffset - offset) >= 0) {
+            result = s.timeUs;
+            break;
+        }
+        result = s.timeUs;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    return result;
+}
+
+size_t AudioStats::read(void* buffer, size_t size) {
+    size_t n = i2s_audio.readBytes((char*)buffer, size);
+    if (n == 0 || !attached) return n;
+
+    readOffset += n;
+
+    // Les octets perdus par overrun precedent ce que le lecteur recoit
+    uint32_t streamOffset = readOffset + droppedBytes;
+    int64_t frameUs = frameTimeForOffset(streamOffset);
+    if (frameUs > 0) {
+        lastReadFrameUs = frameUs;
+        uint32_t lag = (uint32_t)(esp_timer_get_time() - frameUs);
+        if (lag > maxReadLagUs) maxReadLagUs = lag;
+    }
+    return n;
+}
+
+void AudioStats::resync() {
+    portENTER_CRITICAL(&mux);
+    readOffset = dmaBytes - droppedBytes;
+    portEXIT_CRITICAL(&mux);
+}
+
+void AudioStats::markDecision(AudioDecision decision) {
+    if (decision >= DECISION_COUNT || lastReadFrameUs == 0) return;
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - lastReadFrameUs);
+    LatencyStat& l = latency[decision];
+    l.count++;
+    l.lastUs = us;
+    l.sumUs += us;
+    if (us > l.maxUs) l.maxUs = us;
+}
+
+// ============================================================
+// Affichage
+// ============================================================
+
+void AudioStats::printStats() {
+    Serial.println("\n=== STATS AUDIO I2S ===");
+    Serial.printf("Callbacks: %s\n", attached ? "actifs" : "absents");
+    Serial.printf("RX: %u buffers DMA, overruns %u en capture / %u hors capture (%u octets perdus)\n",
+                  rxFrames, rxOverruns, rxOverrunsIdle, droppedBytes);
+    Serial.printf("TX: %u buffers DMA, underruns %u en lecture\n", txFrames, txUnderruns);
+    Serial.printf("Retard lecteur max: %.1f ms\n", maxReadLagUs / 1000.0f);
+    Serial.println("Latence capture -> decision (ms): n / dernier / moyen / max");
+    for (int i = 0; i < DECISION_COUNT; i++) {
+        const LatencyStat& l = latency[i];
+        if (l.count == 0) continue;
+        Serial.printf("  %-11s %4u / %7.1f / %7.1f / %7.1f\n", DECISION_NAMES[i], l.count,
+                      l.lastUs / 1000.0f, (float)(l.sumUs / l.count) / 1000.0f, l.maxUs / 1000.0f);
+    }
+    Serial.println("=======================\n");
+}
+
+void AudioStats::printPeriodic() {
+    if (millis() - lastPeriodic < AUDIO_STATS_INTERVAL) return;
+    lastPeriodic = millis();
+
+    const LatencyStat& vad = latency[DECISION_VAD_END];
+    const LatencyStat& wake = latency[DECISION_WAKE_END];
+    Serial.printf("[audio] rx_ovr=%u/%u tx_udr=%u lag_max=%.1fms vad_end=%.1f/%.1fms wake_end=%.1f/%.1fms\n",
+                  rxOverruns, rxOverrunsIdle, txUnderruns, maxReadLagUs / 1000.0f,
+                  vad.count ? (float)(vad.sumUs / vad.count) / 1000.0f : 0.0f, vad.maxUs / 1000.0f,
+                  wake.count ? (float)(wake.sumUs / wake.count) / 1000.0f : 0.0f, wake.maxUs / 1000.0f);
+}
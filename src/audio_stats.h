@@ -0,0 +1,103 @@
+// audio_stats.h - Instrumentation I2S: overruns/underruns DMA et latences
+// Les callbacks ISR du driver I2S horodatent chaque buffer DMA recu et
+// comptent les pertes (file RX pleine = echantillons perdus, file TX vide
+// = lecture affamee). Les lectures micro passent par read() pour relier
+// chaque echantillon lu a l'instant ou il a quitte le DMA, ce qui donne la
+// latence capture -> decision (VAD, wake word).
+#ifndef AUDIO_STATS_H
+#define AUDIO_STATS_H
+
+#include <Arduino.h>
+#include <ESP_I2S.h>
+
+#define AUDIO_STATS_STAMPS      64      // Buffers DMA horodates (historique)
+#define AUDIO_STATS_INTERVAL    60000   // Ligne de stats periodique (ms)
+
+// Decisions dont on mesure la latence depuis la capture
+enum AudioDecision {
+    DECISION_WAKE_ONSET,     // Wake word: debut de parole
+    DECISION_WAKE_END,       // Wake word: fin de parole (avant Whisper)
+    DECISION_WAKE_CONFIRM,   // Wake word confirme (Whisper inclus)
+    DECISION_VAD_ONSET,      // Commande: debut de parole
+    DECISION_VAD_END,        // Commande: fin de parole
+    DECISION_COUNT
+};
+
+struct LatencyStat {
+    uint32_t count;
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+};
+
+class AudioStats {
+public:
+    AudioStats();
+
+    // A appeler apres chaque i2s_audio.begin() (les canaux sont recrees)
+    bool attach();
+
+    // Lecture micro instrumentee (remplace i2s_audio.readBytes)
+    size_t read(void* buffer, size_t size);
+
+    // Le lecteur est a jour (file DMA videe): recaler les offsets
+    void resync();
+
+    // Phases ou une perte compte vraiment
+    void setCaptureActive(bool active) { captureActive = active; }
+    void setPlaybackActive(bool active) { playbackActive = active; }
+
+    // Latence depuis la capture du dernier echantillon lu
+    void markDecision(AudioDecision decision);
+
+    // Instant (esp_timer, us) ou le dernier echantillon lu a quitte le DMA
+    int64_t lastFrameTimeUs() { return lastReadFrameUs; }
+
+    uint32_t getRxOverruns() { return rxOverruns; }
+    uint32_t getRxOverrunsIdle() { return rxOverrunsIdle; }
+
+    void printStats();
+    void printPeriodic();  // Une ligne toutes les AUDIO_STATS_INTERVAL ms
+    void reset();
+
+private:
+    bool attached;
+
+    // Ecrits par les ISR
+    volatile uint32_t rxFrames;
+    volatile uint32_t rxOverruns;          // Pendant une capture
+    volatile uint32_t rxOverrunsIdle;      // Micro non lu (hors capture)
+    volatile uint32_t txFrames;
+    volatile uint32_t txUnderruns;         // Pendant une lecture
+    volatile uint32_t dmaBytes;            // Octets recus du DMA (cumul)
+    volatile uint32_t droppedBytes;        // Octets perdus par overrun
+    volatile bool captureActive;
+    volatile bool playbackActive;
+
+    struct DmaStamp {
+        uint32_t endOffset;  // Offset cumule de fin du buffer
+        int64_t timeUs;
+    };
+    DmaStamp stamps[AUDIO_STATS_STAMPS];
+    volatile uint32_t stampNext;
+    portMUX_TYPE mux;
+
+    // Cote lecteur
+    uint32_t readOffset;
+    int64_t lastReadFrameUs;
+    uint32_t maxReadLagUs;
+
+    LatencyStat latency[DECISION_COUNT];
+    unsigned long lastPeriodic;
+
+    static bool IRAM_ATTR onRecv(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx);
+    static bool IRAM_ATTR onRecvOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx);
+    static bool IRAM_ATTR onSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx);
+    static bool IRAM_ATTR onSendOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* ctx);
+
+    int64_t frameTimeForOffset(uint32_t offset);
+};
+
+extern AudioStats audioStats;
+
+#endif
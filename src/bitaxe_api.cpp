@@ -1,21 +1,36 @@
 // bitaxe_api.cpp - Implémentation API Bitaxe
 #include "bitaxe_api.h"
 #include <WiFi.h>
+#include "json_stream.h"
+#include "http_validators.h"
 
 BitaxeAPI bitaxeAPI;
 
 BitaxeAPI::BitaxeAPI() {
     lastError = "";
+    errorMutex = xSemaphoreCreateMutex();
+}
+
+// Polling de fond (httpExecutor) et menu Mining en meme temps: lastError partage
+void BitaxeAPI::setError(const String& error) {
+    xSemaphoreTake(errorMutex, portMAX_DELAY);
+    lastError = error;
+    xSemaphoreGive(errorMutex);
+}
+
+String BitaxeAPI::getLastError() {
+    xSemaphoreTake(errorMutex, portMAX_DELAY);
+    String error = lastError;
+    xSemaphoreGive(errorMutex);
+    return error;
 }
 
 bool BitaxeAPI::fetchMinerInfo(const char* ip, BitaxeMinerInfo& info) {
-    memset(&info, 0, sizeof(info));
-    strncpy(info.ip, ip, sizeof(info.ip) - 1);
-    info.valid = false;
-    info.isOnline = false;
+    bool cached = info.valid && strncmp(info.ip, ip, sizeof(info.ip)) == 0;
 
     if (WiFi.status() != WL_CONNECTED) {
-        lastError = "WiFi non connecté";
+        resetInfo(info, ip);
+        setError("WiFi non connecté");
         return false;
     }
 
@@ -24,26 +39,56 @@ bool BitaxeAPI::fetchMinerInfo(const char* ip, BitaxeMinerInfo& info) {
 
     http.begin(url);
     http.setTimeout(5000);  // 5 secondes timeout
+    jsonReader.prepare(http);
+    bool conditional = cached && httpValidators.apply(http, url);
 
     int httpCode = http.GET();
 
+    if (httpCode == HTTP_CODE_NOT_MODIFIED && conditional) {
+        // Rien de change depuis le dernier poll: info en cache gardee
+        httpValidators.notModified(url);
+        http.end();
+        info.isOnline = true;
+        info.lastUpdate = millis();
+        return true;
+    }
+
+    resetInfo(info, ip);
+
     if (httpCode != 200) {
         if (httpCode < 0) {
-            lastError = "Mineur hors ligne";
+            setError("Mineur hors ligne");
         } else {
-            lastError = "Erreur HTTP: " + String(httpCode);
+            setError("Erreur HTTP: " + String(httpCode));
         }
         http.end();
         return false;
     }
 
-    String payload = http.getString();
+    // Seuls les champs de BitaxeMinerInfo sont alloues (reponse ~2 Ko)
+    JsonDocument filter;
+    for (const char* field : { "hostname", "version", "ASICModel", "hashRate", "power", "voltage",
+                               "frequency", "temp", "vrTemp", "sharesAccepted", "sharesRejected",
+                               "bestDiff", "stratumURL", "stratumUser", "uptimeSeconds" }) {
+        filter[field] = true;
+    }
+
+    JsonDocument doc;
+    bool keepAlive;
+    size_t bodyBytes = 0;
+    unsigned long parseStart = millis();
+    DeserializationError error = jsonReader.read(http, doc, &filter, keepAlive, "bitaxe", &bodyBytes);
+    if (!error) httpValidators.store(http, url, bodyBytes, millis() - parseStart);
     http.end();
 
-    if (!parseSystemInfo(payload, info)) {
+    if (error) {
+        setError("Erreur JSON: " + String(error.c_str()));
+        Serial.printf("Bitaxe %s: erreur JSON: %s\n", ip, error.c_str());
         return false;
     }
 
+    parseSystemInfo(doc, info);
+
     info.valid = true;
     info.isOnline = true;
     info.lastUpdate = millis();
@@ -51,17 +96,14 @@ bool BitaxeAPI::fetchMinerInfo(const char* ip, BitaxeMinerInfo& info) {
     return true;
 }
 
-bool BitaxeAPI::parseSystemInfo(const String& json, BitaxeMinerInfo& info) {
-    // Parser JSON avec ArduinoJson
-    DynamicJsonDocument doc(4096);
-    DeserializationError error = deserializeJson(doc, json);
-
-    if (error) {
-        lastError = "Erreur JSON: " + String(error.c_str());
-        Serial.println(lastError);
-        return false;
-    }
+void BitaxeAPI::resetInfo(BitaxeMinerInfo& info, const char* ip) {
+    memset(&info, 0, sizeof(info));
+    strncpy(info.ip, ip, sizeof(info.ip) - 1);
+    info.valid = false;
+    info.isOnline = false;
+}
 
+void BitaxeAPI::parseSystemInfo(JsonDocument& doc, BitaxeMinerInfo& info) {
     // Infos générales
     if (doc.containsKey("hostname")) {
         strncpy(info.hostname, doc["hostname"] | "", sizeof(info.hostname) - 1);
@@ -123,8 +165,6 @@ bool BitaxeAPI::parseSystemInfo(const String& json, BitaxeMinerInfo& info) {
 
     Serial.printf("Bitaxe %s: %.2f GH/s, %.1fW, %.1f°C\n",
                   info.hostname, info.hashrate, info.power, info.tempChip);
-
-    return true;
 }
 
 MiningStats BitaxeAPI::getAggregatedStats() {
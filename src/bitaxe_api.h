@@ -65,7 +65,9 @@ class BitaxeAPI {
 public:
     BitaxeAPI();
 
-    // Récupérer les infos d'un mineur
+    // Récupérer les infos d'un mineur. Si info est deja la copie en cache
+    // de ce mineur (valid, meme ip), requete conditionnelle: sur 304 info
+    // est gardee telle quelle.
     bool fetchMinerInfo(const char* ip, BitaxeMinerInfo& info);
 
     // Récupérer les stats agrégées
@@ -77,13 +79,18 @@ public:
     // Formater l'uptime
     String formatUptime(uint32_t seconds);
 
-    String getLastError() { return lastError; }
+    String getLastError();
 
 private:
     String lastError;
+    SemaphoreHandle_t errorMutex;   // Mineurs interroges depuis l'executeur et le menu
 
-    // Parser la réponse JSON de /api/system/info
-    bool parseSystemInfo(const String& json, BitaxeMinerInfo& info);
+    void setError(const String& error);
+
+    // Remplir info depuis la réponse JSON (filtrée) de /api/system/info
+    void parseSystemInfo(JsonDocument& doc, BitaxeMinerInfo& info);
+    // Mineur sans donnees (hors ligne ou reponse a relire)
+    void resetInfo(BitaxeMinerInfo& info, const char* ip);
 };
 
 extern BitaxeAPI bitaxeAPI;
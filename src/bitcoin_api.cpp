@@ -1,11 +1,14 @@
 // bitcoin_api.cpp - Implementation complete API Bitcoin via mempool.space
 #include "bitcoin_api.h"
 #include <ArduinoJson.h>
+#include "circuit_breaker.h"
+#include "single_flight.h"
+#include "http_validators.h"
 
 BitcoinAPI bitcoinAPI;
 
 BitcoinAPI::BitcoinAPI() {
-    client = nullptr;
+    initialized = false;
     blockHeight = 0;
     currentPrice = {0, 0, 0, 0, 0, 0, 0, 0, false};
     currentFees = {0, 0, 0, 0, 0, false};
@@ -15,11 +18,11 @@ BitcoinAPI::BitcoinAPI() {
     txInfo = {"", false, 0, 0, 0, 0, false};
     hashRateInfo = {0, 0, 0, 0, 0, 0, false};
     lightningStats = {0, 0, 0, 0, 0, false};
+    errorMutex = xSemaphoreCreateMutex();
 }
 
 void BitcoinAPI::begin() {
-    client = new WiFiClientSecure();
-    client->setInsecure();
+    initialized = true;
     Serial.println("Bitcoin API (mempool.space) initialisee");
 }
 
@@ -27,36 +30,203 @@ void BitcoinAPI::begin() {
 // Methode HTTP generique
 // ============================================================
 
-String BitcoinAPI::httpGet(const String& endpoint) {
-    if (!client) {
-        lastError = "Client non initialise";
-        return "";
+bool BitcoinAPI::httpGet(const String& endpoint, JsonDocument* doc, const JsonDocument* filter,
+                         char* text, size_t textSize, const char* label, bool* unchanged) {
+    if (unchanged) *unchanged = false;
+    if (!initialized) {
+        setError("Client non initialise");
+        return false;
     }
 
-    HTTPClient https;
     String url = String(MEMPOOL_BASE_URL) + endpoint;
 
-    if (!https.begin(*client, url)) {
-        lastError = "Connexion echouee: " + endpoint;
-        return "";
+    // Meme GET deja en cours (rafraichissement abandonne, autre tache):
+    // copie de son resultat plutot qu'une seconde requete
+    bool ok;
+    if (singleFlight.join("GET", url, doc, text, textSize, ok, SF_WAIT_MS, unchanged)) {
+        if (!ok) setError("Echec de la requete partagee: " + endpoint);
+        return ok;
+    }
+
+    // Circuit ouvert: pas d'attente du timeout, le cache est garde
+    uint32_t retryMs = 0;
+    if (!circuitBreaker.allowUrl(url, &retryMs)) {
+        setError("mempool.space indisponible, essai dans " + String(retryMs / 1000) + " s");
+        ok = false;
+    } else {
+        unsigned long start = millis();
+        bool hostFailed = false;
+        ok = httpGetPooled(url, endpoint, doc, filter, text, textSize, label, hostFailed, unchanged);
+        circuitBreaker.recordUrl(url, !hostFailed, millis() - start);
     }
 
-    https.setTimeout(10000);
-    int httpCode = https.GET();
+    singleFlight.land("GET", url, ok, doc, text, unchanged && *unchanged);
+    return ok;
+}
+
+bool BitcoinAPI::httpGetPooled(const String& url, const String& endpoint, JsonDocument* doc,
+                               const JsonDocument* filter, char* text, size_t textSize,
+                               const char* label, bool& hostFailed, bool* unchanged) {
+    hostFailed = true;
+
+    // GET idempotent: rejoue une fois si le socket keep-alive etait perime
+    for (int attempt = 0; attempt < 2; attempt++) {
+        PooledClient* client = connectionPool.acquireForUrl(url, attempt > 0);
+        if (!client) {
+            setError("Connexion echouee: " + endpoint);
+            return false;
+        }
+
+        HTTPClient https;
+        https.setReuse(true);
+
+        if (!https.begin(*client, url)) {
+            connectionPool.release(client, false);
+            setError("Connexion echouee: " + endpoint);
+            return false;
+        }
+
+        https.setTimeout(10000);
+        jsonReader.prepare(https);
+        bool conditional = unchanged && httpValidators.apply(https, url);
+        int httpCode = https.GET();
+
+        if (httpCode < 0) {
+            bool reused = client->wasReused();
+            https.end();
+            connectionPool.release(client, false);
+            if (reused) continue;
+            setError("HTTP " + String(httpCode) + " sur " + endpoint);
+            return false;
+        }
+
+        // 4xx: le serveur repond, seul ce endpoint est en cause
+        hostFailed = httpCode >= 500;
+        if (httpCode == HTTP_CODE_NOT_MODIFIED && conditional) {
+            // 304: pas de corps, socket reutilisable, cache du module garde
+            httpValidators.notModified(url);
+            *unchanged = true;
+            https.end();
+            connectionPool.release(client, true);
+            return true;
+        }
+        if (httpCode != 200) {
+            setError("HTTP " + String(httpCode) + " sur " + endpoint);
+            https.end();
+            // Corps d'erreur non lu: ne pas remettre le socket au pool
+            connectionPool.release(client, false);
+            return false;
+        }
+
+        // Corps lu directement depuis le socket, sans String intermediaire
+        bool keepAlive = false;
+        bool ok;
+        size_t bodyBytes = 0;
+        unsigned long parseStart = millis();
+        if (doc) {
+            DeserializationError error = jsonReader.read(https, *doc, filter, keepAlive, label, &bodyBytes);
+            if (error) setError("Erreur JSON " + String(label) + ": " + String(error.c_str()));
+            ok = !error;
+        } else {
+            ok = jsonReader.readText(https, text, textSize, keepAlive, &bodyBytes);
+            if (!ok) setError("Reponse vide: " + endpoint);
+        }
+        if (ok && unchanged) httpValidators.store(https, url, bodyBytes, millis() - parseStart);
 
-    if (httpCode != 200) {
-        lastError = "HTTP " + String(httpCode) + " sur " + endpoint;
         https.end();
-        return "";
+        connectionPool.release(client, keepAlive);
+        return ok;
     }
 
-    String response = https.getString();
-    https.end();
-    return response;
+    setError("Connexion perdue: " + endpoint);
+    return false;
+}
+
+// Les fetch* tournent en parallele (httpExecutor): lastError partage
+void BitcoinAPI::setError(const String& error) {
+    xSemaphoreTake(errorMutex, portMAX_DELAY);
+    lastError = error;
+    xSemaphoreGive(errorMutex);
+}
+
+String BitcoinAPI::getLastError() {
+    xSemaphoreTake(errorMutex, portMAX_DELAY);
+    String error = lastError;
+    xSemaphoreGive(errorMutex);
+    return error;
 }
 
 bool BitcoinAPI::isConnected() {
-    return client != nullptr;
+    return initialized;
+}
+
+// ============================================================
+// Filtres JSON: seuls ces champs sont alloues
+// ============================================================
+
+static void priceFilter(JsonDocument& filter) {
+    filter["USD"] = true;
+    filter["EUR"] = true;
+    filter["GBP"] = true;
+    filter["CAD"] = true;
+    filter["CHF"] = true;
+    filter["AUD"] = true;
+    filter["JPY"] = true;
+}
+
+static void blockFilter(JsonDocument& filter) {
+    filter["height"] = true;
+    filter["timestamp"] = true;
+    filter["tx_count"] = true;
+    filter["size"] = true;
+    filter["weight"] = true;
+    filter["difficulty"] = true;
+}
+
+// Sans fee_histogram (plusieurs Ko)
+static void mempoolFilter(JsonDocument& filter) {
+    filter["count"] = true;
+    filter["vsize"] = true;
+    filter["total_fee"] = true;
+}
+
+static void addressFilter(JsonDocument& filter) {
+    for (const char* stats : { "chain_stats", "mempool_stats" }) {
+        filter[stats]["funded_txo_sum"] = true;
+        filter[stats]["spent_txo_sum"] = true;
+        filter[stats]["tx_count"] = true;
+    }
+}
+
+// Sans vin/vout
+static void transactionFilter(JsonDocument& filter) {
+    filter["fee"] = true;
+    filter["vsize"] = true;
+    filter["weight"] = true;
+    filter["status"]["confirmed"] = true;
+    filter["status"]["block_height"] = true;
+}
+
+// Sans les historiques hashrates[] et difficulty[]
+static void hashrateFilter(JsonDocument& filter) {
+    filter["currentHashrate"] = true;
+    filter["currentDifficulty"] = true;
+}
+
+static void adjustmentFilter(JsonDocument& filter) {
+    filter["progressPercent"] = true;
+    filter["difficultyChange"] = true;
+    filter["remainingBlocks"] = true;
+    filter["remainingTime"] = true;
+}
+
+static void lightningFilter(JsonDocument& filter) {
+    JsonVariant latest = filter["latest"];
+    latest["channel_count"] = true;
+    latest["node_count"] = true;
+    latest["total_capacity"] = true;
+    latest["avg_fee_rate"] = true;
+    latest["avg_base_fee_mtokens"] = true;
 }
 
 // ============================================================
@@ -64,15 +234,15 @@ bool BitcoinAPI::isConnected() {
 // ============================================================
 
 bool BitcoinAPI::fetchPrice() {
-    String response = httpGet("/v1/prices");
-    if (response.isEmpty()) return false;
-
+    JsonDocument filter;
+    priceFilter(filter);
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        lastError = "Erreur JSON prix: " + String(error.c_str());
-        return false;
+    bool unchanged;
+    if (!getJson("/v1/prices", doc, &filter, "prix", &unchanged)) return false;
+    if (unchanged) {
+        // 304: prix en cache confirme
+        currentPrice.timestamp = millis();
+        return true;
     }
 
     currentPrice.usd = doc["USD"].as<float>();
@@ -118,16 +288,11 @@ String BitcoinAPI::formatPrice(const char* currency) {
 // ============================================================
 
 bool BitcoinAPI::fetchFees() {
-    String response = httpGet("/v1/fees/recommended");
-    if (response.isEmpty()) return false;
-
+    // Objet de 5 entiers: pas de filtre
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        lastError = "Erreur JSON frais: " + String(error.c_str());
-        return false;
-    }
+    bool unchanged;
+    if (!getJson("/v1/fees/recommended", doc, nullptr, "frais", &unchanged)) return false;
+    if (unchanged) return true;
 
     currentFees.fastestFee = doc["fastestFee"].as<int>();
     currentFees.halfHourFee = doc["halfHourFee"].as<int>();
@@ -157,42 +322,38 @@ String BitcoinAPI::formatFees() {
 // ============================================================
 
 bool BitcoinAPI::fetchBlockHeight() {
-    String response = httpGet("/blocks/tip/height");
-    if (response.isEmpty()) return false;
+    char text[16];
+    bool unchanged;
+    if (!getText("/blocks/tip/height", text, sizeof(text), &unchanged)) return false;
+    if (unchanged) return true;
 
-    blockHeight = response.toInt();
+    blockHeight = atoi(text);
     Serial.printf("Hauteur bloc: %d\n", blockHeight);
     return true;
 }
 
 bool BitcoinAPI::fetchLatestBlock() {
     // D'abord recuperer le hash du dernier bloc
-    String hashResponse = httpGet("/blocks/tip/hash");
-    if (hashResponse.isEmpty()) return false;
+    char hash[72];
+    if (!getText("/blocks/tip/hash", hash, sizeof(hash))) return false;
 
-    return fetchBlockByHash(hashResponse.c_str());
+    return fetchBlockByHash(hash);
 }
 
 bool BitcoinAPI::fetchBlock(int height) {
     String endpoint = "/block-height/" + String(height);
-    String hashResponse = httpGet(endpoint);
-    if (hashResponse.isEmpty()) return false;
+    char hash[72];
+    if (!getText(endpoint, hash, sizeof(hash))) return false;
 
-    return fetchBlockByHash(hashResponse.c_str());
+    return fetchBlockByHash(hash);
 }
 
 bool BitcoinAPI::fetchBlockByHash(const char* hash) {
     String endpoint = "/block/" + String(hash);
-    String response = httpGet(endpoint);
-    if (response.isEmpty()) return false;
-
+    JsonDocument filter;
+    blockFilter(filter);
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        lastError = "Erreur JSON bloc: " + String(error.c_str());
-        return false;
-    }
+    if (!getJson(endpoint, doc, &filter, "bloc")) return false;
 
     currentBlock.height = doc["height"].as<int>();
     currentBlock.hash = String(hash);
@@ -225,16 +386,12 @@ String BitcoinAPI::formatBlockInfo() {
 // ============================================================
 
 bool BitcoinAPI::fetchMempoolInfo() {
-    String response = httpGet("/mempool");
-    if (response.isEmpty()) return false;
-
+    JsonDocument filter;
+    mempoolFilter(filter);
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        lastError = "Erreur JSON mempool: " + String(error.c_str());
-        return false;
-    }
+    bool unchanged;
+    if (!getJson("/mempool", doc, &filter, "mempool", &unchanged)) return false;
+    if (unchanged) return true;
 
     mempoolInfo.count = doc["count"].as<int>();
     mempoolInfo.vsize = doc["vsize"].as<long>();
@@ -261,16 +418,10 @@ String BitcoinAPI::formatMempoolInfo() {
 
 bool BitcoinAPI::fetchAddressInfo(const char* address) {
     String endpoint = "/address/" + String(address);
-    String response = httpGet(endpoint);
-    if (response.isEmpty()) return false;
-
+    JsonDocument filter;
+    addressFilter(filter);
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        lastError = "Erreur JSON adresse: " + String(error.c_str());
-        return false;
-    }
+    if (!getJson(endpoint, doc, &filter, "adresse")) return false;
 
     addressInfo.address = String(address);
 
@@ -324,16 +475,10 @@ String BitcoinAPI::formatBalance(long long sats) {
 
 bool BitcoinAPI::fetchTransaction(const char* txid) {
     String endpoint = "/tx/" + String(txid);
-    String response = httpGet(endpoint);
-    if (response.isEmpty()) return false;
-
+    JsonDocument filter;
+    transactionFilter(filter);
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        lastError = "Erreur JSON tx: " + String(error.c_str());
-        return false;
-    }
+    if (!getJson(endpoint, doc, &filter, "tx")) return false;
 
     txInfo.txid = String(txid);
     txInfo.fee = doc["fee"].as<int>();
@@ -377,32 +522,28 @@ String BitcoinAPI::formatTransactionInfo() {
 // ============================================================
 
 bool BitcoinAPI::fetchHashRate() {
-    String response = httpGet("/v1/mining/hashrate/3d");
-    if (response.isEmpty()) return false;
-
+    JsonDocument filter;
+    hashrateFilter(filter);
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        lastError = "Erreur JSON hashrate: " + String(error.c_str());
-        return false;
+    bool unchanged;
+    if (!getJson("/v1/mining/hashrate/3d", doc, &filter, "hashrate", &unchanged)) return false;
+
+    if (!unchanged) {
+        hashRateInfo.currentHashrate = doc["currentHashrate"].as<double>();
+        hashRateInfo.currentDifficulty = doc["currentDifficulty"].as<double>();
+        hashRateInfo.valid = true;
+        Serial.printf("Hashrate: %.2f EH/s\n", hashRateInfo.currentHashrate / 1e18);
     }
 
-    hashRateInfo.currentHashrate = doc["currentHashrate"].as<double>();
-    hashRateInfo.currentDifficulty = doc["currentDifficulty"].as<double>();
-    hashRateInfo.valid = true;
-
-    Serial.printf("Hashrate: %.2f EH/s\n", hashRateInfo.currentHashrate / 1e18);
-
-    // Recuperer aussi l'ajustement de difficulte
-    String diffResponse = httpGet("/v1/mining/difficulty-adjustments");
-    if (!diffResponse.isEmpty()) {
-        JsonDocument diffDoc;
-        if (!deserializeJson(diffDoc, diffResponse)) {
-            if (diffDoc.is<JsonArray>() && diffDoc.size() > 0) {
-                hashRateInfo.difficultyChange = diffDoc[0]["difficultyChange"].as<float>();
-            }
-        }
+    // Recuperer aussi l'ajustement de difficulte en cours
+    JsonDocument diffFilter;
+    adjustmentFilter(diffFilter);
+    JsonDocument diffDoc;
+    if (getJson("/v1/difficulty-adjustment", diffDoc, &diffFilter, "ajustement", &unchanged) && !unchanged) {
+        hashRateInfo.progressPercent = diffDoc["progressPercent"].as<int>();
+        hashRateInfo.difficultyChange = diffDoc["difficultyChange"].as<float>();
+        hashRateInfo.remainingBlocks = diffDoc["remainingBlocks"].as<int>();
+        hashRateInfo.remainingTime = diffDoc["remainingTime"].as<long long>() / 1000;  // ms -> s
     }
 
     return true;
@@ -430,16 +571,12 @@ String BitcoinAPI::formatDifficulty() {
 // ============================================================
 
 bool BitcoinAPI::fetchLightningStats() {
-    String response = httpGet("/v1/lightning/statistics/latest");
-    if (response.isEmpty()) return false;
-
+    JsonDocument filter;
+    lightningFilter(filter);
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-
-    if (error) {
-        lastError = "Erreur JSON lightning: " + String(error.c_str());
-        return false;
-    }
+    bool unchanged;
+    if (!getJson("/v1/lightning/statistics/latest", doc, &filter, "lightning", &unchanged)) return false;
+    if (unchanged) return true;
 
     JsonObject latest = doc["latest"];
     lightningStats.channelCount = latest["channel_count"].as<int>();
@@ -466,6 +603,31 @@ String BitcoinAPI::formatLightningStats() {
     return String(buf);
 }
 
+// ============================================================
+// Benchmark parsing
+// ============================================================
+
+void BitcoinAPI::benchmarkParsing() {
+    Serial.println("\n=== PIC HEAP: getString + doc complet vs flux filtre ===");
+    JsonDocument filter;
+
+    hashrateFilter(filter);
+    jsonReader.benchmark(String(MEMPOOL_BASE_URL) + "/v1/mining/hashrate/3d", filter, "hashrate");
+
+    filter.clear();
+    mempoolFilter(filter);
+    jsonReader.benchmark(String(MEMPOOL_BASE_URL) + "/mempool", filter, "mempool");
+
+    filter.clear();
+    lightningFilter(filter);
+    jsonReader.benchmark(String(MEMPOOL_BASE_URL) + "/v1/lightning/statistics/latest", filter, "lightning");
+
+    filter.clear();
+    priceFilter(filter);
+    jsonReader.benchmark(String(MEMPOOL_BASE_URL) + "/v1/prices", filter, "prix");
+    Serial.println("=======================================================\n");
+}
+
 // ============================================================
 // Utilitaires de formatage
 // ============================================================
@@ -3,8 +3,9 @@
 #define BITCOIN_API_H
 
 #include <Arduino.h>
-#include <WiFiClientSecure.h>
 #include <HTTPClient.h>
+#include "connection_pool.h"
+#include "json_stream.h"
 
 #define MEMPOOL_BASE_URL "https://mempool.space/api"
 
@@ -147,7 +148,7 @@ public:
     String formatLightningStats();
 
     // === Utilitaires ===
-    String getLastError() { return lastError; }
+    String getLastError();
     bool isConnected();
 
     // Conversion sats <-> BTC
@@ -158,9 +159,13 @@ public:
     static String formatNumber(long long num);
     static String formatHashrate(double hashrate);
 
+    // Pic de heap par endpoint: ancien getString() contre flux filtre
+    void benchmarkParsing();
+
 private:
-    WiFiClientSecure* client;
+    bool initialized;
     String lastError;
+    SemaphoreHandle_t errorMutex;   // Requetes paralleles (httpExecutor)
 
     // Donnees en cache
     BitcoinPrice currentPrice;
@@ -173,8 +178,26 @@ private:
     LightningStats lightningStats;
     int blockHeight;
 
-    // Methode HTTP generique
-    String httpGet(const String& endpoint);
+    // GET generique, corps lu en flux: JSON filtre dans doc, ou texte court.
+    // Passe par le disjoncteur (circuit_breaker.h): mempool.space en panne
+    // -> echec immediat, les donnees en cache restent.
+    // unchanged (polls dont le resultat est garde en cache): requete
+    // conditionnelle (http_validators.h), true sur 304: doc / text vides,
+    // garder le cache. Un 304 suppose une reponse 200 deja parsee.
+    bool httpGet(const String& endpoint, JsonDocument* doc, const JsonDocument* filter,
+                 char* text, size_t textSize, const char* label, bool* unchanged = nullptr);
+    // hostFailed: aucune reponse exploitable du serveur (transport, 5xx)
+    bool httpGetPooled(const String& url, const String& endpoint, JsonDocument* doc,
+                       const JsonDocument* filter, char* text, size_t textSize,
+                       const char* label, bool& hostFailed, bool* unchanged);
+    bool getJson(const String& endpoint, JsonDocument& doc, const JsonDocument* filter, const char* label,
+                 bool* unchanged = nullptr) {
+        return httpGet(endpoint, &doc, filter, nullptr, 0, label, unchanged);
+    }
+    bool getText(const String& endpoint, char* text, size_t textSize, bool* unchanged = nullptr) {
+        return httpGet(endpoint, nullptr, nullptr, text, textSize, "texte", unchanged);
+    }
+    void setError(const String& error);
 };
 
 extern BitcoinAPI bitcoinAPI;
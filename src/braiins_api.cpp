@@ -1,7 +1,9 @@
 // braiins_api.cpp - Implementation API Braiins Pool
 #include "braiins_api.h"
 #include <HTTPClient.h>
-#include <ArduinoJson.h>
+#include "connection_pool.h"
+#include "json_stream.h"
+#include "http_validators.h"
 
 BraiinsAPI braiinsAPI;
 
@@ -28,49 +30,79 @@ void BraiinsAPI::setToken(const char* token) {
                   strlen(token) > 4 ? String(token).substring(0, 4).c_str() : "");
 }
 
-bool BraiinsAPI::httpGet(const char* endpoint, String& response) {
+bool BraiinsAPI::httpGet(const char* endpoint, JsonDocument& doc, const JsonDocument& filter, const char* label,
+                         bool* unchanged) {
+    if (unchanged) *unchanged = false;
     if (!hasToken()) {
         lastError = "Token non configure";
         return false;
     }
 
-    HTTPClient http;
     String url = String(BRAIINS_API_BASE) + endpoint;
 
     Serial.printf("Braiins GET: %s\n", url.c_str());
 
-    http.begin(url);
+    PooledClient* client = connectionPool.acquireForUrl(url);
+    if (!client) {
+        lastError = "Connexion echouee";
+        return false;
+    }
+
+    HTTPClient http;
+    http.setReuse(true);
+    http.begin(*client, url);
     http.addHeader("SlushPool-Auth-Token", apiToken);
     http.setTimeout(10000);
+    jsonReader.prepare(http);
+    bool conditional = unchanged && httpValidators.apply(http, url);
 
     int httpCode = http.GET();
 
-    if (httpCode == HTTP_CODE_OK) {
-        response = http.getString();
+    if (httpCode == HTTP_CODE_NOT_MODIFIED && conditional) {
+        // Stats inchangees depuis le dernier poll
+        httpValidators.notModified(url);
+        *unchanged = true;
+        http.end();
+        connectionPool.release(client, true);
+        return true;
+    } else if (httpCode == HTTP_CODE_OK) {
+        // JSON filtre lu depuis le socket
+        bool keepAlive;
+        size_t bodyBytes = 0;
+        unsigned long parseStart = millis();
+        DeserializationError error = jsonReader.read(http, doc, &filter, keepAlive, label, &bodyBytes);
+        if (!error) httpValidators.store(http, url, bodyBytes, millis() - parseStart);
         http.end();
+        connectionPool.release(client, keepAlive);
+        if (error) {
+            lastError = "JSON parse error";
+            return false;
+        }
         return true;
     } else {
         lastError = "HTTP " + String(httpCode);
         Serial.printf("Braiins erreur: %d\n", httpCode);
         http.end();
+        connectionPool.release(client, false);
         return false;
     }
 }
 
 bool BraiinsAPI::fetchPoolStats() {
-    String response;
-    if (!httpGet("/stats/json/btc/", response)) {
-        poolStats.valid = false;
-        return false;
-    }
+    JsonDocument filter;
+    JsonVariant btc = filter["btc"];
+    btc["luck_b10"] = true;
+    btc["luck_b50"] = true;
+    btc["active_workers"] = true;
+    btc["pool_scoring_hash_rate"] = true;
 
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-    if (error) {
-        lastError = "JSON parse error";
+    bool unchanged;
+    if (!httpGet("/stats/json/btc/", doc, filter, "braiins pool", poolStats.valid ? &unchanged : nullptr)) {
         poolStats.valid = false;
         return false;
     }
+    if (poolStats.valid && unchanged) return true;
 
     // Parser les stats du pool
     poolStats.luck = doc["btc"]["luck_b10"] | doc["btc"]["luck_b50"] | 0.0f;
@@ -86,19 +118,22 @@ bool BraiinsAPI::fetchPoolStats() {
 }
 
 bool BraiinsAPI::fetchProfile() {
-    String response;
-    if (!httpGet("/accounts/profile/json/btc/", response)) {
-        profile.valid = false;
-        return false;
+    JsonDocument filter;
+    filter["username"] = true;
+    JsonVariant btc = filter["btc"];
+    for (const char* field : { "confirmed_reward", "unconfirmed_reward", "estimated_reward",
+                               "hash_rate_5m", "hash_rate_60m", "hash_rate_24h",
+                               "ok_workers", "off_workers", "low_workers", "dis_workers" }) {
+        btc[field] = true;
     }
 
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-    if (error) {
-        lastError = "JSON parse error";
+    bool unchanged;
+    if (!httpGet("/accounts/profile/json/btc/", doc, filter, "braiins profil", profile.valid ? &unchanged : nullptr)) {
         profile.valid = false;
         return false;
     }
+    if (profile.valid && unchanged) return true;
 
     // Parser le profil utilisateur
     profile.username = doc["username"] | "";
@@ -140,19 +175,17 @@ bool BraiinsAPI::fetchProfile() {
 }
 
 bool BraiinsAPI::fetchWorkers() {
-    String response;
-    if (!httpGet("/accounts/workers/json/btc/", response)) {
-        workerCount = 0;
-        return false;
-    }
+    // Cles = noms des workers: tout l'objet workers est garde
+    JsonDocument filter;
+    filter["btc"]["workers"] = true;
 
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-    if (error) {
-        lastError = "JSON parse error";
+    bool unchanged;
+    if (!httpGet("/accounts/workers/json/btc/", doc, filter, "braiins workers", workerCount > 0 ? &unchanged : nullptr)) {
         workerCount = 0;
         return false;
     }
+    if (workerCount > 0 && unchanged) return true;
 
     // Parser les workers
     JsonObject workersObj = doc["btc"]["workers"];
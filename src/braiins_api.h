@@ -3,6 +3,7 @@
 #define BRAIINS_API_H
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
 
 // Structure pour les stats du pool
 struct BraiinsPoolStats {
@@ -86,8 +87,11 @@ private:
     int workerCount;
     String lastError;
 
-    // Helper pour requetes HTTP
-    bool httpGet(const char* endpoint, String& response);
+    // Helper pour requetes HTTP (corps JSON filtre lu en flux).
+    // unchanged (cache du fetch rempli): requete conditionnelle, true sur
+    // 304, doc vide
+    bool httpGet(const char* endpoint, JsonDocument& doc, const JsonDocument& filter, const char* label,
+                 bool* unchanged = nullptr);
 
     // Formater hashrate
     String formatHashrate(float thps);
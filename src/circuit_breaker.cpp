@@ -0,0 +1,209 @@
+// circuit_breaker.cpp - Disjoncteur par hote
+#include "circuit_breaker.h"
+#include "connection_pool.h"
+
+CircuitBreaker circuitBreaker;
+
+static const char* stateNames[] = { "ferme", "OUVERT", "essai" };
+
+CircuitBreaker::CircuitBreaker() {
+    memset(hosts, 0, sizeof(hosts));
+    count = 0;
+    enabled = true;
+    mutex = xSemaphoreCreateMutex();
+}
+
+BreakerHost* CircuitBreaker::find(const char* host, bool create) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(hosts[i].host, host) == 0) return &hosts[i];
+    }
+    // Table pleine: hote non suivi, appels toujours autorises
+    if (!create || count >= BREAKER_MAX_HOSTS) return nullptr;
+
+    BreakerHost& h = hosts[count++];
+    memset(&h, 0, sizeof(h));
+    strncpy(h.host, host, BREAKER_HOST_LEN - 1);
+    h.state = BREAKER_CLOSED;
+    h.backoffMs = BREAKER_BACKOFF_MIN_MS;
+    return &h;
+}
+
+// Pourcentage d'echecs (ou d'appels lents) sur la fenetre
+int CircuitBreaker::rate(const BreakerHost& h, bool slow) {
+    if (h.windowCount == 0) return 0;
+    int n = 0;
+    for (int i = 0; i < h.windowCount; i++) {
+        if (slow ? h.latencyMs[i] >= BREAKER_SLOW_MS : h.failed[i]) n++;
+    }
+    return 100 * n / h.windowCount;
+}
+
+void CircuitBreaker::trip(BreakerHost& h) {
+    // Gigue "moitie + aleatoire": les hotes et les appareils d'une meme
+    // piece ne reessaient pas tous au meme instant
+    uint32_t half = h.backoffMs / 2;
+    h.openForMs = half + random(half + 1);
+    h.backoffMs = h.backoffMs * 2 > BREAKER_BACKOFF_MAX_MS ? BREAKER_BACKOFF_MAX_MS : h.backoffMs * 2;
+    h.state = BREAKER_OPEN;
+    h.openedAt = millis();
+    h.probing = false;
+    h.opens++;
+    Serial.printf("Disjoncteur: %s ouvert %u s (echecs %d%%, lents %d%%, %d d'affilee)\n",
+                  h.host, h.openForMs / 1000, rate(h, false), rate(h, true), h.consecutive);
+}
+
+void CircuitBreaker::close(BreakerHost& h) {
+    // Fenetre videe: les echecs d'avant la panne ne comptent plus
+    h.state = BREAKER_CLOSED;
+    h.backoffMs = BREAKER_BACKOFF_MIN_MS;
+    h.windowCount = 0;
+    h.windowPos = 0;
+    h.consecutive = 0;
+    h.probing = false;
+}
+
+bool CircuitBreaker::allow(const char* host, uint32_t* retryMs) {
+    if (!enabled) return true;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    BreakerHost* h = find(host, true);
+    bool ok = true;
+    unsigned long now = millis();
+
+    if (h && h->state == BREAKER_OPEN) {
+        uint32_t elapsed = now - h->openedAt;
+        if (elapsed >= h->openForMs) {
+            // Fin du delai: cet appel sert d'essai
+            h->state = BREAKER_HALF_OPEN;
+            h->probing = true;
+            h->probeAt = now;
+            Serial.printf("Disjoncteur: %s semi-ouvert, essai\n", h->host);
+        } else {
+            ok = false;
+            if (retryMs) *retryMs = h->openForMs - elapsed;
+        }
+    } else if (h && h->state == BREAKER_HALF_OPEN) {
+        if (h->probing && now - h->probeAt < BREAKER_PROBE_TIMEOUT_MS) {
+            // Un seul essai a la fois
+            ok = false;
+            if (retryMs) *retryMs = 0;
+        } else {
+            h->probing = true;
+            h->probeAt = now;
+        }
+    }
+
+    if (!ok) h->rejected++;
+    xSemaphoreGive(mutex);
+    return ok;
+}
+
+void CircuitBreaker::record(const char* host, bool ok, uint32_t ms) {
+    if (!enabled) return;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    BreakerHost* h = find(host, true);
+    if (!h) {
+        xSemaphoreGive(mutex);
+        return;
+    }
+
+    h->failed[h->windowPos] = !ok;
+    h->latencyMs[h->windowPos] = ms > 65535 ? 65535 : ms;
+    h->windowPos = (h->windowPos + 1) % BREAKER_WINDOW;
+    if (h->windowCount < BREAKER_WINDOW) h->windowCount++;
+
+    h->calls++;
+    if (ok) {
+        h->consecutive = 0;
+    } else {
+        h->failures++;
+        h->failMsTotal += ms;
+        h->consecutive++;
+    }
+
+    if (h->state == BREAKER_HALF_OPEN) {
+        if (ok) {
+            Serial.printf("Disjoncteur: %s retabli (%u ms)\n", h->host, ms);
+            close(*h);
+        } else {
+            trip(*h);
+        }
+    } else if (h->state == BREAKER_CLOSED) {
+        // Appels lances avant l'ouverture: resultat compte, etat inchange
+        bool judged = h->windowCount >= BREAKER_MIN_CALLS;
+        if (h->consecutive >= BREAKER_CONSECUTIVE ||
+            (judged && rate(*h, false) >= BREAKER_FAILURE_RATE) ||
+            (judged && rate(*h, true) >= BREAKER_SLOW_RATE)) {
+            trip(*h);
+        }
+    }
+    xSemaphoreGive(mutex);
+}
+
+bool CircuitBreaker::allowUrl(const String& url, uint32_t* retryMs) {
+    String host;
+    uint16_t port;
+    if (!ConnectionPool::parseUrl(url, host, port)) return true;
+    return allow(host.c_str(), retryMs);
+}
+
+void CircuitBreaker::recordUrl(const String& url, bool ok, uint32_t ms) {
+    String host;
+    uint16_t port;
+    if (ConnectionPool::parseUrl(url, host, port)) record(host.c_str(), ok, ms);
+}
+
+BreakerState CircuitBreaker::getState(const char* host) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    BreakerHost* h = find(host, false);
+    BreakerState state = h ? h->state : BREAKER_CLOSED;
+    xSemaphoreGive(mutex);
+    return state;
+}
+
+int CircuitBreaker::getOpenCount() {
+    int n = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int i = 0; i < count; i++) {
+        if (hosts[i].state != BREAKER_CLOSED) n++;
+    }
+    xSemaphoreGive(mutex);
+    return n;
+}
+
+void CircuitBreaker::setEnabled(bool on) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    enabled = on;
+    // Desactive: tous les circuits refermes, compteurs gardes
+    for (int i = 0; i < count; i++) close(hosts[i]);
+    xSemaphoreGive(mutex);
+}
+
+void CircuitBreaker::printStats() {
+    Serial.println("\n=== DISJONCTEURS ===");
+    Serial.printf("Etat: %s\n", enabled ? "ON" : "OFF (timeouts complets)");
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    unsigned long now = millis();
+    for (int i = 0; i < count; i++) {
+        const BreakerHost& h = hosts[i];
+        uint32_t avgFailMs = h.failures ? h.failMsTotal / h.failures : 0;
+        uint32_t latencySum = 0;
+        for (int j = 0; j < h.windowCount; j++) latencySum += h.latencyMs[j];
+
+        Serial.printf("%-28s %-6s", h.host, stateNames[h.state]);
+        if (h.state == BREAKER_OPEN) {
+            uint32_t elapsed = now - h.openedAt;
+            Serial.printf(" (essai dans %u s)", elapsed < h.openForMs ? (h.openForMs - elapsed) / 1000 : 0);
+        }
+        Serial.println();
+        Serial.printf("  Fenetre: %d appels, echecs %d%%, lents %d%%, moy %u ms\n",
+                      h.windowCount, rate(h, false), rate(h, true),
+                      h.windowCount ? latencySum / h.windowCount : 0);
+        Serial.printf("  Total: %u appels, %u echecs | %u ouvertures | %u refus (~%u s d'attente evites)\n",
+                      h.calls, h.failures, h.opens, h.rejected, h.rejected * avgFailMs / 1000);
+    }
+    if (count == 0) Serial.println("Aucun appel observe");
+    xSemaphoreGive(mutex);
+    Serial.println("====================\n");
+}
@@ -0,0 +1,92 @@
+// circuit_breaker.h - Disjoncteur par hote (mempool.space, LNbits, LNURL)
+// Quand un service ne repond plus, chaque appel de refreshBitcoinData() ou
+// executeClaudeAction() attendait son timeout complet (10-30 s) et gelait
+// l'ecran. Le disjoncteur observe les derniers appels de chaque hote
+// (echecs de transport, 5xx, latence). Au-dela des seuils il s'ouvre: les
+// appels echouent tout de suite et les donnees en cache restent
+// affichees. Apres un delai exponentiel avec gigue, un seul appel d'essai
+// passe (semi-ouvert): succes -> ferme, echec -> rouvert plus longtemps.
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <Arduino.h>
+
+#define BREAKER_MAX_HOSTS        6
+#define BREAKER_HOST_LEN         64
+#define BREAKER_WINDOW           8        // Derniers appels observes par hote
+#define BREAKER_MIN_CALLS        3        // Avant de juger les taux
+#define BREAKER_FAILURE_RATE     50       // % d'echecs qui ouvre le circuit
+#define BREAKER_CONSECUTIVE      3        // Echecs d'affilee qui l'ouvrent
+#define BREAKER_SLOW_MS          8000     // Appel lent (timeouts 10-30 s)
+#define BREAKER_SLOW_RATE        75       // % d'appels lents qui l'ouvre
+#define BREAKER_BACKOFF_MIN_MS   5000     // Premiere ouverture
+#define BREAKER_BACKOFF_MAX_MS   300000   // Plafond du delai exponentiel
+#define BREAKER_PROBE_TIMEOUT_MS 60000    // Essai jamais conclu: nouvel essai
+
+enum BreakerState {
+    BREAKER_CLOSED,         // Appels normaux
+    BREAKER_OPEN,           // Echec immediat jusqu'a la fin du delai
+    BREAKER_HALF_OPEN       // Un appel d'essai en cours
+};
+
+struct BreakerHost {
+    char host[BREAKER_HOST_LEN];
+    BreakerState state;
+
+    // Fenetre glissante des derniers appels
+    bool failed[BREAKER_WINDOW];
+    uint16_t latencyMs[BREAKER_WINDOW];
+    int windowCount;
+    int windowPos;
+    int consecutive;
+
+    uint32_t backoffMs;         // Prochain delai d'ouverture (avant gigue)
+    uint32_t openForMs;         // Delai en cours (avec gigue)
+    unsigned long openedAt;
+    bool probing;
+    unsigned long probeAt;
+
+    uint32_t calls;
+    uint32_t failures;
+    uint32_t rejected;          // Appels refuses circuit ouvert
+    uint32_t opens;
+    uint32_t failMsTotal;       // Attente moyenne d'un echec = temps evite par refus
+};
+
+class CircuitBreaker {
+public:
+    CircuitBreaker();
+
+    // Appel autorise vers host? false: circuit ouvert, echouer sans
+    // attendre (retryMs: temps avant le prochain essai)
+    bool allow(const char* host, uint32_t* retryMs = nullptr);
+    // Resultat de l'appel autorise. ok = false: transport en echec ou 5xx
+    // (un 4xx est une reponse du service, pas une panne).
+    void record(const char* host, bool ok, uint32_t ms);
+
+    // Memes appels a partir de l'URL de la requete
+    bool allowUrl(const String& url, uint32_t* retryMs = nullptr);
+    void recordUrl(const String& url, bool ok, uint32_t ms);
+
+    BreakerState getState(const char* host);
+    int getOpenCount();
+
+    void setEnabled(bool on);
+    bool isEnabled() { return enabled; }
+    void printStats();
+
+private:
+    BreakerHost hosts[BREAKER_MAX_HOSTS];
+    int count;
+    bool enabled;
+    SemaphoreHandle_t mutex;
+
+    BreakerHost* find(const char* host, bool create);
+    void trip(BreakerHost& h);
+    void close(BreakerHost& h);
+    int rate(const BreakerHost& h, bool slow);
+};
+
+extern CircuitBreaker circuitBreaker;
+
+#endif
@@ -1,90 +1,229 @@
-// claude_api.cpp - Implementation de l'API Claude avec contexte Bitcoin
+// claude_api.cpp - Implementation de l'API Claude (outils Bitcoin, Lightning, Mining)
 #include "claude_api.h"
 #include <ArduinoJson.h>
 
 ClaudeAPI claudeAPI;
 
-ClaudeAPI::ClaudeAPI() {
-    client = nullptr;
-    bitcoinContext = "";
-    miningContext = "";
+// System prompt, en flash (.rodata). Identique octet pour octet d'un appel
+// a l'autre: avec les definitions d'outils (claude_tools.h), c'est le
+// prefixe mis en cache par l'API (cache_control). Plus de donnees temps
+// reel ici: Claude les demande par outil.
+static const char CLAUDE_SYSTEM_PROMPT[] =
+    "Tu es SATOSHI, assistant Bitcoin et mining. "
+    "REGLE ABSOLUE: Reponse en 1-2 phrases, MAX 260 caracteres. "
+    "Sois direct, pas de bavardage. Francais uniquement.\n\n"
+    "DONNEES: prix, frais, reseau, mineurs Bitaxe et solde du wallet viennent des outils get_*. "
+    "Appelle seulement ceux dont la question a besoin, jamais de chiffre invente.\n\n"
+    "ACTIONS LIGHTNING: pay pour envoyer des sats, receive pour en recevoir (QR code), "
+    "stats pour les statistiques du wallet. Appelle l'outil directement, sans texte avant: "
+    "l'appareil affiche et confirme lui-meme.\n"
+    "L'adresse peut etre Lightning Address (user@domain.com) ou BOLT11 (lnbc...).";
+
+// Requete ecrite sur le socket par blocs: serializeJson() ecrit jeton par
+// jeton, soit un record TLS par cle ou valeur sans tampon
+class ClaudeRequestWriter : public Print {
+public:
+    ClaudeRequestWriter(Client& out, uint8_t* buf, size_t size)
+        : out(out), buf(buf), size(size), len(0), failed(false), writes(0) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+
+    size_t write(const uint8_t* data, size_t n) override {
+        size_t done = 0;
+        while (done < n && !failed) {
+            if (len == size) send();
+            size_t room = size - len;
+            size_t take = n - done < room ? n - done : room;
+            memcpy(buf + len, data + done, take);
+            len += take;
+            done += take;
+        }
+        return failed ? 0 : n;
+    }
+
+    // Vider le tampon. false si une ecriture a echoue.
+    bool send() {
+        if (len > 0 && !failed) {
+            failed = out.write(buf, len) != len;
+            writes++;
+        }
+        len = 0;
+        return !failed;
+    }
+
+    uint32_t getWrites() { return writes; }
+
+private:
+    Client& out;
+    uint8_t* buf;
+    size_t size;
+    size_t len;
+    bool failed;
+    uint32_t writes;
+};
+
+ClaudeAPI::ClaudeAPI() : sse(onSseEvent, this) {
+    initialized = false;
+    streaming = true;
+    promptCache = true;
+    memset(&stream, 0, sizeof(stream));
+    memset(&usage, 0, sizeof(usage));
+    memset(&usageTotal, 0, sizeof(usageTotal));
+    memset(cacheStats, 0, sizeof(cacheStats));
+    memset(calls, 0, sizeof(calls));
+    toolInputs = nullptr;
+    callCount = 0;
+    action.tool = CLAUDE_TOOL_NONE;
+    action.address = "";
+    action.amount = 0;
+    toolsUsed = 0;
 }
 
 void ClaudeAPI::begin() {
-    client = new WiFiClientSecure();
-    client->setInsecure();
+    // Arguments d'outils (factures BOLT11) hors RAM interne
+    if (!toolInputs) {
+        size_t size = CLAUDE_TOOL_CALLS * CLAUDE_TOOL_INPUT_MAX;
+        toolInputs = psramFound() ? (char*)ps_malloc(size) : (char*)malloc(size);
+        if (!toolInputs) {
+            Serial.println("Claude API: tampons d'outils non alloues");
+            return;
+        }
+        for (int i = 0; i < CLAUDE_TOOL_CALLS; i++) calls[i].input = toolInputs + i * CLAUDE_TOOL_INPUT_MAX;
+    }
+    claudeTools.begin();
+    initialized = true;
     Serial.println("Claude API initialisee");
 }
 
-void ClaudeAPI::updateBitcoinContext(const String& context) {
-    bitcoinContext = context;
+void ClaudeAPI::setStreaming(bool on) {
+    streaming = on;
+    Serial.printf("Claude streaming: %s\n", on ? "ON" : "OFF");
 }
 
-void ClaudeAPI::updateMiningContext(const String& context) {
-    miningContext = context;
+void ClaudeAPI::setPromptCache(bool on) {
+    promptCache = on;
+    Serial.printf("Claude cache du prompt: %s\n", on ? "ON" : "OFF");
 }
 
-String ClaudeAPI::buildRequestBody(const char* message) {
-    JsonDocument doc;
-
+uint32_t ClaudeAPI::buildRequest(JsonDocument& doc, const char* message, bool stream) {
     doc["model"] = CLAUDE_MODEL;
-    doc["max_tokens"] = 100;  // Limite basse pour reponses courtes
-
-    // System prompt pour SATOSHI avec contexte Bitcoin temps reel
-    String systemPrompt = "Tu es SATOSHI, assistant Bitcoin et mining. "
-                         "REGLE ABSOLUE: Reponse en 1-2 phrases, MAX 260 caracteres. "
-                         "Sois direct, pas de bavardage. Francais uniquement.\n\n"
-                         "IMPORTANT - ACTIONS LIGHTNING:\n"
-                         "1. PAIEMENT: Quand l'utilisateur demande d'envoyer des sats/bitcoin:\n"
-                         "   ACTION:PAY:<adresse_lightning>:<montant_sats>\n"
-                         "   Exemple: 'envoie 10 sats a bob@walletofsatoshi.com' ->\n"
-                         "   ACTION:PAY:bob@walletofsatoshi.com:10\n"
-                         "   J'envoie 10 sats a bob!\n\n"
-                         "2. RECEPTION: Quand l'utilisateur demande de recevoir des sats:\n"
-                         "   ACTION:RECEIVE:<montant_sats>\n"
-                         "   Exemple: 'je veux recevoir 100 sats' ->\n"
-                         "   ACTION:RECEIVE:100\n"
-                         "   Voici ton QR code pour recevoir 100 sats!\n\n"
-                         "3. STATS: Quand l'utilisateur demande ses stats wallet:\n"
-                         "   ACTION:STATS\n"
-                         "   Voici tes statistiques!\n\n"
-                         "4. MINING: Pour questions sur la mine/mineurs Bitaxe:\n"
-                         "   ACTION:MINING_STATUS\n"
-                         "   Puis utilise les donnees mining ci-dessous pour repondre.\n\n"
-                         "Mets TOUJOURS la ligne ACTION en PREMIERE ligne, puis ton message.\n"
-                         "L'adresse peut etre Lightning Address (user@domain.com) ou BOLT11 (lnbc...).\n\n";
-
-    // Ajouter le contexte Bitcoin si disponible
-    if (bitcoinContext.length() > 0) {
-        systemPrompt += "DONNEES BITCOIN EN TEMPS REEL (via mempool.space):\n";
-        systemPrompt += bitcoinContext;
-        systemPrompt += "\n";
-    }
-
-    // Ajouter le contexte Mining si disponible
-    if (miningContext.length() > 0) {
-        systemPrompt += "\nDONNEES MINING BITAXE EN TEMPS REEL:\n";
-        systemPrompt += miningContext;
-        systemPrompt += "\n";
-    }
-
-    systemPrompt += "\nUtilise ces donnees pour repondre aux questions.";
-
-    doc["system"] = systemPrompt;
-
+    doc["max_tokens"] = CLAUDE_MAX_TOKENS;
+    if (stream) doc["stream"] = true;
+
+    // Outils puis system prompt: prefixe fixe, mis en cache jusqu'au
+    // cache_control du prompt
+    doc["tools"] = serialized(ClaudeTools::definitions());
+    JsonArray system = doc["system"].to<JsonArray>();
+    JsonObject fixed = system.add<JsonObject>();
+    fixed["type"] = "text";
+    fixed["text"] = CLAUDE_SYSTEM_PROMPT;
+    if (promptCache) fixed["cache_control"]["type"] = "ephemeral";
+
+    // Echanges precedents (relances: "et en euros ?") puis la question
     JsonArray messages = doc["messages"].to<JsonArray>();
+    uint32_t historyTokens = conversationHistory.appendTo(messages);
     JsonObject userMsg = messages.add<JsonObject>();
     userMsg["role"] = "user";
     userMsg["content"] = message;
+    return historyTokens;
+}
+
+ClaudeAPI::ToolCall* ClaudeAPI::addToolCall(const char* id, const char* name) {
+    if (callCount >= CLAUDE_TOOL_CALLS) {
+        Serial.printf("Claude: appel d'outil %s ignore (max %d)\n", name, CLAUDE_TOOL_CALLS);
+        return nullptr;
+    }
+    ToolCall* call = &calls[callCount++];
+    strncpy(call->id, id, CLAUDE_TOOL_ID_LEN - 1);
+    call->id[CLAUDE_TOOL_ID_LEN - 1] = '\0';
+    strncpy(call->name, name, sizeof(call->name) - 1);
+    call->name[sizeof(call->name) - 1] = '\0';
+    call->tool = ClaudeTools::find(name);
+    call->input[0] = '\0';
+    call->inputLen = 0;
+    call->truncated = false;
+    Serial.printf("Claude: outil %s\n", name);
+    return call;
+}
+
+void ClaudeAPI::appendToolResults(JsonDocument& doc, const String& text) {
+    JsonArray messages = doc["messages"];
+
+    // Tour de l'assistant tel que recu: texte eventuel puis appels
+    JsonObject assistant = messages.add<JsonObject>();
+    assistant["role"] = "assistant";
+    JsonArray content = assistant["content"].to<JsonArray>();
+    if (text.length() > 0) {
+        JsonObject block = content.add<JsonObject>();
+        block["type"] = "text";
+        block["text"] = text;
+    }
+
+    JsonObject user = messages.add<JsonObject>();
+    user["role"] = "user";
+    JsonArray results = user["content"].to<JsonArray>();
+
+    for (int i = 0; i < callCount; i++) {
+        ToolCall& call = calls[i];
+        // Arguments vides en flux (outil sans parametre): objet vide
+        JsonDocument input;
+        if (deserializeJson(input, call.input, call.inputLen) || !input.is<JsonObject>()) {
+            input.to<JsonObject>();
+        }
+        JsonObject use = content.add<JsonObject>();
+        use["type"] = "tool_use";
+        use["id"] = call.id;
+        use["name"] = call.name;
+        use["input"] = input;
+
+        String output;
+        bool ok = claudeTools.run(call.tool, output);
+        if (call.tool == CLAUDE_TOOL_NONE) output = "Outil inconnu";
+        if (call.tool < CLAUDE_TOOL_COUNT) toolsUsed |= 1u << call.tool;
+        Serial.printf("Outil %s: %s\n", call.name, output.c_str());
+
+        JsonObject result = results.add<JsonObject>();
+        result["type"] = "tool_result";
+        result["tool_use_id"] = call.id;
+        result["content"] = output;
+        if (!ok) result["is_error"] = true;
+    }
+}
+
+void ClaudeAPI::readUsage(JsonVariant src, ClaudeUsage& dst) {
+    dst.input = src["input_tokens"] | dst.input;
+    dst.cacheWrite = src["cache_creation_input_tokens"] | dst.cacheWrite;
+    dst.cacheRead = src["cache_read_input_tokens"] | dst.cacheRead;
+    dst.output = src["output_tokens"] | dst.output;
+}
 
-    String output;
-    serializeJson(doc, output);
-    return output;
+void ClaudeAPI::recordUsage(uint32_t latencyMs) {
+    int kind = usage.cacheRead > 0 ? 0 : usage.cacheWrite > 0 ? 1 : 2;
+    cacheStats[kind].calls++;
+    cacheStats[kind].latencyMs += latencyMs;
+    usageTotal.input += usage.input;
+    usageTotal.cacheWrite += usage.cacheWrite;
+    usageTotal.cacheRead += usage.cacheRead;
+    usageTotal.output += usage.output;
+    Serial.printf("Claude tokens: %u entree, %u lus du cache, %u ecrits, %u sortie (%u ms)\n",
+                  usage.input, usage.cacheRead, usage.cacheWrite, usage.output, latencyMs);
 }
 
-bool ClaudeAPI::parseResponse(const String& jsonResponse, String& content) {
+bool ClaudeAPI::parseResponse(HttpResponseReader& reader, String& content, bool& keepAlive) {
+    // Blocs de texte et appels d'outils, tokens et message d'erreur
+    // seulement (sans id du message, stop_reason...)
+    JsonDocument filter;
+    filter["error"]["message"] = true;
+    filter["content"][0]["type"] = true;
+    filter["content"][0]["text"] = true;
+    filter["content"][0]["id"] = true;
+    filter["content"][0]["name"] = true;
+    filter["content"][0]["input"] = true;
+    filter["usage"] = true;
+
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, jsonResponse);
+    DeserializationError error = jsonReader.read(reader, doc, &filter, "claude");
+    keepAlive = reader.canReuse();
 
     if (error) {
         lastError = "Erreur JSON: " + String(error.c_str());
@@ -98,63 +237,342 @@ bool ClaudeAPI::parseResponse(const String& jsonResponse, String& content) {
         return false;
     }
 
-    if (doc.containsKey("content") && doc["content"].size() > 0) {
-        content = doc["content"][0]["text"].as<String>();
-        return true;
+    readUsage(doc["usage"], usage);
+
+    size_t before = content.length();
+    for (JsonObject block : doc["content"].as<JsonArray>()) {
+        const char* type = block["type"] | "";
+        if (strcmp(type, "text") == 0) {
+            const char* text = block["text"] | "";
+            if (*text == '\0') continue;
+            if (content.length() > 0) content += "\n";     // Suite d'un texte precedent
+            content += text;
+        } else if (strcmp(type, "tool_use") == 0) {
+            ToolCall* call = addToolCall(block["id"] | "", block["name"] | "");
+            if (!call) continue;
+            if (measureJson(block["input"]) >= CLAUDE_TOOL_INPUT_MAX) {
+                call->truncated = true;
+            } else {
+                call->inputLen = serializeJson(block["input"], call->input, CLAUDE_TOOL_INPUT_MAX);
+            }
+        }
     }
+    if (content.length() > before || callCount > 0) return true;
 
     lastError = "Format de reponse invalide";
     return false;
 }
 
-bool ClaudeAPI::sendMessage(const char* userMessage, String& response) {
-    if (!client) {
-        lastError = "Client non initialise";
+bool ClaudeAPI::readStream(HttpResponseReader& reader, String& content, bool& keepAlive) {
+    keepAlive = false;
+    sse.reset();
+    size_t before = content.length();
+
+    uint8_t buf[CLAUDE_STREAM_CHUNK];
+    while (!stream.stopped && !stream.failed) {
+        size_t n = reader.read(buf, sizeof(buf));
+        if (n == 0) break;
+        sse.feed(buf, n);
+    }
+    if (!stream.stopped && !stream.failed) sse.finish();
+
+    // Apres message_stop il ne reste que la fin du chunked
+    keepAlive = stream.stopped && reader.drain() && reader.canReuse();
+
+    if (stream.failed) return false;
+    if (!stream.stopped) {
+        // Arguments d'outil peut-etre tronques: appels abandonnes
+        callCount = 0;
+        Serial.printf("Claude: flux interrompu apres %u caracteres\n", (unsigned)(content.length() - before));
+        if (content.length() == before) {
+            lastError = reader.hasError() ? String(reader.getError()) : "Flux interrompu";
+            return false;
+        }
+    }
+    return content.length() > before || callCount > 0;
+}
+
+void ClaudeAPI::onSseEvent(const char* event, const char* data, size_t len, void* arg) {
+    ClaudeAPI* self = (ClaudeAPI*)arg;
+    StreamState& s = self->stream;
+
+    if (strcmp(event, "message_stop") == 0) {
+        s.stopped = true;
+        return;
+    }
+    if (strcmp(event, "content_block_stop") == 0) {
+        s.toolCall = -1;
+        return;
+    }
+    bool isError = strcmp(event, "error") == 0;
+    bool isDelta = strcmp(event, "content_block_delta") == 0;
+    bool isStart = strcmp(event, "content_block_start") == 0;
+    // Tokens: entree et cache dans message_start, sortie dans message_delta
+    bool isUsage = strcmp(event, "message_start") == 0 || strcmp(event, "message_delta") == 0;
+    if (!isError && !isDelta && !isStart && !isUsage) return;     // ping...
+
+    JsonDocument filter;
+    filter["delta"]["text"] = true;
+    filter["delta"]["partial_json"] = true;
+    filter["content_block"]["type"] = true;
+    filter["content_block"]["id"] = true;
+    filter["content_block"]["name"] = true;
+    filter["error"]["message"] = true;
+    filter["usage"] = true;
+    filter["message"]["usage"] = true;
+    JsonDocument doc;
+    if (deserializeJson(doc, data, len, DeserializationOption::Filter(filter))) return;
+
+    if (isError) {
+        self->lastError = doc["error"]["message"] | "Erreur du flux";
+        Serial.println("Erreur API (flux): " + self->lastError);
+        s.failed = true;
+        return;
+    }
+    if (isUsage) {
+        readUsage(doc["message"]["usage"], self->usage);
+        readUsage(doc["usage"], self->usage);
+        return;
+    }
+    if (isStart) {
+        // Bloc tool_use: arguments a suivre en input_json_delta
+        const char* type = doc["content_block"]["type"] | "";
+        if (strcmp(type, "tool_use") != 0) return;
+        ToolCall* call = self->addToolCall(doc["content_block"]["id"] | "", doc["content_block"]["name"] | "");
+        s.toolCall = call ? call - self->calls : -1;
+        return;
+    }
+
+    const char* json = doc["delta"]["partial_json"] | (const char*)nullptr;
+    if (json) {
+        if (s.toolCall < 0) return;
+        ToolCall& call = self->calls[s.toolCall];
+        size_t n = strlen(json);
+        // JSON coupe = arguments faux: signale, jamais passe tronque
+        if (call.truncated || call.inputLen + n >= CLAUDE_TOOL_INPUT_MAX) {
+            call.truncated = true;
+            return;
+        }
+        memcpy(call.input + call.inputLen, json, n);
+        call.inputLen += n;
+        call.input[call.inputLen] = '\0';
+        return;
+    }
+
+    const char* text = doc["delta"]["text"] | "";
+    if (*text == '\0' || s.content->length() >= MAX_RESPONSE_LENGTH) return;
+    if (s.firstTokenMs == 0) {
+        s.firstTokenMs = millis() - s.start;
+        if (s.turn) s.turn->markFirstToken();
+        Serial.printf("Claude: premier texte en %u ms\n", s.firstTokenMs);
+    }
+    if (s.separate) {
+        // Texte d'avant l'appel d'outil deja passe: fin de phrase
+        s.separate = false;
+        *s.content += "\n";
+        if (s.onText) s.onText("\n", s.arg);
+    }
+    *s.content += text;
+    if (s.onText) s.onText(text, s.arg);
+}
+
+bool ClaudeAPI::exchange(Client& client, JsonDocument& doc, bool streamed, unsigned long timeoutMs,
+                         String& content, bool& answered, bool& keepAlive, bool& stale) {
+    answered = false;
+    keepAlive = false;
+    stale = false;
+
+    // En-tetes et corps JSON dans le meme tampon: pas de String pour le
+    // corps, premier record TLS plein
+    ClaudeRequestWriter out(client, sendBuffer, sizeof(sendBuffer));
+    out.printf("POST %s HTTP/1.1\r\n"
+               "Host: %s\r\n"
+               "x-api-key: %s\r\n"
+               "anthropic-version: 2023-06-01\r\n"
+               "Content-Type: application/json\r\n"
+               "Content-Length: %u\r\n\r\n",
+               CLAUDE_API_PATH, CLAUDE_API_HOST, configManager.config.anthropic_key,
+               (unsigned)measureJson(doc));
+    serializeJson(doc, out);
+    if (!out.send()) {
+        // Ecriture refusee: socket keep-alive ferme par le serveur
+        stale = true;
+        lastError = "Envoi echoue";
         return false;
     }
 
-    if (strlen(configManager.config.anthropic_key) == 0) {
-        lastError = "Cle API manquante";
+    HttpResponseReader reader(client, timeoutMs);
+    if (!reader.readHeaders()) {
+        stale = reader.isStale();
+        lastError = reader.getError();
         return false;
     }
+    answered = true;
 
-    Serial.println("Envoi a Claude...");
-    Serial.printf("Message: %s\n", userMessage);
+    int httpCode = reader.getStatus();
+    Serial.printf("Code HTTP: %d\n", httpCode);
 
-    HTTPClient https;
-    https.setTimeout(30000);  // 30 secondes timeout
+    // Corps lu directement depuis le socket: evenements SSE, ou JSON
+    // (reponse complete, ou erreur meme en streaming)
+    bool ok = streamed && httpCode == 200
+        ? readStream(reader, content, keepAlive)
+        : parseResponse(reader, content, keepAlive);
 
-    if (!https.begin(*client, CLAUDE_API_URL)) {
-        lastError = "Connexion echouee";
+    if (httpCode != 200) {
+        Serial.println("Erreur response: " + lastError);
+        lastError = "HTTP " + String(httpCode);
         return false;
     }
+    return ok;
+}
 
-    https.addHeader("Content-Type", "application/json");
-    https.addHeader("x-api-key", configManager.config.anthropic_key);
-    https.addHeader("anthropic-version", "2023-06-01");
+bool ClaudeAPI::post(JsonDocument& doc, bool streamed, TurnBudget* turn, String& content, uint32_t& latencyMs) {
+    size_t before = content.length();
+
+    // Socket keep-alive du pool: si le serveur l'a ferme pendant
+    // l'inactivite, l'envoi echoue et la requete est rejouee une fois
+    for (int attempt = 0; attempt < 2; attempt++) {
+        PooledClient* client = connectionPool.acquireForUrl(CLAUDE_API_URL, attempt > 0);
+        if (!client) {
+            lastError = "Connexion echouee";
+            return false;
+        }
+
+        // Recalcule au rejeu: le premier essai a consomme du budget
+        unsigned long timeoutMs = turn ? turn->timeoutFor(TURN_LLM, CLAUDE_TIMEOUT_MS) : CLAUDE_TIMEOUT_MS;
+        bool reused = client->wasReused();
+
+        content.remove(before);
+        callCount = 0;
+        memset(&usage, 0, sizeof(usage));
+        unsigned long start = millis();
+        stream.stopped = false;
+        stream.failed = false;
+        stream.toolCall = -1;
+        stream.separate = before > 0;
+        uint32_t firstBefore = stream.firstTokenMs;
+
+        bool answered, keepAlive, stale;
+        bool ok = exchange(*client, doc, streamed, timeoutMs, content, answered, keepAlive, stale);
+        connectionPool.release(client, keepAlive);
+
+        if (!answered) {
+            if (stale && reused) continue;
+            Serial.printf("Erreur Claude: %s\n", lastError.c_str());
+            return false;
+        }
+
+        if (ok) {
+            // POST -> 1er texte de cette requete, ou reponse complete
+            bool firstHere = streamed && firstBefore == 0 && stream.firstTokenMs > 0;
+            latencyMs = firstHere ? stream.firstTokenMs - (start - stream.start) : millis() - start;
+            recordUsage(latencyMs);
+        }
+        return ok;
+    }
 
-    String requestBody = buildRequestBody(userMessage);
-    Serial.println("Request body:");
-    Serial.println(requestBody);
+    lastError = "Connexion perdue";
+    return false;
+}
 
-    int httpCode = https.POST(requestBody);
+bool ClaudeAPI::sendMessage(const char* userMessage, String& response, TurnBudget* turn,
+                            ClaudeTextFn onText, void* arg) {
+    if (!initialized) {
+        lastError = "Client non initialise";
+        return false;
+    }
 
-    Serial.printf("Code HTTP: %d\n", httpCode);
+    if (strlen(configManager.config.anthropic_key) == 0) {
+        lastError = "Cle API manquante";
+        return false;
+    }
 
-    if (httpCode != 200) {
-        String errorBody = https.getString();
-        Serial.println("Erreur response:");
-        Serial.println(errorBody);
-        lastError = "HTTP " + String(httpCode);
-        https.end();
+    Serial.println("Envoi a Claude...");
+    Serial.printf("Message: %s\n", userMessage);
+
+    bool streamed = onText && streaming;
+    JsonDocument doc;
+    uint32_t historyTokens = buildRequest(doc, userMessage, streamed);
+
+    response = "";
+    action.tool = CLAUDE_TOOL_NONE;
+    action.address = "";
+    toolsUsed = 0;
+    stream = { &response, onText, arg, turn, millis(), 0, false, false, false, -1 };
+
+    // Outils de donnees: resultats renvoyes, Claude repond a la requete
+    // suivante. Outil d'action: fin du message, execute par l'appelant.
+    for (int round = 0; round < CLAUDE_TOOL_ROUNDS; round++) {
+        size_t before = response.length();
+        uint32_t latencyMs = 0;
+        if (!post(doc, streamed, turn, response, latencyMs)) return false;
+        if (round == 0) conversationHistory.recordLatency(historyTokens, latencyMs,
+                                                          usage.input + usage.cacheRead + usage.cacheWrite);
+        if (callCount == 0) break;
+
+        for (int i = 0; i < callCount; i++) {
+            if (!ClaudeTools::isAction(calls[i].tool)) continue;
+            toolsUsed |= 1u << calls[i].tool;
+            // Arguments tronques: erreur, jamais un paiement sans adresse
+            JsonDocument input;
+            bool parsed = !calls[i].truncated && !deserializeJson(input, calls[i].input, calls[i].inputLen);
+            if (!parsed || !claudeTools.parseAction(calls[i].tool, input.as<JsonVariant>(), action)) {
+                lastError = calls[i].truncated || parsed ? "Facture trop longue" : "Arguments d'action invalides";
+                Serial.printf("Claude: %s: %s (%d octets max)\n", calls[i].name, lastError.c_str(),
+                              CLAUDE_TOOL_INPUT_MAX - 1);
+                action.tool = CLAUDE_TOOL_NONE;
+                action.address = "";
+                return false;
+            }
+            break;
+        }
+        if (action.tool != CLAUDE_TOOL_NONE) break;
+
+        if (round == CLAUDE_TOOL_ROUNDS - 1) {
+            Serial.println("Claude: trop de requetes d'outils, reponse partielle");
+            break;
+        }
+        String text = response.substring(before);
+        text.trim();
+        appendToolResults(doc, text);
+    }
+
+    response.trim();
+    if (response.length() == 0 && action.tool == CLAUDE_TOOL_NONE) {
+        lastError = "Reponse vide";
         return false;
     }
 
-    String responseBody = https.getString();
-    Serial.println("Response:");
-    Serial.println(responseBody);
+    // Historique: action sans texte resumee pour les relances
+    if (response.length() > 0) {
+        conversationHistory.addExchange(userMessage, response.c_str());
+    } else {
+        char summary[96];
+        ClaudeTools::describe(action, summary, sizeof(summary));
+        conversationHistory.addExchange(userMessage, summary);
+    }
 
-    https.end();
+    Serial.println("Response:");
+    Serial.println(response);
+    return true;
+}
 
-    return parseResponse(responseBody, response);
+void ClaudeAPI::printStats() {
+    static const char* KINDS[3] = { "cache lu", "cache ecrit", "sans cache" };
+
+    Serial.println("\n=== CLAUDE: CACHE DU PROMPT ===");
+    Serial.printf("Cache: %s, partie fixe %u octets\n", promptCache ? "ON" : "OFF",
+                  (unsigned)strlen(CLAUDE_SYSTEM_PROMPT));
+    Serial.printf("Tokens entree: %u hors cache, %u lus du cache, %u ecrits | sortie: %u\n",
+                  usageTotal.input, usageTotal.cacheRead, usageTotal.cacheWrite, usageTotal.output);
+    Serial.println("Appels        nombre   latence moy (1er texte)");
+    for (int i = 0; i < 3; i++) {
+        const ClaudeCacheStats& c = cacheStats[i];
+        Serial.printf("%-12s  %6u   %6u ms\n", KINDS[i], c.calls, c.calls ? c.latencyMs / c.calls : 0);
+    }
+    if (promptCache && cacheStats[2].calls > 0 && usageTotal.cacheRead == 0 && usageTotal.cacheWrite == 0) {
+        // L'API ignore cache_control sous ce seuil, sans erreur
+        Serial.printf("Rien en cache: prefixe sous %u tokens (minimum du modele)\n", CLAUDE_CACHE_MIN_TOKENS);
+    }
+    Serial.println("===============================\n");
 }
@@ -3,13 +3,47 @@
 #define CLAUDE_API_H
 
 #include <Arduino.h>
-#include <WiFiClientSecure.h>
-#include <HTTPClient.h>
+#include <ArduinoJson.h>
 #include "config.h"
+#include "connection_pool.h"
+#include "json_stream.h"
+#include "turn_budget.h"
+#include "sse_parser.h"
+#include "conversation_history.h"
+#include "claude_tools.h"
 
 #define CLAUDE_API_URL "https://api.anthropic.com/v1/messages"
+#define CLAUDE_API_HOST "api.anthropic.com"
+#define CLAUDE_API_PATH "/v1/messages"
 #define CLAUDE_MODEL "claude-sonnet-4-20250514"
 #define MAX_RESPONSE_LENGTH 2048
+#define CLAUDE_TIMEOUT_MS 30000     // Hors tour vocal (sinon TurnBudget)
+#define CLAUDE_STREAM_CHUNK 256     // Corps SSE lu par blocs
+#define CLAUDE_SEND_BUFFER 1024     // Requete ecrite sur le socket par blocs
+#define CLAUDE_CACHE_MIN_TOKENS 1024    // Prefixe minimum mis en cache (Sonnet)
+#define CLAUDE_MAX_TOKENS 1024      // Texte borne par le prompt; BOLT11 longue ~1 token / 2 car.
+#define CLAUDE_TOOL_ROUNDS 3        // Requetes max par message (donnees puis reponse)
+#define CLAUDE_TOOL_CALLS 4         // Appels d'outils par reponse
+#define CLAUDE_TOOL_ID_LEN 48
+#define CLAUDE_TOOL_INPUT_MAX 2304  // Arguments JSON (pay avec BOLT11 longue), PSRAM
+
+// Texte recu en flux (stream: true), appele sur la tache de sendMessage a
+// chaque delta. text: fragment seul, la reponse complete suit dans response.
+typedef void (*ClaudeTextFn)(const char* text, void* arg);
+
+// Tokens d'un appel (champ usage de la reponse ou de message_start)
+struct ClaudeUsage {
+    uint32_t input;             // Entree hors cache
+    uint32_t cacheWrite;        // Prefixe ecrit dans le cache
+    uint32_t cacheRead;         // Prefixe relu du cache
+    uint32_t output;
+};
+
+// Appels cumules selon l'usage du cache (lu, ecrit, aucun)
+struct ClaudeCacheStats {
+    uint32_t calls;
+    uint32_t latencyMs;         // Somme POST -> 1er texte (reponse complete hors flux)
+};
 
 class ClaudeAPI {
 public:
@@ -17,25 +51,99 @@ public:
 
     void begin();
 
-    // Envoyer un message avec contexte Bitcoin
-    bool sendMessage(const char* userMessage, String& response);
+    // Envoyer un message. Claude appelle les outils de donnees dont il a
+    // besoin (reponse en plusieurs requetes), ou un outil d'action
+    // (getAction). turn: timeout tire du budget du tour vocal (nullptr:
+    // CLAUDE_TIMEOUT_MS). Avec onText (et le streaming actif), reponse en
+    // server-sent events: chaque fragment de texte est passe a onText des
+    // son arrivee.
+    bool sendMessage(const char* userMessage, String& response, TurnBudget* turn = nullptr,
+                     ClaudeTextFn onText = nullptr, void* arg = nullptr);
+
+    // Streaming ON/OFF (/stream): comparer le temps jusqu'au 1er audio
+    void setStreaming(bool on);
+    bool isStreaming() { return streaming; }
+    // Dernier appel en flux: POST -> premier fragment de texte
+    uint32_t getFirstTokenMs() { return stream.firstTokenMs; }
 
-    // Mettre a jour le contexte Bitcoin (prix, fees, etc.)
-    void updateBitcoinContext(const String& context);
+    // Cache du prompt ON/OFF (/cache): cache_control sur la partie fixe
+    void setPromptCache(bool on);
+    bool isPromptCache() { return promptCache; }
+    ClaudeUsage getLastUsage() { return usage; }
+    void printStats();
 
-    // Mettre a jour le contexte Mining (Bitaxe)
-    void updateMiningContext(const String& context);
+    // Dernier message: action demandee (tool CLAUDE_TOOL_NONE sinon) et
+    // outils appeles
+    const ClaudeAction& getAction() { return action; }
+    bool usedTool(ClaudeToolId tool) { return (toolsUsed & (1u << tool)) != 0; }
 
     String getLastError() { return lastError; }
 
 private:
-    WiFiClientSecure* client;
+    bool initialized;
     String lastError;
-    String bitcoinContext;  // Contexte Bitcoin actuel
-    String miningContext;   // Contexte Mining (Bitaxe)
 
-    String buildRequestBody(const char* message);
-    bool parseResponse(const String& jsonResponse, String& content);
+    // Etat de la reponse en flux en cours (une a la fois, tache principale)
+    struct StreamState {
+        String* content;
+        ClaudeTextFn onText;
+        void* arg;
+        TurnBudget* turn;
+        unsigned long start;
+        uint32_t firstTokenMs;
+        bool stopped;           // message_stop recu
+        bool failed;            // evenement error
+        bool separate;          // Texte d'une requete precedente: '\n' avant la suite
+        int toolCall;           // Bloc tool_use en cours (index dans calls), -1 sinon
+    };
+
+    // Appel d'outil d'une reponse; arguments JSON bruts (en flux: fragments
+    // input_json_delta concatenes) dans toolInputs
+    struct ToolCall {
+        char id[CLAUDE_TOOL_ID_LEN];
+        char name[24];
+        ClaudeToolId tool;
+        char* input;            // CLAUDE_TOOL_INPUT_MAX octets
+        size_t inputLen;
+        bool truncated;         // Arguments plus longs que le tampon
+    };
+
+    bool streaming;
+    StreamState stream;
+    SseParser sse;              // Buffers de ligne hors de la pile
+
+    bool promptCache;
+    ClaudeUsage usage;          // Dernier appel
+    ClaudeUsage usageTotal;
+    ClaudeCacheStats cacheStats[3];     // 0: cache lu, 1: ecrit, 2: aucun
+    uint8_t sendBuffer[CLAUDE_SEND_BUFFER];
+
+    ToolCall calls[CLAUDE_TOOL_CALLS];
+    char* toolInputs;           // CLAUDE_TOOL_CALLS x CLAUDE_TOOL_INPUT_MAX (PSRAM)
+    int callCount;
+    ClaudeAction action;
+    uint32_t toolsUsed;         // Bits ClaudeToolId
+
+    // Outils et prompt fixes (flash), echanges precedents et question.
+    // Retourne les tokens d'historique estimes.
+    uint32_t buildRequest(JsonDocument& doc, const char* message, bool stream);
+    // Une requete (rejouee une fois sur socket perime), texte ajoute a content
+    bool post(JsonDocument& doc, bool streamed, TurnBudget* turn, String& content, uint32_t& latencyMs);
+    // Appels de la reponse: assistant (tool_use) puis resultats des outils
+    // de donnees (tool_result) ajoutes a messages pour la requete suivante
+    void appendToolResults(JsonDocument& doc, const String& text);
+    ToolCall* addToolCall(const char* id, const char* name);
+    // Requete ecrite sur le socket, reponse lue. stale: aucune reponse
+    // (socket keep-alive ferme par le serveur), keepAlive: socket reutilisable
+    bool exchange(Client& client, JsonDocument& doc, bool streamed, unsigned long timeoutMs,
+                  String& content, bool& answered, bool& keepAlive, bool& stale);
+    // Reponse (ou erreur) JSON lue en flux
+    bool parseResponse(HttpResponseReader& reader, String& content, bool& keepAlive);
+    // Reponse 200 en server-sent events: deltas de texte vers content et onText
+    bool readStream(HttpResponseReader& reader, String& content, bool& keepAlive);
+    static void readUsage(JsonVariant src, ClaudeUsage& dst);
+    void recordUsage(uint32_t latencyMs);
+    static void onSseEvent(const char* event, const char* data, size_t len, void* arg);
 };
 
 extern ClaudeAPI claudeAPI;
@@ -0,0 +1,234 @@
+// claude_tools.cpp - Outils de Claude (tool use): donnees locales et actions
+#include "claude_tools.h"
+#include "bitcoin_api.h"
+#include "lnbits_api.h"
+#include "mining_manager.h"
+#include "http_executor.h"
+
+ClaudeTools claudeTools;
+
+static const char* const TOOL_NAMES[CLAUDE_TOOL_COUNT] = {
+    "get_price", "get_fees", "get_network", "get_mining_status", "get_wallet_balance",
+    "pay", "receive", "stats"
+};
+
+// Definitions envoyees a chaque requete: meme texte a chaque appel, elles
+// font partie du prefixe mis en cache avec la partie fixe du system prompt
+static const char CLAUDE_TOOLS_JSON[] = R"json([
+{"name":"get_price","description":"Prix actuel du bitcoin en USD et EUR.","input_schema":{"type":"object","properties":{}}},
+{"name":"get_fees","description":"Frais on-chain recommandes en sat/vB (prochain bloc, 30 min, 1 h, economique).","input_schema":{"type":"object","properties":{}}},
+{"name":"get_network","description":"Reseau Bitcoin: hauteur du dernier bloc, mempool, hashrate, taille du reseau Lightning.","input_schema":{"type":"object","properties":{}}},
+{"name":"get_mining_status","description":"Mineurs Bitaxe de l'utilisateur: nombre en ligne, hashrate, consommation, temperature.","input_schema":{"type":"object","properties":{}}},
+{"name":"get_wallet_balance","description":"Solde du wallet Lightning (LNbits) de l'utilisateur.","input_schema":{"type":"object","properties":{}}},
+{"name":"pay","description":"Envoyer des sats depuis le wallet Lightning. L'appareil affiche et confirme le paiement.","input_schema":{"type":"object","properties":{"address":{"type":"string","description":"Lightning Address (user@domain.com) ou facture BOLT11 (lnbc...)"},"amount_sats":{"type":"integer","description":"Montant en sats (celui de la facture pour BOLT11)"}},"required":["address","amount_sats"]}},
+{"name":"receive","description":"Creer une facture Lightning et afficher son QR code pour recevoir des sats.","input_schema":{"type":"object","properties":{"amount_sats":{"type":"integer","description":"Montant en sats"}},"required":["amount_sats"]}},
+{"name":"stats","description":"Afficher les statistiques du wallet (recu/depense sur 7 et 30 jours).","input_schema":{"type":"object","properties":{}}}
+])json";
+
+ClaudeTools::ClaudeTools() {
+    address = nullptr;
+    memset(calls, 0, sizeof(calls));
+    memset(refreshes, 0, sizeof(refreshes));
+    memset(runMs, 0, sizeof(runMs));
+    memset(fetchedAt, 0, sizeof(fetchedAt));
+}
+
+bool ClaudeTools::begin() {
+    if (address) return true;
+    address = psramFound() ? (char*)ps_malloc(TOOL_ADDRESS_MAX) : (char*)malloc(TOOL_ADDRESS_MAX);
+    if (!address) {
+        Serial.println("Outils Claude: tampon d'adresse non alloue, pay indisponible");
+        return false;
+    }
+    address[0] = '\0';
+    return true;
+}
+
+const char* ClaudeTools::definitions() {
+    return CLAUDE_TOOLS_JSON;
+}
+
+ClaudeToolId ClaudeTools::find(const char* name) {
+    for (int i = 0; i < CLAUDE_TOOL_COUNT; i++) {
+        if (strcmp(name, TOOL_NAMES[i]) == 0) return (ClaudeToolId)i;
+    }
+    return CLAUDE_TOOL_NONE;
+}
+
+const char* ClaudeTools::nameOf(ClaudeToolId tool) {
+    return tool < CLAUDE_TOOL_COUNT ? TOOL_NAMES[tool] : "?";
+}
+
+void ClaudeTools::markFresh(ClaudeToolId tool) {
+    if (tool < CLAUDE_TOOL_COUNT) fetchedAt[tool] = millis();
+}
+
+bool ClaudeTools::isStale(ClaudeToolId tool) {
+    bool valid;
+    switch (tool) {
+        case CLAUDE_TOOL_PRICE:   valid = bitcoinAPI.getPrice().valid; break;
+        case CLAUDE_TOOL_FEES:    valid = bitcoinAPI.getFees().valid; break;
+        case CLAUDE_TOOL_NETWORK: valid = bitcoinAPI.getBlockHeight() > 0; break;
+        case CLAUDE_TOOL_WALLET:  valid = lnbitsAPI.getBalance().valid; break;
+        // Mineurs: polling de fond seulement (un Bitaxe injoignable coute 5 s)
+        default: return false;
+    }
+    return !valid || fetchedAt[tool] == 0 || millis() - fetchedAt[tool] > TOOL_MAX_AGE_MS;
+}
+
+bool ClaudeTools::refresh(ClaudeToolId tool) {
+    refreshes[tool]++;
+    bool ok;
+    switch (tool) {
+        case CLAUDE_TOOL_PRICE:
+            ok = bitcoinAPI.fetchPrice();
+            break;
+        case CLAUDE_TOOL_FEES:
+            ok = bitcoinAPI.fetchFees();
+            break;
+        case CLAUDE_TOOL_NETWORK: {
+            // Quatre endpoints en parallele, devant le polling de fond. Futur
+            // encore pris par un appel precedent: pas de nouvelle requete,
+            // donnee non marquee fraiche.
+            static HttpFuture jobs[4];
+            bool submitted[4];
+            submitted[0] = httpExecutor.submit(jobs[0], "hauteur", [](void*) { return bitcoinAPI.fetchBlockHeight(); },
+                                               nullptr, nullptr, HTTP_PRIORITY_INTERACTIVE);
+            submitted[1] = httpExecutor.submit(jobs[1], "mempool", [](void*) { return bitcoinAPI.fetchMempoolInfo(); },
+                                               nullptr, nullptr, HTTP_PRIORITY_INTERACTIVE);
+            submitted[2] = httpExecutor.submit(jobs[2], "hashrate", [](void*) { return bitcoinAPI.fetchHashRate(); },
+                                               nullptr, nullptr, HTTP_PRIORITY_INTERACTIVE);
+            submitted[3] = httpExecutor.submit(jobs[3], "lightning", [](void*) { return bitcoinAPI.fetchLightningStats(); },
+                                               nullptr, nullptr, HTTP_PRIORITY_INTERACTIVE);
+            if (!httpExecutor.waitAll(jobs, 4, TOOL_FETCH_TIMEOUT_MS)) {
+                Serial.println("Outil get_network: requetes encore en cours, donnees partielles");
+            }
+            ok = true;
+            for (int i = 0; i < 4; i++) {
+                if (!submitted[i]) Serial.printf("Outil get_network: %s encore en cours, non relance\n", jobs[i].getName());
+                ok = ok && submitted[i] && !jobs[i].isPending() && jobs[i].succeeded();
+            }
+            break;
+        }
+        case CLAUDE_TOOL_WALLET:
+            ok = lnbitsAPI.fetchBalance();
+            break;
+        default:
+            return false;
+    }
+    // Echec: cache (eventuel) servi, nouvelle tentative au prochain appel
+    if (ok) fetchedAt[tool] = millis();
+    return ok;
+}
+
+bool ClaudeTools::run(ClaudeToolId tool, String& result) {
+    if (tool >= CLAUDE_TOOL_COUNT || isAction(tool)) return false;
+
+    unsigned long start = millis();
+    calls[tool]++;
+    if (isStale(tool)) refresh(tool);
+
+    char buf[160];
+    result = "";
+    switch (tool) {
+        case CLAUDE_TOOL_PRICE: {
+            BitcoinPrice price = bitcoinAPI.getPrice();
+            if (price.valid) {
+                snprintf(buf, sizeof(buf), "Prix: $%.0f USD / %.0f EUR", price.usd, price.eur);
+                result = buf;
+            }
+            break;
+        }
+        case CLAUDE_TOOL_FEES: {
+            BitcoinFees fees = bitcoinAPI.getFees();
+            if (fees.valid) {
+                snprintf(buf, sizeof(buf), "Frais: prochain bloc %d sat/vB, 30 min %d, 1 h %d, economique %d",
+                         fees.fastestFee, fees.halfHourFee, fees.hourFee, fees.economyFee);
+                result = buf;
+            }
+            break;
+        }
+        case CLAUDE_TOOL_NETWORK: {
+            int blockHeight = bitcoinAPI.getBlockHeight();
+            if (blockHeight > 0) {
+                snprintf(buf, sizeof(buf), "Bloc: #%d\n", blockHeight);
+                result += buf;
+            }
+            MempoolInfo mempool = bitcoinAPI.getMempoolInfo();
+            if (mempool.valid) {
+                snprintf(buf, sizeof(buf), "Mempool: %d tx (%.1f MB)\n", mempool.count, mempool.vsize / 1000000.0f);
+                result += buf;
+            }
+            if (bitcoinAPI.getHashRateInfo().valid) {
+                result += "Hashrate: " + bitcoinAPI.formatHashRate() + "\n";
+            }
+            LightningStats lightning = bitcoinAPI.getLightningStats();
+            if (lightning.valid) {
+                snprintf(buf, sizeof(buf), "Lightning: %d noeuds, %.0f BTC\n",
+                         lightning.nodeCount, BitcoinAPI::satsToBTC(lightning.totalCapacity));
+                result += buf;
+            }
+            break;
+        }
+        case CLAUDE_TOOL_MINING:
+            result = miningManager.formatMiningStatus();
+            break;
+        case CLAUDE_TOOL_WALLET:
+            if (lnbitsAPI.getBalance().valid) result = "Wallet LNbits: " + lnbitsAPI.formatBalance();
+            break;
+        default:
+            break;
+    }
+
+    runMs[tool] += millis() - start;
+    if (result.length() == 0) {
+        result = "Donnee indisponible pour le moment";
+        return false;
+    }
+    return true;
+}
+
+bool ClaudeTools::parseAction(ClaudeToolId tool, JsonVariant input, ClaudeAction& action) {
+    calls[tool]++;
+    action.tool = tool;
+    action.address = "";
+    action.amount = input["amount_sats"] | (int64_t)0;
+
+    const char* text = input["address"] | "";
+    size_t len = strlen(text);
+    if (len == 0) return true;
+    // Facture tronquee = paiement impossible: erreur plutot qu'adresse vide
+    if (!address || len >= TOOL_ADDRESS_MAX) {
+        Serial.printf("Outil %s: adresse de %u caracteres refusee (max %d)\n",
+                      nameOf(tool), (unsigned)len, TOOL_ADDRESS_MAX - 1);
+        return false;
+    }
+    memcpy(address, text, len + 1);
+    action.address = address;
+    return true;
+}
+
+void ClaudeTools::describe(const ClaudeAction& action, char* out, size_t size) {
+    switch (action.tool) {
+        case CLAUDE_TOOL_PAY:
+            snprintf(out, size, "(pay: %lld sats vers %.48s)", (long long)action.amount, action.address);
+            break;
+        case CLAUDE_TOOL_RECEIVE:
+            snprintf(out, size, "(receive: facture de %lld sats)", (long long)action.amount);
+            break;
+        default:
+            snprintf(out, size, "(%s)", nameOf(action.tool));
+            break;
+    }
+}
+
+void ClaudeTools::printStats() {
+    Serial.println("\n=== OUTILS CLAUDE ===");
+    Serial.printf("Definitions: %u octets (prefixe cache)\n", (unsigned)strlen(CLAUDE_TOOLS_JSON));
+    Serial.println("Outil                appels  rafraichis  moy");
+    for (int i = 0; i < CLAUDE_TOOL_COUNT; i++) {
+        Serial.printf("%-20s %6u  %10u  %4u ms\n", TOOL_NAMES[i], calls[i], refreshes[i],
+                      calls[i] ? runMs[i] / calls[i] : 0);
+    }
+    Serial.println("=====================\n");
+}
@@ -0,0 +1,83 @@
+// claude_tools.h - Outils de Claude (tool use): donnees locales et actions
+// Le system prompt embarquait a chaque tour tout le contexte Bitcoin et
+// Mining (et askClaude() rafraichissait d'abord les 7 endpoints), et les
+// actions etaient cherchees dans le texte (indexOf("ACTION:PAY:")). Ici
+// Claude recoit des definitions d'outils (constantes en flash, dans le
+// prefixe cache) et n'appelle que ceux dont la question a besoin:
+//  - outils de donnees: servis depuis le cache des APIs, rafraichi a la
+//    demande seulement s'il est absent ou plus vieux que TOOL_MAX_AGE_MS.
+//    Le resultat repart vers Claude (tool_result) pour la reponse.
+//  - outils d'action (pay, receive, stats): arguments types remis a
+//    executeClaudeAction(), le tour s'arrete la.
+#ifndef CLAUDE_TOOLS_H
+#define CLAUDE_TOOLS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define TOOL_MAX_AGE_MS        300000   // Donnee plus vieille: rafraichie avant reponse
+#define TOOL_FETCH_TIMEOUT_MS  10000    // Rafraichissement a la demande
+#define TOOL_ADDRESS_MAX       2048     // Lightning Address ou BOLT11 (route hints: > 500 car.), PSRAM
+
+enum ClaudeToolId {
+    // Donnees (resultat renvoye a Claude)
+    CLAUDE_TOOL_PRICE,
+    CLAUDE_TOOL_FEES,
+    CLAUDE_TOOL_NETWORK,
+    CLAUDE_TOOL_MINING,
+    CLAUDE_TOOL_WALLET,
+    // Actions (executees par l'appareil, fin du tour)
+    CLAUDE_TOOL_PAY,
+    CLAUDE_TOOL_RECEIVE,
+    CLAUDE_TOOL_STATS,
+    CLAUDE_TOOL_COUNT,
+    CLAUDE_TOOL_NONE = CLAUDE_TOOL_COUNT
+};
+
+// Action demandee par Claude, arguments deja extraits du JSON
+struct ClaudeAction {
+    ClaudeToolId tool;          // CLAUDE_TOOL_NONE: aucune action
+    const char* address;        // Tampon PSRAM de ClaudeTools, "" si absente
+    int64_t amount;             // sats
+};
+
+class ClaudeTools {
+public:
+    ClaudeTools();
+
+    // Tampon d'adresse des actions (PSRAM, RAM interne si absente)
+    bool begin();
+
+    // Tableau "tools" de la requete (JSON en flash)
+    static const char* definitions();
+    static ClaudeToolId find(const char* name);
+    static const char* nameOf(ClaudeToolId tool);
+    static bool isAction(ClaudeToolId tool) { return tool >= CLAUDE_TOOL_PAY && tool < CLAUDE_TOOL_COUNT; }
+
+    // Outil de donnees -> texte du tool_result. false si aucune donnee.
+    bool run(ClaudeToolId tool, String& result);
+    // Outil d'action: arguments -> action (validee par executeClaudeAction).
+    // false si l'adresse depasse TOOL_ADDRESS_MAX: jamais tronquee.
+    bool parseAction(ClaudeToolId tool, JsonVariant input, ClaudeAction& action);
+    // Resume d'une action pour l'historique de conversation
+    static void describe(const ClaudeAction& action, char* out, size_t size);
+
+    // Donnee rafraichie hors outil (demarrage, polling de fond)
+    void markFresh(ClaudeToolId tool);
+
+    void printStats();
+
+private:
+    char* address;              // TOOL_ADDRESS_MAX octets
+    uint32_t calls[CLAUDE_TOOL_COUNT];
+    uint32_t refreshes[CLAUDE_TOOL_COUNT];     // Cache absent ou trop vieux
+    uint32_t runMs[CLAUDE_TOOL_COUNT];
+    unsigned long fetchedAt[CLAUDE_TOOL_COUNT];
+
+    bool isStale(ClaudeToolId tool);
+    bool refresh(ClaudeToolId tool);     // true si la donnee a ete relue
+};
+
+extern ClaudeTools claudeTools;
+
+#endif
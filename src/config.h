@@ -51,6 +51,9 @@
 #define AUDIO_BUFFER_SIZE  1024
 #define MAX_RECORDING_TIME 15000
 
+// Pause courte (ms) declenchant une transcription speculative pendant le VAD
+#define SPECULATIVE_STT_PAUSE_MS 250
+
 // ============================================================
 // Configuration SD Card (SDMMC)
 // ============================================================
@@ -0,0 +1,431 @@
+// connection_pool.cpp - Pool de connexions TLS keep-alive partage par les API
+#include "connection_pool.h"
+#include "tls_session_cache.h"
+#include "tls_profile.h"
+#include "dns_cache.h"
+#include "http_executor.h"
+#include <lwip/sockets.h>
+#include <errno.h>
+
+ConnectionPool connectionPool;
+
+// ============================================================
+// PooledClient
+// ============================================================
+
+void PooledClient::close() {
+    WiFiClientSecure::stop();
+}
+
+void PooledClient::stop() {
+    // Hors lecture: destructeur ou end() d'HTTPClient, le pool decide
+    if (reading == 0) return;
+    // Lecture echouee dans WiFiClientSecure: le socket ne servira plus
+    dead = true;
+    close();
+}
+
+bool PooledClient::peerClosed() {
+    if (dead || !sslclient || sslclient->socket < 0) return true;
+    uint8_t probe;
+    int n = recv(sslclient->socket, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0) return true;
+    if (n < 0) return errno != EAGAIN && errno != EWOULDBLOCK;
+    // Octets en attente: close_notify ou reste de reponse, vus par available()
+    return false;
+}
+
+bool PooledClient::connectResumable(const char* host, uint16_t port, bool resume) {
+    dead = false;
+    // Bundle CA lu par le core a la connexion
+    tlsProfile.apply(this);
+
+    // Handshake differe (mode STARTTLS du core): TCP et configuration
+    // mbedtls d'abord, puis suites preferees et session en cache sont
+    // injectees avant le handshake proprement dit
+    setPlainStart();
+    IPAddress ip;
+    bool cached;
+    if (!dnsCache.resolve(host, ip, &cached)) return false;
+    if (!connect(ip, port, host, _CA_cert, _cert, _private_key)) {
+        // Adresse en cache refusee (hote deplace): nouvelle resolution
+        if (!cached) return false;
+        dnsCache.invalidate(host);
+        if (!dnsCache.resolve(host, ip) || !connect(ip, port, host, _CA_cert, _cert, _private_key)) return false;
+    }
+
+    tlsProfile.configure(this);
+    bool offered = resume && tlsSessionCache.offer(host, &sslclient->ssl_ctx);
+
+    unsigned long start = millis();
+    if (!startTLS()) return false;
+    handshakeMs = millis() - start;
+
+    if (resume) tlsSessionCache.save(host, &sslclient->ssl_ctx, offered, handshakeMs);
+    return true;
+}
+
+const char* PooledClient::getCipherSuite() {
+    return sslclient ? mbedtls_ssl_get_ciphersuite(&sslclient->ssl_ctx) : "";
+}
+
+const char* PooledClient::getAlpnProtocol() {
+    return sslclient ? mbedtls_ssl_get_alpn_protocol(&sslclient->ssl_ctx) : nullptr;
+}
+
+// read() et available() encadrent les appels a WiFiClientSecure: un stop()
+// pendant ce temps vient d'une erreur de lecture, pas d'HTTPClient
+// (connected() passe aussi par read(buf, 0))
+int PooledClient::read() {
+    reading++;
+    int c = WiFiClientSecure::read();
+    reading--;
+    if (c >= 0) httpExecutor.chargeBytes(1);
+    return c;
+}
+
+int PooledClient::read(uint8_t* buf, size_t size) {
+    reading++;
+    int n = WiFiClientSecure::read(buf, size);
+    reading--;
+    if (n > 0) httpExecutor.chargeBytes(n);
+    return n;
+}
+
+int PooledClient::available() {
+    reading++;
+    int n = WiFiClientSecure::available();
+    reading--;
+    return n;
+}
+
+size_t PooledClient::write(uint8_t b) {
+    size_t n = WiFiClientSecure::write(b);
+    httpExecutor.chargeBytes(n);
+    return n;
+}
+
+size_t PooledClient::write(const uint8_t* buf, size_t size) {
+    size_t n = WiFiClientSecure::write(buf, size);
+    httpExecutor.chargeBytes(n);
+    return n;
+}
+
+// ============================================================
+// Pool
+// ============================================================
+
+ConnectionPool::ConnectionPool() {
+    memset(slots, 0, sizeof(slots));
+    memset(hostStats, 0, sizeof(hostStats));
+    mutex = xSemaphoreCreateMutex();
+    totalHandshakes = 0;
+    totalReuses = 0;
+    idleEvictions = 0;
+    capEvictions = 0;
+    overflowClients = 0;
+    prewarmOpened = 0;
+    prewarmUsed = 0;
+    prewarmWasted = 0;
+    prewarmSavedMs = 0;
+}
+
+void ConnectionPool::lock() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void ConnectionPool::unlock() {
+    xSemaphoreGive(mutex);
+}
+
+bool ConnectionPool::parseUrl(const String& url, String& host, uint16_t& port) {
+    int start = url.indexOf("://");
+    if (start < 0) return false;
+    port = url.startsWith("https") ? 443 : 80;
+    start += 3;
+
+    int end = url.indexOf('/', start);
+    if (end < 0) end = url.length();
+    host = url.substring(start, end);
+
+    int colon = host.indexOf(':');
+    if (colon >= 0) {
+        port = host.substring(colon + 1).toInt();
+        host = host.substring(0, colon);
+    }
+    return host.length() > 0 && host.length() < POOL_HOST_LEN;
+}
+
+PoolHostStats* ConnectionPool::statsFor(const char* host) {
+    for (int i = 0; i < POOL_MAX_HOSTS; i++) {
+        if (strcmp(hostStats[i].host, host) == 0) return &hostStats[i];
+    }
+    for (int i = 0; i < POOL_MAX_HOSTS; i++) {
+        if (hostStats[i].host[0] == '\0') {
+            strncpy(hostStats[i].host, host, POOL_HOST_LEN - 1);
+            return &hostStats[i];
+        }
+    }
+    // Table pleine: derniere entree partagee
+    return &hostStats[POOL_MAX_HOSTS - 1];
+}
+
+void ConnectionPool::closeSlot(Slot& slot) {
+    if (slot.client) slot.client->close();
+    // Ouvert d'avance puis jamais emprunte
+    if (slot.prewarmed) {
+        prewarmWasted++;
+        slot.prewarmed = false;
+    }
+    slot.open = false;
+    slot.requests = 0;
+}
+
+bool ConnectionPool::isAlive(Slot& slot) {
+    if (millis() - slot.lastUsed > POOL_IDLE_TIMEOUT) return false;
+    // Keep-alive serveur plus court que POOL_IDLE_TIMEOUT (uvicorn: 5 s)
+    if (slot.client->peerClosed()) return false;
+    if (!slot.client->connected() || slot.client->isDead()) return false;
+    // Octets en attente sur un socket inactif: reponse precedente mal lue
+    if (slot.client->available() > 0) return false;
+    return true;
+}
+
+int ConnectionPool::findLruIdle() {
+    int lru = -1;
+    for (int i = 0; i < POOL_MAX_CONNECTIONS; i++) {
+        if (!slots[i].open || slots[i].inUse) continue;
+        if (lru < 0 || slots[i].lastUsed < slots[lru].lastUsed) lru = i;
+    }
+    return lru;
+}
+
+PooledClient* ConnectionPool::acquireForUrl(const String& url, bool fresh) {
+    String host;
+    uint16_t port;
+    if (!parseUrl(url, host, port)) return nullptr;
+    return acquire(host.c_str(), port, fresh);
+}
+
+PooledClient* ConnectionPool::acquire(const char* host, uint16_t port, bool fresh) {
+    return open(host, port, fresh, false);
+}
+
+PooledClient* ConnectionPool::open(const char* host, uint16_t port, bool fresh, bool warming) {
+    lock();
+    PoolHostStats* stats = statsFor(host);
+    if (!warming) stats->requests++;
+
+    // 1. Socket inactif deja ouvert vers cet hote
+    for (int i = 0; i < POOL_MAX_CONNECTIONS && !fresh; i++) {
+        Slot& slot = slots[i];
+        if (!slot.open || slot.inUse || slot.port != port || strcmp(slot.host, host) != 0) continue;
+
+        if (!isAlive(slot)) {
+            stats->stale++;
+            closeSlot(slot);
+            continue;
+        }
+
+        slot.inUse = true;
+        slot.client->reused = true;
+        stats->reuses++;
+        totalReuses++;
+        // Handshake (et DNS) deja payes pendant que l'utilisateur parlait
+        if (slot.prewarmed) {
+            prewarmUsed++;
+            prewarmSavedMs += slot.warmMs;
+            slot.prewarmed = false;
+        }
+        unlock();
+        return slot.client;
+    }
+
+    // 2. Plafond memoire: liberer les sessions inactives les plus anciennes
+    while (ESP.getFreeHeap() < POOL_MIN_FREE_HEAP) {
+        int lru = findLruIdle();
+        if (lru < 0) break;
+        closeSlot(slots[lru]);
+        capEvictions++;
+    }
+
+    // 3. Slot libre, sinon recycler le socket inactif le plus ancien
+    int index = -1;
+    for (int i = 0; i < POOL_MAX_CONNECTIONS; i++) {
+        if (!slots[i].inUse && !slots[i].open) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        index = findLruIdle();
+        if (index >= 0) {
+            closeSlot(slots[index]);
+            capEvictions++;
+        }
+    }
+
+    PooledClient* client;
+    if (index >= 0) {
+        Slot& slot = slots[index];
+        if (!slot.client) slot.client = new PooledClient();
+        strncpy(slot.host, host, POOL_HOST_LEN - 1);
+        slot.port = port;
+        slot.inUse = true;
+        client = slot.client;
+    } else {
+        // Toutes les connexions sont empruntees: client hors pool
+        client = new PooledClient();
+        overflowClients++;
+    }
+    client->reused = false;
+    unlock();
+
+    // Handshake hors verrou: les autres taches continuent d'emprunter
+    unsigned long start = millis();
+    bool ok = client->connectResumable(host, port);
+    uint32_t elapsed = millis() - start;
+
+    lock();
+    if (!ok) {
+        client->close();
+        stats->failures++;
+        if (index >= 0) {
+            slots[index].inUse = false;
+            slots[index].open = false;
+        }
+        unlock();
+        if (index < 0) delete client;
+        Serial.printf("Pool: connexion %s:%d echouee\n", host, port);
+        return nullptr;
+    }
+
+    stats->handshakes++;
+    stats->handshakeMsTotal += elapsed;
+    if (elapsed > stats->handshakeMsMax) stats->handshakeMsMax = elapsed;
+    totalHandshakes++;
+    if (index >= 0) {
+        slots[index].open = true;
+        slots[index].requests = 0;
+        slots[index].prewarmed = warming;
+        slots[index].warmMs = elapsed;
+    }
+    unlock();
+
+    Serial.printf("Pool: handshake %s en %u ms\n", host, elapsed);
+    return client;
+}
+
+bool ConnectionPool::prewarm(const char* host, uint16_t port) {
+    // Socket inactif deja ouvert et encore loin de la fermeture pour inactivite
+    lock();
+    for (int i = 0; i < POOL_MAX_CONNECTIONS; i++) {
+        Slot& slot = slots[i];
+        if (!slot.open || slot.inUse || slot.port != port || strcmp(slot.host, host) != 0) continue;
+        if (isAlive(slot) && millis() - slot.lastUsed < POOL_IDLE_TIMEOUT - POOL_PREWARM_MARGIN) {
+            unlock();
+            return true;
+        }
+    }
+    unlock();
+
+    // Socket neuf: celui qui approche de la fermeture sera evince
+    PooledClient* client = open(host, port, true, true);
+    if (!client) return false;
+
+    // Rendu inactif sans compter de requete
+    lock();
+    for (int i = 0; i < POOL_MAX_CONNECTIONS; i++) {
+        Slot& slot = slots[i];
+        if (slot.client != client) continue;
+        slot.inUse = false;
+        slot.lastUsed = millis();
+        prewarmOpened++;
+        unlock();
+        return true;
+    }
+    unlock();
+
+    // Pool plein: client temporaire inutile
+    client->close();
+    delete client;
+    return false;
+}
+
+void ConnectionPool::release(PooledClient* client, bool keepAlive) {
+    if (!client) return;
+
+    lock();
+    for (int i = 0; i < POOL_MAX_CONNECTIONS; i++) {
+        Slot& slot = slots[i];
+        if (slot.client != client) continue;
+
+        slot.inUse = false;
+        // Reponse lue jusqu'au bout et socket toujours ouvert
+        if (keepAlive && client->connected() && client->available() == 0 && !client->isDead()) {
+            slot.lastUsed = millis();
+            slot.requests++;
+        } else {
+            closeSlot(slot);
+        }
+        unlock();
+        return;
+    }
+    unlock();
+
+    // Client temporaire (pool plein)
+    client->close();
+    delete client;
+}
+
+void ConnectionPool::evictIdle() {
+    lock();
+    for (int i = 0; i < POOL_MAX_CONNECTIONS; i++) {
+        Slot& slot = slots[i];
+        if (slot.open && !slot.inUse && millis() - slot.lastUsed > POOL_IDLE_TIMEOUT) {
+            closeSlot(slot);
+            idleEvictions++;
+        }
+    }
+    unlock();
+}
+
+void ConnectionPool::closeAll() {
+    lock();
+    for (int i = 0; i < POOL_MAX_CONNECTIONS; i++) {
+        if (slots[i].open && !slots[i].inUse) closeSlot(slots[i]);
+    }
+    unlock();
+}
+
+int ConnectionPool::getOpenCount() {
+    int count = 0;
+    for (int i = 0; i < POOL_MAX_CONNECTIONS; i++) {
+        if (slots[i].open) count++;
+    }
+    return count;
+}
+
+void ConnectionPool::printStats() {
+    Serial.println("\n=== POOL CONNEXIONS TLS ===");
+    uint32_t requests = totalHandshakes + totalReuses;
+    Serial.printf("Ouvertes: %d/%d | Heap libre: %u\n", getOpenCount(), POOL_MAX_CONNECTIONS, ESP.getFreeHeap());
+    Serial.printf("Handshakes: %u | Reutilisations: %u (%.0f%%)\n", totalHandshakes, totalReuses,
+                  requests ? 100.0f * totalReuses / requests : 0.0f);
+    Serial.printf("Fermetures: %u inactives, %u plafond, %u hors pool\n",
+                  idleEvictions, capEvictions, overflowClients);
+    Serial.printf("Pre-chauffage: %u ouvertes, %u utilisees, %u perdues | %u ms economises (moy %u ms)\n",
+                  prewarmOpened, prewarmUsed, prewarmWasted, prewarmSavedMs,
+                  prewarmUsed ? prewarmSavedMs / prewarmUsed : 0);
+
+    for (int i = 0; i < POOL_MAX_HOSTS; i++) {
+        const PoolHostStats& s = hostStats[i];
+        if (s.host[0] == '\0') continue;
+        uint32_t served = s.handshakes + s.reuses;
+        Serial.printf("  %-24s req %3u | hs %3u (moy %4u ms, max %4u ms) | reuse %3.0f%% | perimes %u | echecs %u\n",
+                      s.host, s.requests, s.handshakes,
+                      s.handshakes ? s.handshakeMsTotal / s.handshakes : 0, s.handshakeMsMax,
+                      served ? 100.0f * s.reuses / served : 0.0f, s.stale, s.failures);
+    }
+    Serial.println("===========================\n");
+}
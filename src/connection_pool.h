@@ -0,0 +1,147 @@
+// connection_pool.h - Pool de connexions TLS keep-alive partage par les API
+// Chaque module ouvrait son propre WiFiClientSecure et payait un handshake
+// complet (300-1000 ms sur S3) a presque chaque requete. Le pool garde les
+// sockets HTTP/1.1 ouverts par hote (api.groq.com, api.anthropic.com,
+// mempool.space, hote LNbits), les ferme apres POOL_IDLE_TIMEOUT et borne
+// leur nombre et la RAM interne qu'ils consomment (~40 Ko par session TLS).
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+
+#define POOL_MAX_CONNECTIONS   4        // Sessions TLS ouvertes simultanement
+#define POOL_MAX_HOSTS         8        // Hotes suivis dans les stats
+#define POOL_HOST_LEN          64
+#define POOL_IDLE_TIMEOUT      30000    // Sous le keep-alive serveur (60-75 s)
+#define POOL_MIN_FREE_HEAP     60000    // RAM interne a garder avant d'ouvrir
+#define POOL_PREWARM_MARGIN    10000    // Socket pre-chauffe: vie restante minimale
+
+// Client TLS emprunte au pool.
+// HTTPClient appelle stop() dans son destructeur, meme apres une reponse
+// keep-alive: cet appel est ignore, seul le pool ferme le socket (release
+// avec keepAlive = false, reponse non lue, inactivite, serveur deconnecte).
+// WiFiClientSecure appelle aussi stop() lui-meme quand une lecture echoue
+// (pair ferme, close_notify): ce stop-la ferme vraiment le socket et le
+// marque mort, le pool ne le rendra plus.
+// Apres une erreur de transport, rendre le client avec keepAlive = false.
+class PooledClient : public WiFiClientSecure {
+public:
+    PooledClient() : reused(false), handshakeMs(0), dead(false), reading(0) {}
+
+    void stop() override;
+    void close();   // Fermeture reelle (pool uniquement)
+    // Socket ferme par le serveur ou lecture TLS echouee
+    bool isDead() { return dead; }
+    // FIN recu sur un socket inactif (recv non bloquant, sans consommer)
+    bool peerClosed();
+
+    // Connexion avec le profil TLS (tlsProfile) et reprise de session
+    // (tlsSessionCache, sauf resume = false)
+    bool connectResumable(const char* host, uint16_t port, bool resume = true);
+    uint32_t getHandshakeMs() { return handshakeMs; }
+    const char* getCipherSuite();
+    // Protocole choisi par ALPN (setAlpnProtocols), nullptr sans ALPN
+    const char* getAlpnProtocol();
+
+    // Connexion deja ouverte avant acquire(): un echec d'envoi peut venir
+    // d'un socket ferme par le serveur, la requete peut etre rejouee
+    bool wasReused() { return reused; }
+
+    // Octets comptes pour le job de l'executeur HTTP en cours (budget du
+    // fond). Donnees applicatives seulement: pas le handshake TLS.
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int available() override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    using WiFiClientSecure::write;
+
+private:
+    friend class ConnectionPool;
+    friend class TlsProfile;
+    bool reused;
+    uint32_t handshakeMs;
+    bool dead;
+    int reading;                // > 0: dans une lecture de WiFiClientSecure
+};
+
+struct PoolHostStats {
+    char host[POOL_HOST_LEN];
+    uint32_t requests;
+    uint32_t handshakes;        // Connexions TLS ouvertes
+    uint32_t reuses;            // Requetes sur un socket deja ouvert
+    uint32_t stale;             // Socket ferme par le serveur pendant l'inactivite
+    uint32_t failures;          // Connexions echouees
+    uint32_t handshakeMsTotal;
+    uint32_t handshakeMsMax;
+};
+
+class ConnectionPool {
+public:
+    ConnectionPool();
+
+    // Connexion ouverte vers host:port (reutilisee si possible).
+    // fresh = true force un nouveau socket (rejeu apres socket perime).
+    PooledClient* acquire(const char* host, uint16_t port = 443, bool fresh = false);
+    PooledClient* acquireForUrl(const String& url, bool fresh = false);
+
+    // Ouvrir d'avance une connexion inactive vers host:port (rien si un
+    // socket ouvert attend deja). Appel bloquant, depuis une tache de fond.
+    bool prewarm(const char* host, uint16_t port = 443);
+
+    // Rendre la connexion. keepAlive = false si la reponse n'a pas ete lue
+    // entierement ou si le serveur a demande "Connection: close".
+    void release(PooledClient* client, bool keepAlive = true);
+
+    // Fermer les connexions inactives depuis POOL_IDLE_TIMEOUT (loop)
+    void evictIdle();
+    void closeAll();
+
+    uint32_t getHandshakes() { return totalHandshakes; }
+    uint32_t getReuses() { return totalReuses; }
+    int getOpenCount();
+    void printStats();
+
+    // "https://host[:port]/path" -> host, port
+    static bool parseUrl(const String& url, String& host, uint16_t& port);
+
+private:
+    struct Slot {
+        PooledClient* client;   // Alloue au premier usage puis recycle
+        char host[POOL_HOST_LEN];
+        uint16_t port;
+        bool inUse;
+        bool open;
+        unsigned long lastUsed;
+        uint32_t requests;      // Requetes servies par ce socket
+        bool prewarmed;         // Ouvert par prewarm(), pas encore emprunte
+        uint32_t warmMs;        // DNS + handshake payes a l'ouverture
+    };
+
+    Slot slots[POOL_MAX_CONNECTIONS];
+    PoolHostStats hostStats[POOL_MAX_HOSTS];
+    SemaphoreHandle_t mutex;
+
+    uint32_t totalHandshakes;
+    uint32_t totalReuses;
+    uint32_t idleEvictions;
+    uint32_t capEvictions;      // Fermees pour tenir le plafond memoire/slots
+    uint32_t overflowClients;   // Pool plein: client temporaire hors pool
+    uint32_t prewarmOpened;
+    uint32_t prewarmUsed;
+    uint32_t prewarmWasted;     // Fermes sans avoir servi
+    uint32_t prewarmSavedMs;
+
+    void lock();
+    void unlock();
+    PooledClient* open(const char* host, uint16_t port, bool fresh, bool warming);
+    PoolHostStats* statsFor(const char* host);
+    void closeSlot(Slot& slot);
+    int findLruIdle();
+    bool isAlive(Slot& slot);
+};
+
+extern ConnectionPool connectionPool;
+
+#endif
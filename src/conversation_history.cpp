@@ -0,0 +1,185 @@
+// conversation_history.cpp - Memoire de conversation bornee pour Claude
+#include "conversation_history.h"
+
+ConversationHistory conversationHistory;
+
+ConversationHistory::ConversationHistory() {
+    arena = nullptr;
+    memset(messages, 0, sizeof(messages));
+    head = 0;
+    count = 0;
+    tail = 0;
+    tokens = 0;
+    lastExchange = 0;
+    enabled = true;
+    exchanges = 0;
+    evicted = 0;
+    expired = 0;
+    memset(buckets, 0, sizeof(buckets));
+}
+
+bool ConversationHistory::begin() {
+    if (arena) return true;
+    arena = psramFound() ? (uint8_t*)ps_malloc(HISTORY_ARENA_SIZE) : (uint8_t*)malloc(HISTORY_ARENA_SIZE);
+    if (!arena) {
+        Serial.println("Historique: arene non allouee, conversation sans memoire");
+        return false;
+    }
+    Serial.printf("Historique: arene %u octets, budget %u tokens\n", HISTORY_ARENA_SIZE, HISTORY_TOKEN_BUDGET);
+    return true;
+}
+
+uint32_t ConversationHistory::estimateTokens(size_t chars) {
+    return (chars + HISTORY_CHARS_PER_TOKEN - 1) / HISTORY_CHARS_PER_TOKEN + HISTORY_MESSAGE_TOKENS;
+}
+
+void ConversationHistory::clear() {
+    head = 0;
+    count = 0;
+    tail = 0;
+    tokens = 0;
+}
+
+void ConversationHistory::evictOldest() {
+    // Echange complet: l'historique commence toujours par une question
+    for (int i = 0; i < 2 && count > 0; i++) {
+        tokens -= messages[head].tokens;
+        head = (head + 1) % HISTORY_MAX_MESSAGES;
+        count--;
+    }
+    if (count == 0) clear();
+    evicted++;
+}
+
+bool ConversationHistory::reserve(size_t size, size_t& pos) {
+    for (;;) {
+        if (count == 0) {
+            pos = 0;
+            return true;
+        }
+        const Message& oldest = messages[head];
+        if (tail > oldest.offset) {
+            // Textes contigus [oldest, tail): libre apres tail, puis avant oldest
+            if (tail + size <= HISTORY_ARENA_SIZE) {
+                pos = tail;
+                return true;
+            }
+            if (size <= oldest.offset) {
+                pos = 0;
+                return true;
+            }
+        } else if (tail + size <= oldest.offset) {
+            // Anneau replie: libre entre tail et le plus ancien
+            pos = tail;
+            return true;
+        }
+        // Seule la question en cours reste: ne pas l'oublier
+        if (count < 2) return false;
+        evictOldest();
+    }
+}
+
+bool ConversationHistory::add(bool assistant, const char* text) {
+    size_t len = strlen(text);
+    if (len >= HISTORY_MESSAGE_MAX) len = HISTORY_MESSAGE_MAX - 1;
+
+    if (count == HISTORY_MAX_MESSAGES) evictOldest();
+    size_t pos;
+    if (!reserve(len + 1, pos)) return false;
+
+    memcpy(arena + pos, text, len);
+    arena[pos + len] = '\0';
+
+    Message& m = messages[(head + count) % HISTORY_MAX_MESSAGES];
+    m.offset = pos;
+    m.length = len;
+    m.tokens = estimateTokens(len);
+    m.assistant = assistant;
+    count++;
+    tail = pos + len + 1;
+    tokens += m.tokens;
+    return true;
+}
+
+void ConversationHistory::addExchange(const char* question, const char* answer) {
+    if (!enabled || !arena || !question || !answer || !*question || !*answer) return;
+
+    if (!add(false, question) || !add(true, answer)) {
+        // Paire incomplete: repartir d'un historique vide plutot que
+        // d'envoyer deux questions de suite
+        clear();
+        return;
+    }
+    exchanges++;
+    lastExchange = millis();
+
+    // Budget: les plus anciens d'abord, le dernier echange reste
+    while (tokens > HISTORY_TOKEN_BUDGET && count > 2) evictOldest();
+}
+
+uint32_t ConversationHistory::appendTo(JsonArray out) {
+    if (!enabled || count == 0) return 0;
+
+    if (millis() - lastExchange > HISTORY_IDLE_MS) {
+        Serial.println("Historique: conversation inactive, oubliee");
+        clear();
+        expired++;
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const Message& m = messages[(head + i) % HISTORY_MAX_MESSAGES];
+        JsonObject msg = out.add<JsonObject>();
+        msg["role"] = m.assistant ? "assistant" : "user";
+        msg["content"] = (const char*)(arena + m.offset);
+    }
+    Serial.printf("Historique: %d messages, ~%u tokens\n", count, tokens);
+    return tokens;
+}
+
+void ConversationHistory::recordLatency(uint32_t historyTokens, uint32_t latencyMs, uint32_t inputTokens) {
+    // 0: sans historique, puis tiers du budget (le dernier deborde)
+    int bucket = 0;
+    if (historyTokens > 0) {
+        bucket = 1 + (historyTokens - 1) * (HISTORY_BUCKETS - 1) / HISTORY_TOKEN_BUDGET;
+        if (bucket >= HISTORY_BUCKETS) bucket = HISTORY_BUCKETS - 1;
+    }
+    buckets[bucket].calls++;
+    buckets[bucket].latencyMs += latencyMs;
+    buckets[bucket].inputTokens += inputTokens;
+}
+
+void ConversationHistory::setEnabled(bool on) {
+    enabled = on;
+    if (!on) clear();
+    Serial.printf("Memoire de conversation: %s\n", on ? "ON" : "OFF");
+}
+
+void ConversationHistory::printStats() {
+    size_t used = 0;
+    for (int i = 0; i < count; i++) used += messages[(head + i) % HISTORY_MAX_MESSAGES].length + 1;
+
+    Serial.println("\n=== MEMOIRE DE CONVERSATION ===");
+    Serial.printf("Etat: %s, %d messages, ~%u / %u tokens\n", enabled ? "ON" : "OFF",
+                  count, tokens, HISTORY_TOKEN_BUDGET);
+    Serial.printf("Arene: %u / %u octets (%s)\n", (unsigned)used, HISTORY_ARENA_SIZE,
+                  !arena ? "absente" : psramFound() ? "PSRAM" : "RAM interne");
+    Serial.printf("Echanges: %u, oublies: %u, conversations expirees: %u\n", exchanges, evicted, expired);
+
+    Serial.println("Historique envoye   appels  latence moy  tokens entree moy");
+    uint32_t step = HISTORY_TOKEN_BUDGET / (HISTORY_BUCKETS - 1);
+    for (int i = 0; i < HISTORY_BUCKETS; i++) {
+        char label[24];
+        if (i == 0) {
+            snprintf(label, sizeof(label), "aucun");
+        } else if (i < HISTORY_BUCKETS - 1) {
+            snprintf(label, sizeof(label), "%u-%u tokens", (i - 1) * step + 1, i * step);
+        } else {
+            snprintf(label, sizeof(label), "> %u tokens", (i - 1) * step);
+        }
+        const HistoryLatencyStats& b = buckets[i];
+        Serial.printf("%-18s  %6u  %8u ms  %17u\n", label, b.calls,
+                      b.calls ? b.latencyMs / b.calls : 0, b.calls ? b.inputTokens / b.calls : 0);
+    }
+    Serial.println("===============================\n");
+}
@@ -0,0 +1,85 @@
+// conversation_history.h - Memoire de conversation bornee pour Claude
+// Chaque sendMessage n'envoyait que la question du moment: une relance
+// ("et en euros ?") perdait son contexte. Ici les derniers echanges
+// question/reponse sont gardes dans une arene PSRAM allouee une fois
+// (anneau de textes, sans String ni fragmentation) et renvoyes dans le
+// tableau messages. Le nombre de tokens est estime a la volee (~4
+// caracteres par token): au-dela du budget, les echanges les plus anciens
+// sont oublies, par paires (les messages restent user/assistant alternes).
+#ifndef CONVERSATION_HISTORY_H
+#define CONVERSATION_HISTORY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define HISTORY_ARENA_SIZE      8192     // Textes des messages (PSRAM)
+#define HISTORY_MAX_MESSAGES    24       // 12 echanges
+#define HISTORY_MESSAGE_MAX     1024     // Texte tronque au-dela (question dictee)
+#define HISTORY_TOKEN_BUDGET    600      // Tokens d'historique envoyes au plus
+#define HISTORY_CHARS_PER_TOKEN 4        // Estimation (francais, sans tokenizer)
+#define HISTORY_MESSAGE_TOKENS  4        // Surcout par message (role, separateurs)
+#define HISTORY_IDLE_MS         600000   // 10 min sans echange: nouvelle conversation
+#define HISTORY_BUCKETS         4        // Latence par taille d'historique envoye
+
+// Appels Claude groupes par taille d'historique (en quarts du budget)
+struct HistoryLatencyStats {
+    uint32_t calls;
+    uint32_t latencyMs;         // Somme POST -> 1er texte
+    uint32_t inputTokens;       // Somme des tokens d'entree annonces par l'API
+};
+
+class ConversationHistory {
+public:
+    ConversationHistory();
+
+    // Arene PSRAM (RAM interne si absente)
+    bool begin();
+
+    // Echange termine: question puis reponse, oldest-first si plein
+    void addExchange(const char* question, const char* answer);
+    // Messages gardes, du plus ancien au plus recent, vers le tableau
+    // messages de la requete. Retourne les tokens estimes ajoutes.
+    uint32_t appendTo(JsonArray messages);
+    void clear();
+
+    // Latence d'un appel selon l'historique envoye (appendTo)
+    void recordLatency(uint32_t historyTokens, uint32_t latencyMs, uint32_t inputTokens);
+
+    void setEnabled(bool on);
+    bool isEnabled() { return enabled; }
+    uint32_t getTokens() { return tokens; }
+    int getMessageCount() { return count; }
+    void printStats();
+
+    static uint32_t estimateTokens(size_t chars);
+
+private:
+    struct Message {
+        uint16_t offset;        // Texte dans l'arene, termine par '\0'
+        uint16_t length;
+        uint16_t tokens;
+        bool assistant;
+    };
+
+    uint8_t* arena;
+    Message messages[HISTORY_MAX_MESSAGES];
+    int head;                   // Plus ancien message
+    int count;
+    size_t tail;                // Fin du texte le plus recent dans l'arene
+    uint32_t tokens;            // Somme estimee des messages gardes
+    unsigned long lastExchange;
+    bool enabled;
+
+    uint32_t exchanges;
+    uint32_t evicted;           // Echanges oublies (budget ou place)
+    uint32_t expired;           // Conversations closes par inactivite
+    HistoryLatencyStats buckets[HISTORY_BUCKETS];
+
+    bool add(bool assistant, const char* text);
+    bool reserve(size_t size, size_t& pos);
+    void evictOldest();
+};
+
+extern ConversationHistory conversationHistory;
+
+#endif
@@ -0,0 +1,270 @@
+// corpus_recorder.cpp - Corpus audio terrain sur carte SD (SDMMC 4 bits)
+#include "corpus_recorder.h"
+#include <SD_MMC.h>
+#include <ArduinoJson.h>
+
+CorpusRecorder corpusRecorder;
+
+static const char* const SOURCE_NAMES[] = { "wake", "command" };
+static const char* const EVENT_NAMES[] = {
+    "speech_start", "pause", "resume", "speculative", "end", "timeout"
+};
+
+CorpusRecorder::CorpusRecorder() {
+    enabled = false;
+    mounted = false;
+    bootId = 0;
+    nextSeq = 0;
+    current = nullptr;
+    queue = nullptr;
+    writerTask = nullptr;
+    clipsWritten = 0;
+    clipsDropped = 0;
+    bytesWritten = 0;
+    lastWriteMs = 0;
+}
+
+bool CorpusRecorder::begin() {
+    prefs.begin("corpus", false);
+    enabled = prefs.getBool("enabled", false);
+    // Numero de demarrage: les noms de fichiers ne se recouvrent pas
+    bootId = prefs.getUInt("boot", 0) + 1;
+    prefs.putUInt("boot", bootId);
+    prefs.end();
+
+    if (!enabled) {
+        return true;
+    }
+    return mount();
+}
+
+bool CorpusRecorder::mount() {
+    if (mounted) return true;
+
+    // Bus 4 bits (pins FNK0104)
+    if (!SD_MMC.setPins(PIN_SD_CLK, PIN_SD_CMD, PIN_SD_D0, PIN_SD_D1, PIN_SD_D2, PIN_SD_D3)) {
+        Serial.println("Corpus: pins SDMMC refuses");
+        return false;
+    }
+    if (!SD_MMC.begin("/sdcard", false)) {
+        Serial.println("Corpus: carte SD absente");
+        return false;
+    }
+
+    if (!SD_MMC.exists(CORPUS_DIR)) {
+        SD_MMC.mkdir(CORPUS_DIR);
+    }
+
+    if (!queue) {
+        queue = xQueueCreate(CORPUS_QUEUE_LEN, sizeof(CorpusClip*));
+    }
+    if (!writerTask) {
+        // Core 0, priorite basse: ne concurrence ni la capture ni l'UI
+        xTaskCreatePinnedToCore(writerLoop, "corpus_sd", 6144, this, 1, &writerTask, 0);
+    }
+
+    mounted = true;
+    Serial.printf("Corpus: SD %llu MB, libre %llu MB, boot %u\n",
+                  SD_MMC.totalBytes() / (1024 * 1024),
+                  (SD_MMC.totalBytes() - SD_MMC.usedBytes()) / (1024 * 1024),
+                  bootId);
+    return true;
+}
+
+void CorpusRecorder::setEnabled(bool enabled) {
+    this->enabled = enabled;
+
+    prefs.begin("corpus", false);
+    prefs.putBool("enabled", enabled);
+    prefs.end();
+
+    if (enabled) {
+        mount();
+    } else {
+        discardClip();
+    }
+}
+
+// ============================================================
+// Construction du clip (tache loop, aucun acces SD)
+// ============================================================
+
+void CorpusRecorder::beginClip(CorpusSource source, int threshold) {
+    if (!isActive()) return;
+
+    discardClip();
+
+    current = new CorpusClip();
+    current->source = source;
+    current->seq = nextSeq++;
+    current->startMs = millis();
+    current->threshold = threshold;
+    current->audio = nullptr;
+    current->audioSize = 0;
+    current->eventCount = 0;
+    current->captureMs = 0;
+    current->sttMs = 0;
+    current->speculative = false;
+}
+
+void CorpusRecorder::logVad(CorpusVadEvent event, int energy) {
+    if (!current || current->eventCount >= CORPUS_MAX_EVENTS) return;
+
+    CorpusEventRecord& rec = current->events[current->eventCount++];
+    rec.ms = millis() - current->startMs;
+    rec.type = event;
+    rec.energy = energy;
+}
+
+void CorpusRecorder::captureAudio(const uint8_t* audio, size_t size) {
+    if (!current || !audio || size == 0) return;
+
+    current->captureMs = millis() - current->startMs;
+
+    if (current->audio) free(current->audio);
+    current->audio = (uint8_t*)ps_malloc(size);
+    if (!current->audio) {
+        current->audioSize = 0;
+        return;
+    }
+    memcpy(current->audio, audio, size);
+    current->audioSize = size;
+}
+
+void CorpusRecorder::setTranscript(const String& text, unsigned long sttMs, bool speculative) {
+    if (!current) return;
+
+    current->transcript = text;
+    current->sttMs = sttMs;
+    current->speculative = speculative;
+}
+
+void CorpusRecorder::commitClip(const char* outcome) {
+    if (!current) return;
+
+    CorpusClip* clip = current;
+    current = nullptr;
+    clip->outcome = outcome;
+
+    if (!clip->audio || !queue || xQueueSend(queue, &clip, 0) != pdTRUE) {
+        // File pleine (carte lente) ou PSRAM epuisee: on perd ce clip
+        clipsDropped++;
+        freeClip(clip);
+    }
+}
+
+void CorpusRecorder::discardClip() {
+    if (current) {
+        freeClip(current);
+        current = nullptr;
+    }
+}
+
+void CorpusRecorder::freeClip(CorpusClip* clip) {
+    if (clip->audio) free(clip->audio);
+    delete clip;
+}
+
+// ============================================================
+// Ecriture SD (tache dediee)
+// ============================================================
+
+void CorpusRecorder::writerLoop(void* param) {
+    CorpusRecorder* self = (CorpusRecorder*)param;
+    CorpusClip* clip;
+
+    for (;;) {
+        if (xQueueReceive(self->queue, &clip, portMAX_DELAY) != pdTRUE) continue;
+
+        if (!self->writeClip(clip)) {
+            self->clipsDropped++;
+        }
+        self->freeClip(clip);
+    }
+}
+
+bool CorpusRecorder::writeClip(CorpusClip* clip) {
+    uint64_t freeBytes = SD_MMC.totalBytes() - SD_MMC.usedBytes();
+    if (freeBytes < (uint64_t)CORPUS_MIN_FREE_MB * 1024 * 1024) {
+        return false;
+    }
+
+    unsigned long start = millis();
+
+    char base[64];
+    snprintf(base, sizeof(base), "%s/%04u_%05u_%s", CORPUS_DIR,
+             bootId, clip->seq, SOURCE_NAMES[clip->source]);
+
+    // Audio: WAV 16 kHz mono 16 bits
+    String wavPath = String(base) + ".wav";
+    File wav = SD_MMC.open(wavPath, FILE_WRITE);
+    if (!wav) return false;
+
+    uint32_t dataSize = clip->audioSize;
+    uint32_t byteRate = AUDIO_SAMPLE_RATE * 2;
+    uint8_t header[44] = {
+        'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 16, 0,
+        'd', 'a', 't', 'a', 0, 0, 0, 0
+    };
+    uint32_t riffSize = dataSize + 36;
+    memcpy(header + 4, &riffSize, 4);
+    uint32_t rate = AUDIO_SAMPLE_RATE;
+    memcpy(header + 24, &rate, 4);
+    memcpy(header + 28, &byteRate, 4);
+    memcpy(header + 40, &dataSize, 4);
+
+    wav.write(header, sizeof(header));
+    size_t written = wav.write(clip->audio, clip->audioSize);
+    wav.close();
+    if (written != clip->audioSize) return false;
+
+    // Annexe JSON: decisions VAD, transcription, timings
+    JsonDocument doc;
+    doc["boot"] = bootId;
+    doc["seq"] = clip->seq;
+    doc["source"] = SOURCE_NAMES[clip->source];
+    doc["sample_rate"] = AUDIO_SAMPLE_RATE;
+    doc["samples"] = clip->audioSize / 2;
+    doc["uptime_ms"] = clip->startMs;
+    doc["outcome"] = clip->outcome;
+    doc["transcript"] = clip->transcript;
+
+    JsonObject timings = doc["timings"].to<JsonObject>();
+    timings["capture_ms"] = clip->captureMs;
+    timings["stt_ms"] = clip->sttMs;
+    timings["speculative"] = clip->speculative;
+
+    JsonObject vad = doc["vad"].to<JsonObject>();
+    vad["threshold"] = clip->threshold;
+    JsonArray events = vad["events"].to<JsonArray>();
+    for (int i = 0; i < clip->eventCount; i++) {
+        JsonObject ev = events.add<JsonObject>();
+        ev["t"] = clip->events[i].ms;
+        ev["ev"] = EVENT_NAMES[clip->events[i].type];
+        ev["e"] = clip->events[i].energy;
+    }
+
+    String jsonPath = String(base) + ".json";
+    File json = SD_MMC.open(jsonPath, FILE_WRITE);
+    if (!json) return false;
+    size_t jsonSize = serializeJson(doc, json);
+    json.close();
+
+    clipsWritten++;
+    bytesWritten += sizeof(header) + written + jsonSize;
+    lastWriteMs = millis() - start;
+    return true;
+}
+
+void CorpusRecorder::printStats() {
+    Serial.println("\n=== CORPUS AUDIO ===");
+    Serial.printf("Etat: %s, carte %s\n", enabled ? "ON" : "OFF", mounted ? "montee" : "absente");
+    Serial.printf("Clips ecrits: %u, perdus: %u\n", clipsWritten, clipsDropped);
+    Serial.printf("Donnees: %u KB, derniere ecriture %u ms\n", bytesWritten / 1024, lastWriteMs);
+    if (mounted) {
+        Serial.printf("Libre: %llu MB\n", (SD_MMC.totalBytes() - SD_MMC.usedBytes()) / (1024 * 1024));
+    }
+    Serial.println("====================\n");
+}
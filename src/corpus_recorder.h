@@ -0,0 +1,107 @@
+// corpus_recorder.h - Enregistrement d'un corpus audio terrain sur carte SD
+// Chaque candidat wake word et chaque commande vocale est ecrit en WAV
+// avec un fichier JSON annexe (decisions VAD, transcription Whisper, timings).
+// La capture ne fait qu'une copie en PSRAM: l'ecriture SD se fait dans une
+// tache dediee et un clip est abandonne plutot que de bloquer la capture.
+#ifndef CORPUS_RECORDER_H
+#define CORPUS_RECORDER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+
+#define CORPUS_DIR          "/corpus"
+#define CORPUS_QUEUE_LEN    4      // Clips en attente d'ecriture
+#define CORPUS_MAX_EVENTS   48     // Decisions VAD memorisees par clip
+#define CORPUS_MIN_FREE_MB  64     // Arret si la carte est presque pleine
+
+// Origine du clip
+enum CorpusSource {
+    CORPUS_WAKE,      // Candidat wake word (WakeWordDetector)
+    CORPUS_COMMAND    // Commande vocale (AudioManager VAD)
+};
+
+// Decisions VAD journalisees
+enum CorpusVadEvent {
+    VAD_SPEECH_START,   // Debut de parole confirme
+    VAD_PAUSE,          // Premiere frame de silence apres parole
+    VAD_RESUME,         // Reprise de parole apres une pause
+    VAD_SPECULATIVE,    // Transcription speculative lancee
+    VAD_END,            // Fin de parole (silence suffisant)
+    VAD_TIMEOUT         // Duree maximale atteinte
+};
+
+struct CorpusEventRecord {
+    uint32_t ms;        // Depuis le debut du clip
+    uint8_t type;
+    int32_t energy;
+};
+
+// Clip en attente d'ecriture (PSRAM)
+struct CorpusClip {
+    CorpusSource source;
+    uint32_t seq;
+    uint32_t startMs;
+    int threshold;
+
+    uint8_t* audio;
+    size_t audioSize;
+
+    CorpusEventRecord events[CORPUS_MAX_EVENTS];
+    int eventCount;
+
+    String transcript;
+    String outcome;
+    uint32_t captureMs;
+    uint32_t sttMs;
+    bool speculative;
+};
+
+class CorpusRecorder {
+public:
+    CorpusRecorder();
+
+    // Lit la preference et monte la carte si l'enregistrement est actif
+    bool begin();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() { return enabled; }
+    bool isActive() { return enabled && mounted; }
+
+    // Construction du clip courant (tache loop)
+    void beginClip(CorpusSource source, int threshold);
+    void logVad(CorpusVadEvent event, int energy);
+    void captureAudio(const uint8_t* audio, size_t size);  // Copie PSRAM
+    void setTranscript(const String& text, unsigned long sttMs, bool speculative = false);
+    void commitClip(const char* outcome);  // Met en file, ne bloque jamais
+    void discardClip();
+
+    void printStats();
+
+private:
+    bool enabled;
+    bool mounted;
+    uint32_t bootId;
+    uint32_t nextSeq;
+
+    CorpusClip* current;
+    QueueHandle_t queue;
+    TaskHandle_t writerTask;
+
+    // Statistiques (ecrites par la tache d'ecriture)
+    volatile uint32_t clipsWritten;
+    volatile uint32_t clipsDropped;
+    volatile uint32_t bytesWritten;
+    volatile uint32_t lastWriteMs;
+
+    Preferences prefs;
+
+    bool mount();
+    static void writerLoop(void* param);
+    bool writeClip(CorpusClip* clip);
+    void freeClip(CorpusClip* clip);
+};
+
+extern CorpusRecorder corpusRecorder;
+
+#endif
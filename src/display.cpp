@@ -88,6 +88,10 @@ Display::Display() {
         0,              // Rotation
         false           // IPS mode (false for standard TFT)
     );
+
+    mutex = xSemaphoreCreateMutex();
+    readyScreen = false;
+    screenGeneration = 0;
 }
 
 bool Display::begin() {
@@ -108,8 +112,21 @@ bool Display::begin() {
     return true;
 }
 
+bool Display::lock(TickType_t wait) {
+    return xSemaphoreTake(mutex, wait) == pdTRUE;
+}
+
+void Display::unlock() {
+    xSemaphoreGive(mutex);
+}
+
 void Display::clear() {
+    // Attendre la fin d'une mise a jour du vu-metre en cours: ensuite il ne
+    // dessine plus tant que l'ecran d'accueil n'est pas reaffiche
+    lock();
+    readyScreen = false;
     gfx->fillScreen(COLOR_BLACK);
+    unlock();
 }
 
 void Display::drawCenteredText(const char* text, int y, uint16_t color, int textSize) {
@@ -264,6 +281,10 @@ void Display::showSatoshiReady() {
     // Ligne 2: INVOICE 21, PARLER
     drawButton(10, 155, 145, 45, "INVOICE", COLOR_ORANGE, COLOR_WHITE);
     drawButton(165, 155, 145, 45, "PARLER", COLOR_GREEN, COLOR_WHITE);
+
+    // Zone libre en bas: le vu-metre peut y dessiner
+    screenGeneration++;
+    readyScreen = true;
 }
 
 void Display::drawButton(int x, int y, int w, int h, const char* label, uint16_t bgColor, uint16_t textColor) {
@@ -391,6 +412,12 @@ void Display::showConversation(const char* userText, const char* satoshiText) {
     drawWrappedText(satoshiText, 10, 135, SCREEN_WIDTH - 20, COLOR_WHITE, 1);
 }
 
+void Display::updateConversation(const char* satoshiText) {
+    // Sous le titre "SATOSHI:", sans effacer l'ecran (pas de clignotement)
+    gfx->fillRect(0, 132, SCREEN_WIDTH, SCREEN_HEIGHT - 132, COLOR_BLACK);
+    drawWrappedText(satoshiText, 10, 135, SCREEN_WIDTH - 20, COLOR_WHITE, 1);
+}
+
 void Display::showInvoice(const char* bolt11, int64_t amountSats) {
     clear();
 
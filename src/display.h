@@ -37,6 +37,8 @@ public:
     void showThinking();
     void showResponse(const char* response);
     void showConversation(const char* userText, const char* satoshiText);
+    // Reponse en flux: seule la zone de reponse de showConversation redessinee
+    void updateConversation(const char* satoshiText);
 
     // Indicateurs audio
     void showRecording();
@@ -62,9 +64,21 @@ public:
 
     Arduino_GFX* getGfx() { return gfx; }
 
+    // Acces concurrent au bus SPI (tache du vu-metre sur core 0)
+    bool lock(TickType_t wait = portMAX_DELAY);
+    void unlock();
+
+    // Ecran d'accueil affiche (remis a false par clear())
+    bool isReadyScreen() { return readyScreen; }
+    uint32_t getScreenGeneration() { return screenGeneration; }
+
 private:
     Arduino_DataBus* bus;
     Arduino_GFX* gfx;
+
+    SemaphoreHandle_t mutex;
+    volatile bool readyScreen;
+    volatile uint32_t screenGeneration;  // Incremente a chaque ecran d'accueil
 };
 
 extern Display display;
@@ -0,0 +1,99 @@
+// dns_cache.cpp - Cache DNS local pour les hotes des API
+#include "dns_cache.h"
+#include <WiFi.h>
+
+DnsCache dnsCache;
+
+DnsCache::DnsCache() {
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        entries[i].host[0] = '\0';
+        entries[i].resolvedAt = 0;
+        entries[i].valid = false;
+    }
+    mutex = xSemaphoreCreateMutex();
+    hits = 0;
+    misses = 0;
+    failures = 0;
+    lookupMsTotal = 0;
+}
+
+DnsCache::Entry* DnsCache::find(const char* host) {
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        if (entries[i].valid && strcmp(entries[i].host, host) == 0) return &entries[i];
+    }
+    return nullptr;
+}
+
+bool DnsCache::resolve(const char* host, IPAddress& ip, bool* fromCache) {
+    if (fromCache) *fromCache = false;
+
+    // Adresse litterale (hote LNbits en IP): rien a resoudre
+    if (ip.fromString(host)) return true;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Entry* entry = find(host);
+    if (entry && millis() - entry->resolvedAt < DNS_CACHE_TTL_MS) {
+        ip = entry->ip;
+        hits++;
+        xSemaphoreGive(mutex);
+        if (fromCache) *fromCache = true;
+        return true;
+    }
+    xSemaphoreGive(mutex);
+
+    // Requete hors verrou: les autres taches lisent le cache pendant ce temps
+    unsigned long start = millis();
+    bool ok = WiFi.hostByName(host, ip) == 1;
+    uint32_t elapsed = millis() - start;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    misses++;
+    lookupMsTotal += elapsed;
+    if (!ok) {
+        failures++;
+        xSemaphoreGive(mutex);
+        Serial.printf("DNS: %s introuvable\n", host);
+        return false;
+    }
+
+    entry = find(host);
+    if (!entry) {
+        // Entree libre, sinon la plus ancienne
+        entry = &entries[0];
+        for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+            if (!entries[i].valid) {
+                entry = &entries[i];
+                break;
+            }
+            if (entries[i].resolvedAt < entry->resolvedAt) entry = &entries[i];
+        }
+        strncpy(entry->host, host, DNS_CACHE_HOST_LEN - 1);
+        entry->host[DNS_CACHE_HOST_LEN - 1] = '\0';
+    }
+    entry->ip = ip;
+    entry->resolvedAt = millis();
+    entry->valid = true;
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+void DnsCache::invalidate(const char* host) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Entry* entry = find(host);
+    if (entry) entry->valid = false;
+    xSemaphoreGive(mutex);
+}
+
+void DnsCache::printStats() {
+    Serial.printf("DNS: %u en cache, %u requetes (moy %u ms), %u echecs\n",
+                  hits, misses, misses ? lookupMsTotal / misses : 0, failures);
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        const Entry& e = entries[i];
+        if (!e.valid) continue;
+        unsigned long age = millis() - e.resolvedAt;
+        Serial.printf("  %-28s %-15s %s\n", e.host, e.ip.toString().c_str(),
+                      age < DNS_CACHE_TTL_MS ? "valide" : "expire");
+    }
+    xSemaphoreGive(mutex);
+}
@@ -0,0 +1,50 @@
+// dns_cache.h - Cache DNS local pour les hotes des API
+// Chaque connexion du pool resolvait son hote (WiFi.hostByName, 20-150 ms
+// selon la box) avant le handshake TLS. Les adresses sont gardees
+// DNS_CACHE_TTL_MS; une connexion refusee sur une adresse en cache
+// provoque une nouvelle resolution.
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+#define DNS_CACHE_SIZE      8
+#define DNS_CACHE_HOST_LEN  64
+#define DNS_CACHE_TTL_MS    300000   // lwIP ne remonte pas le TTL: 5 min
+
+class DnsCache {
+public:
+    DnsCache();
+
+    // Adresse de host, depuis le cache si possible. fromCache (optionnel):
+    // true si aucune requete DNS n'a ete faite.
+    bool resolve(const char* host, IPAddress& ip, bool* fromCache = nullptr);
+
+    // Adresse refusee (hote deplace): oublier l'entree
+    void invalidate(const char* host);
+
+    void printStats();
+
+private:
+    struct Entry {
+        char host[DNS_CACHE_HOST_LEN];
+        IPAddress ip;
+        unsigned long resolvedAt;
+        bool valid;
+    };
+
+    Entry entries[DNS_CACHE_SIZE];
+    SemaphoreHandle_t mutex;
+
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t failures;
+    uint32_t lookupMsTotal;     // Temps passe en requetes DNS
+
+    Entry* find(const char* host);
+};
+
+extern DnsCache dnsCache;
+
+#endif
@@ -0,0 +1,439 @@
+// hpack.cpp - Compression des en-tetes HTTP/2 (HPACK, RFC 7541)
+#include "hpack.h"
+#include <string.h>
+
+// Table statique (RFC 7541 annexe A), index 1 a 61
+static const HpackHeader staticTable[HPACK_STATIC_COUNT] = {
+    { ":authority", "" },
+    { ":method", "GET" },
+    { ":method", "POST" },
+    { ":path", "/" },
+    { ":path", "/index.html" },
+    { ":scheme", "http" },
+    { ":scheme", "https" },
+    { ":status", "200" },
+    { ":status", "204" },
+    { ":status", "206" },
+    { ":status", "304" },
+    { ":status", "400" },
+    { ":status", "404" },
+    { ":status", "500" },
+    { "accept-charset", "" },
+    { "accept-encoding", "gzip, deflate" },
+    { "accept-language", "" },
+    { "accept-ranges", "" },
+    { "accept", "" },
+    { "access-control-allow-origin", "" },
+    { "age", "" },
+    { "allow", "" },
+    { "authorization", "" },
+    { "cache-control", "" },
+    { "content-disposition", "" },
+    { "content-encoding", "" },
+    { "content-language", "" },
+    { "content-length", "" },
+    { "content-location", "" },
+    { "content-range", "" },
+    { "content-type", "" },
+    { "cookie", "" },
+    { "date", "" },
+    { "etag", "" },
+    { "expect", "" },
+    { "expires", "" },
+    { "from", "" },
+    { "host", "" },
+    { "if-match", "" },
+    { "if-modified-since", "" },
+    { "if-none-match", "" },
+    { "if-range", "" },
+    { "if-unmodified-since", "" },
+    { "last-modified", "" },
+    { "link", "" },
+    { "location", "" },
+    { "max-forwards", "" },
+    { "proxy-authenticate", "" },
+    { "proxy-authorization", "" },
+    { "range", "" },
+    { "referer", "" },
+    { "refresh", "" },
+    { "retry-after", "" },
+    { "server", "" },
+    { "set-cookie", "" },
+    { "strict-transport-security", "" },
+    { "transfer-encoding", "" },
+    { "user-agent", "" },
+    { "vary", "" },
+    { "via", "" },
+    { "www-authenticate", "" },
+};
+
+// Longueur en bits du code Huffman de chaque octet, 256 = EOS (annexe B).
+// Le code est canonique: les codes se deduisent des longueurs.
+static const uint8_t huffmanLengths[257] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30,
+};
+
+#define HUFFMAN_MAX_BITS 30
+
+static uint16_t huffmanSymbols[257];          // Tries par (longueur, octet)
+static uint32_t huffmanFirst[HUFFMAN_MAX_BITS + 1];
+static uint16_t huffmanOffset[HUFFMAN_MAX_BITS + 1];
+static uint16_t huffmanCount[HUFFMAN_MAX_BITS + 1];
+static bool huffmanReady = false;
+
+// Tables de decodage canonique, construites une fois (resultat identique
+// si deux taches le font en meme temps)
+static void huffmanInit() {
+    if (huffmanReady) return;
+    uint16_t count[HUFFMAN_MAX_BITS + 1] = {0};
+    for (int s = 0; s < 257; s++) count[huffmanLengths[s]]++;
+
+    uint16_t offset[HUFFMAN_MAX_BITS + 1];
+    uint32_t code = 0;
+    uint16_t index = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_BITS; len++) {
+        huffmanFirst[len] = code;
+        huffmanOffset[len] = index;
+        huffmanCount[len] = count[len];
+        offset[len] = index;
+        index += count[len];
+        code = (code + count[len]) << 1;
+    }
+    for (int s = 0; s < 257; s++) {
+        huffmanSymbols[offset[huffmanLengths[s]]++] = s;
+    }
+    huffmanReady = true;
+}
+
+bool hpackHuffmanDecode(const uint8_t* data, size_t len, char* out, size_t room, size_t& outLen) {
+    huffmanInit();
+    outLen = 0;
+    uint32_t code = 0;
+    int bits = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        for (int b = 7; b >= 0; b--) {
+            code = (code << 1) | ((data[i] >> b) & 1);
+            bits++;
+            if (bits > HUFFMAN_MAX_BITS) return false;
+            uint32_t rank = code - huffmanFirst[bits];
+            if (code < huffmanFirst[bits] || rank >= huffmanCount[bits]) continue;
+
+            uint16_t symbol = huffmanSymbols[huffmanOffset[bits] + rank];
+            if (symbol == 256) return false;    // EOS interdit dans une chaine
+            if (outLen >= room) return false;
+            out[outLen++] = (char)symbol;
+            code = 0;
+            bits = 0;
+        }
+    }
+
+    // Bourrage: au plus 7 bits, tous a 1 (prefixe de EOS)
+    return bits <= 7 && code == (1u << bits) - 1;
+}
+
+// ============================================================
+// Entiers a prefixe (RFC 7541 5.1)
+// ============================================================
+
+static bool decodeInt(const uint8_t*& p, const uint8_t* end, int prefix, uint32_t& value) {
+    if (p >= end) return false;
+    uint32_t max = (1u << prefix) - 1;
+    value = *p++ & max;
+    if (value < max) return true;
+
+    for (int shift = 0; p < end; shift += 7) {
+        if (shift > 21) return false;       // Au-dela de 2^28: absurde ici
+        uint8_t b = *p++;
+        value += (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static size_t intLength(int prefix, uint32_t value) {
+    uint32_t max = (1u << prefix) - 1;
+    if (value < max) return 1;
+    size_t n = 2;
+    for (value -= max; value >= 0x80; value >>= 7) n++;
+    return n;
+}
+
+static size_t encodeInt(uint8_t* out, uint8_t flags, int prefix, uint32_t value) {
+    uint32_t max = (1u << prefix) - 1;
+    if (value < max) {
+        out[0] = flags | value;
+        return 1;
+    }
+    out[0] = flags | max;
+    size_t n = 1;
+    for (value -= max; value >= 0x80; value >>= 7) {
+        out[n++] = 0x80 | (value & 0x7f);
+    }
+    out[n++] = value;
+    return n;
+}
+
+static bool equalsLen(const char* a, size_t aLen, const char* b, size_t bLen) {
+    return aLen == bLen && memcmp(a, b, aLen) == 0;
+}
+
+// ============================================================
+// Table dynamique
+// ============================================================
+
+HpackTable::HpackTable() {
+    count = 0;
+    used = 0;
+    size = 0;
+    maxSize = HPACK_TABLE_SIZE;
+}
+
+void HpackTable::setMaxSize(size_t max) {
+    maxSize = max > HPACK_TABLE_SIZE ? HPACK_TABLE_SIZE : max;
+    while (size > maxSize) evictOldest();
+}
+
+void HpackTable::evictOldest() {
+    if (count == 0) return;
+    size_t len = entries[0].nameLen + entries[0].valueLen;
+    memmove(data, data + len, used - len);
+    used -= len;
+    size -= len + HPACK_ENTRY_OVERHEAD;
+    for (int i = 1; i < count; i++) {
+        entries[i - 1] = entries[i];
+        entries[i - 1].offset -= len;
+    }
+    count--;
+}
+
+void HpackTable::add(const char* name, size_t nameLen, const char* value, size_t valueLen) {
+    size_t entrySize = nameLen + valueLen + HPACK_ENTRY_OVERHEAD;
+    if (entrySize > maxSize) {
+        while (count > 0) evictOldest();
+        return;
+    }
+    while (size + entrySize > maxSize) evictOldest();
+
+    // used <= maxSize - 32 * count: toujours de la place dans data
+    Entry& e = entries[count++];
+    e.offset = used;
+    e.nameLen = nameLen;
+    e.valueLen = valueLen;
+    memcpy(data + used, name, nameLen);
+    memcpy(data + used + nameLen, value, valueLen);
+    used += nameLen + valueLen;
+    size += entrySize;
+}
+
+bool HpackTable::get(int index, const char*& name, size_t& nameLen, const char*& value, size_t& valueLen) {
+    if (index < 1 || index > count) return false;
+    const Entry& e = entries[count - index];
+    name = data + e.offset;
+    nameLen = e.nameLen;
+    value = data + e.offset + e.nameLen;
+    valueLen = e.valueLen;
+    return true;
+}
+
+int HpackTable::find(const char* name, size_t nameLen, const char* value, size_t valueLen, int& nameIndex) {
+    nameIndex = 0;
+    for (int index = 1; index <= count; index++) {
+        const Entry& e = entries[count - index];
+        if (!equalsLen(data + e.offset, e.nameLen, name, nameLen)) continue;
+        if (equalsLen(data + e.offset + e.nameLen, e.valueLen, value, valueLen)) return index;
+        if (nameIndex == 0) nameIndex = index;
+    }
+    return 0;
+}
+
+// ============================================================
+// Decodeur
+// ============================================================
+
+HpackDecoder::HpackDecoder() {
+    maxTableSize = HPACK_TABLE_SIZE;
+    error = "";
+    huffmanInit();
+}
+
+void HpackDecoder::setMaxTableSize(size_t size) {
+    maxTableSize = size > HPACK_TABLE_SIZE ? HPACK_TABLE_SIZE : size;
+    if (table.getMaxSize() > maxTableSize) table.setMaxSize(maxTableSize);
+}
+
+bool HpackDecoder::fail(const char* reason) {
+    error = reason;
+    return false;
+}
+
+bool HpackDecoder::readString(const uint8_t*& p, const uint8_t* end, char* out, size_t room, size_t& len) {
+    if (p >= end) return false;
+    bool huffman = *p & 0x80;
+    uint32_t length;
+    if (!decodeInt(p, end, 7, length) || length > (size_t)(end - p)) return false;
+
+    if (huffman) {
+        if (!hpackHuffmanDecode(p, length, out, room, len)) return false;
+    } else {
+        if (length > room) return false;
+        memcpy(out, p, length);
+        len = length;
+    }
+    p += length;
+    return true;
+}
+
+bool HpackDecoder::decode(const uint8_t* block, size_t len, HpackHeaderFn fn, void* arg) {
+    const uint8_t* p = block;
+    const uint8_t* end = block + len;
+    bool fieldSeen = false;
+    error = "";
+
+    while (p < end) {
+        uint8_t first = *p;
+
+        if ((first & 0xe0) == 0x20) {
+            // Mise a jour de taille: seulement en debut de bloc
+            uint32_t size;
+            if (fieldSeen || !decodeInt(p, end, 5, size)) return fail("mise a jour de table invalide");
+            if (size > maxTableSize) return fail("table plus grande qu'annonce");
+            table.setMaxSize(size);
+            continue;
+        }
+        fieldSeen = true;
+
+        if (first & 0x80) {
+            // Champ indexe
+            uint32_t index;
+            const char* name;
+            const char* value;
+            size_t nameLen, valueLen;
+            if (!decodeInt(p, end, 7, index) || index == 0) return fail("index invalide");
+            if (index <= HPACK_STATIC_COUNT) {
+                name = staticTable[index - 1].name;
+                value = staticTable[index - 1].value;
+                nameLen = strlen(name);
+                valueLen = strlen(value);
+            } else if (!table.get(index - HPACK_STATIC_COUNT, name, nameLen, value, valueLen)) {
+                return fail("index hors table");
+            }
+            if (fn) fn(name, nameLen, value, valueLen, arg);
+            continue;
+        }
+
+        // Litteral: avec indexation (01), sans (0000) ou jamais indexe (0001)
+        bool indexing = first & 0x40;
+        uint32_t nameIndex;
+        if (!decodeInt(p, end, indexing ? 6 : 4, nameIndex)) return fail("litteral tronque");
+
+        // Nom copie: l'ajout a la table peut evincer l'entree d'origine
+        size_t nameLen;
+        if (nameIndex == 0) {
+            if (!readString(p, end, scratch, sizeof(scratch), nameLen)) return fail("nom invalide");
+        } else {
+            const char* name;
+            const char* value;
+            size_t valueLen;
+            if (nameIndex <= HPACK_STATIC_COUNT) {
+                name = staticTable[nameIndex - 1].name;
+                nameLen = strlen(name);
+            } else if (!table.get(nameIndex - HPACK_STATIC_COUNT, name, nameLen, value, valueLen)) {
+                return fail("index de nom hors table");
+            }
+            if (nameLen > sizeof(scratch)) return fail("nom trop long");
+            memcpy(scratch, name, nameLen);
+        }
+
+        size_t valueLen;
+        char* value = scratch + nameLen;
+        if (!readString(p, end, value, sizeof(scratch) - nameLen, valueLen)) return fail("valeur invalide");
+
+        if (indexing) table.add(scratch, nameLen, value, valueLen);
+        if (fn) fn(scratch, nameLen, value, valueLen, arg);
+    }
+    return true;
+}
+
+// ============================================================
+// Encodeur
+// ============================================================
+
+HpackEncoder::HpackEncoder() {
+    pendingSize = HPACK_TABLE_SIZE;
+    sizeUpdatePending = false;
+}
+
+void HpackEncoder::setMaxTableSize(size_t size) {
+    if (size > HPACK_TABLE_SIZE) size = HPACK_TABLE_SIZE;
+    if (size == table.getMaxSize() && !sizeUpdatePending) return;
+    pendingSize = size;
+    sizeUpdatePending = true;
+}
+
+size_t HpackEncoder::beginBlock(uint8_t* out, size_t room) {
+    if (!sizeUpdatePending) return 0;
+    if (room < intLength(5, pendingSize)) return 0;
+    table.setMaxSize(pendingSize);
+    sizeUpdatePending = false;
+    return encodeInt(out, 0x20, 5, pendingSize);
+}
+
+size_t HpackEncoder::encode(uint8_t* out, size_t room, const char* name, const char* value, bool index) {
+    size_t nameLen = strlen(name);
+    size_t valueLen = strlen(value);
+
+    // Champ deja connu en entier: un index
+    int nameIndex = 0;
+    for (int i = 0; i < HPACK_STATIC_COUNT; i++) {
+        if (strcmp(staticTable[i].name, name) != 0) continue;
+        if (strcmp(staticTable[i].value, value) == 0) {
+            if (room < intLength(7, i + 1)) return 0;
+            return encodeInt(out, 0x80, 7, i + 1);
+        }
+        if (nameIndex == 0) nameIndex = i + 1;
+    }
+    int dynamicName;
+    int found = table.find(name, nameLen, value, valueLen, dynamicName);
+    if (found) {
+        if (room < intLength(7, HPACK_STATIC_COUNT + found)) return 0;
+        return encodeInt(out, 0x80, 7, HPACK_STATIC_COUNT + found);
+    }
+    if (nameIndex == 0 && dynamicName) nameIndex = HPACK_STATIC_COUNT + dynamicName;
+
+    // Litteral, ajoute a la table s'il tient dedans
+    if (nameLen + valueLen + HPACK_ENTRY_OVERHEAD > table.getMaxSize()) index = false;
+    int prefix = index ? 6 : 4;
+    size_t need = intLength(prefix, nameIndex) + intLength(7, valueLen) + valueLen;
+    if (nameIndex == 0) need += intLength(7, nameLen) + nameLen;
+    if (need > room) return 0;
+
+    size_t n = encodeInt(out, index ? 0x40 : 0x00, prefix, nameIndex);
+    if (nameIndex == 0) {
+        n += encodeInt(out + n, 0x00, 7, nameLen);
+        memcpy(out + n, name, nameLen);
+        n += nameLen;
+    }
+    n += encodeInt(out + n, 0x00, 7, valueLen);
+    memcpy(out + n, value, valueLen);
+    n += valueLen;
+
+    if (index) table.add(name, nameLen, value, valueLen);
+    return n;
+}
@@ -0,0 +1,112 @@
+// hpack.h - Compression des en-tetes HTTP/2 (HPACK, RFC 7541)
+// Decodeur complet: table statique, table dynamique avec eviction,
+// entiers a prefixe et chaines Huffman (les serveurs les utilisent
+// partout). Encodeur minimal: index de la table statique, sinon litteral
+// avec indexation incrementale, chaines sans Huffman (permis par la RFC).
+// Les en-tetes repetes d'une requete a l'autre (authorization, :path,
+// content-type) ne coutent plus qu'un octet apres la premiere requete.
+// Sans dependance Arduino: compile aussi sous Linux (tools/h2_client).
+#ifndef HPACK_H
+#define HPACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HPACK_TABLE_SIZE      4096    // SETTINGS_HEADER_TABLE_SIZE par defaut
+#define HPACK_ENTRY_OVERHEAD  32      // Cout fixe d'une entree (RFC 7541 4.1)
+#define HPACK_STATIC_COUNT    61
+#define HPACK_STRING_MAX      1024    // Nom + valeur decodes
+
+struct HpackHeader {
+    const char* name;       // Minuscules (HTTP/2)
+    const char* value;
+};
+
+// En-tete decode. Chaines non terminees, valides pendant l'appel.
+typedef void (*HpackHeaderFn)(const char* name, size_t nameLen,
+                              const char* value, size_t valueLen, void* arg);
+
+// Table dynamique: FIFO, index 1 = entree la plus recente
+class HpackTable {
+public:
+    HpackTable();
+
+    void setMaxSize(size_t size);
+    size_t getMaxSize() { return maxSize; }
+    size_t getSize() { return size; }
+    int getCount() { return count; }
+
+    // Entree plus grande que la table: table videe, rien d'ajoute
+    void add(const char* name, size_t nameLen, const char* value, size_t valueLen);
+    bool get(int index, const char*& name, size_t& nameLen, const char*& value, size_t& valueLen);
+    // Index (1..) de l'entree nom + valeur, 0 sinon. nameIndex: entree de meme nom.
+    int find(const char* name, size_t nameLen, const char* value, size_t valueLen, int& nameIndex);
+
+private:
+    struct Entry {
+        uint16_t offset;
+        uint16_t nameLen;
+        uint16_t valueLen;
+    };
+
+    // Stockage du plus ancien au plus recent
+    char data[HPACK_TABLE_SIZE];
+    Entry entries[HPACK_TABLE_SIZE / HPACK_ENTRY_OVERHEAD];
+    int count;
+    size_t used;            // Octets occupes dans data
+    size_t size;            // Taille RFC (longueurs + 32 par entree)
+    size_t maxSize;
+
+    void evictOldest();
+};
+
+class HpackDecoder {
+public:
+    HpackDecoder();
+
+    // Plafond annonce au serveur (SETTINGS_HEADER_TABLE_SIZE)
+    void setMaxTableSize(size_t size);
+
+    // Bloc d'en-tetes complet (HEADERS + CONTINUATION). false: erreur de
+    // compression, fatale pour la connexion (table desynchronisee).
+    bool decode(const uint8_t* block, size_t len, HpackHeaderFn fn, void* arg);
+
+    const char* getError() { return error; }
+    size_t getTableSize() { return table.getSize(); }
+
+private:
+    HpackTable table;
+    size_t maxTableSize;
+    char scratch[HPACK_STRING_MAX];
+    const char* error;
+
+    bool readString(const uint8_t*& p, const uint8_t* end, char* out, size_t room, size_t& len);
+    bool fail(const char* reason);
+};
+
+class HpackEncoder {
+public:
+    HpackEncoder();
+
+    // SETTINGS_HEADER_TABLE_SIZE du serveur: signale au debut du bloc suivant
+    void setMaxTableSize(size_t size);
+
+    // Debut d'un bloc d'en-tetes. Retourne les octets ecrits.
+    size_t beginBlock(uint8_t* out, size_t room);
+    // Un en-tete. index = false pour les valeurs propres a une requete
+    // (content-length): pas d'entree inutile dans la table. 0 si trop long
+    // (table inchangee).
+    size_t encode(uint8_t* out, size_t room, const char* name, const char* value, bool index = true);
+
+    size_t getTableSize() { return table.getSize(); }
+
+private:
+    HpackTable table;
+    size_t pendingSize;
+    bool sizeUpdatePending;
+};
+
+// Decodage Huffman (RFC 7541 annexe B). false: code invalide ou EOS.
+bool hpackHuffmanDecode(const uint8_t* data, size_t len, char* out, size_t room, size_t& outLen);
+
+#endif
@@ -0,0 +1,1131 @@
+// http2_client.cpp - Client HTTP/2 minimal (RFC 9113) pour api.groq.com
+#include "http2_client.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define FRAME_DATA            0x0
+#define FRAME_HEADERS         0x1
+#define FRAME_PRIORITY        0x2
+#define FRAME_RST_STREAM      0x3
+#define FRAME_SETTINGS        0x4
+#define FRAME_PUSH_PROMISE    0x5
+#define FRAME_PING            0x6
+#define FRAME_GOAWAY          0x7
+#define FRAME_WINDOW_UPDATE   0x8
+#define FRAME_CONTINUATION    0x9
+
+#define FLAG_END_STREAM       0x1
+#define FLAG_ACK              0x1
+#define FLAG_END_HEADERS      0x4
+#define FLAG_PADDED           0x8
+#define FLAG_PRIORITY         0x20
+
+#define SETTINGS_HEADER_TABLE_SIZE       0x1
+#define SETTINGS_ENABLE_PUSH             0x2
+#define SETTINGS_MAX_CONCURRENT_STREAMS  0x3
+#define SETTINGS_INITIAL_WINDOW_SIZE     0x4
+#define SETTINGS_MAX_FRAME_SIZE          0x5
+
+#define H2_WINDOW_MAX         0x7fffffff
+
+static const char clientPreface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+static uint32_t readU32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void writeU32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static bool equalsLen(const char* a, size_t aLen, const char* b) {
+    return aLen == strlen(b) && memcmp(a, b, aLen) == 0;
+}
+
+static long parseDecimal(const char* p, size_t len) {
+    long v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] < '0' || p[i] > '9') return -1;
+        v = v * 10 + (p[i] - '0');
+    }
+    return len > 0 ? v : -1;
+}
+
+// ============================================================
+// Session
+// ============================================================
+
+Http2Session::Http2Session(Http2WriteFn write, void* arg) {
+    writeFn = write;
+    writeArg = arg;
+    memset(streams, 0, sizeof(streams));
+    nextStreamId = 1;
+
+    peerSettings = false;
+    peerMaxStreams = H2_MAX_STREAMS;      // Illimite par defaut, borne par nos indices
+    peerInitialWindow = H2_DEFAULT_WINDOW;
+    peerMaxFrame = H2_FRAME_MAX;
+    connSendWindow = H2_DEFAULT_WINDOW;
+    connRecvUnacked = 0;
+
+    dead = false;
+    goaway = false;
+    error = "";
+
+    headLen = 0;
+    frameLen = 0;
+    frameType = 0;
+    frameFlags = 0;
+    frameStream = 0;
+    framePos = 0;
+    padLen = 0;
+    frameTarget = -1;
+    controlLen = 0;
+
+    blockLen = 0;
+    blockFrameStart = 0;
+    expectContinuation = false;
+    blockStream = 0;
+    blockEndStream = false;
+
+    memset(&stats, 0, sizeof(stats));
+
+    outLen = 0;
+    out = (uint8_t*)malloc(H2_OUT_BUFFER);
+    if (!out) {
+        dead = true;
+        error = "memoire insuffisante";
+    }
+}
+
+Http2Session::~Http2Session() {
+    free(out);
+}
+
+bool Http2Session::start() {
+    if (dead) return false;
+
+    // Pas de push, fenetre de reception par flux agrandie
+    uint8_t settings[12];
+    settings[0] = 0;
+    settings[1] = SETTINGS_ENABLE_PUSH;
+    writeU32(settings + 2, 0);
+    settings[6] = 0;
+    settings[7] = SETTINGS_INITIAL_WINDOW_SIZE;
+    writeU32(settings + 8, H2_STREAM_WINDOW);
+
+    append((const uint8_t*)clientPreface, sizeof(clientPreface) - 1);
+    appendFrame(FRAME_SETTINGS, 0, 0, settings, sizeof(settings));
+    // La fenetre de connexion ne se regle que par WINDOW_UPDATE
+    sendWindowUpdate(0, H2_CONNECTION_WINDOW - H2_DEFAULT_WINDOW);
+    return flush();
+}
+
+int Http2Session::findStream(uint32_t id) {
+    if (id == 0) return -1;
+    for (int i = 0; i < H2_MAX_STREAMS; i++) {
+        if (streams[i].id == id) return i;
+    }
+    return -1;
+}
+
+int Http2Session::getActiveStreams() {
+    int active = 0;
+    for (int i = 0; i < H2_MAX_STREAMS; i++) {
+        const Stream& s = streams[i];
+        if (s.id != 0 && !s.reset && !(s.localClosed && s.remoteClosed)) active++;
+    }
+    return active;
+}
+
+bool Http2Session::canOpen() {
+    if (dead || goaway || nextStreamId > H2_WINDOW_MAX) return false;
+    // Avant les SETTINGS du serveur sa limite de flux est inconnue: un seul
+    uint32_t active = getActiveStreams();
+    if (active >= peerMaxStreams || (!peerSettings && active >= 1)) return false;
+    for (int i = 0; i < H2_MAX_STREAMS; i++) {
+        if (streams[i].id == 0) return true;
+    }
+    return false;
+}
+
+bool Http2Session::isDone(int index) {
+    if (index < 0 || index >= H2_MAX_STREAMS) return true;
+    const Stream& s = streams[index];
+    return dead || s.reset || s.remoteClosed;
+}
+
+bool Http2Session::isReset(int index) {
+    if (index < 0 || index >= H2_MAX_STREAMS) return true;
+    const Stream& s = streams[index];
+    return s.reset || (dead && !s.remoteClosed);
+}
+
+uint32_t Http2Session::getResetCode(int index) {
+    return index >= 0 && index < H2_MAX_STREAMS ? streams[index].resetCode : H2_NO_ERROR;
+}
+
+int Http2Session::getStatus(int index) {
+    return index >= 0 && index < H2_MAX_STREAMS ? streams[index].status : 0;
+}
+
+uint32_t Http2Session::getBodyBytes(int index) {
+    return index >= 0 && index < H2_MAX_STREAMS ? streams[index].bodyBytes : 0;
+}
+
+// ============================================================
+// Envoi
+// ============================================================
+
+bool Http2Session::flush() {
+    if (outLen == 0) return !dead;
+    size_t len = outLen;
+    outLen = 0;
+    if (!writeFn(out, len, writeArg)) {
+        abort("ecriture socket echouee");
+        return false;
+    }
+    stats.bytesOut += len;
+    return true;
+}
+
+bool Http2Session::append(const uint8_t* data, size_t len) {
+    if (!out) return false;
+    while (len > 0) {
+        size_t n = H2_OUT_BUFFER - outLen;
+        if (n > len) n = len;
+        memcpy(out + outLen, data, n);
+        outLen += n;
+        data += n;
+        len -= n;
+        // Tampon plein: un record TLS de 16 Ko
+        if (outLen == H2_OUT_BUFFER && !flush()) return false;
+    }
+    return true;
+}
+
+void Http2Session::writeFrameHeader(uint8_t* p, uint32_t len, uint8_t type, uint8_t flags, uint32_t stream) {
+    p[0] = len >> 16;
+    p[1] = len >> 8;
+    p[2] = len;
+    p[3] = type;
+    p[4] = flags;
+    writeU32(p + 5, stream & H2_WINDOW_MAX);
+}
+
+bool Http2Session::appendFrame(uint8_t type, uint8_t flags, uint32_t stream, const uint8_t* payload, size_t len) {
+    uint8_t header[9];
+    writeFrameHeader(header, len, type, flags, stream);
+    return append(header, sizeof(header)) && (len == 0 || append(payload, len));
+}
+
+void Http2Session::sendWindowUpdate(uint32_t stream, uint32_t increment) {
+    uint8_t payload[4];
+    writeU32(payload, increment & H2_WINDOW_MAX);
+    appendFrame(FRAME_WINDOW_UPDATE, 0, stream, payload, sizeof(payload));
+}
+
+void Http2Session::resetStream(int index, uint32_t code) {
+    Stream& s = streams[index];
+    if (s.reset) return;
+    uint8_t payload[4];
+    writeU32(payload, code);
+    appendFrame(FRAME_RST_STREAM, 0, s.id, payload, sizeof(payload));
+    s.reset = true;
+    s.resetCode = code;
+    stats.resets++;
+}
+
+void Http2Session::failConnection(uint32_t code, const char* reason) {
+    if (dead) return;
+    uint8_t payload[8];
+    writeU32(payload, 0);           // Aucun flux serveur traite
+    writeU32(payload + 4, code);
+    appendFrame(FRAME_GOAWAY, 0, 0, payload, sizeof(payload));
+    flush();
+    abort(reason);
+}
+
+void Http2Session::abort(const char* reason) {
+    if (!dead) error = reason;
+    dead = true;
+    outLen = 0;
+    for (int i = 0; i < H2_MAX_STREAMS; i++) {
+        Stream& s = streams[i];
+        if (s.id != 0 && !s.remoteClosed && !s.reset) {
+            s.reset = true;
+            s.resetCode = H2_CANCEL;
+        }
+    }
+}
+
+void Http2Session::shutdown() {
+    if (dead || goaway) return;
+    uint8_t payload[8];
+    writeU32(payload, 0);
+    writeU32(payload + 4, H2_NO_ERROR);
+    appendFrame(FRAME_GOAWAY, 0, 0, payload, sizeof(payload));
+    flush();
+    goaway = true;
+}
+
+int Http2Session::open(const Http2Request& req) {
+    if (!canOpen()) return -1;
+
+    const char* scheme = req.scheme ? req.scheme : "https";
+    char length[24];
+    bool hasLength = req.contentLength > 0;
+    if (hasLength) snprintf(length, sizeof(length), "%ld", req.contentLength);
+
+    // Taille au pire (litteraux sans index): verifiee avant d'encoder, un
+    // bloc abandonne en cours desynchroniserait la table dynamique
+    size_t worst = 5;
+    const HpackHeader pseudo[4] = {
+        { ":method", req.method },
+        { ":scheme", scheme },
+        { ":authority", req.authority },
+        { ":path", req.path },
+    };
+    for (int i = 0; i < 4; i++) worst += strlen(pseudo[i].name) + strlen(pseudo[i].value) + 10;
+    for (int i = 0; i < req.headerCount; i++) {
+        worst += strlen(req.headers[i].name) + strlen(req.headers[i].value) + 10;
+    }
+    if (hasLength) worst += 14 + strlen(length) + 10;
+    if (worst > sizeof(encoded)) {
+        error = "en-tetes de requete trop longs";
+        return -1;
+    }
+
+    size_t n = encoder.beginBlock(encoded, sizeof(encoded));
+    uint32_t raw = 0;
+    for (int i = 0; i < 4; i++) {
+        n += encoder.encode(encoded + n, sizeof(encoded) - n, pseudo[i].name, pseudo[i].value);
+        raw += strlen(pseudo[i].name) + strlen(pseudo[i].value) + 4;
+    }
+    for (int i = 0; i < req.headerCount; i++) {
+        n += encoder.encode(encoded + n, sizeof(encoded) - n, req.headers[i].name, req.headers[i].value);
+        raw += strlen(req.headers[i].name) + strlen(req.headers[i].value) + 4;
+    }
+    if (hasLength) {
+        n += encoder.encode(encoded + n, sizeof(encoded) - n, "content-length", length, false);
+        raw += 14 + strlen(length) + 4;
+    }
+
+    int index = 0;
+    while (streams[index].id != 0) index++;
+    Stream& s = streams[index];
+    memset(&s, 0, sizeof(s));
+    s.id = nextStreamId;
+    nextStreamId += 2;
+    s.sendWindow = peerInitialWindow;
+    s.contentLength = -1;
+    s.onHeaders = req.onHeaders;
+    s.sink = req.sink;
+    s.arg = req.arg;
+    s.localClosed = req.contentLength == 0;
+
+    // Priorite: aucune dependance, poids relatif aux autres flux
+    int weight = req.weight > 0 ? req.weight : H2_DEFAULT_WEIGHT;
+    if (weight > 256) weight = 256;
+    uint8_t priority[5];
+    writeU32(priority, 0);
+    priority[4] = weight - 1;
+
+    uint8_t flags = FLAG_END_HEADERS | FLAG_PRIORITY;
+    if (s.localClosed) flags |= FLAG_END_STREAM;
+    uint8_t header[9];
+    writeFrameHeader(header, sizeof(priority) + n, FRAME_HEADERS, flags, s.id);
+    append(header, sizeof(header));
+    append(priority, sizeof(priority));
+    append(encoded, n);
+    flush();
+
+    stats.streams++;
+    stats.headerBytesRaw += raw;
+    stats.headerBytesPacked += n;
+    uint32_t active = getActiveStreams();
+    if (active > stats.maxConcurrent) stats.maxConcurrent = active;
+    return dead ? -1 : index;
+}
+
+size_t Http2Session::send(int index, const uint8_t* data, size_t len) {
+    if (dead || index < 0 || index >= H2_MAX_STREAMS) return 0;
+    Stream& s = streams[index];
+    if (s.id == 0 || s.reset || s.localClosed) return 0;
+
+    size_t sent = 0;
+    while (sent < len) {
+        int32_t window = connSendWindow < s.sendWindow ? connSendWindow : s.sendWindow;
+        if (window <= 0) {
+            stats.windowStalls++;
+            break;
+        }
+        size_t n = len - sent;
+        if (n > (size_t)window) n = window;
+        if (n > peerMaxFrame) n = peerMaxFrame;
+
+        if (!appendFrame(FRAME_DATA, 0, s.id, data + sent, n)) break;
+        connSendWindow -= n;
+        s.sendWindow -= n;
+        sent += n;
+    }
+    // Pas de flush: les trames suivantes completent le record
+    return sent;
+}
+
+bool Http2Session::end(int index) {
+    if (dead || index < 0 || index >= H2_MAX_STREAMS) return false;
+    Stream& s = streams[index];
+    if (s.id == 0 || s.reset) return false;
+    if (!s.localClosed) {
+        appendFrame(FRAME_DATA, FLAG_END_STREAM, s.id, nullptr, 0);
+        s.localClosed = true;
+    }
+    return flush();
+}
+
+void Http2Session::close(int index) {
+    if (index < 0 || index >= H2_MAX_STREAMS) return;
+    Stream& s = streams[index];
+    if (s.id == 0) return;
+    if (!dead && !s.reset && !(s.localClosed && s.remoteClosed)) {
+        resetStream(index, H2_CANCEL);
+        flush();
+    }
+    s.id = 0;
+}
+
+// ============================================================
+// Reception
+// ============================================================
+
+bool Http2Session::feed(const uint8_t* data, size_t len) {
+    if (dead) return false;
+    stats.bytesIn += len;
+
+    size_t i = 0;
+    while (i < len && !dead) {
+        if (headLen < sizeof(head)) {
+            size_t n = sizeof(head) - headLen;
+            if (n > len - i) n = len - i;
+            memcpy(head + headLen, data + i, n);
+            headLen += n;
+            i += n;
+            if (headLen == sizeof(head) && beginFrame() && frameLen == 0) {
+                endFrame();
+                headLen = 0;
+            }
+            continue;
+        }
+
+        size_t n = frameLen - framePos;
+        if (n > len - i) n = len - i;
+        frameBytes(data + i, n);
+        framePos += n;
+        i += n;
+        if (framePos == frameLen) {
+            endFrame();
+            headLen = 0;
+        }
+    }
+
+    // SETTINGS ACK, PING, WINDOW_UPDATE
+    flush();
+    return !dead;
+}
+
+bool Http2Session::beginFrame() {
+    frameLen = ((uint32_t)head[0] << 16) | ((uint32_t)head[1] << 8) | head[2];
+    frameType = head[3];
+    frameFlags = head[4];
+    frameStream = readU32(head + 5) & H2_WINDOW_MAX;
+    framePos = 0;
+    padLen = 0;
+    controlLen = 0;
+    frameTarget = -1;
+
+    if (frameLen > H2_FRAME_MAX) {
+        failConnection(H2_FRAME_SIZE_ERROR, "trame trop longue");
+        return false;
+    }
+    if (expectContinuation && (frameType != FRAME_CONTINUATION || frameStream != blockStream)) {
+        failConnection(H2_PROTOCOL_ERROR, "CONTINUATION attendue");
+        return false;
+    }
+
+    switch (frameType) {
+        case FRAME_DATA:
+            if (frameStream == 0) break;
+            frameTarget = findStream(frameStream);
+            return true;
+        case FRAME_HEADERS:
+            if (frameStream == 0) break;
+            blockStream = frameStream;
+            blockLen = 0;
+            blockFrameStart = 0;
+            blockEndStream = frameFlags & FLAG_END_STREAM;
+            return true;
+        case FRAME_CONTINUATION:
+            if (!expectContinuation) break;
+            blockFrameStart = blockLen;
+            return true;
+        case FRAME_PUSH_PROMISE:
+            // Refuse par SETTINGS_ENABLE_PUSH = 0
+            break;
+        case FRAME_SETTINGS:
+            if (frameStream != 0) break;
+            if ((frameFlags & FLAG_ACK) ? frameLen != 0 : frameLen % 6 != 0) {
+                failConnection(H2_FRAME_SIZE_ERROR, "SETTINGS invalide");
+                return false;
+            }
+            return true;
+        case FRAME_PING:
+            if (frameLen != 8 || frameStream != 0) break;
+            return true;
+        case FRAME_WINDOW_UPDATE:
+        case FRAME_RST_STREAM:
+            if (frameLen != 4) {
+                failConnection(H2_FRAME_SIZE_ERROR, "trame de controle invalide");
+                return false;
+            }
+            return true;
+        case FRAME_GOAWAY:
+            if (frameStream != 0 || frameLen < 8) break;
+            return true;
+        default:
+            // PRIORITY et types inconnus: ignores
+            return true;
+    }
+    failConnection(H2_PROTOCOL_ERROR, "trame inattendue");
+    return false;
+}
+
+void Http2Session::frameBytes(const uint8_t* data, size_t len) {
+    switch (frameType) {
+        case FRAME_DATA:
+            dataBytes(data, len);
+            break;
+        case FRAME_HEADERS:
+        case FRAME_CONTINUATION:
+            if (blockLen + len > sizeof(block)) {
+                failConnection(H2_PROTOCOL_ERROR, "en-tetes de reponse trop longs");
+                return;
+            }
+            memcpy(block + blockLen, data, len);
+            blockLen += len;
+            break;
+        case FRAME_SETTINGS:
+            // Parametres de 6 octets appliques au fil de l'eau
+            for (size_t i = 0; i < len; i++) {
+                control[controlLen++] = data[i];
+                if (controlLen == 6) {
+                    applySetting(control);
+                    controlLen = 0;
+                }
+            }
+            break;
+        default:
+            for (size_t i = 0; i < len && controlLen < sizeof(control); i++) {
+                control[controlLen++] = data[i];
+            }
+            break;
+    }
+}
+
+void Http2Session::endFrame() {
+    switch (frameType) {
+        case FRAME_DATA:
+            dataDone();
+            break;
+        case FRAME_HEADERS:
+        case FRAME_CONTINUATION:
+            headerBlockDone();
+            break;
+        default:
+            controlDone();
+            break;
+    }
+}
+
+void Http2Session::dataBytes(const uint8_t* data, size_t len) {
+    size_t pos = framePos;
+    if ((frameFlags & FLAG_PADDED) && pos == 0) {
+        padLen = data[0];
+        if (padLen >= frameLen) {
+            failConnection(H2_PROTOCOL_ERROR, "bourrage invalide");
+            return;
+        }
+        data++;
+        len--;
+        pos++;
+    }
+    size_t dataEnd = frameLen - padLen;
+    if (pos >= dataEnd || len == 0) return;
+    if (pos + len > dataEnd) len = dataEnd - pos;
+
+    if (frameTarget < 0) return;        // Flux deja libere: octets jetes
+    Stream& s = streams[frameTarget];
+    if (s.reset || !s.headersDone) return;
+    s.bodyBytes += len;
+    if (s.sink && !s.sink(data, len, s.arg)) resetStream(frameTarget, H2_CANCEL);
+}
+
+void Http2Session::dataDone() {
+    // Octets consommes (bourrage compris): rendus par WINDOW_UPDATE a
+    // mi-fenetre, les sinks vident tout de suite
+    connRecvUnacked += frameLen;
+    if (connRecvUnacked >= H2_CONNECTION_WINDOW / 2) {
+        sendWindowUpdate(0, connRecvUnacked);
+        connRecvUnacked = 0;
+    }
+    if (frameTarget < 0) return;
+
+    Stream& s = streams[frameTarget];
+    if (frameFlags & FLAG_END_STREAM) {
+        s.remoteClosed = true;
+    } else if (!s.reset) {
+        s.recvUnacked += frameLen;
+        if (s.recvUnacked >= H2_STREAM_WINDOW / 2) {
+            sendWindowUpdate(s.id, s.recvUnacked);
+            s.recvUnacked = 0;
+        }
+    }
+}
+
+void Http2Session::onHeader(const char* name, size_t nameLen, const char* value, size_t valueLen, void* arg) {
+    Http2Session* self = (Http2Session*)arg;
+    if (self->frameTarget < 0) return;
+    Stream& s = self->streams[self->frameTarget];
+    if (s.headersDone) return;          // Trailers ignores
+
+    if (equalsLen(name, nameLen, ":status")) {
+        s.status = parseDecimal(value, valueLen);
+    } else if (equalsLen(name, nameLen, "content-length")) {
+        s.contentLength = parseDecimal(value, valueLen);
+    }
+}
+
+void Http2Session::headerBlockDone() {
+    if (frameType == FRAME_HEADERS) {
+        // Bourrage et champs de priorite retires du fragment
+        size_t fragment = blockLen - blockFrameStart;
+        size_t skip = 0;
+        size_t pad = 0;
+        if (frameFlags & FLAG_PADDED) {
+            if (fragment < 1) {
+                failConnection(H2_PROTOCOL_ERROR, "HEADERS invalide");
+                return;
+            }
+            pad = block[blockFrameStart];
+            skip = 1;
+        }
+        if (frameFlags & FLAG_PRIORITY) skip += 5;
+        if (skip + pad > fragment) {
+            failConnection(H2_PROTOCOL_ERROR, "HEADERS invalide");
+            return;
+        }
+        memmove(block + blockFrameStart, block + blockFrameStart + skip, fragment - skip - pad);
+        blockLen = blockFrameStart + fragment - skip - pad;
+    }
+
+    if (!(frameFlags & FLAG_END_HEADERS)) {
+        expectContinuation = true;
+        return;
+    }
+    expectContinuation = false;
+
+    // Decode meme pour un flux libere: la table dynamique doit suivre
+    frameTarget = findStream(blockStream);
+    if (!decoder.decode(block, blockLen, onHeader, this)) {
+        failConnection(H2_COMPRESSION_ERROR, decoder.getError());
+        return;
+    }
+    blockLen = 0;
+    if (frameTarget < 0) return;
+
+    Stream& s = streams[frameTarget];
+    if (!s.headersDone) {
+        if (s.status >= 100 && s.status < 200) {
+            // 1xx: la vraie reponse suit dans un autre HEADERS
+            s.status = 0;
+        } else {
+            s.headersDone = true;
+            if (s.status <= 0) {
+                resetStream(frameTarget, H2_PROTOCOL_ERROR);
+            } else if (s.onHeaders && !s.reset && !s.onHeaders(s.status, s.contentLength, s.arg)) {
+                resetStream(frameTarget, H2_CANCEL);
+            }
+        }
+    }
+    if (blockEndStream) s.remoteClosed = true;
+}
+
+void Http2Session::applySetting(const uint8_t* p) {
+    uint16_t id = ((uint16_t)p[0] << 8) | p[1];
+    uint32_t value = readU32(p + 2);
+
+    switch (id) {
+        case SETTINGS_HEADER_TABLE_SIZE:
+            encoder.setMaxTableSize(value);
+            break;
+        case SETTINGS_MAX_CONCURRENT_STREAMS:
+            peerMaxStreams = value;
+            break;
+        case SETTINGS_INITIAL_WINDOW_SIZE: {
+            if (value > H2_WINDOW_MAX) {
+                failConnection(H2_FLOW_CONTROL_ERROR, "fenetre initiale invalide");
+                return;
+            }
+            // Ecart applique aux flux ouverts (fenetre eventuellement negative)
+            int32_t delta = (int32_t)value - peerInitialWindow;
+            for (int i = 0; i < H2_MAX_STREAMS; i++) {
+                if (streams[i].id != 0) streams[i].sendWindow += delta;
+            }
+            peerInitialWindow = value;
+            break;
+        }
+        case SETTINGS_MAX_FRAME_SIZE:
+            if (value < H2_FRAME_MAX || value > 0xffffff) {
+                failConnection(H2_PROTOCOL_ERROR, "taille de trame invalide");
+                return;
+            }
+            peerMaxFrame = H2_FRAME_MAX;    // Nos trames restent a 16 Ko
+            break;
+        default:
+            break;
+    }
+}
+
+void Http2Session::controlDone() {
+    switch (frameType) {
+        case FRAME_SETTINGS:
+            if (!(frameFlags & FLAG_ACK)) {
+                peerSettings = true;
+                appendFrame(FRAME_SETTINGS, FLAG_ACK, 0, nullptr, 0);
+            }
+            break;
+
+        case FRAME_PING:
+            if (!(frameFlags & FLAG_ACK)) appendFrame(FRAME_PING, FLAG_ACK, 0, control, 8);
+            break;
+
+        case FRAME_WINDOW_UPDATE: {
+            uint32_t increment = readU32(control) & H2_WINDOW_MAX;
+            if (frameStream == 0) {
+                if (increment == 0 || (int64_t)connSendWindow + increment > H2_WINDOW_MAX) {
+                    failConnection(H2_FLOW_CONTROL_ERROR, "WINDOW_UPDATE invalide");
+                    return;
+                }
+                connSendWindow += increment;
+                break;
+            }
+            int index = findStream(frameStream);
+            if (index < 0) break;
+            Stream& s = streams[index];
+            if (increment == 0 || (int64_t)s.sendWindow + increment > H2_WINDOW_MAX) {
+                resetStream(index, increment == 0 ? H2_PROTOCOL_ERROR : H2_FLOW_CONTROL_ERROR);
+                break;
+            }
+            s.sendWindow += increment;
+            break;
+        }
+
+        case FRAME_RST_STREAM: {
+            int index = findStream(frameStream);
+            if (index < 0) break;
+            Stream& s = streams[index];
+            if (!s.reset) stats.resets++;
+            s.reset = true;
+            s.resetCode = readU32(control);
+            break;
+        }
+
+        case FRAME_GOAWAY: {
+            // Flux au-dela du dernier traite: jamais vus par le serveur
+            uint32_t lastStream = readU32(control) & H2_WINDOW_MAX;
+            goaway = true;
+            error = "GOAWAY recu";
+            for (int i = 0; i < H2_MAX_STREAMS; i++) {
+                Stream& s = streams[i];
+                if (s.id > lastStream && !s.reset && !s.remoteClosed) {
+                    s.reset = true;
+                    s.resetCode = H2_REFUSED_STREAM;
+                }
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+#ifdef ARDUINO
+// ============================================================
+// Connexions TLS (ALPN h2) et requetes
+// ============================================================
+
+Http2Client http2;
+
+// Le core garde le pointeur: tableau statique
+static const char* h2Alpn[] = { "h2", "http/1.1", nullptr };
+
+static bool writeToClient(const uint8_t* data, size_t len, void* arg) {
+    PooledClient* client = (PooledClient*)arg;
+    while (len > 0) {
+        size_t n = client->write(data, len);
+        if (n == 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+static void addStats(Http2SessionStats& total, const Http2SessionStats& s) {
+    total.streams += s.streams;
+    if (s.maxConcurrent > total.maxConcurrent) total.maxConcurrent = s.maxConcurrent;
+    total.resets += s.resets;
+    total.windowStalls += s.windowStalls;
+    total.headerBytesRaw += s.headerBytesRaw;
+    total.headerBytesPacked += s.headerBytesPacked;
+    total.bytesIn += s.bytesIn;
+    total.bytesOut += s.bytesOut;
+}
+
+void Http2Connection::disconnect() {
+    if (session) {
+        session->shutdown();
+        addStats(totals, session->getStats());
+        delete session;
+        session = nullptr;
+    }
+    if (client) {
+        client->close();
+        delete client;
+        client = nullptr;
+    }
+    // Les Http2Call de l'ancienne session voient la connexion perdue
+    generation++;
+}
+
+bool Http2Connection::ensureConnected() {
+    if (session) {
+        bool idle = session->getActiveStreams() == 0;
+        if (session->isAlive() && client->connected() &&
+            !(idle && millis() - lastUsed > H2_IDLE_TIMEOUT_MS)) {
+            return true;
+        }
+        // GOAWAY: les flux deja acceptes se terminent avant de reconnecter
+        if (!session->isDead() && !idle && client->connected()) return true;
+        disconnect();
+    }
+    if (h1Only) return false;
+
+    client = new PooledClient();
+    client->setAlpnProtocols(h2Alpn);
+    unsigned long start = millis();
+    if (!client->connectResumable(host, port)) {
+        delete client;
+        client = nullptr;
+        failures++;
+        Serial.printf("HTTP/2: connexion %s echouee\n", host);
+        return false;
+    }
+
+    const char* alpn = client->getAlpnProtocol();
+    if (!alpn || strcmp(alpn, "h2") != 0) {
+        // Serveur HTTP/1.1 seulement: le pool reste utilise pour cet hote
+        Serial.printf("HTTP/2: %s refuse h2 (ALPN %s), HTTP/1.1\n", host, alpn ? alpn : "absent");
+        h1Only = true;
+        client->close();
+        delete client;
+        client = nullptr;
+        return false;
+    }
+
+    session = new Http2Session(writeToClient, client);
+    if (!session->start()) {
+        Serial.printf("HTTP/2: preface %s echouee (%s)\n", host, session->getError());
+        disconnect();
+        failures++;
+        return false;
+    }
+    connects++;
+    lastUsed = millis();
+    Serial.printf("HTTP/2: connexion %s en %lu ms (%s)\n", host, millis() - start, client->getCipherSuite());
+    return true;
+}
+
+bool Http2Connection::pump() {
+    if (!session) return false;
+    if (!session->flush()) return false;
+
+    int avail;
+    while ((avail = client->available()) > 0) {
+        int n = client->read(rx, avail < (int)sizeof(rx) ? avail : sizeof(rx));
+        if (n <= 0) break;
+        lastUsed = millis();
+        if (!session->feed(rx, n)) break;
+    }
+    if (!session->isDead() && !client->connected()) session->abort("connexion fermee par le serveur");
+    return !session->isDead();
+}
+
+// ============================================================
+// Http2Call
+// ============================================================
+
+Http2Call::Http2Call() {
+    conn = nullptr;
+    generation = 0;
+    stream = -1;
+    status = 0;
+    bodyBytes = 0;
+    cancelled = false;
+    error = "";
+}
+
+Http2Call::~Http2Call() {
+    release();
+}
+
+bool Http2Call::attached() {
+    return conn && stream >= 0 && conn->session && conn->generation == generation;
+}
+
+void Http2Call::release() {
+    if (!conn || stream < 0) return;
+    conn->lock();
+    if (attached()) conn->session->close(stream);
+    conn->unlock();
+    stream = -1;
+}
+
+bool Http2Call::begin(const char* host, uint16_t port, const Http2Request& req) {
+    release();
+    status = 0;
+    bodyBytes = 0;
+    cancelled = false;
+    conn = http2.isEnabled() ? http2.find(host, port) : nullptr;
+    if (!conn || conn->h1Only) {
+        error = "HTTP/2 indisponible";
+        return false;
+    }
+
+    unsigned long start = millis();
+    while (true) {
+        conn->lock();
+        if (!conn->ensureConnected()) {
+            conn->unlock();
+            error = "connexion HTTP/2 echouee";
+            return false;
+        }
+
+        Http2Session* session = conn->session;
+        if (session->isAlive() && session->canOpen()) {
+            bool shared = session->getActiveStreams() > 0;
+            stream = session->open(req);
+            if (stream >= 0) {
+                generation = conn->generation;
+                conn->requests++;
+                if (shared) conn->sharedRequests++;
+                conn->lastUsed = millis();
+            } else {
+                error = session->getError();
+            }
+            conn->unlock();
+            return stream >= 0;
+        }
+
+        // Tous les flux occupes (ou GOAWAY): les reponses en cours avancent
+        conn->pump();
+        conn->unlock();
+        if (millis() - start > H2_OPEN_TIMEOUT_MS) {
+            error = "aucun flux HTTP/2 libre";
+            return false;
+        }
+        delay(2);
+    }
+}
+
+size_t Http2Call::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t Http2Call::write(const uint8_t* data, size_t len) {
+    if (!conn) return 0;
+    size_t done = 0;
+    unsigned long last = millis();
+
+    while (done < len) {
+        conn->lock();
+        if (!attached() || conn->session->isDone(stream)) {
+            // Reponse anticipee (erreur 4xx) ou connexion perdue
+            conn->unlock();
+            error = "flux ferme pendant l'envoi";
+            break;
+        }
+        size_t n = conn->session->send(stream, data + done, len - done);
+        // Fenetre epuisee: lire les WINDOW_UPDATE du serveur
+        if (n == 0) conn->pump();
+        conn->unlock();
+
+        if (n > 0) {
+            done += n;
+            last = millis();
+            continue;
+        }
+        if (millis() - last > H2_WRITE_TIMEOUT_MS) {
+            error = "fenetre d'envoi fermee";
+            break;
+        }
+        delay(1);
+    }
+    return done;
+}
+
+bool Http2Call::finish(unsigned long timeoutMs, volatile bool* cancel) {
+    if (!conn || stream < 0) return false;
+
+    conn->lock();
+    if (attached()) conn->session->end(stream);
+    conn->unlock();
+
+    unsigned long start = millis();
+    bool reset = false;
+    while (true) {
+        conn->lock();
+        bool ok = attached();
+        bool done = false;
+        if (ok) {
+            // Lit pour tous les flux: sinks et onHeaders des autres requetes
+            // peuvent etre appeles depuis cette tache
+            conn->pump();
+            done = conn->session->isDone(stream);
+            if (done) {
+                status = conn->session->getStatus(stream);
+                bodyBytes = conn->session->getBodyBytes(stream);
+                reset = conn->session->isReset(stream);
+                if (reset) error = conn->session->isDead() ? conn->session->getError() : "flux reinitialise";
+            }
+        }
+        conn->unlock();
+
+        if (!ok) {
+            error = "connexion HTTP/2 perdue";
+            stream = -1;
+            return false;
+        }
+        if (done) break;
+        if (cancel && *cancel) {
+            // RST_STREAM: la connexion reste ouverte pour les autres flux
+            cancelled = true;
+            error = "annule";
+            release();
+            return false;
+        }
+        if (millis() - start > timeoutMs) {
+            error = "delai depasse";
+            release();
+            return false;
+        }
+        delay(2);
+    }
+
+    release();
+    return !reset && status > 0;
+}
+
+// ============================================================
+// Http2Client
+// ============================================================
+
+Http2Client::Http2Client() {
+    count = 0;
+    enabled = true;
+}
+
+Http2Connection* Http2Client::find(const char* host, uint16_t port) {
+    for (int i = 0; i < count; i++) {
+        if (connections[i].port == port && strcmp(connections[i].host, host) == 0) return &connections[i];
+    }
+    return nullptr;
+}
+
+bool Http2Client::addHost(const char* host, uint16_t port) {
+    if (find(host, port)) return true;
+    if (count >= H2_MAX_CONNECTIONS) return false;
+
+    Http2Connection& c = connections[count];
+    memset(&c, 0, sizeof(c));
+    strncpy(c.host, host, H2_HOST_LEN - 1);
+    c.port = port;
+    c.mutex = xSemaphoreCreateMutex();
+    count++;
+    return true;
+}
+
+bool Http2Client::handles(const char* host, uint16_t port) {
+    if (!enabled) return false;
+    Http2Connection* c = find(host, port);
+    return c && !c->h1Only;
+}
+
+bool Http2Client::prewarm(const char* host, uint16_t port) {
+    Http2Connection* c = find(host, port);
+    if (!enabled || !c || c->h1Only) return false;
+    c->lock();
+    // SETTINGS du serveur lus tout de suite
+    bool ok = c->ensureConnected() && c->pump();
+    c->unlock();
+    return ok;
+}
+
+void Http2Client::setEnabled(bool on) {
+    enabled = on;
+    for (int i = 0; i < count; i++) {
+        // Nouvel essai ALPN a la reactivation
+        if (on) connections[i].h1Only = false;
+    }
+    if (!on) closeAll();
+}
+
+void Http2Client::closeAll() {
+    for (int i = 0; i < count; i++) {
+        Http2Connection& c = connections[i];
+        c.lock();
+        if (c.session) c.disconnect();
+        c.unlock();
+    }
+}
+
+void Http2Client::printStats() {
+    Serial.println("\n=== HTTP/2 ===");
+    Serial.printf("Etat: %s\n", enabled ? "ON" : "OFF (HTTP/1.1 via le pool)");
+    for (int i = 0; i < count; i++) {
+        Http2Connection& c = connections[i];
+        c.lock();
+        Http2SessionStats s = c.totals;
+        const char* state = c.h1Only ? "HTTP/1.1 (ALPN)" : "fermee";
+        if (c.session) {
+            addStats(s, c.session->getStats());
+            if (c.session->isAlive()) state = "ouverte";
+        }
+        c.unlock();
+
+        Serial.printf("%s:%u %s | connexions %u | requetes %u (%u simultanees) | echecs %u\n",
+                      c.host, c.port, state, c.connects, c.requests, c.sharedRequests, c.failures);
+        Serial.printf("  Flux: %u (pic %u) | RST %u | fenetre d'envoi pleine %u fois\n",
+                      s.streams, s.maxConcurrent, s.resets, s.windowStalls);
+        Serial.printf("  En-tetes: %u -> %u octets HPACK (%.0f%%) | recus %u Ko, envoyes %u Ko\n",
+                      s.headerBytesRaw, s.headerBytesPacked,
+                      s.headerBytesRaw ? 100.0f * s.headerBytesPacked / s.headerBytesRaw : 0.0f,
+                      s.bytesIn / 1024, s.bytesOut / 1024);
+    }
+    Serial.println("==============\n");
+}
+#endif
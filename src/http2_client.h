@@ -0,0 +1,301 @@
+// http2_client.h - Client HTTP/2 minimal (RFC 9113) pour api.groq.com
+// Groq sert la transcription (Whisper) et la synthese (TTS) sur le meme
+// hote. En HTTP/1.1 chaque requete occupe un socket du pool jusqu'a la
+// fin de sa reponse: deux requetes simultanees = deux handshakes TLS, et
+// l'annulation d'un STT speculatif coute le socket. Ici une connexion TLS
+// par hote (ALPN "h2") porte plusieurs flux: en-tetes HPACK (hpack.h),
+// controle de flux par flux et par connexion, poids de priorite envoyes
+// avec HEADERS, annulation par RST_STREAM sans fermer la connexion.
+// Pas de push serveur (SETTINGS_ENABLE_PUSH = 0), pas de h2c.
+// Le coeur (Http2Session) ne depend pas d'Arduino: il se compile aussi
+// sous Linux contre un serveur h2 local (tools/h2_client).
+#ifndef HTTP2_CLIENT_H
+#define HTTP2_CLIENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hpack.h"
+#include "http_response.h"
+
+#define H2_MAX_STREAMS          4         // Flux simultanes par connexion
+#define H2_FRAME_MAX            16384     // SETTINGS_MAX_FRAME_SIZE (minimum RFC)
+#define H2_OUT_BUFFER           16384     // Trames regroupees en records TLS pleins
+#define H2_HEADER_BLOCK_MAX     4096      // HEADERS + CONTINUATION recus
+#define H2_REQUEST_HEADERS_MAX  512       // Bloc HPACK d'une requete
+#define H2_CONTROL_MAX          64        // Charge utile gardee (GOAWAY: debug tronque)
+#define H2_STREAM_WINDOW        262144    // Fenetre de reception par flux
+#define H2_CONNECTION_WINDOW    1048576   // Fenetre de reception de la connexion
+#define H2_DEFAULT_WINDOW       65535
+#define H2_DEFAULT_WEIGHT       16
+
+// Codes d'erreur RST_STREAM / GOAWAY
+#define H2_NO_ERROR             0x0
+#define H2_PROTOCOL_ERROR       0x1
+#define H2_FLOW_CONTROL_ERROR   0x3
+#define H2_FRAME_SIZE_ERROR     0x6
+#define H2_REFUSED_STREAM       0x7
+#define H2_CANCEL               0x8
+#define H2_COMPRESSION_ERROR    0x9
+
+// Octets a envoyer au serveur. false: socket en erreur.
+typedef bool (*Http2WriteFn)(const uint8_t* data, size_t len, void* arg);
+// Statut et en-tetes recus, avant le corps: preparer le sink (tampon a la
+// taille annoncee, texte d'erreur...). false: abandonner le flux.
+typedef bool (*Http2HeadersFn)(int status, long contentLength, void* arg);
+
+struct Http2Request {
+    const char* method;
+    const char* scheme;             // nullptr: "https"
+    const char* authority;
+    const char* path;
+    const HpackHeader* headers;     // En-tetes en minuscules
+    int headerCount;
+    long contentLength;             // -1: inconnue, 0: sans corps
+    int weight;                     // 1-256, 0: H2_DEFAULT_WEIGHT
+    Http2HeadersFn onHeaders;       // Optionnel
+    HttpBodySink sink;              // Corps de la reponse (optionnel)
+    void* arg;                      // Passe a onHeaders et au sink
+};
+
+struct Http2SessionStats {
+    uint32_t streams;
+    uint32_t maxConcurrent;         // Pic de flux ouverts en meme temps
+    uint32_t resets;                // RST_STREAM envoyes ou recus
+    uint32_t windowStalls;          // Envoi bloque par une fenetre epuisee
+    uint32_t headerBytesRaw;        // En-tetes de requete en clair
+    uint32_t headerBytesPacked;     // Les memes apres HPACK
+    uint32_t bytesIn;
+    uint32_t bytesOut;
+};
+
+class Http2Session {
+public:
+    Http2Session(Http2WriteFn write, void* writeArg);
+    ~Http2Session();
+
+    // Preface, SETTINGS et fenetre de connexion
+    bool start();
+
+    // Octets recus du serveur. Traite toutes les trames completes et
+    // repond aux SETTINGS/PING. false: connexion inutilisable.
+    bool feed(const uint8_t* data, size_t len);
+
+    // Nouveau flux: HEADERS (+ END_STREAM si contentLength == 0).
+    // Retourne l'indice du flux, -1 si aucun flux disponible.
+    int open(const Http2Request& req);
+    // Corps: octets acceptes par les fenetres d'envoi (0: attendre un
+    // WINDOW_UPDATE, voir feed())
+    size_t send(int stream, const uint8_t* data, size_t len);
+    // Fin du corps (DATA vide + END_STREAM)
+    bool end(int stream);
+    // Libere le flux, RST_STREAM CANCEL si la reponse n'est pas finie
+    void close(int stream);
+
+    // Trames en attente vers le socket (appele avant d'attendre le serveur)
+    bool flush();
+    // Socket ferme: flux en cours termines en erreur
+    void abort(const char* reason);
+    // GOAWAY NO_ERROR
+    void shutdown();
+
+    bool canOpen();
+    bool isAlive() { return !dead && !goaway; }
+    bool isDead() { return dead; }
+    int getActiveStreams();
+    const char* getError() { return error; }
+
+    bool isDone(int stream);
+    bool isReset(int stream);
+    uint32_t getResetCode(int stream);
+    int getStatus(int stream);
+    uint32_t getBodyBytes(int stream);
+
+    const Http2SessionStats& getStats() { return stats; }
+
+private:
+    struct Stream {
+        uint32_t id;                // 0: indice libre
+        bool localClosed;           // END_STREAM envoye
+        bool remoteClosed;          // END_STREAM recu
+        bool reset;
+        uint32_t resetCode;
+        int32_t sendWindow;
+        uint32_t recvUnacked;
+        int status;
+        long contentLength;
+        uint32_t bodyBytes;
+        bool headersDone;
+        Http2HeadersFn onHeaders;
+        HttpBodySink sink;
+        void* arg;
+    };
+
+    Http2WriteFn writeFn;
+    void* writeArg;
+    Stream streams[H2_MAX_STREAMS];
+    uint32_t nextStreamId;
+
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+
+    // Parametres du serveur
+    bool peerSettings;              // Premier SETTINGS du serveur recu
+    uint32_t peerMaxStreams;
+    int32_t peerInitialWindow;
+    uint32_t peerMaxFrame;
+    int32_t connSendWindow;
+    uint32_t connRecvUnacked;
+
+    bool dead;
+    bool goaway;
+    const char* error;
+
+    // Trame en cours de reception
+    uint8_t head[9];
+    size_t headLen;
+    uint32_t frameLen;
+    uint8_t frameType;
+    uint8_t frameFlags;
+    uint32_t frameStream;
+    uint32_t framePos;
+    uint8_t padLen;
+    int frameTarget;                // Indice du flux de la trame DATA/HEADERS
+    uint8_t control[H2_CONTROL_MAX];
+    size_t controlLen;
+
+    // Bloc d'en-tetes (HEADERS + CONTINUATION)
+    uint8_t block[H2_HEADER_BLOCK_MAX];
+    size_t blockLen;
+    size_t blockFrameStart;
+    bool expectContinuation;
+    uint32_t blockStream;
+    bool blockEndStream;
+
+    uint8_t* out;
+    size_t outLen;
+    uint8_t encoded[H2_REQUEST_HEADERS_MAX];
+
+    Http2SessionStats stats;
+
+    int findStream(uint32_t id);
+    bool append(const uint8_t* data, size_t len);
+    bool appendFrame(uint8_t type, uint8_t flags, uint32_t stream, const uint8_t* payload, size_t len);
+    void writeFrameHeader(uint8_t* p, uint32_t len, uint8_t type, uint8_t flags, uint32_t stream);
+    void sendWindowUpdate(uint32_t stream, uint32_t increment);
+    void resetStream(int index, uint32_t code);
+    void failConnection(uint32_t code, const char* reason);
+
+    bool beginFrame();
+    void frameBytes(const uint8_t* data, size_t len);
+    void endFrame();
+    void dataBytes(const uint8_t* data, size_t len);
+    void dataDone();
+    void headerBlockDone();
+    void applySetting(const uint8_t* p);
+    void controlDone();
+
+    static void onHeader(const char* name, size_t nameLen, const char* value, size_t valueLen, void* arg);
+};
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "connection_pool.h"
+
+#define H2_MAX_CONNECTIONS      2
+#define H2_HOST_LEN             64
+#define H2_READ_CHUNK           1024
+#define H2_OPEN_TIMEOUT_MS      10000     // Attente d'un flux libre
+#define H2_WRITE_TIMEOUT_MS     30000     // Fenetre d'envoi fermee trop longtemps
+#define H2_IDLE_TIMEOUT_MS      60000     // Connexion inactive: rouverte (NAT, serveur)
+
+// Connexion TLS vers un hote, partagee par les taches (mutex)
+struct Http2Connection {
+    char host[H2_HOST_LEN];
+    uint16_t port;
+    PooledClient* client;
+    Http2Session* session;
+    SemaphoreHandle_t mutex;
+    uint32_t generation;            // Incremente a chaque nouvelle connexion
+    bool h1Only;                    // ALPN refuse: HTTP/1.1 via le pool
+    unsigned long lastUsed;
+    uint8_t rx[H2_READ_CHUNK];
+
+    uint32_t connects;
+    uint32_t requests;
+    uint32_t sharedRequests;        // Requetes ouvertes pendant une autre
+    uint32_t failures;
+    Http2SessionStats totals;       // Sessions precedentes
+
+    void lock() { xSemaphoreTake(mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGive(mutex); }
+    bool ensureConnected();
+    bool pump();
+    void disconnect();
+};
+
+// Une requete sur la connexion HTTP/2 de l'hote. Print: le corps s'ecrit
+// avec write() (payload JSON, MultipartWriter::sendBody()).
+class Http2Call : public Print {
+public:
+    Http2Call();
+    ~Http2Call();
+
+    // Ouvre le flux (attend un flux libre). false: HTTP/2 indisponible
+    // pour cet hote, passer par HTTP/1.1.
+    bool begin(const char* host, uint16_t port, const Http2Request& req);
+
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+
+    // Fin du corps puis reponse complete (sink et onHeaders appeles par la
+    // tache qui lit le socket, pas forcement celle-ci). *cancel: RST_STREAM.
+    bool finish(unsigned long timeoutMs, volatile bool* cancel = nullptr);
+
+    int getStatus() { return status; }
+    uint32_t getBodyBytes() { return bodyBytes; }
+    bool wasCancelled() { return cancelled; }
+    const char* getError() { return error; }
+
+private:
+    Http2Connection* conn;
+    uint32_t generation;
+    int stream;
+    int status;
+    uint32_t bodyBytes;
+    bool cancelled;
+    const char* error;
+
+    bool attached();
+    void release();
+};
+
+class Http2Client {
+public:
+    Http2Client();
+
+    // Hote servi en HTTP/2 quand le serveur accepte "h2"
+    bool addHost(const char* host, uint16_t port = 443);
+    // Actif, hote declare et ALPN pas encore refuse
+    bool handles(const char* host, uint16_t port);
+    // Connexion ouverte d'avance (pre-chauffage au debut de parole)
+    bool prewarm(const char* host, uint16_t port);
+
+    void setEnabled(bool on);
+    bool isEnabled() { return enabled; }
+    void closeAll();
+    void printStats();
+
+private:
+    friend class Http2Call;
+    Http2Connection connections[H2_MAX_CONNECTIONS];
+    int count;
+    bool enabled;
+
+    Http2Connection* find(const char* host, uint16_t port);
+};
+
+extern Http2Client http2;
+#endif
+
+#endif
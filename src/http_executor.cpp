@@ -0,0 +1,321 @@
+// http_executor.cpp - Executeur de requetes HTTP en parallele
+#include "http_executor.h"
+
+HttpExecutor httpExecutor;
+
+// ============================================================
+// HttpFuture
+// ============================================================
+
+HttpFuture::HttpFuture() {
+    name = "";
+    fn = nullptr;
+    arg = nullptr;
+    callback = nullptr;
+    priority = HTTP_PRIORITY_USER;
+    doneSignal = xSemaphoreCreateBinary();
+    pending = false;
+    result = false;
+    cancelled = false;
+    deferred = false;
+    bytes = 0;
+    submittedAt = 0;
+    startedAt = 0;
+    finishedAt = 0;
+}
+
+HttpFuture::~HttpFuture() {
+    if (doneSignal) vSemaphoreDelete(doneSignal);
+}
+
+bool HttpFuture::wait(unsigned long timeoutMs) {
+    if (!pending) return true;
+    if (xSemaphoreTake(doneSignal, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) return false;
+    return true;
+}
+
+// ============================================================
+// Pool de taches
+// ============================================================
+
+HttpExecutor::HttpExecutor() {
+    memset(queues, 0, sizeof(queues));
+    work = nullptr;
+    started = false;
+    statsMux = portMUX_INITIALIZER_UNLOCKED;
+    memset(workerTasks, 0, sizeof(workerTasks));
+    memset(workerJobs, 0, sizeof(workerJobs));
+    interactiveDepth = 0;
+    backgroundActive = 0;
+    budgetWindowStart = 0;
+    budgetUsed = 0;
+    memset(classStats, 0, sizeof(classStats));
+    active = 0;
+    peakActive = 0;
+    completed = 0;
+    failed = 0;
+    inlineRuns = 0;
+    queueMsMax = 0;
+}
+
+bool HttpExecutor::begin() {
+    if (started) return true;
+
+    for (int p = 0; p < HTTP_PRIORITY_COUNT; p++) {
+        queues[p] = xQueueCreate(HTTP_EXECUTOR_QUEUE, sizeof(HttpFuture*));
+    }
+    work = xSemaphoreCreateCounting(HTTP_EXECUTOR_QUEUE * HTTP_PRIORITY_COUNT, 0);
+    if (!queues[HTTP_PRIORITY_INTERACTIVE] || !queues[HTTP_PRIORITY_USER] ||
+        !queues[HTTP_PRIORITY_BACKGROUND] || !work) {
+        Serial.println("Executeur HTTP: file non creee, requetes sequentielles");
+        return false;
+    }
+
+    int workers = 0;
+    for (int i = 0; i < HTTP_EXECUTOR_WORKERS; i++) {
+        char taskName[12];
+        snprintf(taskName, sizeof(taskName), "http_w%d", i);
+        if (xTaskCreatePinnedToCore(workerLoop, taskName, HTTP_WORKER_STACK, this, 1, &workerTasks[i], 0) == pdPASS) {
+            workers++;
+        }
+    }
+    started = workers > 0;
+
+    Serial.printf("Executeur HTTP: %d taches\n", workers);
+    return started;
+}
+
+void HttpExecutor::workerLoop(void* param) {
+    HttpExecutor* self = (HttpExecutor*)param;
+    while (true) {
+        if (xSemaphoreTake(self->work, portMAX_DELAY) != pdTRUE) continue;
+        HttpFuture* future = self->next();
+        if (future) {
+            self->run(future);
+        } else if (uxQueueMessagesWaiting(self->queues[HTTP_PRIORITY_BACKGROUND]) > 0) {
+            // Seul du fond differe reste en file: jeton rendu, nouvel essai
+            xSemaphoreGive(self->work);
+            delay(HTTP_DEFER_POLL_MS);
+        }
+        // Sinon le job de ce jeton a ete annule (cancelBackground)
+    }
+}
+
+const char* HttpExecutor::backgroundBlocked() {
+    if (interactiveDepth > 0) return "tour vocal";
+
+    portENTER_CRITICAL(&statsMux);
+    if (millis() - budgetWindowStart >= HTTP_BUDGET_WINDOW_MS) {
+        budgetWindowStart = millis();
+        budgetUsed = 0;
+    }
+    bool overBudget = budgetUsed >= HTTP_BACKGROUND_BUDGET;
+    bool busy = backgroundActive >= HTTP_BACKGROUND_WORKERS;
+    portEXIT_CRITICAL(&statsMux);
+
+    if (overBudget) return "budget";
+    if (busy) return "tache de fond occupee";
+    return nullptr;
+}
+
+HttpFuture* HttpExecutor::next() {
+    HttpFuture* future;
+    if (xQueueReceive(queues[HTTP_PRIORITY_INTERACTIVE], &future, 0) == pdTRUE) return future;
+    if (xQueueReceive(queues[HTTP_PRIORITY_USER], &future, 0) == pdTRUE) return future;
+
+    QueueHandle_t background = queues[HTTP_PRIORITY_BACKGROUND];
+    if (xQueuePeek(background, &future, 0) != pdTRUE) return nullptr;
+
+    const char* reason = backgroundBlocked();
+    if (reason) {
+        // Compte une fois par job, pas a chaque nouvel essai
+        if (!future->deferred) {
+            future->deferred = true;
+            portENTER_CRITICAL(&statsMux);
+            classStats[HTTP_PRIORITY_BACKGROUND].deferred++;
+            portEXIT_CRITICAL(&statsMux);
+            Serial.printf("Executeur HTTP: %s differe (%s)\n", future->name, reason);
+        }
+        return nullptr;
+    }
+
+    portENTER_CRITICAL(&statsMux);
+    bool slot = backgroundActive < HTTP_BACKGROUND_WORKERS;
+    if (slot) backgroundActive++;
+    portEXIT_CRITICAL(&statsMux);
+    if (!slot) return nullptr;
+
+    if (xQueueReceive(background, &future, 0) == pdTRUE) return future;
+
+    // Job annule entre-temps
+    portENTER_CRITICAL(&statsMux);
+    backgroundActive--;
+    portEXIT_CRITICAL(&statsMux);
+    return nullptr;
+}
+
+int HttpExecutor::workerSlot() {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < HTTP_EXECUTOR_WORKERS; i++) {
+        if (workerTasks[i] == self) return i;
+    }
+    return -1;
+}
+
+void HttpExecutor::chargeBytes(size_t n) {
+    if (!started) return;
+    int slot = workerSlot();
+    if (slot < 0) return;
+    // Seule cette tache ecrit le compteur de son job
+    HttpFuture* future = workerJobs[slot];
+    if (future) future->bytes += n;
+}
+
+void HttpExecutor::run(HttpFuture* future) {
+    future->startedAt = millis();
+    HttpPriority priority = future->priority;
+    int slot = workerSlot();
+    if (slot >= 0) workerJobs[slot] = future;
+
+    portENTER_CRITICAL(&statsMux);
+    active++;
+    if (active > peakActive) peakActive = active;
+    uint32_t queued = future->startedAt - future->submittedAt;
+    if (queued > queueMsMax) queueMsMax = queued;
+    classStats[priority].queueMsTotal += queued;
+    if (queued > classStats[priority].queueMsMax) classStats[priority].queueMsMax = queued;
+    portEXIT_CRITICAL(&statsMux);
+
+    bool ok = future->fn(future->arg);
+    future->finishedAt = millis();
+    if (slot >= 0) workerJobs[slot] = nullptr;
+
+    portENTER_CRITICAL(&statsMux);
+    active--;
+    completed++;
+    if (!ok) failed++;
+    classStats[priority].completed++;
+    classStats[priority].bytes += future->bytes;
+    if (priority == HTTP_PRIORITY_BACKGROUND) {
+        budgetUsed += future->bytes;
+        // Job execute sur la tache appelante: aucun emplacement pris
+        if (slot >= 0) backgroundActive--;
+    }
+    portEXIT_CRITICAL(&statsMux);
+
+    if (future->callback) future->callback(ok, future->arg);
+
+    // Resultat visible avant le signal de fin
+    future->result = ok;
+    future->pending = false;
+    xSemaphoreGive(future->doneSignal);
+}
+
+bool HttpExecutor::submit(HttpFuture& future, const char* name, HttpJobFn fn,
+                          void* arg, HttpJobCallback callback, HttpPriority priority) {
+    if (future.pending) return false;
+
+    // Signal d'une execution precedente jamais attendue
+    xSemaphoreTake(future.doneSignal, 0);
+
+    future.name = name;
+    future.fn = fn;
+    future.arg = arg;
+    future.callback = callback;
+    future.priority = priority;
+    future.result = false;
+    future.cancelled = false;
+    future.deferred = false;
+    future.bytes = 0;
+    future.pending = true;
+    future.submittedAt = millis();
+
+    portENTER_CRITICAL(&statsMux);
+    classStats[priority].submitted++;
+    portEXIT_CRITICAL(&statsMux);
+
+    HttpFuture* ptr = &future;
+    if (!started || xQueueSend(queues[priority], &ptr, 0) != pdTRUE) {
+        portENTER_CRITICAL(&statsMux);
+        inlineRuns++;
+        portEXIT_CRITICAL(&statsMux);
+        run(&future);
+        return true;
+    }
+    xSemaphoreGive(work);
+    return true;
+}
+
+void HttpExecutor::beginInteractive(bool cancelQueued) {
+    portENTER_CRITICAL(&statsMux);
+    interactiveDepth++;
+    portEXIT_CRITICAL(&statsMux);
+    if (cancelQueued) cancelBackground();
+}
+
+void HttpExecutor::endInteractive() {
+    portENTER_CRITICAL(&statsMux);
+    if (interactiveDepth > 0) interactiveDepth--;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+int HttpExecutor::cancelBackground() {
+    if (!started) return 0;
+
+    int count = 0;
+    HttpFuture* future;
+    while (xQueueReceive(queues[HTTP_PRIORITY_BACKGROUND], &future, 0) == pdTRUE) {
+        // Jeton deja pris par une tache: elle trouvera la file vide
+        xSemaphoreTake(work, 0);
+
+        future->finishedAt = future->startedAt = millis();
+        future->cancelled = true;
+        portENTER_CRITICAL(&statsMux);
+        classStats[HTTP_PRIORITY_BACKGROUND].cancelled++;
+        portEXIT_CRITICAL(&statsMux);
+
+        if (future->callback) future->callback(false, future->arg);
+        future->result = false;
+        future->pending = false;
+        xSemaphoreGive(future->doneSignal);
+        count++;
+    }
+    if (count > 0) Serial.printf("Executeur HTTP: %d job(s) de fond annule(s)\n", count);
+    return count;
+}
+
+bool HttpExecutor::waitAll(HttpFuture* futures, int count, unsigned long timeoutMs) {
+    unsigned long start = millis();
+    bool all = true;
+    for (int i = 0; i < count; i++) {
+        unsigned long elapsed = millis() - start;
+        unsigned long remaining = elapsed < timeoutMs ? timeoutMs - elapsed : 0;
+        if (!futures[i].wait(remaining)) all = false;
+    }
+    return all;
+}
+
+void HttpExecutor::printStats() {
+    Serial.println("\n=== EXECUTEUR HTTP ===");
+    Serial.printf("Taches: %d | Actives: %d (pic %d)\n",
+                  started ? HTTP_EXECUTOR_WORKERS : 0, active, peakActive);
+    Serial.printf("Jobs: %u termines, %u en echec, %u sans pool\n", completed, failed, inlineRuns);
+    Serial.printf("Attente en file max: %u ms\n", queueMsMax);
+
+    static const char* classNames[HTTP_PRIORITY_COUNT] = { "interactif", "utilisateur", "fond" };
+    Serial.println("Classe       soumis  termines  annules  differes  attente moy/max ms  octets");
+    portENTER_CRITICAL(&statsMux);
+    HttpClassStats snapshot[HTTP_PRIORITY_COUNT];
+    memcpy(snapshot, classStats, sizeof(snapshot));
+    uint32_t used = budgetUsed;
+    portEXIT_CRITICAL(&statsMux);
+    for (int p = 0; p < HTTP_PRIORITY_COUNT; p++) {
+        const HttpClassStats& c = snapshot[p];
+        Serial.printf("%-11s  %6u  %8u  %7u  %8u  %8u / %-7u  %u\n", classNames[p],
+                      c.submitted, c.completed, c.cancelled, c.deferred,
+                      c.completed ? c.queueMsTotal / c.completed : 0, c.queueMsMax, c.bytes);
+    }
+    Serial.printf("Budget du fond: %u / %u octets cette minute | Tour vocal: %s\n",
+                  used, HTTP_BACKGROUND_BUDGET, interactiveDepth > 0 ? "oui" : "non");
+    Serial.println("======================\n");
+}
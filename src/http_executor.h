@@ -0,0 +1,148 @@
+// http_executor.h - Executeur de requetes HTTP en parallele
+// refreshBitcoinData() enchainait 7 appels HTTPS bloquants (prix, frais,
+// hauteur, mempool, hashrate, lightning, solde LNbits): le rafraichissement
+// durait la somme des requetes. Les requetes independantes sont confiees a
+// un petit pool de taches (HTTP_EXECUTOR_WORKERS connexions au plus), la
+// duree totale tend vers celle de la requete la plus lente.
+// Les jobs ont une classe de priorite: le fond (rafraichissement
+// periodique, polling des mineurs) passe apres les requetes de
+// l'utilisateur, attend la fin d'un tour vocal (beginInteractive) et
+// consomme au plus HTTP_BACKGROUND_BUDGET octets par minute.
+#ifndef HTTP_EXECUTOR_H
+#define HTTP_EXECUTOR_H
+
+#include <Arduino.h>
+
+#define HTTP_EXECUTOR_WORKERS   3        // Requetes simultanees (sessions TLS)
+#define HTTP_EXECUTOR_QUEUE     16
+#define HTTP_WORKER_STACK       10240    // Handshake mbedtls + JSON
+#define HTTP_BACKGROUND_WORKERS 1        // Taches prises par le fond (les autres restent libres)
+#define HTTP_BACKGROUND_BUDGET  65536    // Octets HTTP par minute pour le fond
+#define HTTP_BUDGET_WINDOW_MS   60000
+#define HTTP_DEFER_POLL_MS      50       // Job de fond differe: nouvel essai
+
+enum HttpPriority {
+    HTTP_PRIORITY_INTERACTIVE,  // Tour vocal en cours (pre-chauffage)
+    HTTP_PRIORITY_USER,         // Demande de l'utilisateur (contexte Claude, menus)
+    HTTP_PRIORITY_BACKGROUND,   // Rafraichissement periodique, polling
+    HTTP_PRIORITY_COUNT
+};
+
+struct HttpClassStats {
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t cancelled;         // Retires de la file par un tour vocal
+    uint32_t deferred;          // Jobs retardes (tour vocal, budget, tache de fond occupee)
+    uint32_t queueMsTotal;
+    uint32_t queueMsMax;
+    uint32_t bytes;             // Octets lus + ecrits via PooledClient
+};
+
+// Job execute sur une tache du pool. Doit etre thread-safe vis-a-vis des
+// autres jobs (un module = ses propres champs, erreurs protegees).
+typedef bool (*HttpJobFn)(void* arg);
+// Rappel optionnel, appele sur la tache du pool a la fin du job
+typedef void (*HttpJobCallback)(bool ok, void* arg);
+
+// Resultat d'un job soumis (futur). Doit survivre a l'execution du job:
+// le declarer static ou membre, pas sur la pile d'un appel qui peut
+// abandonner l'attente.
+class HttpFuture {
+public:
+    HttpFuture();
+    ~HttpFuture();
+
+    // Attendre la fin du job. false si le delai expire.
+    bool wait(unsigned long timeoutMs);
+    bool isPending() { return pending; }
+    bool succeeded() { return result; }
+    // Job de fond retire de la file avant execution (succeeded() = false)
+    bool wasCancelled() { return cancelled; }
+    const char* getName() { return name; }
+
+    uint32_t getQueueMs() { return startedAt - submittedAt; }
+    uint32_t getRunMs() { return finishedAt - startedAt; }
+
+private:
+    friend class HttpExecutor;
+    const char* name;
+    HttpJobFn fn;
+    void* arg;
+    HttpJobCallback callback;
+    HttpPriority priority;
+    SemaphoreHandle_t doneSignal;
+    volatile bool pending;
+    bool result;
+    bool cancelled;
+    bool deferred;
+    uint32_t bytes;
+    unsigned long submittedAt;
+    unsigned long startedAt;
+    unsigned long finishedAt;
+};
+
+class HttpExecutor {
+public:
+    HttpExecutor();
+
+    // Cree les taches du pool (core 0, comme la pile reseau)
+    bool begin();
+
+    // Mettre un job en file. Sans pool (begin() non appele ou file pleine),
+    // le job s'execute tout de suite sur la tache appelante.
+    // false si le futur est encore en cours (soumission precedente).
+    // Les taches prennent toujours la classe la plus prioritaire en file.
+    bool submit(HttpFuture& future, const char* name, HttpJobFn fn,
+                void* arg = nullptr, HttpJobCallback callback = nullptr,
+                HttpPriority priority = HTTP_PRIORITY_USER);
+
+    // Attendre un lot de futurs. false si le delai global expire.
+    bool waitAll(HttpFuture* futures, int count, unsigned long timeoutMs);
+
+    // Tour vocal: les jobs de fond attendent endInteractive(), ceux deja en
+    // file sont annules si cancelQueued. Appels imbriques comptes.
+    void beginInteractive(bool cancelQueued = true);
+    void endInteractive();
+    bool isInteractive() { return interactiveDepth > 0; }
+    // Retire les jobs de fond en file: termines en echec, callback(false)
+    int cancelBackground();
+
+    // Octets echanges par la tache courante (PooledClient), imputes au job
+    // en cours sur cette tache. Ignore hors des taches du pool.
+    void chargeBytes(size_t n);
+
+    bool isStarted() { return started; }
+    int getActive() { return active; }
+    void printStats();
+
+private:
+    QueueHandle_t queues[HTTP_PRIORITY_COUNT];
+    SemaphoreHandle_t work;     // Un jeton par job en file, toutes classes
+    bool started;
+    portMUX_TYPE statsMux;
+    TaskHandle_t workerTasks[HTTP_EXECUTOR_WORKERS];
+    HttpFuture* workerJobs[HTTP_EXECUTOR_WORKERS];
+
+    volatile int interactiveDepth;
+    int backgroundActive;
+    unsigned long budgetWindowStart;
+    uint32_t budgetUsed;        // Octets du fond dans la fenetre courante
+    HttpClassStats classStats[HTTP_PRIORITY_COUNT];
+
+    volatile int active;
+    int peakActive;
+    uint32_t completed;
+    uint32_t failed;
+    uint32_t inlineRuns;        // Executes sur la tache appelante (pas de pool)
+    uint32_t queueMsMax;
+
+    static void workerLoop(void* param);
+    HttpFuture* next();
+    const char* backgroundBlocked();
+    int workerSlot();
+    void run(HttpFuture* future);
+};
+
+extern HttpExecutor httpExecutor;
+
+#endif
@@ -0,0 +1,402 @@
+// http_response.cpp - Lecture incrementale des reponses HTTP/1.1
+#include "http_response.h"
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+// Comparaison de noms d'en-tetes (ASCII, insensible a la casse)
+static bool equalsNoCase(const char* a, const char* b) {
+    while (*a && *b) {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) return false;
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static bool containsNoCase(const char* text, const char* token) {
+    size_t n = strlen(token);
+    for (; *text; text++) {
+        size_t i = 0;
+        while (i < n && text[i] && tolower((unsigned char)text[i]) == token[i]) i++;
+        if (i == n) return true;
+    }
+    return false;
+}
+
+// ============================================================
+// Automate
+// ============================================================
+
+HttpResponseParser::HttpResponseParser() {
+    sink = nullptr;
+    sinkArg = nullptr;
+    watchedCount = 0;
+    reset();
+}
+
+void HttpResponseParser::reset() {
+    state = HTTP_PARSE_STATUS;
+    headersComplete = false;
+    status = 0;
+    contentLength = -1;
+    chunked = false;
+    keepAlive = false;
+    remaining = 0;
+    bodyBytes = 0;
+    error = "";
+    lineLen = 0;
+    for (int i = 0; i < watchedCount; i++) {
+        if (watched[i].size > 0) watched[i].out[0] = '\0';
+    }
+}
+
+void HttpResponseParser::beginBody(long length, bool isChunked, bool reusable) {
+    reset();
+    status = 200;
+    contentLength = isChunked ? -1 : length;
+    chunked = isChunked;
+    keepAlive = reusable;
+    endHeaders();
+}
+
+void HttpResponseParser::setSink(HttpBodySink fn, void* arg) {
+    sink = fn;
+    sinkArg = arg;
+}
+
+bool HttpResponseParser::watchHeader(const char* name, char* out, size_t size) {
+    if (watchedCount >= HTTP_WATCH_MAX) return false;
+    watched[watchedCount].name = name;
+    watched[watchedCount].out = out;
+    watched[watchedCount].size = size;
+    watchedCount++;
+    if (size > 0) out[0] = '\0';
+    return true;
+}
+
+void HttpResponseParser::fail(const char* reason) {
+    if (state == HTTP_PARSE_DONE || state == HTTP_PARSE_ERROR) return;
+    state = HTTP_PARSE_ERROR;
+    error = reason;
+    keepAlive = false;
+}
+
+void HttpResponseParser::finish() {
+    if (state == HTTP_PARSE_UNTIL_CLOSE) {
+        state = HTTP_PARSE_DONE;
+        return;
+    }
+    fail(state == HTTP_PARSE_STATUS && lineLen == 0 ? "connexion fermee" : "reponse tronquee");
+}
+
+bool HttpResponseParser::emit(const uint8_t* data, size_t len) {
+    bodyBytes += len;
+    if (sink && !sink(data, len, sinkArg)) {
+        fail("corps refuse par le sink");
+        return false;
+    }
+    return true;
+}
+
+size_t HttpResponseParser::feed(const uint8_t* data, size_t len) {
+    size_t pos = 0;
+    while (pos < len) {
+        switch (state) {
+            case HTTP_PARSE_STATUS:
+            case HTTP_PARSE_HEADERS:
+            case HTTP_PARSE_CHUNK_SIZE:
+            case HTTP_PARSE_CHUNK_END:
+            case HTTP_PARSE_TRAILERS: {
+                // Lignes: un octet a la fois, CR ignore, LF termine
+                uint8_t c = data[pos++];
+                if (c == '\n') {
+                    line[lineLen] = '\0';
+                    bool wasHeaders = headersComplete;
+                    lineDone();
+                    lineLen = 0;
+                    // Pause apres les en-tetes: l'appelant choisit le sink
+                    if (!wasHeaders && headersComplete) return pos;
+                } else if (c != '\r' && lineLen < HTTP_LINE_MAX - 1) {
+                    line[lineLen++] = (char)c;
+                }
+                break;
+            }
+
+            case HTTP_PARSE_BODY:
+            case HTTP_PARSE_CHUNK_DATA: {
+                size_t n = len - pos;
+                if ((long)n > remaining) n = remaining;
+                if (!emit(data + pos, n)) return pos;
+                pos += n;
+                remaining -= n;
+                if (remaining == 0) {
+                    state = state == HTTP_PARSE_BODY ? HTTP_PARSE_DONE : HTTP_PARSE_CHUNK_END;
+                }
+                break;
+            }
+
+            case HTTP_PARSE_UNTIL_CLOSE:
+                if (!emit(data + pos, len - pos)) return pos;
+                pos = len;
+                break;
+
+            case HTTP_PARSE_DONE:
+            case HTTP_PARSE_ERROR:
+                return pos;
+        }
+    }
+    return pos;
+}
+
+void HttpResponseParser::lineDone() {
+    switch (state) {
+        case HTTP_PARSE_STATUS:
+            // CRLF residuel avant la ligne de statut: tolere
+            if (lineLen > 0) parseStatus();
+            break;
+
+        case HTTP_PARSE_HEADERS:
+            if (lineLen == 0) endHeaders();
+            else parseHeader();
+            break;
+
+        case HTTP_PARSE_CHUNK_SIZE:
+            parseChunkSize();
+            break;
+
+        case HTTP_PARSE_CHUNK_END:
+            if (lineLen != 0) fail("fin de chunk invalide");
+            else state = HTTP_PARSE_CHUNK_SIZE;
+            break;
+
+        case HTTP_PARSE_TRAILERS:
+            if (lineLen == 0) state = HTTP_PARSE_DONE;
+            else parseHeader();
+            break;
+
+        default:
+            break;
+    }
+}
+
+void HttpResponseParser::parseStatus() {
+    // "HTTP/1.1 200 OK"
+    if (lineLen < 12 || strncmp(line, "HTTP/1.", 7) != 0 || line[8] != ' ' ||
+        !isdigit((unsigned char)line[9]) || !isdigit((unsigned char)line[10]) ||
+        !isdigit((unsigned char)line[11])) {
+        fail("ligne de statut invalide");
+        return;
+    }
+    status = (line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0');
+    keepAlive = line[7] == '1';
+    state = HTTP_PARSE_HEADERS;
+}
+
+void HttpResponseParser::parseHeader() {
+    char* colon = strchr(line, ':');
+    if (!colon) return;  // Ligne malformee ignoree
+
+    char* nameEnd = colon;
+    while (nameEnd > line && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t')) nameEnd--;
+    *nameEnd = '\0';
+
+    char* value = colon + 1;
+    while (*value == ' ' || *value == '\t') value++;
+    char* valueEnd = line + lineLen;
+    while (valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) valueEnd--;
+    *valueEnd = '\0';
+
+    // Pas de cadrage depuis les trailers
+    if (state == HTTP_PARSE_HEADERS) {
+        if (equalsNoCase(line, "content-length")) {
+            char* end;
+            long length = strtol(value, &end, 10);
+            if (end == value || *end != '\0' || length < 0) {
+                fail("Content-Length invalide");
+                return;
+            }
+            contentLength = length;
+        } else if (equalsNoCase(line, "transfer-encoding")) {
+            if (containsNoCase(value, "chunked")) chunked = true;
+        } else if (equalsNoCase(line, "connection")) {
+            if (containsNoCase(value, "close")) keepAlive = false;
+            else if (containsNoCase(value, "keep-alive")) keepAlive = true;
+        }
+    }
+
+    for (int i = 0; i < watchedCount; i++) {
+        if (watched[i].size > 0 && equalsNoCase(line, watched[i].name)) {
+            strncpy(watched[i].out, value, watched[i].size - 1);
+            watched[i].out[watched[i].size - 1] = '\0';
+        }
+    }
+}
+
+void HttpResponseParser::parseChunkSize() {
+    // Taille en hexa, extensions ";..." ignorees
+    char* end;
+    long size = strtol(line, &end, 16);
+    if (end == line || size < 0) {
+        fail("taille de chunk invalide");
+        return;
+    }
+    if (size == 0) {
+        state = HTTP_PARSE_TRAILERS;
+    } else {
+        remaining = size;
+        state = HTTP_PARSE_CHUNK_DATA;
+    }
+}
+
+void HttpResponseParser::endHeaders() {
+    // 100 Continue et autres reponses intermediaires: la vraie suit
+    if (status >= 100 && status < 200) {
+        reset();
+        return;
+    }
+
+    headersComplete = true;
+    if (status == 204 || status == 304) {
+        state = HTTP_PARSE_DONE;
+    } else if (chunked) {
+        // Transfer-Encoding prime sur Content-Length (RFC 9112)
+        contentLength = -1;
+        state = HTTP_PARSE_CHUNK_SIZE;
+    } else if (contentLength >= 0) {
+        remaining = contentLength;
+        state = contentLength == 0 ? HTTP_PARSE_DONE : HTTP_PARSE_BODY;
+    } else {
+        keepAlive = false;
+        state = HTTP_PARSE_UNTIL_CLOSE;
+    }
+}
+
+// ============================================================
+// Lecteur sur socket (ESP32)
+// ============================================================
+#ifdef ARDUINO
+
+HttpResponseReader::HttpResponseReader(Client& client, unsigned long timeoutMs)
+    : client(client) {
+    this->timeoutMs = timeoutMs;
+    cancel = nullptr;
+    cancelled = false;
+    rawPos = 0;
+    rawLen = 0;
+    bytesIn = 0;
+}
+
+bool HttpResponseReader::fillRaw() {
+    unsigned long start = millis();
+    while (client.available() == 0) {
+        if (cancel && *cancel) {
+            cancelled = true;
+            parser.fail("annule");
+            return false;
+        }
+        if (!client.connected()) {
+            parser.finish();
+            return false;
+        }
+        if (millis() - start > timeoutMs) {
+            parser.fail("timeout");
+            return false;
+        }
+        delay(1);
+    }
+
+    int n = client.read(raw, sizeof(raw));
+    if (n <= 0) {
+        parser.fail("lecture socket");
+        return false;
+    }
+    rawPos = 0;
+    rawLen = n;
+    bytesIn += n;
+    return true;
+}
+
+bool HttpResponseReader::pump() {
+    if (rawPos == rawLen && !fillRaw()) return false;
+    rawPos += parser.feed(raw + rawPos, rawLen - rawPos);
+    return true;
+}
+
+bool HttpResponseReader::readHeaders() {
+    while (!parser.headersDone() && !parser.hasError()) {
+        if (!pump()) break;
+    }
+    return parser.headersDone() && !parser.hasError();
+}
+
+bool HttpResponseReader::readBody(HttpBodySink sink, void* arg) {
+    parser.setSink(sink, arg);
+    while (!parser.isComplete() && !parser.hasError()) {
+        if (!pump()) break;
+    }
+    parser.setSink(nullptr, nullptr);
+    return parser.isComplete();
+}
+
+// Sink de read(): copie dans le buffer de l'appelant
+struct HttpCopyTarget {
+    uint8_t* out;
+    size_t len;
+};
+
+static bool copySink(const uint8_t* data, size_t len, void* arg) {
+    HttpCopyTarget* target = (HttpCopyTarget*)arg;
+    memcpy(target->out + target->len, data, len);
+    target->len += len;
+    return true;
+}
+
+size_t HttpResponseReader::read(uint8_t* out, size_t size) {
+    HttpCopyTarget target = { out, 0 };
+    parser.setSink(copySink, &target);
+
+    // Le corps decode n'est jamais plus long que l'entree: fournir au plus
+    // la place restante garantit que la copie tient dans out
+    while (target.len < size && !parser.isComplete() && !parser.hasError()) {
+        if (rawPos == rawLen) {
+            if (target.len > 0) break;  // Ne pas bloquer avec des donnees pretes
+            if (!fillRaw()) break;
+        }
+        size_t n = rawLen - rawPos;
+        if (n > size - target.len) n = size - target.len;
+        rawPos += parser.feed(raw + rawPos, n);
+    }
+
+    parser.setSink(nullptr, nullptr);
+    return target.len;
+}
+
+size_t HttpResponseReader::readText(char* out, size_t size) {
+    size_t len = 0;
+    while (len < size - 1) {
+        size_t n = read((uint8_t*)out + len, size - 1 - len);
+        if (n == 0) break;
+        len += n;
+    }
+    out[len] = '\0';
+    drain();
+    return len;
+}
+
+bool HttpResponseReader::drain(size_t maxBytes) {
+    uint32_t start = parser.getBodyBytes();
+    parser.setSink(nullptr, nullptr);
+    while (!parser.isComplete() && !parser.hasError()) {
+        if (parser.getBodyBytes() - start > maxBytes) break;
+        if (!pump()) break;
+    }
+    return parser.isComplete();
+}
+
+int HttpResponseReader::available() {
+    if (parser.isComplete() || parser.hasError()) return 0;
+    return (rawLen - rawPos) + client.available();
+}
+
+#endif
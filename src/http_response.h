@@ -0,0 +1,173 @@
+// http_response.h - Lecture incrementale des reponses HTTP/1.1
+// Whisper, TTS Groq et TTS Google lisaient chacun la ligne de statut, les
+// en-tetes (indexOf("Content-Length: ") sur une String) et le corps chunked
+// a la main, avec leurs propres boucles delay(1). Un seul automate ici:
+// statut, en-tetes insensibles a la casse, corps Content-Length, chunked
+// (extensions, trailers) ou jusqu'a fermeture, sans String. Les octets du
+// corps sont pousses vers un sink fourni par l'appelant (tampon audio,
+// decodeur base64, parseur JSON...).
+// Le coeur ne depend pas d'Arduino: il se compile aussi sous Linux pour le
+// rejeu de reponses enregistrees (tools/http_replay).
+#ifndef HTTP_RESPONSE_H
+#define HTTP_RESPONSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HTTP_LINE_MAX          128      // Ligne d'en-tete gardee (tronquee au-dela)
+#define HTTP_WATCH_MAX         4        // En-tetes copies pour l'appelant
+#define HTTP_READ_CHUNK        512      // Lecture socket par blocs
+#define HTTP_READ_TIMEOUT_MS   10000    // Silence max du serveur
+#define HTTP_DRAIN_MAX         8192     // Fin de corps lue pour garder le socket
+
+// Destination du corps. false: arreter (tampon plein, annulation)
+typedef bool (*HttpBodySink)(const uint8_t* data, size_t len, void* arg);
+
+enum HttpParseState {
+    HTTP_PARSE_STATUS,
+    HTTP_PARSE_HEADERS,
+    HTTP_PARSE_BODY,          // Content-Length
+    HTTP_PARSE_UNTIL_CLOSE,   // Ni longueur ni chunked
+    HTTP_PARSE_CHUNK_SIZE,
+    HTTP_PARSE_CHUNK_DATA,
+    HTTP_PARSE_CHUNK_END,     // CRLF apres les donnees du chunk
+    HTTP_PARSE_TRAILERS,
+    HTTP_PARSE_DONE,
+    HTTP_PARSE_ERROR
+};
+
+class HttpResponseParser {
+public:
+    HttpResponseParser();
+
+    // Nouvelle reponse (meme socket keep-alive). Garde le sink et les
+    // en-tetes surveilles.
+    void reset();
+
+    // Corps seul: en-tetes deja lus par HTTPClient. keepAlive = false si
+    // la reponse portait "Connection: close"
+    void beginBody(long contentLength, bool chunked, bool keepAlive = true);
+
+    void setSink(HttpBodySink sink, void* arg);
+
+    // Copier la valeur d'un en-tete (ou trailer) dans out, nom insensible
+    // a la casse. false si HTTP_WATCH_MAX en-tetes sont deja surveilles.
+    bool watchHeader(const char* name, char* out, size_t size);
+
+    // Consomme des octets recus, retourne le nombre traite. S'arrete juste
+    // apres les en-tetes (choisir le sink selon le statut), a la fin du
+    // message et en cas d'erreur: rappeler feed() avec le reste.
+    size_t feed(const uint8_t* data, size_t len);
+
+    // Socket ferme par le serveur: termine un corps "jusqu'a fermeture",
+    // erreur sinon
+    void finish();
+    void fail(const char* reason);
+
+    HttpParseState getState() { return state; }
+    bool headersDone() { return headersComplete; }
+    bool isComplete() { return state == HTTP_PARSE_DONE; }
+    bool hasError() { return state == HTTP_PARSE_ERROR; }
+    const char* getError() { return error; }
+
+    int getStatus() { return status; }
+    long getContentLength() { return contentLength; }
+    bool isChunked() { return chunked; }
+    // HTTP/1.1 sans "Connection: close" et corps delimite
+    bool isKeepAlive() { return keepAlive; }
+    uint32_t getBodyBytes() { return bodyBytes; }
+
+private:
+    struct WatchedHeader {
+        const char* name;
+        char* out;
+        size_t size;
+    };
+
+    HttpParseState state;
+    bool headersComplete;
+    int status;
+    long contentLength;
+    bool chunked;
+    bool keepAlive;
+    long remaining;           // Octets restants (corps ou chunk courant)
+    uint32_t bodyBytes;
+    const char* error;
+
+    char line[HTTP_LINE_MAX];
+    size_t lineLen;
+
+    HttpBodySink sink;
+    void* sinkArg;
+    WatchedHeader watched[HTTP_WATCH_MAX];
+    int watchedCount;
+
+    void lineDone();
+    void parseStatus();
+    void parseHeader();
+    void parseChunkSize();
+    void endHeaders();
+    bool emit(const uint8_t* data, size_t len);
+};
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <Client.h>
+
+// Reponse lue sur un socket (PooledClient ou flux d'HTTPClient)
+class HttpResponseReader {
+public:
+    HttpResponseReader(Client& client, unsigned long timeoutMs = HTTP_READ_TIMEOUT_MS);
+
+    // Abandon de l'attente quand *flag passe a true (STT speculatif)
+    void setCancelFlag(volatile bool* flag) { cancel = flag; }
+    bool watchHeader(const char* name, char* out, size_t size) {
+        return parser.watchHeader(name, out, size);
+    }
+
+    // Statut et en-tetes (reponses 1xx sautees)
+    bool readHeaders();
+    // Flux d'HTTPClient: en-tetes deja consommes
+    void beginBody(long contentLength, bool chunked, bool keepAlive = true) {
+        parser.beginBody(contentLength, chunked, keepAlive);
+    }
+
+    // Tout le corps vers le sink. true si lu jusqu'au bout.
+    bool readBody(HttpBodySink sink, void* arg);
+    // Octets decodes du corps, au plus size. 0 en fin de corps ou erreur.
+    size_t read(uint8_t* out, size_t size);
+    // Debut du corps en texte (message d'erreur), reste jete
+    size_t readText(char* out, size_t size);
+    // Lire et jeter la fin du corps. true si le message est complet.
+    bool drain(size_t maxBytes = HTTP_DRAIN_MAX);
+
+    int available();
+    int getStatus() { return parser.getStatus(); }
+    long getContentLength() { return parser.getContentLength(); }
+    bool isComplete() { return parser.isComplete(); }
+    bool hasError() { return parser.hasError(); }
+    const char* getError() { return parser.getError(); }
+    uint32_t getBodyBytes() { return parser.getBodyBytes(); }
+    // Socket ferme avant le moindre octet (keep-alive perime)
+    bool isStale() { return bytesIn == 0 && !cancelled && parser.hasError(); }
+    bool wasCancelled() { return cancelled; }
+    // Message lu en entier, rien en trop: le socket peut retourner au pool
+    bool canReuse() { return parser.isComplete() && parser.isKeepAlive() && rawPos == rawLen; }
+
+private:
+    Client& client;
+    HttpResponseParser parser;
+    unsigned long timeoutMs;
+    volatile bool* cancel;
+    bool cancelled;
+    uint8_t raw[HTTP_READ_CHUNK];
+    size_t rawPos;
+    size_t rawLen;
+    uint32_t bytesIn;
+
+    bool fillRaw();
+    bool pump();
+};
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+// http_validators.cpp - Requetes conditionnelles (ETag, Last-Modified) par URL
+#include "http_validators.h"
+
+HttpValidatorCache httpValidators;
+
+HttpValidatorCache::HttpValidatorCache() {
+    memset(entries, 0, sizeof(entries));
+    mutex = xSemaphoreCreateMutex();
+    enabled = true;
+}
+
+HttpValidatorEntry* HttpValidatorCache::find(const String& url) {
+    for (int i = 0; i < HTTP_VALIDATOR_ENTRIES; i++) {
+        if (entries[i].url[0] != '\0' && strcmp(entries[i].url, url.c_str()) == 0) return &entries[i];
+    }
+    return nullptr;
+}
+
+bool HttpValidatorCache::apply(HTTPClient& http, const String& url) {
+    if (!enabled) return false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    HttpValidatorEntry* entry = find(url);
+    bool sent = false;
+    if (entry) {
+        entry->lastUsed = millis();
+        if (entry->etag[0] != '\0') {
+            http.addHeader("If-None-Match", entry->etag);
+            sent = true;
+        }
+        if (entry->lastModified[0] != '\0') {
+            http.addHeader("If-Modified-Since", entry->lastModified);
+            sent = true;
+        }
+    }
+    xSemaphoreGive(mutex);
+    return sent;
+}
+
+void HttpValidatorCache::store(HTTPClient& http, const String& url, size_t bodyBytes, uint32_t parseMs) {
+    if (url.length() >= HTTP_VALIDATOR_URL_LEN) return;
+
+    String etag = http.header("ETag");
+    String lastModified = http.header("Last-Modified");
+    if (etag.length() >= HTTP_VALIDATOR_ETAG_LEN) etag = "";
+    if (lastModified.length() >= HTTP_VALIDATOR_DATE_LEN) lastModified = "";
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    HttpValidatorEntry* entry = find(url);
+    if (!entry && (etag.length() > 0 || lastModified.length() > 0)) {
+        // Nouvelle URL avec validateurs: entree libre ou la moins recente
+        entry = &entries[0];
+        for (int i = 0; i < HTTP_VALIDATOR_ENTRIES; i++) {
+            if (entries[i].url[0] == '\0') {
+                entry = &entries[i];
+                break;
+            }
+            if (entries[i].lastUsed < entry->lastUsed) entry = &entries[i];
+        }
+        memset(entry, 0, sizeof(*entry));
+        strncpy(entry->url, url.c_str(), HTTP_VALIDATOR_URL_LEN - 1);
+    }
+    if (entry) {
+        // Serveur sans validateurs: entree gardee pour les stats, vide
+        strncpy(entry->etag, etag.c_str(), HTTP_VALIDATOR_ETAG_LEN - 1);
+        entry->etag[HTTP_VALIDATOR_ETAG_LEN - 1] = '\0';
+        strncpy(entry->lastModified, lastModified.c_str(), HTTP_VALIDATOR_DATE_LEN - 1);
+        entry->lastModified[HTTP_VALIDATOR_DATE_LEN - 1] = '\0';
+        entry->bodyBytes = bodyBytes;
+        entry->parseMs = parseMs;
+        entry->full++;
+        entry->lastUsed = millis();
+    }
+    xSemaphoreGive(mutex);
+}
+
+void HttpValidatorCache::notModified(const String& url) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    HttpValidatorEntry* entry = find(url);
+    if (entry) {
+        entry->notModified++;
+        entry->bytesSaved += entry->bodyBytes;
+        entry->parseMsSaved += entry->parseMs;
+        entry->lastUsed = millis();
+    }
+    xSemaphoreGive(mutex);
+}
+
+void HttpValidatorCache::forget(const String& url) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    HttpValidatorEntry* entry = find(url);
+    if (entry) {
+        entry->etag[0] = '\0';
+        entry->lastModified[0] = '\0';
+    }
+    xSemaphoreGive(mutex);
+}
+
+void HttpValidatorCache::setEnabled(bool on) {
+    enabled = on;
+    Serial.printf("Requetes conditionnelles: %s\n", on ? "ON" : "OFF");
+}
+
+void HttpValidatorCache::printStats() {
+    Serial.println("\n=== REQUETES CONDITIONNELLES ===");
+    Serial.printf("Etat: %s\n", enabled ? "ON" : "OFF");
+    Serial.println("URL                                                 200   304  octets evites  parse evite");
+
+    uint32_t bytesTotal = 0, parseTotal = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int i = 0; i < HTTP_VALIDATOR_ENTRIES; i++) {
+        const HttpValidatorEntry& e = entries[i];
+        if (e.url[0] == '\0') continue;
+        // Fin de l'URL: le chemin distingue les endpoints
+        size_t len = strlen(e.url);
+        const char* shown = len > 48 ? e.url + len - 48 : e.url;
+        Serial.printf("%-48s %s %5u %5u  %13u  %8u ms\n", shown,
+                      (e.etag[0] || e.lastModified[0]) ? "V" : "-",
+                      e.full, e.notModified, e.bytesSaved, e.parseMsSaved);
+        bytesTotal += e.bytesSaved;
+        parseTotal += e.parseMsSaved;
+    }
+    xSemaphoreGive(mutex);
+
+    Serial.printf("Total evite: %u octets, %u ms de parse (V = validateur connu)\n", bytesTotal, parseTotal);
+    Serial.println("================================\n");
+}
@@ -0,0 +1,64 @@
+// http_validators.h - Requetes conditionnelles (ETag, Last-Modified) par URL
+// La plupart des polls (prix, frais, hauteur, mineurs Bitaxe, Braiins)
+// renvoient les memes donnees qu'au poll precedent: corps transfere et
+// parse pour rien. Les validateurs de la derniere reponse 200 sont gardes
+// par URL et renvoyes (If-None-Match, If-Modified-Since). Sur 304 le corps
+// n'est ni lu ni parse, la structure en cache du module reste valide. Les
+// octets et le temps de parse evites sont comptes par endpoint (/etag).
+#ifndef HTTP_VALIDATORS_H
+#define HTTP_VALIDATORS_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+
+#define HTTP_VALIDATOR_ENTRIES   16
+#define HTTP_VALIDATOR_URL_LEN   128
+#define HTTP_VALIDATOR_ETAG_LEN  80
+#define HTTP_VALIDATOR_DATE_LEN  40       // "Wed, 21 Oct 2015 07:28:00 GMT"
+
+struct HttpValidatorEntry {
+    char url[HTTP_VALIDATOR_URL_LEN];
+    char etag[HTTP_VALIDATOR_ETAG_LEN];
+    char lastModified[HTTP_VALIDATOR_DATE_LEN];
+    uint32_t bodyBytes;         // Derniere reponse 200: corps lu
+    uint32_t parseMs;           // ... et temps de lecture + parse
+    uint32_t full;              // Reponses 200
+    uint32_t notModified;       // Reponses 304
+    uint32_t bytesSaved;
+    uint32_t parseMsSaved;
+    unsigned long lastUsed;
+};
+
+class HttpValidatorCache {
+public:
+    HttpValidatorCache();
+
+    // Avant GET: ajoute If-None-Match / If-Modified-Since si connus.
+    // true si la requete est conditionnelle (304 possible)
+    bool apply(HTTPClient& http, const String& url);
+
+    // Reponse 200 lue et parsee: validateurs retenus (ETag / Last-Modified
+    // collectes par jsonReader.prepare()). Appeler avant http.end().
+    void store(HTTPClient& http, const String& url, size_t bodyBytes, uint32_t parseMs);
+
+    // Reponse 304: corps et parse de la derniere reponse 200 evites
+    void notModified(const String& url);
+
+    // Cache du module vide ou invalide: plus de requete conditionnelle
+    void forget(const String& url);
+
+    void setEnabled(bool on);
+    bool isEnabled() { return enabled; }
+    void printStats();
+
+private:
+    HttpValidatorEntry entries[HTTP_VALIDATOR_ENTRIES];
+    SemaphoreHandle_t mutex;    // Polls paralleles (httpExecutor)
+    bool enabled;
+
+    HttpValidatorEntry* find(const String& url);
+};
+
+extern HttpValidatorCache httpValidators;
+
+#endif
@@ -0,0 +1,241 @@
+// json_stream.cpp - Lecture JSON en flux depuis le socket HTTP
+#include "json_stream.h"
+#include "connection_pool.h"
+#include "http_executor.h"
+#include <esp_heap_caps.h>
+
+JsonStreamReader jsonReader;
+
+// ============================================================
+// HttpBodyStream
+// ============================================================
+
+HttpBodyStream::HttpBodyStream(HttpResponseReader& reader) : reader(reader) {
+    bufPos = 0;
+    bufLen = 0;
+}
+
+bool HttpBodyStream::fill() {
+    bufPos = 0;
+    bufLen = reader.read(buffer, sizeof(buffer));
+    return bufLen > 0;
+}
+
+int HttpBodyStream::available() {
+    if (bufPos < bufLen) return bufLen - bufPos;
+    return reader.available();
+}
+
+int HttpBodyStream::read() {
+    if (bufPos == bufLen && !fill()) return -1;
+    return buffer[bufPos++];
+}
+
+int HttpBodyStream::peek() {
+    if (bufPos == bufLen && !fill()) return -1;
+    return buffer[bufPos];
+}
+
+size_t HttpBodyStream::readBytes(char* out, size_t length) {
+    size_t copied = 0;
+    while (copied < length) {
+        if (bufPos == bufLen && !fill()) break;
+        size_t n = bufLen - bufPos;
+        if (n > length - copied) n = length - copied;
+        memcpy(out + copied, buffer + bufPos, n);
+        bufPos += n;
+        copied += n;
+    }
+    return copied;
+}
+
+// ============================================================
+// JsonStreamReader
+// ============================================================
+
+JsonStreamReader::JsonStreamReader() {
+    memset(stats, 0, sizeof(stats));
+    mutex = xSemaphoreCreateMutex();
+}
+
+size_t JsonStreamReader::freeHeap() {
+    // Interne + PSRAM: ArduinoJson et String passent par malloc
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+size_t JsonStreamReader::usedSince(size_t before) {
+    size_t now = freeHeap();
+    return before > now ? before - now : 0;
+}
+
+void JsonStreamReader::prepare(HTTPClient& http) {
+    static const char* keys[] = { "Transfer-Encoding", "Connection", "ETag", "Last-Modified" };
+    http.collectHeaders(keys, 4);
+}
+
+void JsonStreamReader::beginBody(HttpResponseReader& reader, HTTPClient& http) {
+    String connection = http.header("Connection");
+    connection.toLowerCase();
+    reader.beginBody(http.getSize(), http.header("Transfer-Encoding").indexOf("chunked") >= 0,
+                     connection.indexOf("close") < 0);
+}
+
+DeserializationError JsonStreamReader::read(HttpResponseReader& reader, JsonDocument& doc,
+                                            const JsonDocument* filter, const char* label) {
+    HttpBodyStream body(reader);
+
+    // Pas de mesure de heap ici: les workers de l'executeur allouent en
+    // parallele, seul le benchmark (en serie) mesure le pic
+    DeserializationError error = filter
+        ? deserializeJson(doc, body, DeserializationOption::Filter(*filter))
+        : deserializeJson(doc, body);
+
+    // Champs hors filtre non lus: finir le corps pour garder le socket
+    if (!error) reader.drain();
+
+    record(label, reader.getBodyBytes(), !error);
+    return error;
+}
+
+DeserializationError JsonStreamReader::read(const char* body, size_t len, JsonDocument& doc,
+                                            const JsonDocument* filter, const char* label) {
+    DeserializationError error = filter
+        ? deserializeJson(doc, body, len, DeserializationOption::Filter(*filter))
+        : deserializeJson(doc, body, len);
+    record(label, len, !error);
+    return error;
+}
+
+DeserializationError JsonStreamReader::read(HTTPClient& http, JsonDocument& doc, const JsonDocument* filter,
+                                            bool& keepAlive, const char* label, size_t* bodyBytes) {
+    keepAlive = false;
+    Client* client = http.getStreamPtr();
+    if (!client) return DeserializationError::IncompleteInput;
+
+    HttpResponseReader reader(*client);
+    beginBody(reader, http);
+
+    DeserializationError error = read(reader, doc, filter, label);
+    keepAlive = !error && reader.canReuse();
+    if (bodyBytes) *bodyBytes = reader.getBodyBytes();
+    return error;
+}
+
+bool JsonStreamReader::readText(HTTPClient& http, char* out, size_t size, bool& keepAlive, size_t* bodyBytes) {
+    keepAlive = false;
+    out[0] = '\0';
+    Client* client = http.getStreamPtr();
+    if (!client) return false;
+
+    HttpResponseReader reader(*client);
+    beginBody(reader, http);
+
+    size_t len = reader.readText(out, size);
+    while (len > 0 && isspace((unsigned char)out[len - 1])) out[--len] = '\0';
+
+    keepAlive = reader.canReuse();
+    if (bodyBytes) *bodyBytes = reader.getBodyBytes();
+    return len > 0;
+}
+
+// ============================================================
+// Stats et benchmark
+// ============================================================
+
+void JsonStreamReader::record(const char* label, size_t body, bool ok) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    JsonStreamLabelStats* entry = &stats[JSON_STREAM_LABELS - 1];
+    for (int i = 0; i < JSON_STREAM_LABELS; i++) {
+        if (strcmp(stats[i].label, label) == 0 || stats[i].label[0] == '\0') {
+            entry = &stats[i];
+            break;
+        }
+    }
+    if (entry->label[0] == '\0') strncpy(entry->label, label, JSON_STREAM_LABEL_LEN - 1);
+
+    entry->parses++;
+    if (!ok) entry->errors++;
+    if (body > entry->bodyMax) entry->bodyMax = body;
+    xSemaphoreGive(mutex);
+}
+
+void JsonStreamReader::benchmark(const String& url, const JsonDocument& filter, const char* label) {
+    size_t peak[2] = { 0, 0 };
+    size_t bodyBytes = 0;
+    bool disturbed = false;     // Job de l'executeur pendant une mesure
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool legacy = pass == 0;
+        PooledClient* client = connectionPool.acquireForUrl(url);
+        if (!client) {
+            Serial.printf("%-12s connexion echouee\n", label);
+            return;
+        }
+
+        HTTPClient http;
+        http.setReuse(true);
+        http.setTimeout(10000);
+        if (!http.begin(*client, url)) {
+            connectionPool.release(client, false);
+            return;
+        }
+        prepare(http);
+
+        if (http.GET() != 200) {
+            http.end();
+            connectionPool.release(client, false);
+            Serial.printf("%-12s HTTP en erreur\n", label);
+            return;
+        }
+
+        // Mesure apres les en-tetes: seul le traitement du corps differe.
+        // Heap globale: valable seulement sans job de l'executeur en cours.
+        if (httpExecutor.getActive() > 0) disturbed = true;
+        size_t before = freeHeap();
+        bool keepAlive = false;
+        {
+            JsonDocument doc;
+            if (legacy) {
+                // Ancien chemin: corps entier en String puis document complet
+                String response = http.getString();
+                deserializeJson(doc, response);
+                bodyBytes = response.length();
+                peak[0] = usedSince(before);
+                keepAlive = true;
+            } else if (http.getStreamPtr()) {
+                HttpResponseReader reader(*http.getStreamPtr());
+                beginBody(reader, http);
+                HttpBodyStream body(reader);
+                deserializeJson(doc, body, DeserializationOption::Filter(filter));
+                peak[1] = usedSince(before);
+                keepAlive = reader.drain() && reader.canReuse();
+            }
+        }
+        if (httpExecutor.getActive() > 0) disturbed = true;
+        http.end();
+        connectionPool.release(client, keepAlive);
+    }
+
+    if (disturbed) {
+        Serial.printf("%-12s executeur HTTP actif pendant la mesure, relancer /json\n", label);
+        return;
+    }
+    Serial.printf("%-12s corps %6u | String+doc %6u | flux filtre %5u octets (-%u%%)\n",
+                  label, bodyBytes, peak[0], peak[1],
+                  peak[0] ? 100 - (unsigned)(100 * peak[1] / peak[0]) : 0);
+}
+
+void JsonStreamReader::printStats() {
+    Serial.println("\n=== JSON EN FLUX ===");
+    Serial.println("Endpoint          lectures  erreurs  corps max (octets)");
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int i = 0; i < JSON_STREAM_LABELS; i++) {
+        const JsonStreamLabelStats& s = stats[i];
+        if (s.label[0] == '\0') continue;
+        Serial.printf("%-16s  %8u  %7u  %9u\n", s.label, s.parses, s.errors, s.bodyMax);
+    }
+    xSemaphoreGive(mutex);
+    Serial.println("corps max = String evitee par requete");
+    Serial.println("Pic de heap par endpoint: /json (mesure en serie)");
+    Serial.println("====================\n");
+}
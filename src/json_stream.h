@@ -0,0 +1,96 @@
+// json_stream.h - Lecture JSON en flux depuis le socket HTTP
+// Les clients lisaient tout le corps dans une String (getString) puis
+// deserialisaient le document complet: /v1/mining/hashrate/3d ou /mempool
+// (historiques, fee_histogram) pour quelques scalaires. Ici le corps est
+// decode a la volee par HttpResponseReader (http_response.h) et passe a
+// ArduinoJson avec un filtre: seuls les champs utiles sont
+// alloues, aucune copie du corps en RAM.
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <ArduinoJson.h>
+#include "http_response.h"
+
+#define JSON_STREAM_BUFFER     256      // Corps decode par blocs
+#define JSON_STREAM_LABELS     12       // Endpoints suivis dans les stats
+#define JSON_STREAM_LABEL_LEN  32
+
+// Corps decode par HttpResponseReader, vu comme un Stream pour ArduinoJson
+class HttpBodyStream : public Stream {
+public:
+    HttpBodyStream(HttpResponseReader& reader);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(char* buffer, size_t length) override;
+    using Stream::readBytes;
+    size_t write(uint8_t) override { return 0; }
+    void flush() override {}
+
+private:
+    HttpResponseReader& reader;
+    uint8_t buffer[JSON_STREAM_BUFFER];
+    size_t bufPos;
+    size_t bufLen;
+
+    bool fill();
+};
+
+struct JsonStreamLabelStats {
+    char label[JSON_STREAM_LABEL_LEN];
+    uint32_t parses;
+    uint32_t errors;
+    uint32_t bodyMax;           // Plus gros corps lu (= String evitee)
+};
+
+class JsonStreamReader {
+public:
+    JsonStreamReader();
+
+    // Avant GET/POST: HTTPClient doit collecter Transfer-Encoding et
+    // Connection (close: socket non rendu au pool), et ETag /
+    // Last-Modified pour les requetes conditionnelles
+    void prepare(HTTPClient& http);
+
+    // Corps de la reponse en cours -> doc (filter nullptr: document entier).
+    // keepAlive = false si le corps n'a pas ete lu jusqu'au bout:
+    // rendre alors le client au pool avec keepAlive = false.
+    // bodyBytes: octets du corps lus (stats des requetes conditionnelles)
+    DeserializationError read(HTTPClient& http, JsonDocument& doc, const JsonDocument* filter,
+                              bool& keepAlive, const char* label, size_t* bodyBytes = nullptr);
+
+    // Reponse lue sur un socket brut (Whisper, TTS Google): document
+    // filtre puis fin du corps videe, voir reader.canReuse()
+    DeserializationError read(HttpResponseReader& reader, JsonDocument& doc, const JsonDocument* filter,
+                              const char* label);
+
+    // Corps deja en RAM (reponse HTTP/2 collectee par le sink du flux)
+    DeserializationError read(const char* body, size_t len, JsonDocument& doc, const JsonDocument* filter,
+                              const char* label);
+
+    // Corps texte court (hauteur de bloc, hash) dans un buffer fixe
+    bool readText(HTTPClient& http, char* out, size_t size, bool& keepAlive, size_t* bodyBytes = nullptr);
+
+    // Pic de heap: getString() + document complet contre flux filtre.
+    // Heap globale: mesure ignoree si l'executeur HTTP travaille en meme temps.
+    void benchmark(const String& url, const JsonDocument& filter, const char* label);
+
+    void printStats();
+
+private:
+    JsonStreamLabelStats stats[JSON_STREAM_LABELS];
+    SemaphoreHandle_t mutex;
+
+    // Corps de la reponse d'HTTPClient (en-tetes collectes par prepare)
+    static void beginBody(HttpResponseReader& reader, HTTPClient& http);
+    void record(const char* label, size_t body, bool ok);
+    static size_t freeHeap();
+    static size_t usedSince(size_t before);
+};
+
+extern JsonStreamReader jsonReader;
+
+#endif
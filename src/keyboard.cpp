@@ -42,8 +42,8 @@ void VirtualKeyboard::draw() {
 
     Arduino_GFX* gfx = display.getGfx();
 
-    // Effacer tout l'ecran
-    gfx->fillScreen(COLOR_BLACK);
+    // Effacer tout l'ecran (masque aussi le vu-metre)
+    display.clear();
 
     // Bouton RETOUR en haut a gauche
     gfx->fillRoundRect(5, 5, 60, 30, 5, COLOR_RED);
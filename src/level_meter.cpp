@@ -0,0 +1,171 @@
+// level_meter.cpp - Vu-metre micro sur l'ecran d'accueil
+#include "level_meter.h"
+#include "display.h"
+#include "audio_stats.h"
+#include <esp_heap_caps.h>
+
+LevelMeter levelMeter;
+
+LevelMeter::LevelMeter() {
+    initialized = false;
+    enabled = true;
+    inputLevel = 0;
+    task = nullptr;
+    lineBuffer = nullptr;
+
+    drawn = false;
+    drawnGeneration = 0;
+    shownLevel = 0;
+    litWidth = 0;
+    peakX = 0;
+    peakTime = 0;
+
+    framesPushed = 0;
+    framesSkipped = 0;
+    pixelsPushed = 0;
+    maxPushUs = 0;
+}
+
+bool LevelMeter::begin() {
+    if (initialized) return true;
+
+    // Buffer en RAM interne: le driver SPI l'envoie sans copie intermediaire
+    size_t size = METER_W * METER_H * sizeof(uint16_t);
+    lineBuffer = (uint16_t*)heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!lineBuffer) {
+        Serial.println("Vu-metre: allocation buffer echouee");
+        return false;
+    }
+
+    // Core 0: la loop (wake word, lecture micro) reste sur core 1
+    if (xTaskCreatePinnedToCore(meterTask, "level_meter", 3072, this, 1, &task, 0) != pdPASS) {
+        Serial.println("Vu-metre: creation tache echouee");
+        free(lineBuffer);
+        lineBuffer = nullptr;
+        return false;
+    }
+
+    initialized = true;
+    Serial.printf("Vu-metre pret: %d fps, zone %dx%d\n", METER_FPS, METER_W, METER_H);
+    return true;
+}
+
+void LevelMeter::meterTask(void* param) {
+    LevelMeter* self = (LevelMeter*)param;
+    TickType_t lastWake = xTaskGetTickCount();
+
+    for (;;) {
+        self->renderFrame();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1000 / METER_FPS));
+    }
+}
+
+// ============================================================
+// Rendu
+// ============================================================
+
+uint16_t LevelMeter::columnColor(int x, int lit, int peak) {
+    if (x % METER_SEGMENT == METER_SEGMENT - 1) return COLOR_BLACK;
+
+    if (x < lit) {
+        int percent = x * 100 / METER_W;
+        if (percent < 60) return COLOR_GREEN;
+        if (percent < 85) return COLOR_ORANGE;
+        return COLOR_RED;
+    }
+    if (peak > lit && x >= peak && x < peak + METER_PEAK_W) return COLOR_WHITE;
+    return COLOR_DARK_GRAY;
+}
+
+void LevelMeter::pushSpan(int x0, int x1, int lit, int peak) {
+    if (x0 < 0) x0 = 0;
+    if (x1 > METER_W) x1 = METER_W;
+    int w = x1 - x0;
+    if (w <= 0) return;
+
+    // Une ligne calculee puis dupliquee: la barre est uniforme en hauteur
+    for (int x = x0; x < x1; x++) {
+        lineBuffer[x - x0] = columnColor(x, lit, peak);
+    }
+    for (int row = 1; row < METER_H; row++) {
+        memcpy(lineBuffer + row * w, lineBuffer, w * sizeof(uint16_t));
+    }
+
+    uint32_t start = micros();
+    display.getGfx()->draw16bitRGBBitmap(METER_X + x0, METER_Y, lineBuffer, w, METER_H);
+    uint32_t elapsed = micros() - start;
+
+    framesPushed++;
+    pixelsPushed += w * METER_H;
+    if (elapsed > maxPushUs) maxPushUs = elapsed;
+}
+
+void LevelMeter::renderFrame() {
+    // Ecran pris par la loop (changement d'ecran, clignement): sauter la frame
+    if (!display.lock(0)) {
+        framesSkipped++;
+        return;
+    }
+
+    if (!display.isReadyScreen()) {
+        drawn = false;
+        display.unlock();
+        return;
+    }
+
+    if (!enabled) {
+        if (drawn) {
+            display.getGfx()->fillRect(METER_X, METER_Y, METER_W, METER_H, COLOR_BLACK);
+            drawn = false;
+        }
+        display.unlock();
+        return;
+    }
+
+    // Attaque immediate, retombee exponentielle
+    int target = constrain(inputLevel, 0, 100);
+    shownLevel *= METER_DECAY;
+    if (target > shownLevel) shownLevel = target;
+    int lit = (int)(shownLevel * METER_W / 100);
+
+    int peak = peakX;
+    if (lit >= peak) {
+        peak = lit;
+        peakTime = millis();
+    } else if (millis() - peakTime > METER_PEAK_HOLD_MS) {
+        peak = max(lit, peak - METER_SEGMENT);
+    }
+
+    bool full = !drawn || drawnGeneration != display.getScreenGeneration();
+    if (full) {
+        pushSpan(0, METER_W, lit, peak);
+        drawn = true;
+        drawnGeneration = display.getScreenGeneration();
+    } else if (lit != litWidth || peak != peakX) {
+        // Colonnes touchees: entre l'ancien et le nouveau front, et les
+        // deux positions du marqueur de crete
+        int x0 = min(min(lit, litWidth), min(peak, peakX));
+        int x1 = max(max(lit, litWidth), max(peak, peakX)) + METER_PEAK_W;
+        pushSpan(x0, x1, lit, peak);
+    }
+
+    litWidth = lit;
+    peakX = peak;
+    display.unlock();
+}
+
+// ============================================================
+// Stats
+// ============================================================
+
+void LevelMeter::printStats() {
+    Serial.printf("Vu-metre: %s\n", enabled ? "ON" : "OFF");
+    Serial.printf("  Frames poussees: %u (%u sautees, ecran occupe)\n", framesPushed, framesSkipped);
+    if (framesPushed > 0) {
+        Serial.printf("  Pixels/frame: %u en moyenne, push max %u us\n",
+                      pixelsPushed / framesPushed, maxPushUs);
+    }
+    // A comparer entre ON et OFF: la capture ne doit pas perdre plus
+    Serial.printf("  Overruns RX en capture: %u (hors capture: %u)\n",
+                  audioStats.getRxOverruns(), audioStats.getRxOverrunsIdle());
+}
@@ -0,0 +1,66 @@
+// level_meter.h - Vu-metre micro sur l'ecran d'accueil
+// Une tache sur core 0 redessine la barre a 30 fps. Seules les colonnes qui
+// changent (front de la barre, marqueur de crete) sont poussees, en une
+// seule fenetre partielle draw16bitRGBBitmap: quelques centaines d'octets
+// SPI par frame au lieu de redessiner la zone depuis la loop, qui lit le
+// micro et ne doit jamais attendre l'ecran.
+#ifndef LEVEL_METER_H
+#define LEVEL_METER_H
+
+#include <Arduino.h>
+
+#define METER_FPS           30
+#define METER_X             10      // Zone libre sous les boutons
+#define METER_Y             212
+#define METER_W             300
+#define METER_H             10
+#define METER_SEGMENT       5       // Pas des segments (4 px allumes + 1 px vide)
+#define METER_DECAY         0.82f   // Retombee par frame
+#define METER_PEAK_HOLD_MS  600     // Maintien du marqueur de crete
+#define METER_PEAK_W        2
+
+class LevelMeter {
+public:
+    LevelMeter();
+
+    bool begin();
+
+    // Niveau courant 0-100 (appele depuis la loop, sans toucher a l'ecran)
+    void setLevel(int level) { inputLevel = level; }
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() { return enabled; }
+
+    void printStats();
+
+private:
+    bool initialized;
+    volatile bool enabled;
+    volatile int inputLevel;
+    TaskHandle_t task;
+
+    uint16_t* lineBuffer;   // METER_W x METER_H, RAM interne DMA
+
+    // Etat affiche
+    bool drawn;
+    uint32_t drawnGeneration;
+    float shownLevel;
+    int litWidth;
+    int peakX;
+    unsigned long peakTime;
+
+    // Stats
+    uint32_t framesPushed;
+    uint32_t framesSkipped;   // Ecran occupe par la loop
+    uint32_t pixelsPushed;
+    uint32_t maxPushUs;
+
+    static void meterTask(void* param);
+    void renderFrame();
+    uint16_t columnColor(int x, int lit, int peak);
+    void pushSpan(int x0, int x1, int lit, int peak);
+};
+
+extern LevelMeter levelMeter;
+
+#endif
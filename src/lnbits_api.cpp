@@ -1,23 +1,32 @@
 // lnbits_api.cpp - Implementation API LNbits
 #include "lnbits_api.h"
 #include <ArduinoJson.h>
+#include "circuit_breaker.h"
+#include "single_flight.h"
 
 LNbitsAPI lnbitsAPI;
 
 LNbitsAPI::LNbitsAPI() {
-    client = nullptr;
+    initialized = false;
     walletBalance.valid = false;
     walletBalance.balance = 0;
 }
 
 void LNbitsAPI::begin() {
-    client = new WiFiClientSecure();
-    client->setInsecure();
+    initialized = true;
     Serial.println("LNbits API initialisee");
 }
 
+bool LNbitsAPI::breakerAllows(const String& url) {
+    uint32_t retryMs = 0;
+    if (circuitBreaker.allowUrl(url, &retryMs)) return true;
+    lastError = "LNbits indisponible, essai dans " + String(retryMs / 1000) + " s";
+    Serial.println(lastError);
+    return false;
+}
+
 bool LNbitsAPI::fetchBalance() {
-    if (!client) {
+    if (!initialized) {
         lastError = "Client non initialise";
         return false;
     }
@@ -30,37 +39,64 @@ bool LNbitsAPI::fetchBalance() {
         return false;
     }
 
-    HTTPClient https;
-    https.setTimeout(10000);  // 10 secondes
-
     String url = String(configManager.config.lnbits_host) + "/api/v1/wallet";
+
+    // Solde deja demande par une autre tache: walletBalance est commun,
+    // seul le resultat est partage
+    bool ok;
+    if (singleFlight.join("GET", url, nullptr, nullptr, 0, ok)) return ok;
+    ok = requestBalance(url);
+    singleFlight.land("GET", url, ok);
+    return ok;
+}
+
+bool LNbitsAPI::requestBalance(const String& url) {
     Serial.println("LNbits fetch: " + url);
 
+    // Cache (solde, stats) garde si le circuit est ouvert
+    if (!breakerAllows(url)) return false;
+    unsigned long start = millis();
+    PooledClient* client = connectionPool.acquireForUrl(url);
+    if (!client) {
+        circuitBreaker.recordUrl(url, false, millis() - start);
+        lastError = "Connexion LNbits echouee";
+        return false;
+    }
+
+    HTTPClient https;
+    https.setTimeout(10000);  // 10 secondes
+    https.setReuse(true);
+
     if (!https.begin(*client, url)) {
+        connectionPool.release(client, false);
         lastError = "Connexion LNbits echouee";
         return false;
     }
 
     https.addHeader("X-Api-Key", configManager.config.lnbits_invoice_key);
+    jsonReader.prepare(https);
 
     int httpCode = https.GET();
+    circuitBreaker.recordUrl(url, httpCode > 0 && httpCode < 500, millis() - start);
     Serial.printf("LNbits HTTP: %d\n", httpCode);
 
     if (httpCode != 200) {
         lastError = "HTTP " + String(httpCode);
         https.end();
+        connectionPool.release(client, false);
         walletBalance.valid = false;
         return false;
     }
 
-    String response = https.getString();
-    https.end();
-
-    Serial.println("LNbits response: " + response);
-
-    // Parser JSON
+    // Parser JSON directement depuis le socket
+    JsonDocument filter;
+    filter["balance"] = true;
+    filter["name"] = true;
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
+    bool keepAlive;
+    DeserializationError error = jsonReader.read(https, doc, &filter, keepAlive, "lnbits solde");
+    https.end();
+    connectionPool.release(client, keepAlive);
 
     if (error) {
         lastError = "JSON error";
@@ -102,7 +138,7 @@ String LNbitsAPI::formatBalance() {
 }
 
 bool LNbitsAPI::createInvoice(int64_t amountSats, const char* memo, String& bolt11) {
-    if (!client) {
+    if (!initialized) {
         lastError = "Client non initialise";
         return false;
     }
@@ -114,13 +150,26 @@ bool LNbitsAPI::createInvoice(int64_t amountSats, const char* memo, String& bolt
         return false;
     }
 
-    HTTPClient https;
-    https.setTimeout(15000);
-
     String url = String(configManager.config.lnbits_host) + "/api/v1/payments";
     Serial.println("LNbits createInvoice: " + url);
 
+    // Circuit ouvert: echec immediat au lieu du timeout de 15-30 s
+    if (!breakerAllows(url)) return false;
+    unsigned long start = millis();
+    // POST jamais rejoue: socket neuf plutot qu'un keep-alive que le serveur a pu fermer
+    PooledClient* client = connectionPool.acquireForUrl(url, true);
+    if (!client) {
+        circuitBreaker.recordUrl(url, false, millis() - start);
+        lastError = "Connexion LNbits echouee";
+        return false;
+    }
+
+    HTTPClient https;
+    https.setTimeout(15000);
+    https.setReuse(true);
+
     if (!https.begin(*client, url)) {
+        connectionPool.release(client, false);
         lastError = "Connexion LNbits echouee";
         return false;
     }
@@ -138,25 +187,34 @@ bool LNbitsAPI::createInvoice(int64_t amountSats, const char* memo, String& bolt
     serializeJson(reqDoc, requestBody);
     Serial.println("Request: " + requestBody);
 
+    jsonReader.prepare(https);
     int httpCode = https.POST(requestBody);
+    circuitBreaker.recordUrl(url, httpCode > 0 && httpCode < 500, millis() - start);
     Serial.printf("LNbits HTTP: %d\n", httpCode);
 
+    JsonDocument doc;
+    bool keepAlive = false;
+
     if (httpCode != 200 && httpCode != 201) {
         lastError = "HTTP " + String(httpCode);
-        String resp = https.getString();
-        Serial.println("Error response: " + resp);
+        if (httpCode > 0) {
+            JsonDocument filter;
+            filter["detail"] = true;
+            if (!jsonReader.read(https, doc, &filter, keepAlive, "lnbits erreur")) {
+                Serial.println("Error response: " + doc["detail"].as<String>());
+            }
+        }
         https.end();
+        connectionPool.release(client, keepAlive);
         return false;
     }
 
-    String response = https.getString();
+    // Parser JSON directement depuis le socket (sans la facture decodee)
+    JsonDocument filter;
+    filter["payment_request"] = true;
+    DeserializationError error = jsonReader.read(https, doc, &filter, keepAlive, "lnbits facture");
     https.end();
-
-    Serial.println("LNbits response: " + response);
-
-    // Parser JSON
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
+    connectionPool.release(client, keepAlive);
 
     if (error) {
         lastError = "JSON error";
@@ -174,7 +232,7 @@ bool LNbitsAPI::createInvoice(int64_t amountSats, const char* memo, String& bolt
 }
 
 bool LNbitsAPI::payInvoice(const char* bolt11) {
-    if (!client) {
+    if (!initialized) {
         lastError = "Client non initialise";
         return false;
     }
@@ -186,13 +244,26 @@ bool LNbitsAPI::payInvoice(const char* bolt11) {
         return false;
     }
 
-    HTTPClient https;
-    https.setTimeout(30000);  // 30 sec pour paiement
-
     String url = String(configManager.config.lnbits_host) + "/api/v1/payments";
     Serial.println("LNbits payInvoice: " + url);
 
+    // Circuit ouvert: echec immediat au lieu du timeout de 15-30 s
+    if (!breakerAllows(url)) return false;
+    unsigned long start = millis();
+    // POST jamais rejoue: socket neuf plutot qu'un keep-alive que le serveur a pu fermer
+    PooledClient* client = connectionPool.acquireForUrl(url, true);
+    if (!client) {
+        circuitBreaker.recordUrl(url, false, millis() - start);
+        lastError = "Connexion LNbits echouee";
+        return false;
+    }
+
+    HTTPClient https;
+    https.setTimeout(30000);  // 30 sec pour paiement
+    https.setReuse(true);
+
     if (!https.begin(*client, url)) {
+        connectionPool.release(client, false);
         lastError = "Connexion LNbits echouee";
         return false;
     }
@@ -209,18 +280,26 @@ bool LNbitsAPI::payInvoice(const char* bolt11) {
     serializeJson(reqDoc, requestBody);
     Serial.println("Pay request: " + requestBody);
 
+    // Paiement non idempotent: jamais rejoue, meme sur socket perime
+    jsonReader.prepare(https);
     int httpCode = https.POST(requestBody);
+    circuitBreaker.recordUrl(url, httpCode > 0 && httpCode < 500, millis() - start);
     Serial.printf("LNbits HTTP: %d\n", httpCode);
 
-    String response = https.getString();
+    // Seul le message d'erreur eventuel est garde
+    JsonDocument filter;
+    filter["detail"] = true;
+    JsonDocument doc;
+    bool keepAlive = false;
+    DeserializationError error = httpCode > 0
+        ? jsonReader.read(https, doc, &filter, keepAlive, "lnbits paiement")
+        : DeserializationError(DeserializationError::IncompleteInput);
     https.end();
-
-    Serial.println("LNbits response: " + response);
+    connectionPool.release(client, keepAlive);
 
     if (httpCode != 200 && httpCode != 201) {
         // Extraire message d'erreur
-        JsonDocument doc;
-        if (!deserializeJson(doc, response)) {
+        if (!error) {
             if (doc["detail"].is<String>()) {
                 lastError = doc["detail"].as<String>();
             } else {
@@ -241,7 +320,7 @@ bool LNbitsAPI::payLnAddress(const char* lnAddress, int64_t amountSats) {
     // 2. Get invoice from callback URL
     // 3. Pay the invoice
 
-    if (!client) {
+    if (!initialized) {
         lastError = "Client non initialise";
         return false;
     }
@@ -258,28 +337,43 @@ bool LNbitsAPI::payLnAddress(const char* lnAddress, int64_t amountSats) {
 
     HTTPClient https;
     https.setTimeout(10000);
+    https.setReuse(true);
 
     // Etape 1: Recuperer les infos LNURL
     String lnurlUrl = "https://" + domain + "/.well-known/lnurlp/" + user;
     Serial.println("LNURL fetch: " + lnurlUrl);
 
-    if (!https.begin(*client, lnurlUrl)) {
+    if (!breakerAllows(lnurlUrl)) return false;
+    unsigned long start = millis();
+    PooledClient* client = connectionPool.acquireForUrl(lnurlUrl);
+    if (!client || !https.begin(*client, lnurlUrl)) {
+        if (!client) circuitBreaker.recordUrl(lnurlUrl, false, millis() - start);
+        connectionPool.release(client, false);
         lastError = "Connexion LNURL echouee";
         return false;
     }
 
+    jsonReader.prepare(https);
     int httpCode = https.GET();
+    circuitBreaker.recordUrl(lnurlUrl, httpCode > 0 && httpCode < 500, millis() - start);
     if (httpCode != 200) {
         lastError = "LNURL HTTP " + String(httpCode);
         https.end();
+        connectionPool.release(client, false);
         return false;
     }
 
-    String response = https.getString();
+    JsonDocument lnurlFilter;
+    lnurlFilter["callback"] = true;
+    lnurlFilter["minSendable"] = true;
+    lnurlFilter["maxSendable"] = true;
+    JsonDocument lnurlDoc;
+    bool keepAlive;
+    DeserializationError error = jsonReader.read(https, lnurlDoc, &lnurlFilter, keepAlive, "lnurl");
     https.end();
+    connectionPool.release(client, keepAlive);
 
-    JsonDocument lnurlDoc;
-    if (deserializeJson(lnurlDoc, response)) {
+    if (error) {
         lastError = "LNURL JSON error";
         return false;
     }
@@ -302,23 +396,35 @@ bool LNbitsAPI::payLnAddress(const char* lnAddress, int64_t amountSats) {
     String invoiceUrl = callback + "?amount=" + String(amountSats * 1000);  // en millisats
     Serial.println("Invoice fetch: " + invoiceUrl);
 
-    if (!https.begin(*client, invoiceUrl)) {
+    // Le callback peut etre sur un autre hote que l'adresse
+    if (!breakerAllows(invoiceUrl)) return false;
+    start = millis();
+    client = connectionPool.acquireForUrl(invoiceUrl);
+    if (!client || !https.begin(*client, invoiceUrl)) {
+        if (!client) circuitBreaker.recordUrl(invoiceUrl, false, millis() - start);
+        connectionPool.release(client, false);
         lastError = "Connexion callback echouee";
         return false;
     }
 
+    jsonReader.prepare(https);
     httpCode = https.GET();
+    circuitBreaker.recordUrl(invoiceUrl, httpCode > 0 && httpCode < 500, millis() - start);
     if (httpCode != 200) {
         lastError = "Callback HTTP " + String(httpCode);
         https.end();
+        connectionPool.release(client, false);
         return false;
     }
 
-    response = https.getString();
+    JsonDocument invoiceFilter;
+    invoiceFilter["pr"] = true;
+    JsonDocument invoiceDoc;
+    error = jsonReader.read(https, invoiceDoc, &invoiceFilter, keepAlive, "lnurl facture");
     https.end();
+    connectionPool.release(client, keepAlive);
 
-    JsonDocument invoiceDoc;
-    if (deserializeJson(invoiceDoc, response)) {
+    if (error) {
         lastError = "Invoice JSON error";
         return false;
     }
@@ -336,7 +442,7 @@ bool LNbitsAPI::payLnAddress(const char* lnAddress, int64_t amountSats) {
 }
 
 bool LNbitsAPI::fetchStats() {
-    if (!client) {
+    if (!initialized) {
         lastError = "Client non initialise";
         return false;
     }
@@ -349,36 +455,55 @@ bool LNbitsAPI::fetchStats() {
         return false;
     }
 
-    HTTPClient https;
-    https.setTimeout(15000);
-
     // Recuperer l'historique des paiements
     String url = String(configManager.config.lnbits_host) + "/api/v1/payments?limit=100";
     Serial.println("LNbits fetchStats: " + url);
 
+    // Cache (solde, stats) garde si le circuit est ouvert
+    if (!breakerAllows(url)) return false;
+    unsigned long start = millis();
+    PooledClient* client = connectionPool.acquireForUrl(url);
+    if (!client) {
+        circuitBreaker.recordUrl(url, false, millis() - start);
+        lastError = "Connexion LNbits echouee";
+        return false;
+    }
+
+    HTTPClient https;
+    https.setTimeout(15000);
+    https.setReuse(true);
+
     if (!https.begin(*client, url)) {
+        connectionPool.release(client, false);
         lastError = "Connexion LNbits echouee";
         return false;
     }
 
     https.addHeader("X-Api-Key", configManager.config.lnbits_invoice_key);
+    jsonReader.prepare(https);
 
     int httpCode = https.GET();
+    circuitBreaker.recordUrl(url, httpCode > 0 && httpCode < 500, millis() - start);
     Serial.printf("LNbits stats HTTP: %d\n", httpCode);
 
     if (httpCode != 200) {
         lastError = "HTTP " + String(httpCode);
         https.end();
+        connectionPool.release(client, false);
         walletStats.valid = false;
         return false;
     }
 
-    String response = https.getString();
-    https.end();
-
-    // Parser JSON array
+    // Parser le tableau en flux: 3 champs par paiement (sans bolt11, memo, extra)
+    JsonDocument filter;
+    filter[0]["time"] = true;
+    filter[0]["amount"] = true;
+    filter[0]["pending"] = true;
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
+    bool keepAlive;
+    DeserializationError error = jsonReader.read(https, doc, &filter, keepAlive, "lnbits paiements");
+    https.end();
+    connectionPool.release(client, keepAlive);
 
     if (error) {
         lastError = "JSON error";
@@ -3,8 +3,9 @@
 #define LNBITS_API_H
 
 #include <Arduino.h>
-#include <WiFiClientSecure.h>
 #include <HTTPClient.h>
+#include "connection_pool.h"
+#include "json_stream.h"
 #include "config.h"
 
 struct WalletBalance {
@@ -56,10 +57,16 @@ public:
     String getLastError() { return lastError; }
 
 private:
-    WiFiClientSecure* client;
+    bool initialized;
     WalletBalance walletBalance;
     WalletStats walletStats;
     String lastError;
+
+    // Disjoncteur (circuit_breaker.h): hote en panne -> echec immediat,
+    // lastError indique le delai avant le prochain essai
+    bool breakerAllows(const String& url);
+    // GET du solde (fetchBalance fusionne les appels concurrents)
+    bool requestBalance(const String& url);
 };
 
 extern LNbitsAPI lnbitsAPI;
@@ -7,12 +7,31 @@
 #include "display.h"
 #include "captive_portal.h"
 #include "claude_api.h"
+#include "claude_tools.h"
 #include "bitcoin_api.h"
 #include "audio.h"
 #include "tts_groq.h"
 #include "tts_google.h"
 #include "whisper_api.h"
+#include "ack_audio.h"
+#include "corpus_recorder.h"
+#include "audio_stats.h"
+#include "level_meter.h"
+#include "connection_pool.h"
+#include "tls_session_cache.h"
+#include "tls_profile.h"
+#include "http_executor.h"
+#include "multipart_writer.h"
+#include "dns_cache.h"
+#include "prewarm.h"
+#include "http2_client.h"
+#include "circuit_breaker.h"
+#include "turn_budget.h"
+#include "single_flight.h"
+#include "http_validators.h"
+#include "speech_pipeline.h"
 #include "wake_word.h"
+#include "wake_arbiter.h"
 #include "touch.h"
 #include "lnbits_api.h"
 // es8311.h remplacé par freenove_es8311.h dans audio.cpp
@@ -40,12 +59,12 @@ enum AppState {
 AppState currentState = STATE_INIT;
 unsigned long stateTimer = 0;
 unsigned long lastDataRefresh = 0;
-unsigned long lastLevelUpdate = 0;
 unsigned long lastBlinkTime = 0;
 unsigned long nextBlinkDelay = 0;  // Délai avant prochain clignement
 int wifiRetryCount = 0;
 const int MAX_WIFI_RETRIES = 20;
 const unsigned long DATA_REFRESH_INTERVAL = 60000;
+const unsigned long STREAM_DRAW_INTERVAL = 200;   // Reponse en flux: redessin max
 
 // Pin du bouton (backup si wake word ne fonctionne pas)
 #define BUTTON_PIN 0  // Boot button sur ESP32-S3
@@ -59,17 +78,23 @@ String serialBuffer = "";  // Buffer pour commandes serie
 void connectToWiFi();
 void processSerialCommand();
 void processVoiceCommand();
-void askClaude(const String& question);
+void listenForCommand(TurnBudget& turn);
+void askClaude(const String& question, TurnBudget* turn = nullptr);
 void refreshBitcoinData();
-String buildBitcoinContext();
+void pollBackgroundRefresh();
 void handleMiningMenu();
 bool inMiningMenu = false;
 
 // Fonction TTS - Groq Orpheus (3600 tokens/jour)
-bool speakText(const char* text, uint8_t** outBuffer, size_t* outSize) {
+// turn: reponse d'un tour vocal, timeout tire de son budget
+bool speakText(const char* text, uint8_t** outBuffer, size_t* outSize, TurnBudget* turn = nullptr) {
     Serial.println("TTS: Utilisation Groq Orpheus");
     resetTTSRateLimitInfo();  // Reset avant chaque appel
-    return getTTSWavBuffer(text, outBuffer, outSize);
+    if (turn) turn->beginStage(TURN_TTS, TTS_TIMEOUT_MS);
+    bool ok = getTTSWavBuffer(text, outBuffer, outSize, turn);
+    if (turn) turn->endStage(TURN_TTS, ok);
+    ackAudio.stop();  // TTS pret: couper l'accuse de reception (fondu)
+    return ok;
 }
 
 // Délai interruptible par touch - retourne true si interrompu
@@ -144,90 +169,129 @@ void refreshBitcoinData() {
 
     display.showMessage("SATOSHI", "Mise à jour...");
 
-    bitcoinAPI.fetchPrice();
-    bitcoinAPI.fetchFees();
-    bitcoinAPI.fetchBlockHeight();
-    bitcoinAPI.fetchMempoolInfo();
-    bitcoinAPI.fetchHashRate();
-    bitcoinAPI.fetchLightningStats();
-    lnbitsAPI.fetchBalance();
-
-    String context = buildBitcoinContext();
-    claudeAPI.updateBitcoinContext(context);
-
-    lastDataRefresh = millis();
-    Serial.println("--- Données mises à jour ---\n");
-}
-
-String buildBitcoinContext() {
-    String context = "";
+    // Requetes independantes en parallele (HTTP_EXECUTOR_WORKERS a la fois).
+    // static: un futur doit survivre a une attente abandonnee.
+    static HttpFuture jobs[7];
+    unsigned long start = millis();
 
-    BitcoinPrice price = bitcoinAPI.getPrice();
-    if (price.valid) {
-        char buf[128];
-        snprintf(buf, sizeof(buf), "- Prix: $%.0f USD / %.0f EUR\n", price.usd, price.eur);
-        context += buf;
+    // Futur encore occupe par un appel precedent (attente abandonnee):
+    // rien de soumis, son resultat ne compte pas pour ce rafraichissement
+    bool submitted[7];
+    submitted[0] = httpExecutor.submit(jobs[0], "prix", [](void*) { return bitcoinAPI.fetchPrice(); });
+    submitted[1] = httpExecutor.submit(jobs[1], "frais", [](void*) { return bitcoinAPI.fetchFees(); });
+    submitted[2] = httpExecutor.submit(jobs[2], "hauteur", [](void*) { return bitcoinAPI.fetchBlockHeight(); });
+    submitted[3] = httpExecutor.submit(jobs[3], "mempool", [](void*) { return bitcoinAPI.fetchMempoolInfo(); });
+    submitted[4] = httpExecutor.submit(jobs[4], "hashrate", [](void*) { return bitcoinAPI.fetchHashRate(); });
+    submitted[5] = httpExecutor.submit(jobs[5], "lightning", [](void*) { return bitcoinAPI.fetchLightningStats(); });
+    submitted[6] = httpExecutor.submit(jobs[6], "lnbits", [](void*) { return lnbitsAPI.fetchBalance(); });
+    for (int i = 0; i < 7; i++) {
+        if (!submitted[i]) Serial.printf("Rafraîchissement: %s encore en cours, non relance\n", jobs[i].getName());
     }
 
-    BitcoinFees fees = bitcoinAPI.getFees();
-    if (fees.valid) {
-        char buf[128];
-        snprintf(buf, sizeof(buf), "- Frais: Rapide %d sat/vB, Normal %d sat/vB\n",
-                 fees.fastestFee, fees.hourFee);
-        context += buf;
+    // Chaque requete a son propre timeout de 10 s
+    if (!httpExecutor.waitAll(jobs, 7, 30000)) {
+        Serial.println("Rafraîchissement: requetes encore en cours, donnees partielles");
     }
 
-    int blockHeight = bitcoinAPI.getBlockHeight();
-    if (blockHeight > 0) {
-        char buf[64];
-        snprintf(buf, sizeof(buf), "- Bloc: #%d\n", blockHeight);
-        context += buf;
+    uint32_t slowest = 0, total = 0;
+    for (HttpFuture& job : jobs) {
+        if (job.isPending()) continue;
+        if (job.getRunMs() > slowest) slowest = job.getRunMs();
+        total += job.getRunMs();
     }
-
-    MempoolInfo mempool = bitcoinAPI.getMempoolInfo();
-    if (mempool.valid) {
-        char buf[128];
-        snprintf(buf, sizeof(buf), "- Mempool: %d tx (%.1f MB)\n",
-                 mempool.count, mempool.vsize / 1000000.0f);
-        context += buf;
+    Serial.printf("Rafraîchissement: %lu ms (requete la plus lente %u ms, cumul %u ms)\n",
+                  millis() - start, slowest, total);
+    if (circuitBreaker.getOpenCount() > 0) {
+        // Hote en panne: ses requetes ont echoue sans attendre, donnees en cache
+        Serial.printf("Rafraîchissement: %d disjoncteur(s) ouvert(s), cache utilise\n",
+                      circuitBreaker.getOpenCount());
     }
 
-    HashRateInfo hashrate = bitcoinAPI.getHashRateInfo();
-    if (hashrate.valid) {
-        char buf[128];
-        snprintf(buf, sizeof(buf), "- Hashrate: %s\n", bitcoinAPI.formatHashRate().c_str());
-        context += buf;
+    // Donnees servies aux outils de Claude sans nouvelle requete: seulement
+    // celles relancees ici et arrivees
+    bool fresh[7];
+    for (int i = 0; i < 7; i++) fresh[i] = submitted[i] && !jobs[i].isPending() && jobs[i].succeeded();
+    if (fresh[0]) claudeTools.markFresh(CLAUDE_TOOL_PRICE);
+    if (fresh[1]) claudeTools.markFresh(CLAUDE_TOOL_FEES);
+    if (fresh[2] && fresh[3] && fresh[4] && fresh[5]) claudeTools.markFresh(CLAUDE_TOOL_NETWORK);
+    if (fresh[6]) claudeTools.markFresh(CLAUDE_TOOL_WALLET);
+
+    lastDataRefresh = millis();
+    Serial.println("--- Données mises à jour ---\n");
+}
+
+// Rafraichissement periodique (prix, frais, hauteur, mineurs) confie a
+// l'executeur en classe fond: la boucle ne bloque plus sur le reseau, les
+// requetes passent apres celles de l'utilisateur et attendent la fin d'un
+// tour vocal. Appele a chaque tour de boucle en STATE_READY.
+void pollBackgroundRefresh() {
+    static HttpFuture dataJobs[3];
+    static HttpFuture minerJob;
+    static bool dataPending = false;
+    static unsigned long dataSubmittedAt = 0;
+
+    if (miningManager.getMinerCount() > 0 && miningManager.needsRefresh() && !minerJob.isPending()) {
+        httpExecutor.submit(minerJob, "mineurs", [](void*) {
+            miningManager.refreshAll();
+            return true;
+        }, nullptr, nullptr, HTTP_PRIORITY_BACKGROUND);
     }
 
-    LightningStats lightning = bitcoinAPI.getLightningStats();
-    if (lightning.valid) {
-        char buf[128];
-        snprintf(buf, sizeof(buf), "- Lightning: %d noeuds, %.0f BTC\n",
-                 lightning.nodeCount, BitcoinAPI::satsToBTC(lightning.totalCapacity));
-        context += buf;
+    if (!dataPending) {
+        if (millis() - lastDataRefresh <= DATA_REFRESH_INTERVAL * 5) return;
+        httpExecutor.submit(dataJobs[0], "prix", [](void*) { return bitcoinAPI.fetchPrice(); },
+                            nullptr, nullptr, HTTP_PRIORITY_BACKGROUND);
+        httpExecutor.submit(dataJobs[1], "frais", [](void*) { return bitcoinAPI.fetchFees(); },
+                            nullptr, nullptr, HTTP_PRIORITY_BACKGROUND);
+        httpExecutor.submit(dataJobs[2], "hauteur", [](void*) { return bitcoinAPI.fetchBlockHeight(); },
+                            nullptr, nullptr, HTTP_PRIORITY_BACKGROUND);
+        dataPending = true;
+        lastDataRefresh = dataSubmittedAt = millis();
+        return;
     }
 
-    // Ajouter solde LNbits si configuré
-    WalletBalance lnBalance = lnbitsAPI.getBalance();
-    if (lnBalance.valid) {
-        char buf[128];
-        snprintf(buf, sizeof(buf), "- Wallet LNbits: %s\n", lnbitsAPI.formatBalance().c_str());
-        context += buf;
+    bool cancelled = false;
+    for (HttpFuture& job : dataJobs) {
+        if (job.isPending()) return;
+        if (job.wasCancelled()) cancelled = true;
     }
+    dataPending = false;
+    if (dataJobs[0].succeeded()) claudeTools.markFresh(CLAUDE_TOOL_PRICE);
+    if (dataJobs[1].succeeded()) claudeTools.markFresh(CLAUDE_TOOL_FEES);
 
-    return context;
+    // Annule par un tour vocal: relance des la fin du tour, sauf si
+    // askClaude() a rafraichi entre-temps
+    if (cancelled && lastDataRefresh == dataSubmittedAt) lastDataRefresh = 0;
 }
 
 void processVoiceCommand() {
+    // Budget du tour: ecoute, STT, Claude et TTS tirent leurs timeouts du
+    // temps restant (voir turn_budget.h)
+    TurnBudget turn;
+    listenForCommand(turn);
+}
+
+// Ecoute, transcription puis Claude. Wake word seul: nouvelle ecoute dans
+// le meme tour (meme budget, durees d'etapes cumulees). Chaque sortie
+// termine le tour (finish), askClaude() compris.
+void listenForCommand(TurnBudget& turn) {
     // Afficher l'état d'écoute
     display.showListening();
     currentState = STATE_COMMAND_LISTENING;
 
     Serial.println("Parlez maintenant...");
 
+    // Whisper, Claude et TTS vont suivre: connexions ouvertes pendant la phrase
+    prewarmer.onSpeechOnset();
+
     // Enregistrement avec VAD (arrêt automatique après silence)
     // Max 10 secondes, arrêt après 800ms de silence
-    if (!audioManager.startRecordingWithVAD(10000, 800)) {
+    turn.beginStage(TURN_LISTEN, 10000);
+    bool recorded = audioManager.startRecordingWithVAD(turn.timeoutFor(TURN_LISTEN, 10000), 800);
+    turn.endStage(TURN_LISTEN, recorded);
+    if (!recorded) {
+        turn.finish(false);
+        corpusRecorder.commitClip("no_speech");
         Serial.println("Erreur: impossible de démarrer l'enregistrement");
         display.showError("Erreur micro");
         delay(2000);
@@ -240,6 +304,8 @@ void processVoiceCommand() {
     Serial.printf("Enregistrement terminé: %d bytes\n", audioSize);
 
     if (audioSize < 2000) {
+        turn.finish(false);
+        corpusRecorder.commitClip("too_short");
         Serial.println("Audio trop court");
         display.showError("Parlez plus longtemps");
         delay(2000);
@@ -250,17 +316,33 @@ void processVoiceCommand() {
     // Transcrire l'audio
     display.showThinking();
     currentState = STATE_TRANSCRIBING;
+    ackAudio.playEarcon(EARCON_PROCESSING);
 
+    // Utiliser la transcription speculative si elle couvre cet enregistrement,
+    // sinon requete normale
     String transcription;
-    if (!whisperAPI.transcribe(audioManager.getRecordingBuffer(), audioSize, transcription)) {
+    unsigned long sttStart = millis();
+    turn.beginStage(TURN_STT, WHISPER_TIMEOUT_MS);
+    bool speculativeHit = audioManager.hasSpeculativeSTT() &&
+                          whisperAPI.finishSpeculative(transcription, turn.timeoutFor(TURN_STT, 30000));
+    if (!speculativeHit &&
+        !whisperAPI.transcribe(audioManager.getRecordingBuffer(), audioSize, transcription, &turn)) {
+        turn.endStage(TURN_STT, false);
+        turn.finish(false);
+        corpusRecorder.setTranscript("", millis() - sttStart);
+        corpusRecorder.commitClip("stt_error");
         Serial.println("Erreur transcription: " + whisperAPI.getLastError());
         display.showError("Erreur transcription");
+        ackAudio.playEarcon(EARCON_ERROR);
         delay(2000);
         currentState = STATE_READY;
         return;
     }
 
+    turn.endStage(TURN_STT, true);
     Serial.println("Transcription: " + transcription);
+    corpusRecorder.setTranscript(transcription, millis() - sttStart, speculativeHit);
+    corpusRecorder.commitClip("ok");
 
     // Vérifier si c'est du silence (transcription vide ou juste des points/espaces)
     String trimmed = transcription;
@@ -276,6 +358,7 @@ void processVoiceCommand() {
 
     if (cleaned.length() < 2) {
         // Silence détecté - sortir du mode dialogue
+        turn.finish(false);
         Serial.println("Silence détecté - fin du dialogue");
         display.showMessage("SATOSHI", "À bientôt!");
         delay(1000);
@@ -291,7 +374,7 @@ void processVoiceCommand() {
         // C'était juste le wake word, attendre la commande
         display.showMessage("SATOSHI", "Je vous écoute...");
         delay(500);
-        processVoiceCommand();  // Réécouter pour la vraie commande
+        listenForCommand(turn);  // Réécouter pour la vraie commande, même tour
         return;
     }
 
@@ -303,74 +386,57 @@ void processVoiceCommand() {
     }
 
     // Envoyer a Claude
-    askClaude(transcription);
+    askClaude(transcription, &turn);
 }
 
-// Parser et exécuter les actions de la réponse Claude
-bool executeClaudeAction(const String& response) {
+// Exécuter l'action demandée par Claude (outil pay, receive ou stats)
+bool executeClaudeAction(const ClaudeAction& action) {
     bool actionExecuted = false;
 
-    // === ACTION:PAY - Paiement Lightning ===
-    int actionIdx = response.indexOf("ACTION:PAY:");
-    if (actionIdx >= 0) {
-        int lineEnd = response.indexOf('\n', actionIdx);
-        if (lineEnd < 0) lineEnd = response.length();
-
-        String actionLine = response.substring(actionIdx + 11, lineEnd);  // Apres "ACTION:PAY:"
-        actionLine.trim();
-
-        // Parser address:amount
-        int colonIdx = actionLine.lastIndexOf(':');
-        if (colonIdx > 0) {
-            String address = actionLine.substring(0, colonIdx);
-            String amountStr = actionLine.substring(colonIdx + 1);
-            int64_t amount = amountStr.toInt();
-
-            Serial.printf("ACTION PAIEMENT: %s -> %lld sats\n", address.c_str(), amount);
-
-            if (amount > 0 && amount <= 100000 && address.length() >= 5) {
-                // Afficher confirmation
-                char msg[100];
-                snprintf(msg, sizeof(msg), "Envoi %lld sats\na %s", amount, address.c_str());
-                display.showMessage("PAIEMENT", msg);
-                delay(1000);
-
-                // Exécuter le paiement
-                bool success = false;
-                if (address.startsWith("lnbc") || address.startsWith("LNBC")) {
-                    success = lnbitsAPI.payInvoice(address.c_str());
-                } else if (address.indexOf('@') > 0) {
-                    success = lnbitsAPI.payLnAddress(address.c_str(), amount);
-                } else {
-                    display.showError("Format adresse?");
-                    delay(2000);
-                }
-
-                if (success) {
-                    Serial.println("Paiement réussi!");
-                    display.showMessage("PAYÉ!", "Paiement envoyé");
-                    delay(2000);
-                    actionExecuted = true;
-                } else if (lnbitsAPI.getLastError().length() > 0) {
-                    display.showError(lnbitsAPI.getLastError().c_str());
-                    delay(3000);
-                }
+    // === pay - Paiement Lightning ===
+    if (action.tool == CLAUDE_TOOL_PAY) {
+        String address = action.address;
+        address.trim();
+        int64_t amount = action.amount;
+
+        Serial.printf("ACTION PAIEMENT: %s -> %lld sats\n", address.c_str(), amount);
+
+        if (amount > 0 && amount <= 100000 && address.length() >= 5) {
+            // Afficher confirmation
+            char msg[100];
+            snprintf(msg, sizeof(msg), "Envoi %lld sats\na %s", amount, address.c_str());
+            display.showMessage("PAIEMENT", msg);
+            delay(1000);
+
+            // Exécuter le paiement
+            bool success = false;
+            if (address.startsWith("lnbc") || address.startsWith("LNBC")) {
+                success = lnbitsAPI.payInvoice(address.c_str());
+            } else if (address.indexOf('@') > 0) {
+                success = lnbitsAPI.payLnAddress(address.c_str(), amount);
             } else {
-                display.showError("Montant invalide");
+                display.showError("Format adresse?");
                 delay(2000);
             }
+
+            if (success) {
+                Serial.println("Paiement réussi!");
+                display.showMessage("PAYÉ!", "Paiement envoyé");
+                delay(2000);
+                actionExecuted = true;
+            } else if (lnbitsAPI.getLastError().length() > 0) {
+                display.showError(lnbitsAPI.getLastError().c_str());
+                delay(3000);
+            }
+        } else {
+            display.showError("Montant invalide");
+            delay(2000);
         }
     }
 
-    // === ACTION:RECEIVE - Recevoir des sats avec QR code ===
-    actionIdx = response.indexOf("ACTION:RECEIVE:");
-    if (actionIdx >= 0) {
-        int lineEnd = response.indexOf('\n', actionIdx);
-        if (lineEnd < 0) lineEnd = response.length();
-
-        String amountStr = response.substring(actionIdx + 15, lineEnd);
-        amountStr.trim();
-        int64_t amount = amountStr.toInt();
+    // === receive - Recevoir des sats avec QR code ===
+    if (action.tool == CLAUDE_TOOL_RECEIVE) {
+        int64_t amount = action.amount;
 
         Serial.printf("ACTION RECEIVE: %lld sats\n", amount);
 
@@ -409,14 +475,16 @@ bool executeClaudeAction(const String& response) {
         }
     }
 
-    // === ACTION:STATS - Afficher les statistiques ===
-    actionIdx = response.indexOf("ACTION:STATS");
-    if (actionIdx >= 0) {
+    // === stats - Afficher les statistiques ===
+    if (action.tool == CLAUDE_TOOL_STATS) {
         Serial.println("ACTION STATS");
 
         display.showMessage("STATS", "Chargement...");
 
-        if (lnbitsAPI.fetchStats()) {
+        // LNbits indisponible (disjoncteur ouvert): dernieres stats connues
+        bool fresh = lnbitsAPI.fetchStats();
+        if (fresh || lnbitsAPI.getStats().valid) {
+            if (!fresh) Serial.println("Stats LNbits en cache: " + lnbitsAPI.getLastError());
             WalletStats stats = lnbitsAPI.getStats();
             char statsMsg[200];
             snprintf(statsMsg, sizeof(statsMsg),
@@ -441,84 +509,92 @@ bool executeClaudeAction(const String& response) {
         }
     }
 
-    // === ACTION:MINING_STATUS - Afficher statut mining Bitaxe ===
-    actionIdx = response.indexOf("ACTION:MINING_STATUS");
-    if (actionIdx >= 0) {
-        Serial.println("ACTION MINING_STATUS");
-
-        // Rafraîchir les données mining si nécessaire
-        if (miningManager.needsRefresh()) {
-            display.showMessage("MINING", "Rafraîchissement...");
-            miningManager.refreshAll();
-        }
-
-        // Afficher les stats mining
-        display.showMiningStats();
+    return actionExecuted;
+}
 
-        // TTS dès l'affichage des stats
-        if (miningManager.getMinerCount() > 0) {
-            MiningStats stats = miningManager.getAggregatedStats();
-            char ttsMsg[200];
-            snprintf(ttsMsg, sizeof(ttsMsg),
-                "Mining: %d mineurs en ligne. Hashrate total %s. Consommation %.1f watts. Température moyenne %.0f degrés.",
-                stats.onlineCount, miningManager.formatTotalHashrate().c_str(),
-                stats.totalPower, stats.avgTemp);
+// Ecran mining apres une reponse qui a appele get_mining_status: les
+// chiffres ont deja ete lus dans la reponse de Claude
+void showMiningStatus() {
+    display.showMiningStats();
 
-            uint8_t* ttsBuffer = nullptr;
-            size_t ttsSize = 0;
-            if (speakText(ttsMsg, &ttsBuffer, &ttsSize)) {
-                audioManager.playAudio(ttsBuffer, ttsSize);
-                free(ttsBuffer);
-            }
-        } else {
-            uint8_t* ttsBuffer = nullptr;
-            size_t ttsSize = 0;
-            if (speakText("Aucun mineur configuré.", &ttsBuffer, &ttsSize)) {
-                audioManager.playAudio(ttsBuffer, ttsSize);
-                free(ttsBuffer);
-            }
+    // Attendre toucher
+    unsigned long startWait = millis();
+    while (millis() - startWait < 10000) {
+        if (touch.touched()) {
+            delay(200);
+            break;
         }
+        delay(100);
+    }
+}
 
-        // Attendre toucher
-        unsigned long startWait = millis();
-        while (millis() - startWait < 10000) {
-            if (touch.touched()) {
-                delay(200);
-                break;
+// Reponse de Claude en cours d'affichage (flux)
+struct StreamView {
+    bool drawn;                 // Ecran de conversation deja affiche
+    unsigned long lastDraw;
+};
+
+// Texte de Claude recu en flux: zone de reponse redessinee (au plus toutes
+// les STREAM_DRAW_INTERVAL ms, et a chaque fin de phrase) et phrases
+// confiees au TTS des qu'elles sont completes
+void onClaudeText(const char* text, void* arg) {
+    StreamView* view = (StreamView*)arg;
+    bool sentenceEnded = speechPipeline.addText(text);
+    if (sentenceEnded || millis() - view->lastDraw >= STREAM_DRAW_INTERVAL) {
+        String shown = speechPipeline.getText();
+        if (shown.length() > 0) {
+            if (view->drawn) {
+                display.updateConversation(shown.c_str());
+            } else {
+                display.showConversation(lastUserMessage.c_str(), shown.c_str());
+                view->drawn = true;
             }
-            delay(100);
+            view->lastDraw = millis();
         }
-        actionExecuted = true;
     }
-
-    return actionExecuted;
+    // Phrases synthetisees jouees pendant que la suite arrive
+    speechPipeline.pump();
 }
 
-void askClaude(const String& question) {
+void askClaude(const String& question, TurnBudget* turn) {
     lastUserMessage = question;
     currentState = STATE_PROCESSING;
     dialogueInterrupted = false;
 
-    if (millis() - lastDataRefresh > DATA_REFRESH_INTERVAL) {
-        refreshBitcoinData();
-    }
-
-    // Mettre à jour le contexte mining si des mineurs sont configurés
-    if (miningManager.getMinerCount() > 0) {
-        if (miningManager.needsRefresh()) {
-            miningManager.refreshAll();
-        }
-        claudeAPI.updateMiningContext(miningManager.formatMiningStatus());
-    }
+    // Donnees Bitcoin et Mining demandees par Claude (outils), servies
+    // depuis le cache: plus de rafraichissement complet avant la question.
+    // Un outil au cache perime compte dans l'etape Claude.
+    if (turn) turn->beginStage(TURN_LLM, CLAUDE_TIMEOUT_MS);
 
     display.showThinking();
     Serial.println("Envoi a Claude...");
 
+    // Masquer la latence Claude + TTS avec une phrase adaptee a la question
+    ackAudio.play(ackAudio.intentFor(question));
+
+    // Reponse en flux: affichee et lue phrase par phrase pendant qu'elle arrive
     String response;
-    if (claudeAPI.sendMessage(question.c_str(), response)) {
+    StreamView view = { false, 0 };
+    speechPipeline.begin(turn);
+    bool answered = claudeAPI.sendMessage(question.c_str(), response, turn, onClaudeText, &view);
+    if (turn) turn->endStage(TURN_LLM, answered);
+    if (answered) {
+        // Reponse avec texte: premieres phrases deja jouees pendant le flux,
+        // la suite est lue ici avant l'affichage final
+        bool streamed = speechPipeline.isSpeaking();
+        bool spoken = streamed && speechPipeline.finish();
+        if (streamed && speechPipeline.wasInterrupted()) {
+            dialogueInterrupted = true;
+            currentState = STATE_READY;
+            display.showSatoshiReady();
+            delay(200);
+            return;
+        }
+
         // Vérifier interruption touch
         if (touch.touched()) {
             Serial.println("Touch - retour menu");
+            if (turn) turn->finish(false);  // Sans effet si le flux l'a deja termine
             dialogueInterrupted = true;
             currentState = STATE_READY;
             display.showSatoshiReady();
@@ -526,11 +602,15 @@ void askClaude(const String& question) {
             return;
         }
 
-        // Vérifier s'il y a une action à exécuter
-        bool actionExecuted = executeClaudeAction(response);
+        // Vérifier s'il y a une action à exécuter. Confirmations, QR code
+        // et attentes du toucher ne comptent pas dans le budget du tour.
+        if (turn) turn->suspend();
+        bool actionExecuted = executeClaudeAction(claudeAPI.getAction());
+        if (turn) turn->resume();
 
         // Si action exécutée, vérifier touch avant de continuer
         if (actionExecuted && touch.touched()) {
+            if (turn) turn->finish(false);
             dialogueInterrupted = true;
             currentState = STATE_READY;
             display.showSatoshiReady();
@@ -538,18 +618,11 @@ void askClaude(const String& question) {
             return;
         }
 
-        // Retirer la ligne ACTION de la réponse affichée
+        // Action appelee sans texte (consigne du prompt): courte confirmation
         String displayResponse = response;
-        int actionIdx = displayResponse.indexOf("ACTION:");
-        if (actionIdx >= 0) {
-            int lineEnd = displayResponse.indexOf('\n', actionIdx);
-            if (lineEnd >= 0) {
-                displayResponse = displayResponse.substring(lineEnd + 1);
-            } else {
-                displayResponse = "";
-            }
+        if (displayResponse.length() == 0) {
+            displayResponse = actionExecuted ? "C'est fait!" : "Action non effectuée.";
         }
-        displayResponse.trim();
 
         lastResponse = displayResponse;
         Serial.println("\n--- Réponse SATOSHI ---");
@@ -563,7 +636,13 @@ void askClaude(const String& question) {
         size_t ttsSize = 0;
         unsigned long audioDurationMs = 0;
 
-        if (speakText(lastResponse.c_str(), &ttsBuffer, &ttsSize)) {
+        if (!streamed) {
+            spoken = speakText(lastResponse.c_str(), &ttsBuffer, &ttsSize, turn);
+            // Reponse prete a jouer: fin du tour (la lecture n'est pas comptee)
+            if (turn && spoken) turn->markFirstAudio();
+            if (turn) turn->finish(spoken);
+        }
+        if (spoken && ttsBuffer) {
             Serial.printf("Lecture audio TTS (%d bytes)...\n", ttsSize);
 
             // Calculer la durée de l'audio WAV
@@ -586,7 +665,7 @@ void askClaude(const String& question) {
                     return;
                 }
             }
-        } else {
+        } else if (!spoken) {
             // TTS échoué - vérifier si rate limit
             if (ttsRateLimitHit) {
                 char rateLimitMsg[100];
@@ -603,6 +682,10 @@ void askClaude(const String& question) {
             }
         }
 
+        if (claudeAPI.usedTool(CLAUDE_TOOL_MINING) && miningManager.getMinerCount() > 0) {
+            showMiningStatus();
+        }
+
         // Attendre touch ou timeout pour continuer dialogue
         Serial.println("\n*** Touchez pour finir, ou parlez... ***");
         display.showMessage("SATOSHI", "Touchez=fin\nParlez=continue");
@@ -636,6 +719,7 @@ void askClaude(const String& question) {
         return;
 
     } else {
+        if (turn) turn->finish(false);
         Serial.println("Erreur: " + claudeAPI.getLastError());
         display.showError(claudeAPI.getLastError().c_str());
         delay(3000);
@@ -674,12 +758,21 @@ void loop() {
                 }
                 delay(400);
 
+                // Profil TLS verifie et sessions reprises (avant toute connexion HTTPS)
+                tlsProfile.begin();
+                tlsSessionCache.begin();
+
                 // Initialiser les APIs
                 claudeAPI.begin();
+                conversationHistory.begin();
                 bitcoinAPI.begin();
                 lnbitsAPI.begin();
                 whisperAPI.begin();
                 miningManager.begin();
+                httpExecutor.begin();
+                prewarmer.begin();
+                // Whisper et TTS multiplexes sur une connexion HTTP/2
+                http2.addHost(GROQ_HOST);
 
                 // Démarrer l'audio I2S avec ES8311 codec EN PREMIER
                 // (initialise Wire/I2C_NUM_0 pour ES8311 et touch)
@@ -689,6 +782,15 @@ void loop() {
                 } else {
                     Serial.println("Audio Manager OK");
 
+                    // Whisper lance des une pause courte, annule si la parole reprend
+                    audioManager.setSpeculativeSTT(true);
+
+                    // Earcons + phrases d'attente deja rendues
+                    ackAudio.begin();
+
+                    // Corpus audio terrain sur SD (si active par /corpus)
+                    corpusRecorder.begin();
+
                     // Mélodie de démarrage courte (volume 50%)
                     Serial.println("Mélodie de démarrage...");
                     audioManager.playTestTone(784, 100);   // G5 - note unique courte
@@ -713,6 +815,15 @@ void loop() {
                 // Initialiser le wake word detector
                 if (useWakeWord) {
                     wakeWord.begin();
+
+                    // Arbitrage LAN: une seule unite repond a "Satoshi"
+                    if (arbiterTransport.begin()) {
+                        wakeArbiter.begin(&arbiterTransport, (uint32_t)(ESP.getEfuseMac() >> 16));
+                        Serial.printf("Arbitre wake word: ID %08X\n", wakeArbiter.getDeviceId());
+                    }
+
+                    // Vu-metre sur l'ecran d'accueil (niveau du wake word)
+                    levelMeter.begin();
                 }
 
                 currentState = STATE_FETCHING_DATA;
@@ -737,6 +848,9 @@ void loop() {
         case STATE_FETCHING_DATA:
             refreshBitcoinData();
 
+            // Premier demarrage: rendre les phrases d'attente manquantes
+            ackAudio.renderMissingPhrases();
+
             currentState = STATE_READY;
             display.showSatoshiReady();
 
@@ -897,7 +1011,9 @@ void loop() {
                     // Prochain clignement dans 3 à 8 secondes
                     nextBlinkDelay = 3000 + random(5000);
                     // Clignement du masque mini (position: cx=50, cy=50, size=55)
+                    display.lock();
                     guyFawkes.randomBlink(display.getGfx(), 50, 50, 55);
+                    display.unlock();
                 }
             }
 
@@ -920,12 +1036,8 @@ void loop() {
                     wakeWord.resume();
                 }
 
-                // Afficher le niveau audio périodiquement
-                if (millis() - lastLevelUpdate > 100) {
-                    lastLevelUpdate = millis();
-                    // Optionnel: afficher niveau audio sur l'ecran
-                    // display.showVolumeLevel(wakeWord.getAudioLevel());
-                }
+                // Niveau audio pour le vu-metre (dessine par sa propre tache)
+                levelMeter.setLevel(wakeWord.getAudioLevel());
             }
 
             // Bouton BOOT: appui court = parler, appui long (3s) = reset config
@@ -989,15 +1101,14 @@ void loop() {
                 connectToWiFi();
             }
 
-            // Rafraîchir les données périodiquement
-            if (millis() - lastDataRefresh > DATA_REFRESH_INTERVAL * 5) {
-                bitcoinAPI.fetchPrice();
-                bitcoinAPI.fetchFees();
-                bitcoinAPI.fetchBlockHeight();
-                String context = buildBitcoinContext();
-                claudeAPI.updateBitcoinContext(context);
-                lastDataRefresh = millis();
-            }
+            // Ligne de stats audio periodique (overruns, latences)
+            audioStats.printPeriodic();
+
+            // Fermer les sockets keep-alive inactifs (libere ~40 Ko chacun)
+            connectionPool.evictIdle();
+
+            // Rafraîchir les données périodiquement (executeur, classe fond)
+            pollBackgroundRefresh();
             break;
 
         case STATE_WAKE_LISTENING:
@@ -1112,6 +1223,155 @@ void processSerialCommand() {
                     serialBuffer = "";
                     return;
                 }
+                else if (serialBuffer == "/spec") {
+                    // Activer/desactiver la transcription speculative
+                    audioManager.setSpeculativeSTT(!audioManager.isSpeculativeSTTEnabled());
+                    whisperAPI.printSpeculativeStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/corpus") {
+                    // Activer/desactiver l'enregistrement du corpus sur SD
+                    corpusRecorder.setEnabled(!corpusRecorder.isEnabled());
+                    corpusRecorder.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/audiostats") {
+                    // Overruns/underruns I2S et latences capture -> decision
+                    audioStats.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/pool") {
+                    // Connexions TLS: handshakes, reutilisations par hote
+                    connectionPool.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/tlscache") {
+                    // Persistance des sessions TLS (chiffrees, LittleFS) + stats reprises
+                    tlsSessionCache.setPersistent(!tlsSessionCache.isPersistent());
+                    tlsSessionCache.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/http") {
+                    // Requetes paralleles: jobs, pic de concurrence, attente en file,
+                    // doublons fusionnes
+                    httpExecutor.printStats();
+                    singleFlight.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/json") {
+                    // Pic de heap getString vs flux filtre + stats par endpoint
+                    bitcoinAPI.benchmarkParsing();
+                    jsonReader.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/upload") {
+                    // Envoi Whisper: records 16 Ko ON/OFF (comparer les debits)
+                    MultipartWriter::setLegacy(!MultipartWriter::isLegacy());
+                    MultipartWriter::printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/prewarm") {
+                    // Pre-chauffage DNS/TLS au debut de parole ON/OFF + gains
+                    prewarmer.setEnabled(!prewarmer.isEnabled());
+                    prewarmer.printStats();
+                    dnsCache.printStats();
+                    connectionPool.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/h2") {
+                    // HTTP/2 vers Groq ON/OFF (OFF: HTTP/1.1 via le pool)
+                    http2.setEnabled(!http2.isEnabled());
+                    http2.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/turn") {
+                    // Budget des tours vocaux: durees et depassements par etape
+                    TurnBudget::printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/stream") {
+                    // Reponse Claude en flux ON/OFF + 1er token / 1er audio par tour
+                    claudeAPI.setStreaming(!claudeAPI.isStreaming());
+                    speechPipeline.printStats();
+                    TurnBudget::printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/cache") {
+                    // Cache du prompt Claude ON/OFF + tokens caches et latence par appel
+                    claudeAPI.setPromptCache(!claudeAPI.isPromptCache());
+                    claudeAPI.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/tools") {
+                    // Outils Claude: appels, rafraichissements a la demande
+                    claudeTools.printStats();
+                    claudeAPI.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/history") {
+                    // Memoire de conversation ON/OFF + latence par taille d'historique
+                    conversationHistory.setEnabled(!conversationHistory.isEnabled());
+                    conversationHistory.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/breaker") {
+                    // Disjoncteurs par hote ON/OFF + etat, fenetres, refus
+                    circuitBreaker.setEnabled(!circuitBreaker.isEnabled());
+                    circuitBreaker.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/etag") {
+                    // Requetes conditionnelles ON/OFF + 200/304 et octets evites par URL
+                    httpValidators.setEnabled(!httpValidators.isEnabled());
+                    httpValidators.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/tls") {
+                    // Verification des certificats ON/OFF (LNbits auto-signe)
+                    tlsProfile.setVerify(!tlsProfile.isVerify());
+                    tlsProfile.printProfile();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/tlsbench") {
+                    // Handshakes: profil verifie vs ancien setInsecure
+                    if (useWakeWord) wakeWord.pause();
+                    tlsProfile.benchmark();
+                    if (useWakeWord) wakeWord.resume();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/meter") {
+                    // Activer/desactiver le vu-metre (comparer les overruns ON/OFF)
+                    levelMeter.setEnabled(!levelMeter.isEnabled());
+                    levelMeter.printStats();
+                    serialBuffer = "";
+                    return;
+                }
+                else if (serialBuffer == "/ack") {
+                    // Activer/desactiver les accuses de reception audio
+                    ackAudio.setEnabled(!ackAudio.isEnabled());
+                    Serial.printf("Accuses audio: %s\n", ackAudio.isEnabled() ? "ON" : "OFF");
+                    serialBuffer = "";
+                    return;
+                }
                 else if (serialBuffer == "/help") {
                     Serial.println("\n=== COMMANDES DISPONIBLES ===");
                     Serial.println("/mic       - Test micro GPIO2 (L420A7J1)");
@@ -1123,6 +1383,27 @@ void processSerialCommand() {
                     Serial.println("/micboth   - Sélectionner MIC1+MIC2");
                     Serial.println("/scanpdm   - Scan complet pins PDM");
                     Serial.println("/scanamp   - Scan pins amplificateur");
+                    Serial.println("/spec      - On/off STT speculatif + stats");
+                    Serial.println("/ack       - On/off accuses de reception audio");
+                    Serial.println("/corpus    - On/off corpus audio sur SD + stats");
+                    Serial.println("/audiostats- Overruns/underruns I2S + latences");
+                    Serial.println("/meter     - On/off vu-metre + overruns");
+                    Serial.println("/pool      - Connexions TLS: handshakes, reutilisation");
+                    Serial.println("/tlscache  - On/off sessions TLS persistantes (secrets en flash) + stats");
+                    Serial.println("/http      - Executeur HTTP parallele + doublons fusionnes");
+                    Serial.println("/json      - JSON en flux: pic heap vs getString + stats");
+                    Serial.println("/upload    - Envoi Whisper 16 Ko ON/OFF + debits");
+                    Serial.println("/prewarm   - On/off pre-chauffage DNS/TLS + gains");
+                    Serial.println("/h2        - On/off HTTP/2 Groq (STT+TTS) + stats");
+                    Serial.println("/breaker   - On/off disjoncteurs mempool/LNbits + etat");
+                    Serial.println("/etag      - On/off requetes conditionnelles + octets evites");
+                    Serial.println("/turn      - Budget des tours vocaux par etape");
+                    Serial.println("/stream    - On/off reponse Claude en flux (lue par phrases)");
+                    Serial.println("/cache     - On/off cache du prompt Claude + tokens caches");
+                    Serial.println("/history   - On/off memoire de conversation + latence");
+                    Serial.println("/tools     - Outils Claude: appels et donnees rafraichies");
+                    Serial.println("/tls       - On/off verification certificats + profil");
+                    Serial.println("/tlsbench  - Benchmark handshakes verifie vs insecure");
                     Serial.println("/help      - Cette aide");
                     Serial.println("Autre      - Envoyer à Claude");
                     Serial.println("=============================\n");
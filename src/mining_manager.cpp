@@ -1,5 +1,6 @@
 // mining_manager.cpp - Implémentation gestionnaire de mineurs
 #include "mining_manager.h"
+#include "single_flight.h"
 
 MiningManager miningManager;
 
@@ -8,10 +9,28 @@ MiningManager::MiningManager() {
     lastRefresh = 0;
     memset(miners, 0, sizeof(miners));
     memset(minerIPs, 0, sizeof(minerIPs));
+    mutex = xSemaphoreCreateMutex();
+}
+
+void MiningManager::lock() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void MiningManager::unlock() {
+    xSemaphoreGive(mutex);
+}
+
+int MiningManager::findMiner(const char* ip) {
+    for (int i = 0; i < minerCount; i++) {
+        if (strcmp(minerIPs[i], ip) == 0) return i;
+    }
+    return -1;
 }
 
 void MiningManager::begin() {
+    lock();
     loadFromNVS();
+    unlock();
     Serial.printf("Mining Manager: %d mineur(s) configuré(s)\n", minerCount);
 
     // Rafraîchir les données au démarrage
@@ -21,33 +40,44 @@ void MiningManager::begin() {
 }
 
 bool MiningManager::addMiner(const char* ip) {
-    if (minerCount >= MAX_MINERS) {
+    lock();
+    bool full = minerCount >= MAX_MINERS;
+    bool known = findMiner(ip) >= 0;
+    unlock();
+
+    if (full) {
         Serial.println("Erreur: nombre max de mineurs atteint");
         return false;
     }
 
     // Vérifier si l'IP existe déjà
-    for (int i = 0; i < minerCount; i++) {
-        if (strcmp(minerIPs[i], ip) == 0) {
-            Serial.println("Erreur: mineur déjà ajouté");
-            return false;
-        }
+    if (known) {
+        Serial.println("Erreur: mineur déjà ajouté");
+        return false;
     }
 
-    // Tester la connexion au mineur
+    // Tester la connexion au mineur (hors verrou)
     BitaxeMinerInfo testInfo;
+    memset(&testInfo, 0, sizeof(testInfo));
     if (!bitaxeAPI.fetchMinerInfo(ip, testInfo)) {
         Serial.printf("Erreur: impossible de contacter le mineur %s\n", ip);
         return false;
     }
 
-    // Ajouter le mineur
+    // Ajouter le mineur (table modifiee pendant le test: reverifier)
+    lock();
+    if (minerCount >= MAX_MINERS || findMiner(ip) >= 0) {
+        unlock();
+        Serial.printf("Erreur: mineur %s non ajouté, liste modifiée entre-temps\n", ip);
+        return false;
+    }
     strncpy(minerIPs[minerCount], ip, sizeof(minerIPs[0]) - 1);
     miners[minerCount] = testInfo;
     minerCount++;
 
     // Sauvegarder
     saveToNVS();
+    unlock();
 
     Serial.printf("Mineur ajouté: %s (%s) - %.2f GH/s\n",
                   testInfo.hostname, ip, testInfo.hashrate);
@@ -56,7 +86,9 @@ bool MiningManager::addMiner(const char* ip) {
 }
 
 bool MiningManager::removeMiner(int index) {
+    lock();
     if (index < 0 || index >= minerCount) {
+        unlock();
         return false;
     }
 
@@ -73,34 +105,63 @@ bool MiningManager::removeMiner(int index) {
     memset(minerIPs[minerCount], 0, sizeof(minerIPs[0]));
 
     saveToNVS();
+    unlock();
     return true;
 }
 
 void MiningManager::clearAllMiners() {
+    lock();
     minerCount = 0;
     memset(miners, 0, sizeof(miners));
     memset(minerIPs, 0, sizeof(minerIPs));
     saveToNVS();
+    unlock();
     Serial.println("Tous les mineurs supprimés");
 }
 
 void MiningManager::refreshAll() {
     Serial.println("Rafraîchissement de tous les mineurs...");
 
-    for (int i = 0; i < minerCount; i++) {
+    // minerCount relu a chaque tour: la liste peut changer entre deux mineurs
+    for (int i = 0; i < getMinerCount(); i++) {
         refreshMiner(i);
         delay(100);  // Petit délai entre les requêtes
     }
 
+    lock();
     lastRefresh = millis();
+    unlock();
 }
 
 bool MiningManager::refreshMiner(int index) {
+    // Copie de l'IP et du cache (requete conditionnelle) sous verrou: la
+    // requete se fait hors verrou, la table peut etre editee pendant ce temps
+    char ip[sizeof(minerIPs[0])];
+    BitaxeMinerInfo info;
+    lock();
     if (index < 0 || index >= minerCount) {
+        unlock();
         return false;
     }
-
-    return bitaxeAPI.fetchMinerInfo(minerIPs[index], miners[index]);
+    memcpy(ip, minerIPs[index], sizeof(ip));
+    info = miners[index];
+    unlock();
+
+    // Mineur deja interroge (menu mining, action Claude): miners[] est
+    // rempli par la requete en cours, seul le resultat est partage
+    String url = "http://" + String(ip) + "/api/system/info";
+    bool ok;
+    if (singleFlight.join("GET", url, nullptr, nullptr, 0, ok)) return ok;
+    ok = bitaxeAPI.fetchMinerInfo(ip, info);
+
+    // Ecrit a la place actuelle du mineur, sauf s'il a ete supprime
+    lock();
+    int slot = findMiner(ip);
+    if (slot >= 0) miners[slot] = info;
+    unlock();
+
+    singleFlight.land("GET", url, ok);
+    return ok;
 }
 
 BitaxeMinerInfo* MiningManager::getMiner(int index) {
@@ -114,9 +175,11 @@ MiningStats MiningManager::getAggregatedStats() {
     MiningStats stats;
     memset(&stats, 0, sizeof(stats));
 
+    lock();
     stats.minerCount = minerCount;
 
     if (minerCount == 0) {
+        unlock();
         return stats;
     }
 
@@ -137,6 +200,7 @@ MiningStats MiningManager::getAggregatedStats() {
             }
         }
     }
+    unlock();
 
     // Calculer les moyennes
     if (tempCount > 0) {
@@ -1,5 +1,8 @@
 // mining_manager.h - Gestionnaire de mineurs Bitaxe
 // Stockage des IPs en NVS, agrégation des stats
+// La table est modifiee par le polling de fond (httpExecutor) et par la
+// boucle (menu Mining, ajout/suppression): mutex pris le temps d'une copie
+// ou d'une ecriture, jamais pendant une requete HTTP.
 #ifndef MINING_MANAGER_H
 #define MINING_MANAGER_H
 
@@ -55,6 +58,11 @@ private:
     char minerIPs[MAX_MINERS][32];
     int minerCount;
     unsigned long lastRefresh;
+    SemaphoreHandle_t mutex;
+
+    void lock();
+    void unlock();
+    int findMiner(const char* ip);      // Sous verrou
 };
 
 extern MiningManager miningManager;
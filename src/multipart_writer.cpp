@@ -0,0 +1,230 @@
+// multipart_writer.cpp - Envoi multipart/form-data sans copie
+#include "multipart_writer.h"
+#include <esp_heap_caps.h>
+
+bool MultipartWriter::legacyMode = false;
+MultipartStats MultipartWriter::stats[2];
+
+MultipartWriter::MultipartWriter() {
+    snprintf(boundary, sizeof(boundary), "----ESP32Boundary%08lx%08lx",
+             (unsigned long)millis(), (unsigned long)esp_random());
+    textLen = 0;
+    head.data = nullptr;
+    head.len = 0;
+    headComplete = false;
+    segmentCount = 0;
+    bodyLength = 0;
+    fileOpen = false;
+    overflow = false;
+}
+
+// ============================================================
+// Construction de la liste de segments
+// ============================================================
+
+bool MultipartWriter::formatText(Segment& seg, const char* fmt, va_list args) {
+    size_t room = sizeof(text) - textLen;
+    int n = vsnprintf(text + textLen, room, fmt, args);
+    if (n < 0 || (size_t)n >= room) {
+        overflow = true;
+        return false;
+    }
+    seg.data = (const uint8_t*)(text + textLen);
+    seg.len = n;
+    textLen += n;
+    return true;
+}
+
+bool MultipartWriter::addSegment(const uint8_t* data, size_t len) {
+    if (segmentCount >= MULTIPART_SEGMENTS) {
+        overflow = true;
+        return false;
+    }
+    if (len == 0) return true;
+    segments[segmentCount].data = data;
+    segments[segmentCount].len = len;
+    segmentCount++;
+    bodyLength += len;
+    return true;
+}
+
+bool MultipartWriter::addText(const char* fmt, ...) {
+    if (segmentCount >= MULTIPART_SEGMENTS) {
+        overflow = true;
+        return false;
+    }
+    Segment seg;
+    va_list args;
+    va_start(args, fmt);
+    bool ok = formatText(seg, fmt, args);
+    va_end(args);
+    return ok && addSegment(seg.data, seg.len);
+}
+
+bool MultipartWriter::setHead(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    bool ok = formatText(head, fmt, args);
+    va_end(args);
+    return ok;
+}
+
+bool MultipartWriter::addField(const char* name, const char* value) {
+    if (fileOpen) {
+        addText("\r\n");
+        fileOpen = false;
+    }
+    return addText("--%s\r\nContent-Disposition: form-data; name=\"%s\"\r\n\r\n", boundary, name) &&
+           addSegment((const uint8_t*)value, strlen(value)) &&
+           addText("\r\n");
+}
+
+bool MultipartWriter::beginFile(const char* name, const char* filename, const char* contentType) {
+    if (fileOpen) addText("\r\n");
+    fileOpen = true;
+    return addText("--%s\r\nContent-Disposition: form-data; name=\"%s\"; filename=\"%s\"\r\n"
+                   "Content-Type: %s\r\n\r\n", boundary, name, filename, contentType);
+}
+
+bool MultipartWriter::addData(const uint8_t* data, size_t len) {
+    return addSegment(data, len);
+}
+
+bool MultipartWriter::end() {
+    if (fileOpen) {
+        addText("\r\n");
+        fileOpen = false;
+    }
+    return addText("--%s--\r\n", boundary) && !overflow;
+}
+
+// ============================================================
+// Envoi
+// ============================================================
+
+bool MultipartWriter::writeAll(Print& out, const uint8_t* data, size_t len, uint32_t& writes) {
+    while (len > 0) {
+        size_t n = out.write(data, len);
+        writes++;
+        if (n == 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool MultipartWriter::send(Print& out, volatile bool* cancel) {
+    if (overflow || !head.data) {
+        Serial.println("Multipart: requete trop longue");
+        return false;
+    }
+
+    // Fin des en-tetes HTTP: longueur connue une fois le corps decrit.
+    // Une seule fois: send() est rejoue sur un socket neuf si besoin.
+    if (!headComplete) {
+        if (!setHead("%.*sContent-Type: multipart/form-data; boundary=%s\r\nContent-Length: %u\r\n\r\n",
+                     (int)head.len, (const char*)head.data, boundary, (unsigned)bodyLength)) {
+            Serial.println("Multipart: en-tetes trop longs");
+            return false;
+        }
+        headComplete = true;
+    }
+    return sendSegments(out, -1, cancel);
+}
+
+bool MultipartWriter::sendBody(Print& out, volatile bool* cancel) {
+    if (overflow) {
+        Serial.println("Multipart: requete trop longue");
+        return false;
+    }
+    return sendSegments(out, 0, cancel);
+}
+
+// first = -1: en-tetes HTTP puis corps
+bool MultipartWriter::sendSegments(Print& out, int first, volatile bool* cancel) {
+    // Tampon d'assemblage en PSRAM (en RAM interne a defaut), ancien mode sans tampon
+    bool legacy = legacyMode;
+    uint8_t* record = nullptr;
+    if (!legacy) {
+        record = (uint8_t*)heap_caps_malloc(MULTIPART_RECORD_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!record) record = (uint8_t*)malloc(MULTIPART_RECORD_SIZE);
+        if (!record) legacy = true;
+    }
+
+    unsigned long start = millis();
+    uint32_t writes = 0;
+    size_t fill = 0;
+    bool ok = true;
+
+    for (int i = first; i < segmentCount && ok; i++) {
+        const Segment& seg = i < 0 ? head : segments[i];
+        const uint8_t* p = seg.data;
+        size_t left = seg.len;
+
+        while (left > 0) {
+            if (cancel && *cancel) {
+                ok = false;
+                break;
+            }
+
+            if (legacy) {
+                // Ancien envoi: un write (donc un record TLS) par Ko
+                size_t n = left < MULTIPART_LEGACY_CHUNK ? left : MULTIPART_LEGACY_CHUNK;
+                if (!writeAll(out, p, n, writes)) { ok = false; break; }
+                p += n;
+                left -= n;
+                yield();
+            } else if (fill == 0 && left >= MULTIPART_RECORD_SIZE) {
+                // Tranche pleine: ecrite depuis la source, sans copie
+                if (!writeAll(out, p, MULTIPART_RECORD_SIZE, writes)) { ok = false; break; }
+                p += MULTIPART_RECORD_SIZE;
+                left -= MULTIPART_RECORD_SIZE;
+            } else {
+                // Petits segments et bords de l'audio: regroupes
+                size_t n = MULTIPART_RECORD_SIZE - fill;
+                if (n > left) n = left;
+                memcpy(record + fill, p, n);
+                fill += n;
+                p += n;
+                left -= n;
+                if (fill == MULTIPART_RECORD_SIZE) {
+                    if (!writeAll(out, record, fill, writes)) { ok = false; break; }
+                    fill = 0;
+                }
+            }
+        }
+    }
+    if (ok && fill > 0) ok = writeAll(out, record, fill, writes);
+    if (record) free(record);
+
+    uint32_t elapsed = millis() - start;
+    size_t total = (first < 0 ? head.len : 0) + bodyLength;
+    if (ok) {
+        MultipartStats& s = stats[legacy ? 0 : 1];
+        s.uploads++;
+        s.bytes += total;
+        s.ms += elapsed;
+        s.writes += writes;
+        s.lastKBps = elapsed > 0 ? total / elapsed : 0;  // octets/ms = Ko/s
+        Serial.printf("Multipart: %u octets en %u ms (%u Ko/s, %u writes%s)\n",
+                      (unsigned)total, elapsed, s.lastKBps, writes, legacy ? ", ancien envoi" : "");
+    }
+    return ok;
+}
+
+void MultipartWriter::printStats() {
+    static const char* names[2] = { "ancien (1 Ko)", "records 16 Ko" };
+    Serial.println("\n=== ENVOI MULTIPART ===");
+    Serial.printf("Mode actif: %s\n", names[legacyMode ? 0 : 1]);
+    for (int i = 0; i < 2; i++) {
+        const MultipartStats& s = stats[i];
+        if (s.uploads == 0) {
+            Serial.printf("%-14s aucun envoi\n", names[i]);
+            continue;
+        }
+        Serial.printf("%-14s %u envois | %u Ko/s moy. (dernier %u) | %u writes/envoi\n",
+                      names[i], s.uploads, s.ms > 0 ? s.bytes / s.ms : 0, s.lastKBps,
+                      s.writes / s.uploads);
+    }
+    Serial.println("=======================\n");
+}
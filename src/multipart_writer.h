@@ -0,0 +1,92 @@
+// multipart_writer.h - Envoi multipart/form-data sans copie
+// Whisper construisait le corps multipart par concatenation de String puis
+// envoyait l'audio en client->write() de 1024 octets avec yield() entre
+// chaque: un record TLS (en-tete, MAC, padding) et un segment TCP par Ko.
+// Ici la requete est une liste de segments (en-tetes HTTP, en-tetes des
+// parties, en-tete WAV, audio, fin) qui pointent sur les donnees d'origine.
+// L'envoi regroupe les petits segments dans un tampon PSRAM de 16 Ko et
+// ecrit l'audio directement par tranches de 16 Ko: un record TLS plein par
+// ecriture (si CONFIG_MBEDTLS_SSL_OUT_CONTENT_LEN le permet, voir
+// platformio.ini).
+#ifndef MULTIPART_WRITER_H
+#define MULTIPART_WRITER_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <stdarg.h>
+
+#define MULTIPART_RECORD_SIZE   16384   // Plaintext max d'un record TLS
+#define MULTIPART_SEGMENTS      16
+#define MULTIPART_TEXT_MAX      1024    // En-tetes HTTP et des parties
+#define MULTIPART_BOUNDARY_LEN  40
+#define MULTIPART_LEGACY_CHUNK  1024    // Ancien envoi, pour comparaison
+
+// Debit d'envoi cumule, par mode (0: ancien, 1: records 16 Ko)
+struct MultipartStats {
+    uint32_t uploads;
+    uint32_t bytes;
+    uint32_t ms;
+    uint32_t writes;            // Appels client.write()
+    uint32_t lastKBps;
+};
+
+class MultipartWriter {
+public:
+    MultipartWriter();
+
+    // Ligne de requete et en-tetes fixes (sans Content-Type/Length ni
+    // ligne vide finale), format printf
+    bool setHead(const char* fmt, ...);
+
+    // Partie texte: la valeur n'est pas copiee et doit rester valide
+    // jusqu'a la fin de send()
+    bool addField(const char* name, const char* value);
+    // Partie fichier: en-tete de partie puis segments de addData()
+    bool beginFile(const char* name, const char* filename, const char* contentType);
+    bool addData(const uint8_t* data, size_t len);
+    // Ferme la partie fichier en cours et le corps
+    bool end();
+
+    size_t getContentLength() { return bodyLength; }
+    // Pour l'en-tete Content-Type quand setHead() n'est pas utilise (HTTP/2)
+    const char* getBoundary() { return boundary; }
+
+    // Envoie la requete complete. false si l'ecriture echoue ou si
+    // *cancel passe a true.
+    bool send(Print& out, volatile bool* cancel = nullptr);
+    // Corps seul, en-tetes portes par le protocole (flux HTTP/2)
+    bool sendBody(Print& out, volatile bool* cancel = nullptr);
+
+    // Comparaison avant/apres: ecritures de MULTIPART_LEGACY_CHUNK octets
+    static void setLegacy(bool legacy) { legacyMode = legacy; }
+    static bool isLegacy() { return legacyMode; }
+    static void printStats();
+
+private:
+    struct Segment {
+        const uint8_t* data;
+        size_t len;
+    };
+
+    char boundary[MULTIPART_BOUNDARY_LEN];
+    char text[MULTIPART_TEXT_MAX];
+    size_t textLen;
+    Segment head;
+    bool headComplete;          // Content-Type/Length ajoutes
+    Segment segments[MULTIPART_SEGMENTS];
+    int segmentCount;
+    size_t bodyLength;
+    bool fileOpen;
+    bool overflow;
+
+    static bool legacyMode;
+    static MultipartStats stats[2];
+
+    bool formatText(Segment& seg, const char* fmt, va_list args);
+    bool addSegment(const uint8_t* data, size_t len);
+    bool addText(const char* fmt, ...);
+    bool sendSegments(Print& out, int first, volatile bool* cancel);
+    bool writeAll(Print& out, const uint8_t* data, size_t len, uint32_t& writes);
+};
+
+#endif
@@ -0,0 +1,94 @@
+// prewarm.cpp - Pre-chauffage des connexions des le debut de la parole
+#include "prewarm.h"
+#include "connection_pool.h"
+#include "http_executor.h"
+#include "http2_client.h"
+#include "whisper_api.h"
+#include "claude_api.h"
+#include <WiFi.h>
+
+ConnectionPrewarmer prewarmer;
+
+// Un futur par hote: survit aux jobs (voir http_executor.h)
+static HttpFuture warmJobs[PREWARM_MAX_HOSTS];
+
+ConnectionPrewarmer::ConnectionPrewarmer() {
+    memset(targets, 0, sizeof(targets));
+    targetCount = 0;
+    enabled = true;
+    lastOnset = 0;
+    onsets = 0;
+    skipped = 0;
+    submitted = 0;
+    failures = 0;
+}
+
+void ConnectionPrewarmer::addTarget(const char* host, uint16_t port) {
+    for (int i = 0; i < targetCount; i++) {
+        if (targets[i].port == port && strcmp(targets[i].host, host) == 0) return;
+    }
+    if (targetCount >= PREWARM_MAX_HOSTS) return;
+    strncpy(targets[targetCount].host, host, PREWARM_HOST_LEN - 1);
+    targets[targetCount].port = port;
+    targetCount++;
+}
+
+void ConnectionPrewarmer::begin() {
+    targetCount = 0;
+
+    // STT et TTS Groq partagent l'hote: un socket suffit, les appels se
+    // suivent et le TTS reprend celui rendu par Whisper
+    addTarget(GROQ_HOST, 443);
+    String host;
+    uint16_t port;
+    if (ConnectionPool::parseUrl(CLAUDE_API_URL, host, port)) {
+        addTarget(host.c_str(), port);
+    }
+
+    Serial.printf("Pre-chauffage: %d hotes\n", targetCount);
+}
+
+bool ConnectionPrewarmer::warmJob(void* arg) {
+    Target* target = (Target*)arg;
+    // Groq en HTTP/2: la connexion multiplexee, pas un socket du pool
+    if (http2.handles(target->host, target->port)) {
+        return http2.prewarm(target->host, target->port);
+    }
+    return connectionPool.prewarm(target->host, target->port);
+}
+
+void ConnectionPrewarmer::onSpeechOnset() {
+    if (!enabled || targetCount == 0) return;
+    onsets++;
+
+    // Sans taches de fond le job bloquerait la capture audio
+    if (!httpExecutor.isStarted() || WiFi.status() != WL_CONNECTED) {
+        skipped++;
+        return;
+    }
+    if (lastOnset != 0 && millis() - lastOnset < PREWARM_COOLDOWN_MS) {
+        skipped++;
+        return;
+    }
+    lastOnset = millis();
+
+    for (int i = 0; i < targetCount; i++) {
+        if (warmJobs[i].isPending()) {
+            skipped++;
+            continue;
+        }
+        httpExecutor.submit(warmJobs[i], "prewarm", warmJob, &targets[i],
+                            [](bool ok, void*) {
+                                if (!ok) prewarmer.failures++;
+                            }, HTTP_PRIORITY_INTERACTIVE);
+        submitted++;
+    }
+}
+
+void ConnectionPrewarmer::printStats() {
+    Serial.printf("Pre-chauffage %s: %u debuts de parole, %u jobs, %u ignores, %u echecs\n",
+                  enabled ? "ON" : "OFF", onsets, submitted, skipped, failures);
+    for (int i = 0; i < targetCount; i++) {
+        Serial.printf("  %s:%u\n", targets[i].host, targets[i].port);
+    }
+}
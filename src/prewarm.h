@@ -0,0 +1,53 @@
+// prewarm.h - Pre-chauffage des connexions des le debut de la parole
+// Des que la VAD du wake word (ou l'appui sur BOOT) annonce une phrase, on
+// sait que Whisper, Claude puis le TTS vont suivre. Pendant que
+// l'utilisateur parle, les hotes sont resolus (dnsCache) et une connexion
+// TLS inactive est ouverte vers chacun dans le pool: transcribe(),
+// sendMessage() et speakText() partent sur des sockets deja chauds.
+// Utilisations, pertes et temps gagne: /pool.
+#ifndef PREWARM_H
+#define PREWARM_H
+
+#include <Arduino.h>
+
+#define PREWARM_COOLDOWN_MS   15000    // Un pre-chauffage par echange
+#define PREWARM_MAX_HOSTS     3
+#define PREWARM_HOST_LEN      64
+
+class ConnectionPrewarmer {
+public:
+    ConnectionPrewarmer();
+
+    // Hotes du pipeline vocal (STT, LLM, TTS), dedoublonnes
+    void begin();
+
+    // Debut de parole: jobs de fond sur l'executeur HTTP, non bloquant
+    void onSpeechOnset();
+
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() { return enabled; }
+    void printStats();
+
+private:
+    struct Target {
+        char host[PREWARM_HOST_LEN];
+        uint16_t port;
+    };
+
+    Target targets[PREWARM_MAX_HOSTS];
+    int targetCount;
+    bool enabled;
+    unsigned long lastOnset;
+
+    uint32_t onsets;
+    uint32_t skipped;           // Rafale (cooldown) ou job precedent en cours
+    uint32_t submitted;
+    uint32_t failures;
+
+    void addTarget(const char* host, uint16_t port);
+    static bool warmJob(void* arg);
+};
+
+extern ConnectionPrewarmer prewarmer;
+
+#endif
@@ -0,0 +1,162 @@
+// single_flight.cpp - Fusion des requetes identiques en cours
+#include "single_flight.h"
+
+SingleFlight singleFlight;
+
+SingleFlight::SingleFlight() {
+    memset(flights, 0, sizeof(flights));
+    memset((void*)waiters, 0, sizeof(waiters));
+    memset(keyStats, 0, sizeof(keyStats));
+    mutex = xSemaphoreCreateMutex();
+    nextId = 1;
+    leads = 0;
+    duplicates = 0;
+    timeouts = 0;
+    untracked = 0;
+    savedMsTotal = 0;
+}
+
+void SingleFlight::makeKey(char* key, const char* method, const String& url) {
+    snprintf(key, SF_KEY_LEN, "%s %s", method, url.c_str());
+}
+
+SingleFlight::Flight* SingleFlight::find(const char* key) {
+    for (int i = 0; i < SF_MAX_FLIGHTS; i++) {
+        if (flights[i].active && strcmp(flights[i].key, key) == 0) return &flights[i];
+    }
+    return nullptr;
+}
+
+SingleFlight::KeyStats* SingleFlight::statsFor(const char* key) {
+    for (int i = 0; i < SF_STATS_KEYS; i++) {
+        if (strcmp(keyStats[i].key, key) == 0) return &keyStats[i];
+        if (keyStats[i].key[0] == '\0') {
+            strncpy(keyStats[i].key, key, SF_KEY_LEN - 1);
+            return &keyStats[i];
+        }
+    }
+    return nullptr;
+}
+
+bool SingleFlight::join(const char* method, const String& url, JsonDocument* doc, char* text, size_t textSize,
+                        bool& ok, unsigned long waitMs, bool* unchanged) {
+    char key[SF_KEY_LEN];
+    makeKey(key, method, url);
+    ok = false;
+    if (unchanged) *unchanged = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Flight* flight = find(key);
+    if (!flight) {
+        // Premier appelant: leader
+        for (int i = 0; i < SF_MAX_FLIGHTS && !flight; i++) {
+            if (!flights[i].active) flight = &flights[i];
+        }
+        if (flight) {
+            flight->active = true;
+            flight->id = nextId++;
+            strncpy(flight->key, key, SF_KEY_LEN - 1);
+            flight->key[SF_KEY_LEN - 1] = '\0';
+            flight->startedAt = millis();
+            leads++;
+            KeyStats* ks = statsFor(key);
+            if (ks) ks->leads++;
+        } else {
+            untracked++;
+        }
+        xSemaphoreGive(mutex);
+        return false;
+    }
+
+    Waiter* waiter = nullptr;
+    for (int i = 0; i < SF_MAX_WAITERS && !waiter; i++) {
+        if (!waiters[i].used) waiter = &waiters[i];
+    }
+    if (!waiter) {
+        // Trop d'appelants en attente: requete faite en double, sans leader
+        untracked++;
+        xSemaphoreGive(mutex);
+        return false;
+    }
+    waiter->used = true;
+    waiter->flightId = flight->id;
+    waiter->doc = doc;
+    waiter->text = text;
+    waiter->textSize = textSize;
+    waiter->done = false;
+    waiter->ok = false;
+    waiter->unchanged = false;
+    duplicates++;
+    KeyStats* ks = statsFor(key);
+    if (ks) ks->duplicates++;
+    xSemaphoreGive(mutex);
+
+    Serial.printf("SingleFlight: %s deja en cours, attente du resultat\n", key);
+
+    // Le leader remplit doc / text sous le mutex puis marque done
+    unsigned long start = millis();
+    while (true) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        bool done = waiter->done;
+        if (done || millis() - start > waitMs) {
+            ok = done && waiter->ok;
+            // 304 sans cache a garder chez cet appelant: pas de resultat
+            if (ok && waiter->unchanged && !unchanged) ok = false;
+            if (unchanged) *unchanged = ok && waiter->unchanged;
+            if (!done) timeouts++;
+            // Slot libere sous le mutex: le leader n'ecrira plus dans doc
+            waiter->used = false;
+            xSemaphoreGive(mutex);
+            return true;
+        }
+        xSemaphoreGive(mutex);
+        delay(5);
+    }
+}
+
+void SingleFlight::land(const char* method, const String& url, bool ok, const JsonDocument* doc, const char* text,
+                        bool unchanged) {
+    char key[SF_KEY_LEN];
+    makeKey(key, method, url);
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Flight* flight = find(key);
+    if (flight) {
+        uint32_t elapsed = millis() - flight->startedAt;
+        for (int i = 0; i < SF_MAX_WAITERS; i++) {
+            Waiter& w = waiters[i];
+            if (!w.used || w.done || w.flightId != flight->id) continue;
+            if (ok && !unchanged && w.doc && doc) *w.doc = *doc;
+            if (ok && !unchanged && w.text && text && w.textSize > 0) {
+                strncpy(w.text, text, w.textSize - 1);
+                w.text[w.textSize - 1] = '\0';
+            }
+            w.ok = ok;
+            w.unchanged = unchanged;
+            w.done = true;
+            savedMsTotal += elapsed;
+        }
+        flight->active = false;
+    }
+    xSemaphoreGive(mutex);
+}
+
+void SingleFlight::printStats() {
+    Serial.println("\n=== REQUETES FUSIONNEES ===");
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Serial.printf("Requetes: %u executees, %u doublons servis (%u ms evites), %u attentes expirees, %u hors table\n",
+                  leads, duplicates, savedMsTotal, timeouts, untracked);
+    for (int i = 0; i < SF_STATS_KEYS; i++) {
+        const KeyStats& ks = keyStats[i];
+        if (ks.key[0] == '\0') continue;
+        if (ks.duplicates == 0) continue;
+        Serial.printf("  %-60.60s %4u + %u doublons\n", ks.key, ks.leads, ks.duplicates);
+    }
+    int inFlight = 0;
+    for (int i = 0; i < SF_MAX_FLIGHTS; i++) {
+        if (flights[i].active) inFlight++;
+    }
+    xSemaphoreGive(mutex);
+    Serial.printf("En cours: %d\n", inFlight);
+    Serial.println("===========================\n");
+}
@@ -0,0 +1,85 @@
+// single_flight.h - Fusion des requetes identiques en cours
+// Les outils de Claude (get_network, get_wallet_balance) peuvent relancer
+// les memes endpoints que le rafraichissement periodique (ou une attente
+// abandonnee de refreshBitcoinData()), et le polling de fond des mineurs
+// peut croiser le rafraichissement du menu mining. Ici une requete est
+// identifiee par methode + URL: le premier appelant (leader) l'execute,
+// les suivants attendent sa fin et recoivent une copie de son resultat
+// (document JSON filtre ou texte court) au lieu de refaire le GET.
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define SF_MAX_FLIGHTS       8        // Requetes distinctes en cours
+#define SF_MAX_WAITERS       8        // Appelants en attente (toutes cles)
+#define SF_KEY_LEN           160      // "GET https://..."
+#define SF_STATS_KEYS        12       // Cles suivies dans les stats
+#define SF_WAIT_MS           30000    // Attente max du resultat d'un leader
+
+class SingleFlight {
+public:
+    SingleFlight();
+
+    // Meme requete deja en cours? Alors attend sa fin, copie son resultat
+    // dans doc / text (si fournis), met ok et retourne true. Sinon
+    // l'appelant devient leader, retourne false: il execute la requete puis
+    // appelle land(). Sans sortie (doc et text nullptr), seul ok est
+    // partage: resultat deja ecrit dans un cache commun (miners[], solde).
+    // unchanged: le leader a recu un 304, doc / text ne sont pas remplis
+    // et le cache du module reste valide.
+    bool join(const char* method, const String& url, JsonDocument* doc, char* text, size_t textSize,
+              bool& ok, unsigned long waitMs = SF_WAIT_MS, bool* unchanged = nullptr);
+    // Fin de la requete du leader: resultat copie aux appelants en attente
+    void land(const char* method, const String& url, bool ok,
+              const JsonDocument* doc = nullptr, const char* text = nullptr, bool unchanged = false);
+
+    uint32_t getDuplicates() { return duplicates; }
+    void printStats();
+
+private:
+    struct Flight {
+        bool active;
+        uint32_t id;
+        char key[SF_KEY_LEN];
+        unsigned long startedAt;
+    };
+
+    struct Waiter {
+        bool used;
+        uint32_t flightId;
+        JsonDocument* doc;
+        char* text;
+        size_t textSize;
+        volatile bool done;
+        bool ok;
+        bool unchanged;
+    };
+
+    struct KeyStats {
+        char key[SF_KEY_LEN];
+        uint32_t leads;
+        uint32_t duplicates;
+    };
+
+    Flight flights[SF_MAX_FLIGHTS];
+    Waiter waiters[SF_MAX_WAITERS];
+    KeyStats keyStats[SF_STATS_KEYS];
+    SemaphoreHandle_t mutex;
+    uint32_t nextId;
+
+    uint32_t leads;
+    uint32_t duplicates;        // Appelants servis par la requete d'un autre
+    uint32_t timeouts;          // Attente expiree (leader trop lent)
+    uint32_t untracked;         // Table pleine: requete non fusionnee
+    uint32_t savedMsTotal;      // Temps de requete evite par les doublons
+
+    static void makeKey(char* key, const char* method, const String& url);
+    Flight* find(const char* key);
+    KeyStats* statsFor(const char* key);
+};
+
+extern SingleFlight singleFlight;
+
+#endif
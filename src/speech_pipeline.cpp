@@ -0,0 +1,207 @@
+// speech_pipeline.cpp - Reponse Claude lue phrase par phrase pendant le flux
+#include "speech_pipeline.h"
+#include "tts_groq.h"
+#include "audio.h"
+#include "ack_audio.h"
+#include "touch.h"
+
+SpeechPipeline speechPipeline;
+
+SpeechPipeline::SpeechPipeline() {
+    for (int i = 0; i < SPEECH_SEGMENTS; i++) {
+        segs[i].text[0] = '\0';
+        segs[i].turn = nullptr;
+        segs[i].wav = nullptr;
+        segs[i].wavSize = 0;
+    }
+    queued = 0;
+    submitted = 0;
+    played = 0;
+    turn = nullptr;
+    cut = 0;
+    started = false;
+    interrupted = false;
+    spoken = false;
+    startedAt = 0;
+    responses = 0;
+    segments = 0;
+    failures = 0;
+    interruptions = 0;
+}
+
+bool SpeechPipeline::synthJob(void* arg) {
+    Segment* seg = (Segment*)arg;
+    return getTTSWavBuffer(seg->text, &seg->wav, &seg->wavSize, seg->turn);
+}
+
+void SpeechPipeline::release() {
+    // Syntheses d'une reponse abandonnee: attendre avant de reutiliser
+    for (int i = 0; i < SPEECH_SEGMENTS; i++) {
+        Segment& seg = segs[i];
+        if (seg.job.isPending()) seg.job.wait(SPEECH_WAIT_MS);
+        if (seg.job.isPending()) continue;   // Tache bloquee: buffer laisse
+        if (seg.wav) free(seg.wav);
+        seg.wav = nullptr;
+        seg.wavSize = 0;
+    }
+}
+
+void SpeechPipeline::begin(TurnBudget* turn) {
+    release();
+    this->turn = turn;
+    queued = 0;
+    submitted = 0;
+    played = 0;
+    raw = "";
+    cut = 0;
+    started = false;
+    interrupted = false;
+    spoken = false;
+    startedAt = millis();
+    resetTTSRateLimitInfo();
+}
+
+String SpeechPipeline::getText() {
+    String text = raw;
+    text.trim();
+    return text;
+}
+
+int SpeechPipeline::findBoundary(bool final) {
+    int len = raw.length();
+    int lastSpace = -1;
+    for (int i = cut; i < len; i++) {
+        char c = raw[i];
+        if (c == ' ') lastSpace = i;
+
+        // Phrase trop longue pour un segment: coupee au dernier espace
+        if (i - cut >= SPEECH_SEGMENT_MAX - 1) return lastSpace > cut ? lastSpace : i;
+
+        bool end = c == '\n';
+        if (c == '.' || c == '!' || c == '?') {
+            // Ponctuation suivie d'un blanc: pas "3.5" ni "..." en cours
+            if (i + 1 >= len) break;
+            end = raw[i + 1] == ' ' || raw[i + 1] == '\n';
+        }
+        if (end && i + 1 - cut >= SPEECH_MIN_CHARS) return i + 1;
+    }
+    return final && cut < len ? len : -1;
+}
+
+bool SpeechPipeline::split(bool final) {
+    bool any = false;
+    while (queued - played < SPEECH_SEGMENTS) {
+        int end = findBoundary(final);
+        if (end < 0) break;
+        String sentence = raw.substring(cut, end);
+        cut = end;
+        sentence.trim();
+        any = true;
+        if (sentence.length() == 0) continue;
+
+        Segment& seg = segs[queued % SPEECH_SEGMENTS];
+        strncpy(seg.text, sentence.c_str(), SPEECH_SEGMENT_MAX - 1);
+        seg.text[SPEECH_SEGMENT_MAX - 1] = '\0';
+        queued++;
+        segments++;
+    }
+    return any;
+}
+
+bool SpeechPipeline::synthInFlight() {
+    return submitted > played && segs[(submitted - 1) % SPEECH_SEGMENTS].job.isPending();
+}
+
+void SpeechPipeline::submitNext() {
+    if (interrupted || submitted >= queued || synthInFlight()) return;
+
+    Segment& seg = segs[submitted % SPEECH_SEGMENTS];
+    bool first = submitted == 0;
+    seg.turn = first ? turn : nullptr;
+    seg.wav = nullptr;
+    seg.wavSize = 0;
+    if (first && turn) turn->beginStage(TURN_TTS, TTS_TIMEOUT_MS);
+    Serial.printf("Pipeline: synthese phrase %u: %s\n", submitted + 1, seg.text);
+    httpExecutor.submit(seg.job, "tts", synthJob, &seg, nullptr, HTTP_PRIORITY_INTERACTIVE);
+    submitted++;
+}
+
+void SpeechPipeline::play(Segment& seg, bool first) {
+    bool ok = seg.job.succeeded() && seg.wav;
+    if (first && turn) turn->endStage(TURN_TTS, ok);
+    if (ok && !spoken && !interrupted) {
+        // Premiere phrase prete: fin du tour (lecture non comptee)
+        if (turn) {
+            turn->markFirstAudio();
+            turn->finish(true);
+        }
+        Serial.printf("Pipeline: 1er audio en %lu ms\n", millis() - startedAt);
+    }
+    if (!ok) {
+        failures++;
+        Serial.println("Pipeline: synthese en echec, phrase sautee");
+    } else if (!interrupted && touch.touched()) {
+        interrupted = true;
+        interruptions++;
+        Serial.println("Touch - lecture interrompue");
+    } else if (!interrupted) {
+        if (!spoken) ackAudio.stop();  // Couper l'accuse de reception (fondu)
+        audioManager.playAudio(seg.wav, seg.wavSize);
+        spoken = true;
+    }
+    if (seg.wav) free(seg.wav);
+    seg.wav = nullptr;
+    seg.wavSize = 0;
+}
+
+bool SpeechPipeline::addText(const char* text) {
+    raw += text;
+    if (!started) {
+        started = true;
+        responses++;
+    }
+    if (interrupted) return false;
+    bool ended = split(false);
+    submitNext();
+    return ended;
+}
+
+void SpeechPipeline::pump() {
+    if (!isSpeaking()) return;
+    while (played < submitted) {
+        Segment& head = segs[played % SPEECH_SEGMENTS];
+        if (head.job.isPending()) break;
+        // Synthese suivante lancee avant la lecture (bloquante) de celle-ci
+        submitNext();
+        play(head, played == 0);
+        played++;
+    }
+    submitNext();
+}
+
+bool SpeechPipeline::finish() {
+    if (!started) return false;
+
+    while (!interrupted) {
+        split(true);
+        submitNext();
+        pump();
+        if (played >= queued || interrupted) break;
+
+        Segment& head = segs[played % SPEECH_SEGMENTS];
+        if (!head.job.wait(SPEECH_WAIT_MS)) {
+            Serial.println("Pipeline: synthese trop longue, fin de la lecture");
+            break;
+        }
+    }
+
+    // Rien n'a pu etre joue: tour termine en echec
+    if (turn) turn->finish(spoken);
+    turn = nullptr;
+    return spoken;
+}
+
+void SpeechPipeline::printStats() {
+    Serial.printf("Lecture par phrases: %u reponses, %u phrases, %u syntheses en echec, %u interruptions\n",
+                  responses, segments, failures, interruptions);
+}
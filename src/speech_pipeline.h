@@ -0,0 +1,83 @@
+// speech_pipeline.h - Reponse Claude lue phrase par phrase pendant le flux
+// Sans streaming, le TTS attendait la reponse complete puis synthetisait
+// tout le texte d'un coup. Ici le texte arrive fragment par fragment
+// (ClaudeAPI::sendMessage avec onText): chaque phrase complete part en
+// synthese sur l'executeur HTTP (classe interactive, une a la fois) et est
+// jouee des qu'elle est prete, pendant que la suite arrive et que la
+// phrase suivante se synthetise. Le texte ecrit avant un appel d'outil de
+// donnees est lu aussi, la suite arrive apres le resultat de l'outil.
+#ifndef SPEECH_PIPELINE_H
+#define SPEECH_PIPELINE_H
+
+#include <Arduino.h>
+#include "http_executor.h"
+#include "turn_budget.h"
+
+#define SPEECH_SEGMENTS        4        // Phrases en synthese ou en attente de lecture
+#define SPEECH_SEGMENT_MAX     320      // > reponse max (260 caracteres)
+#define SPEECH_MIN_CHARS       24       // Phrase plus courte: groupee avec la suivante
+#define SPEECH_WAIT_MS         35000    // Synthese d'une phrase (TTS_TIMEOUT_MS + marge)
+
+class SpeechPipeline {
+public:
+    SpeechPipeline();
+
+    // Nouvelle reponse. turn: stage TTS et 1er audio du tour (nullptr hors tour)
+    void begin(TurnBudget* turn);
+
+    // Fragment de texte recu. Decoupe les phrases completes, lance leur
+    // synthese. true si une phrase vient d'etre terminee (redessiner).
+    bool addText(const char* text);
+    // Joue les phrases deja synthetisees, dans l'ordre (lecture bloquante)
+    void pump();
+    // Fin du flux: reste du texte lu, attente de toutes les phrases.
+    // true si au moins une phrase a ete jouee.
+    bool finish();
+
+    // Texte recu (lu ici). false: action sans texte, lue par l'appelant
+    bool isSpeaking() { return started; }
+    bool wasInterrupted() { return interrupted; }
+    // Texte a afficher
+    String getText();
+
+    void printStats();
+
+private:
+    struct Segment {
+        char text[SPEECH_SEGMENT_MAX];
+        HttpFuture job;
+        TurnBudget* turn;       // Premiere phrase seulement (tache du pool)
+        uint8_t* wav;
+        size_t wavSize;
+    };
+
+    Segment segs[SPEECH_SEGMENTS];
+    uint32_t queued;            // Phrases decoupees
+    uint32_t submitted;         // ... confiees au TTS
+    uint32_t played;            // ... jouees (ou abandonnees)
+
+    TurnBudget* turn;
+    String raw;                 // Reponse recue
+    int cut;                    // Debut de la phrase en cours dans raw
+    bool started;
+    bool interrupted;
+    bool spoken;
+    unsigned long startedAt;
+
+    uint32_t responses;
+    uint32_t segments;
+    uint32_t failures;          // Syntheses en echec (phrase sautee)
+    uint32_t interruptions;
+
+    int findBoundary(bool final);
+    bool split(bool final);
+    void submitNext();
+    bool synthInFlight();
+    void play(Segment& seg, bool first);
+    void release();
+    static bool synthJob(void* arg);
+};
+
+extern SpeechPipeline speechPipeline;
+
+#endif
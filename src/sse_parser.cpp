@@ -0,0 +1,105 @@
+// sse_parser.cpp - Decodage incremental d'un flux server-sent events
+#include "sse_parser.h"
+
+SseParser::SseParser(SseEventFn fn, void* arg) {
+    this->fn = fn;
+    this->arg = arg;
+    events = 0;
+    overflows = 0;
+    reset();
+}
+
+void SseParser::reset() {
+    lineLen = 0;
+    lineOverflow = false;
+    lastWasCR = false;
+    event[0] = '\0';
+    dataLen = 0;
+    data[0] = '\0';
+    hasData = false;
+    dataOverflow = false;
+}
+
+void SseParser::feed(const uint8_t* bytes, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = (char)bytes[i];
+        if (c == '\n' && lastWasCR) {
+            // Seconde moitie d'un \r\n: ligne deja terminee
+            lastWasCR = false;
+            continue;
+        }
+        lastWasCR = c == '\r';
+        if (c == '\r' || c == '\n') {
+            endLine();
+            continue;
+        }
+        if (lineLen < SSE_LINE_MAX - 1) {
+            line[lineLen++] = c;
+        } else {
+            lineOverflow = true;
+        }
+    }
+}
+
+void SseParser::finish() {
+    if (lineLen > 0) endLine();
+    dispatch();
+}
+
+void SseParser::endLine() {
+    line[lineLen] = '\0';
+    size_t len = lineLen;
+    bool overflow = lineOverflow;
+    lineLen = 0;
+    lineOverflow = false;
+
+    if (len == 0) {
+        dispatch();
+        return;
+    }
+    if (line[0] == ':') return;     // Commentaire (keep-alive)
+
+    // "champ: valeur" (un espace apres ':' ignore), ou "champ" seul
+    char* value = strchr(line, ':');
+    if (value) {
+        *value++ = '\0';
+        if (*value == ' ') value++;
+    } else {
+        value = line + len;
+    }
+
+    if (strcmp(line, "event") == 0) {
+        strncpy(event, value, SSE_EVENT_LEN - 1);
+        event[SSE_EVENT_LEN - 1] = '\0';
+    } else if (strcmp(line, "data") == 0) {
+        if (overflow) dataOverflow = true;
+        size_t n = strlen(value);
+        size_t needed = n + (hasData ? 1 : 0);
+        if (dataLen + needed >= SSE_DATA_MAX) {
+            dataOverflow = true;
+        } else {
+            if (hasData) data[dataLen++] = '\n';
+            memcpy(data + dataLen, value, n);
+            dataLen += n;
+            data[dataLen] = '\0';
+        }
+        hasData = true;
+    }
+    // id, retry: reconnexion non geree (une requete = un flux)
+}
+
+void SseParser::dispatch() {
+    if (hasData) {
+        if (dataOverflow) {
+            overflows++;
+        } else {
+            events++;
+            if (fn) fn(event, data, dataLen, arg);
+        }
+    }
+    event[0] = '\0';
+    dataLen = 0;
+    data[0] = '\0';
+    hasData = false;
+    dataOverflow = false;
+}
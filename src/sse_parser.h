@@ -0,0 +1,56 @@
+// sse_parser.h - Decodage incremental d'un flux server-sent events
+// Reponse Claude en streaming (stream: true): le corps est une suite
+// d'evenements "event: ...\ndata: {...}\n\n" qui arrivent par morceaux de
+// taille quelconque. Le parseur accepte les octets au fil de l'eau (fin de
+// ligne \n, \r\n ou \r, meme coupee entre deux morceaux) et appelle le
+// callback a chaque evenement complet (ligne vide).
+#ifndef SSE_PARSER_H
+#define SSE_PARSER_H
+
+#include <Arduino.h>
+
+#define SSE_LINE_MAX     1024     // content_block_delta: ~150 octets + texte
+#define SSE_EVENT_LEN    32
+#define SSE_DATA_MAX     1536
+
+// Evenement complet. data termine par '\0' (lignes data jointes par '\n').
+// event vide si le serveur n'en donne pas ("message" par defaut).
+typedef void (*SseEventFn)(const char* event, const char* data, size_t len, void* arg);
+
+class SseParser {
+public:
+    SseParser(SseEventFn fn, void* arg);
+
+    void reset();
+    // Octets du corps (deja decodes du chunked)
+    void feed(const uint8_t* data, size_t len);
+    // Fin du corps: evenement non termine par une ligne vide envoye
+    void finish();
+
+    uint32_t getEvents() { return events; }
+    // Evenements tronques (ligne ou data trop longue), ignores
+    uint32_t getOverflows() { return overflows; }
+
+private:
+    SseEventFn fn;
+    void* arg;
+
+    char line[SSE_LINE_MAX];
+    size_t lineLen;
+    bool lineOverflow;
+    bool lastWasCR;             // \r\n coupe entre deux morceaux
+
+    char event[SSE_EVENT_LEN];
+    char data[SSE_DATA_MAX];
+    size_t dataLen;
+    bool hasData;
+    bool dataOverflow;
+
+    uint32_t events;
+    uint32_t overflows;
+
+    void endLine();
+    void dispatch();
+};
+
+#endif
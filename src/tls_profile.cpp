@@ -0,0 +1,220 @@
+// tls_profile.cpp - Profil TLS verifie pour toutes les connexions du pool
+#include "tls_profile.h"
+#include "connection_pool.h"
+#include "ca_bundle.h"
+#include <esp_heap_caps.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/version.h>
+#include <mbedtls/platform.h>
+
+TlsProfile tlsProfile;
+
+// AES-GCM avant tout: AES materiel (ChaCha20 serait en logiciel).
+// ECDSA en tete: certificats et signatures plus courts que RSA
+// (Cloudflare et Google servent un certificat ECDSA si on le propose).
+static const int PREFERRED_SUITES[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,     // Serveurs sans ECDHE (LNbits)
+    0
+};
+
+#if MBEDTLS_VERSION_MAJOR >= 3
+// P-384: cles des racines ISRG X2 / GTS R4 et de certains intermediaires
+static const uint16_t PREFERRED_GROUPS[] = {
+    MBEDTLS_SSL_IANA_TLS_GROUP_X25519,
+    MBEDTLS_SSL_IANA_TLS_GROUP_SECP256R1,
+    MBEDTLS_SSL_IANA_TLS_GROUP_SECP384R1,
+    0
+};
+#endif
+
+// Hotes des API (STT, LLM, prix Bitcoin)
+static const char* BENCH_HOSTS[] = { "api.groq.com", "api.anthropic.com", "mempool.space" };
+
+TlsProfile::TlsProfile() {
+    verify = true;
+    allocatorInstalled = false;
+    psramReady = false;
+    legacyTask = nullptr;
+    psramAllocs = 0;
+    internalAllocs = 0;
+}
+
+void TlsProfile::begin() {
+    prefs.begin("tls", false);
+    verify = prefs.getBool("verify", true);
+    prefs.end();
+
+    // Bundle global du core: charge une fois (setCACertBundle le
+    // reinitialise, pas sur pendant un handshake d'une autre tache)
+    WiFiClientSecure loader;
+#if defined(ESP_ARDUINO_VERSION_VAL) && ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3, 1, 0)
+    loader.setCACertBundle(CA_BUNDLE, sizeof(CA_BUNDLE));
+#else
+    loader.setCACertBundle(CA_BUNDLE);
+#endif
+
+    // Heure UTC: dates de validite des certificats (si mbedtls les verifie)
+    configTime(0, 0, "pool.ntp.org", "time.google.com");
+
+    psramReady = psramFound();
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO)
+    // ~40 Ko par session, surtout le tampon de reception de 16 Ko:
+    // les gros blocs vont en PSRAM, le reste (bignums, X.509) en interne
+    if (psramReady) {
+        allocatorInstalled = mbedtls_platform_set_calloc_free(tlsCalloc, tlsFree) == 0;
+    }
+#endif
+
+    Serial.printf("Profil TLS: verification %s, %d racines CA (%u octets), tampons %s\n",
+                  verify ? "ON" : "OFF", CA_BUNDLE_CERTS, sizeof(CA_BUNDLE),
+                  allocatorInstalled ? "PSRAM" : "RAM interne");
+}
+
+// ============================================================
+// Allocateur mbedtls
+// ============================================================
+
+void* TlsProfile::tlsCalloc(size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) return nullptr;
+    size_t bytes = count * size;
+
+    if (bytes >= TLS_PSRAM_MIN_ALLOC && tlsProfile.psramReady &&
+        tlsProfile.legacyTask != xTaskGetCurrentTaskHandle()) {
+        void* ptr = heap_caps_calloc(count, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (ptr) {
+            tlsProfile.psramAllocs++;
+            return ptr;
+        }
+    }
+    if (bytes >= TLS_PSRAM_MIN_ALLOC) tlsProfile.internalAllocs++;
+    return heap_caps_calloc(count, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+void TlsProfile::tlsFree(void* ptr) {
+    heap_caps_free(ptr);
+}
+
+// ============================================================
+// Application aux clients du pool
+// ============================================================
+
+void TlsProfile::apply(PooledClient* client) {
+    if (!verify || legacyTask == xTaskGetCurrentTaskHandle()) {
+        client->setInsecure();
+        return;
+    }
+    // setInsecure() d'un usage precedent n'est pas annule par le bundle
+    client->_use_insecure = false;
+    client->_use_ca_bundle = true;
+}
+
+void TlsProfile::configure(PooledClient* client) {
+    if (legacyTask == xTaskGetCurrentTaskHandle()) return;
+
+    mbedtls_ssl_config* conf = &client->sslclient->ssl_conf;
+    mbedtls_ssl_conf_ciphersuites(conf, PREFERRED_SUITES);
+#if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_ssl_conf_groups(conf, PREFERRED_GROUPS);
+#endif
+}
+
+void TlsProfile::setVerify(bool verify) {
+    this->verify = verify;
+
+    prefs.begin("tls", false);
+    prefs.putBool("verify", verify);
+    prefs.end();
+
+    // Sockets ouverts avec l'ancien reglage
+    connectionPool.closeAll();
+}
+
+// ============================================================
+// Diagnostic
+// ============================================================
+
+void TlsProfile::printProfile() {
+    Serial.println("\n=== PROFIL TLS ===");
+    Serial.printf("Verification certificats: %s\n", verify ? "ON (bundle CA)" : "OFF (non securise)");
+    Serial.printf("Bundle CA: %d racines, %u octets en flash\n", CA_BUNDLE_CERTS, sizeof(CA_BUNDLE));
+    Serial.println("Suites: ECDHE-ECDSA/ECDHE-RSA AES-GCM, courbes X25519/P-256/P-384");
+
+    Serial.print("Accelerateurs mbedtls:");
+#ifdef CONFIG_MBEDTLS_HARDWARE_AES
+    Serial.print(" AES");
+#endif
+#ifdef CONFIG_MBEDTLS_HARDWARE_SHA
+    Serial.print(" SHA");
+#endif
+#ifdef CONFIG_MBEDTLS_HARDWARE_MPI
+    Serial.print(" MPI(RSA/ECC)");
+#endif
+#ifdef CONFIG_MBEDTLS_HARDWARE_ECC
+    Serial.print(" ECC");
+#endif
+    Serial.println();
+
+    Serial.print("Tampons:");
+#ifdef CONFIG_MBEDTLS_DYNAMIC_BUFFER
+    Serial.print(" dynamiques");
+#endif
+#ifdef CONFIG_MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+    Serial.print(" taille variable");
+#endif
+    Serial.printf(" %s (>= %d octets)\n", allocatorInstalled ? "PSRAM" : "RAM interne", TLS_PSRAM_MIN_ALLOC);
+    Serial.printf("Gros blocs: %u en PSRAM, %u en RAM interne\n", psramAllocs, internalAllocs);
+    Serial.printf("RAM interne libre: %u | PSRAM libre: %u\n",
+                  heap_caps_get_free_size(MALLOC_CAP_INTERNAL), heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    Serial.println("==================\n");
+}
+
+void TlsProfile::benchmark(int runs) {
+    Serial.printf("\n=== BENCHMARK TLS (%d handshakes complets par hote) ===\n", runs);
+    Serial.println("Profil      Hote                   moy ms  max ms  interne  PSRAM   Suite");
+
+    for (const char* host : BENCH_HOSTS) {
+        for (int pass = 0; pass < 2; pass++) {
+            bool legacy = pass == 0;
+            uint32_t msTotal = 0, msMax = 0;
+            int32_t internalTotal = 0, psramTotal = 0;
+            int done = 0;
+            String suite = "-";
+
+            legacyTask = legacy ? xTaskGetCurrentTaskHandle() : nullptr;
+            for (int i = 0; i < runs; i++) {
+                PooledClient* client = new PooledClient();
+                size_t internalBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+                size_t psramBefore = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+                // Sans cache de session: toujours un handshake complet
+                if (client->connectResumable(host, 443, false)) {
+                    // RAM tenue par la session ouverte
+                    internalTotal += (int32_t)(internalBefore - heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+                    psramTotal += (int32_t)(psramBefore - heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+                    msTotal += client->getHandshakeMs();
+                    if (client->getHandshakeMs() > msMax) msMax = client->getHandshakeMs();
+                    suite = client->getCipherSuite();
+                    done++;
+                }
+                client->close();
+                delete client;
+                delay(100);
+            }
+            legacyTask = nullptr;
+
+            if (done == 0) {
+                Serial.printf("%-11s %-22s echec\n", legacy ? "insecure" : "verifie", host);
+                continue;
+            }
+            Serial.printf("%-11s %-22s %6u  %6u  %7d  %6d   %s\n",
+                          legacy ? "insecure" : "verifie", host, msTotal / done, msMax,
+                          internalTotal / done, psramTotal / done, suite.c_str());
+        }
+    }
+    Serial.println("insecure = ancien profil: setInsecure, suites par defaut, RAM interne");
+    Serial.println("=====================================================\n");
+}
@@ -0,0 +1,60 @@
+// tls_profile.h - Profil TLS verifie pour toutes les connexions du pool
+// Remplace setInsecure(): les certificats serveurs sont verifies contre un
+// bundle compact de racines CA en flash (ca_bundle.h, ~5 Ko). Suites
+// ECDHE-ECDSA/ECDHE-RSA en AES-GCM (AES et SHA materiels du S3, echange de
+// cles sur l'accelerateur MPI), tampons d'enregistrement mbedtls en PSRAM.
+// /tlsbench compare handshake et RAM interne avec l'ancien mode non verifie.
+#ifndef TLS_PROFILE_H
+#define TLS_PROFILE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#define TLS_PSRAM_MIN_ALLOC    4096     // Allocations mbedtls >= : PSRAM (tampons 16 Ko)
+#define TLS_BENCH_RUNS         3        // Handshakes complets par hote et par profil
+
+class PooledClient;
+
+class TlsProfile {
+public:
+    TlsProfile();
+
+    // Preference de verification (NVS), bundle CA, allocateur PSRAM
+    void begin();
+
+    // Avant connect(): bundle CA, ou mode non verifie si desactive
+    void apply(PooledClient* client);
+
+    // Apres connect() en mode STARTTLS, avant le handshake:
+    // suites et courbes preferees (lues a l'ecriture du ClientHello)
+    void configure(PooledClient* client);
+
+    // Verification desactivable pour un LNbits auto-heberge (certificat auto-signe)
+    void setVerify(bool verify);
+    bool isVerify() { return verify; }
+
+    void printProfile();
+
+    // Handshakes complets (sans cache de session) vers les hotes des API:
+    // profil verifie contre ancien profil (setInsecure, suites et RAM par defaut)
+    void benchmark(int runs = TLS_BENCH_RUNS);
+
+private:
+    Preferences prefs;
+    bool verify;
+    bool allocatorInstalled;
+    bool psramReady;
+
+    // Tache du benchmark en mode ancien profil: allocations en RAM interne
+    TaskHandle_t legacyTask;
+
+    uint32_t psramAllocs;
+    uint32_t internalAllocs;
+
+    static void* tlsCalloc(size_t count, size_t size);
+    static void tlsFree(void* ptr);
+};
+
+extern TlsProfile tlsProfile;
+
+#endif
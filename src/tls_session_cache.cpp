@@ -0,0 +1,339 @@
+// tls_session_cache.cpp - Cache de sessions TLS (reprise de session)
+#include "tls_session_cache.h"
+#include <LittleFS.h>
+#include <mbedtls/gcm.h>
+#include <esp_flash_encrypt.h>
+
+TlsSessionCache tlsSessionCache;
+
+// mbedtls 2.x: champs de session publics
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(member) member
+#endif
+
+TlsSessionCache::TlsSessionCache() {
+    memset(entries, 0, sizeof(entries));
+    memset(&stats, 0, sizeof(stats));
+    mutex = xSemaphoreCreateMutex();
+    persistent = false;
+    fsReady = false;
+    memset(fileKey, 0, sizeof(fileKey));
+    keyReady = false;
+}
+
+void TlsSessionCache::begin() {
+    prefs.begin("tls", false);
+    persistent = prefs.getBool("persist", false);
+    prefs.end();
+
+    if (persistent) {
+        fsReady = LittleFS.begin(true);
+        if (fsReady && loadKey()) loadFiles();
+    }
+
+    Serial.printf("Cache sessions TLS: %d hotes, persistance %s\n",
+                  TLS_CACHE_ENTRIES, persistent ? "ON" : "OFF");
+    if (persistent) warnPersistence();
+}
+
+// ============================================================
+// Table des sessions
+// ============================================================
+
+TlsSessionCache::Entry* TlsSessionCache::find(const char* host) {
+    for (int i = 0; i < TLS_CACHE_ENTRIES; i++) {
+        if (entries[i].data && strcmp(entries[i].host, host) == 0) return &entries[i];
+    }
+    return nullptr;
+}
+
+TlsSessionCache::Entry* TlsSessionCache::allocate(const char* host) {
+    Entry* entry = find(host);
+    if (entry) return entry;
+
+    // Entree libre, sinon la moins recemment utilisee
+    entry = &entries[0];
+    for (int i = 0; i < TLS_CACHE_ENTRIES; i++) {
+        if (!entries[i].data) {
+            entry = &entries[i];
+            break;
+        }
+        if (entries[i].lastUsed < entry->lastUsed) entry = &entries[i];
+    }
+
+    if (entry->data) free(entry->data);
+    memset(entry, 0, sizeof(Entry));
+    strncpy(entry->host, host, TLS_CACHE_HOST_LEN - 1);
+    return entry;
+}
+
+bool TlsSessionCache::store(Entry& entry, const uint8_t* data, size_t length, const uint8_t* master) {
+    if (entry.data && entry.length != length) {
+        free(entry.data);
+        entry.data = nullptr;
+    }
+    if (!entry.data) {
+        entry.data = psramFound() ? (uint8_t*)ps_malloc(length) : (uint8_t*)malloc(length);
+        if (!entry.data) return false;
+    }
+    memcpy(entry.data, data, length);
+    memcpy(entry.master, master, sizeof(entry.master));
+    entry.length = length;
+    entry.lastUsed = millis();
+    return true;
+}
+
+bool TlsSessionCache::offer(const char* host, mbedtls_ssl_context* ssl) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Entry* entry = find(host);
+    if (!entry) {
+        xSemaphoreGive(mutex);
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    bool ok = mbedtls_ssl_session_load(&session, entry->data, entry->length) == 0 &&
+              mbedtls_ssl_set_session(ssl, &session) == 0;
+    mbedtls_ssl_session_free(&session);
+
+    if (ok) {
+        entry->lastUsed = millis();
+    } else {
+        // Format incompatible (mise a jour mbedtls): oublier la session
+        free(entry->data);
+        memset(entry, 0, sizeof(Entry));
+    }
+    xSemaphoreGive(mutex);
+    return ok;
+}
+
+bool TlsSessionCache::save(const char* host, mbedtls_ssl_context* ssl, bool offered, uint32_t handshakeMs) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(ssl, &session) != 0) {
+        mbedtls_ssl_session_free(&session);
+        return false;
+    }
+
+    size_t length = 0;
+    uint8_t* buffer = psramFound() ? (uint8_t*)ps_malloc(TLS_CACHE_MAX_BYTES) : (uint8_t*)malloc(TLS_CACHE_MAX_BYTES);
+    bool serialized = buffer &&
+        mbedtls_ssl_session_save(&session, buffer, TLS_CACHE_MAX_BYTES, &length) == 0;
+    const uint8_t* master = session.MBEDTLS_PRIVATE(master);
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    // Reprise: le serveur a accepte la session, le secret maitre est conserve
+    Entry* known = find(host);
+    bool resumed = offered && known && memcmp(known->master, master, sizeof(known->master)) == 0;
+
+    if (resumed) {
+        stats.resumed++;
+        stats.resumedMsTotal += handshakeMs;
+        if (handshakeMs > stats.resumedMsMax) stats.resumedMsMax = handshakeMs;
+    } else {
+        stats.full++;
+        stats.fullMsTotal += handshakeMs;
+        if (handshakeMs > stats.fullMsMax) stats.fullMsMax = handshakeMs;
+        if (offered) stats.rejected++;
+    }
+
+    // Un nouveau ticket peut accompagner une reprise: toujours garder le dernier
+    if (serialized) {
+        Entry* entry = allocate(host);
+        if (store(*entry, buffer, length, master) && persistent && !resumed) {
+            // Ecriture flash seulement apres un handshake complet
+            writeFile(*entry);
+        }
+    }
+
+    xSemaphoreGive(mutex);
+
+    free(buffer);
+    mbedtls_ssl_session_free(&session);
+    return resumed;
+}
+
+// ============================================================
+// Persistance LittleFS
+// ============================================================
+
+String TlsSessionCache::pathFor(const char* host) {
+    return String(TLS_CACHE_DIR) + "/" + host;
+}
+
+// Cle des fichiers: aleatoire, tiree une fois et gardee en NVS
+bool TlsSessionCache::loadKey() {
+    if (keyReady) return true;
+    prefs.begin("tls", false);
+    if (prefs.getBytesLength("key") == TLS_CACHE_KEY_LEN) {
+        keyReady = prefs.getBytes("key", fileKey, TLS_CACHE_KEY_LEN) == TLS_CACHE_KEY_LEN;
+    } else {
+        for (size_t i = 0; i < TLS_CACHE_KEY_LEN; i += 4) {
+            uint32_t r = esp_random();
+            memcpy(fileKey + i, &r, 4);
+        }
+        keyReady = prefs.putBytes("key", fileKey, TLS_CACHE_KEY_LEN) == TLS_CACHE_KEY_LEN;
+    }
+    prefs.end();
+    if (!keyReady) Serial.println("Cache TLS: cle NVS indisponible, sessions gardees en RAM");
+    return keyReady;
+}
+
+void TlsSessionCache::writeFile(const Entry& entry) {
+    if (!fsReady || !keyReady) return;
+
+    // Format: magic, IV, tag GCM puis [secret maitre (48 octets), session]
+    // chiffres; l'hote (nom du fichier) est authentifie
+    size_t plainLen = sizeof(entry.master) + entry.length;
+    uint8_t* plain = psramFound() ? (uint8_t*)ps_malloc(plainLen * 2) : (uint8_t*)malloc(plainLen * 2);
+    if (!plain) return;
+    uint8_t* cipher = plain + plainLen;
+    memcpy(plain, entry.master, sizeof(entry.master));
+    memcpy(plain + sizeof(entry.master), entry.data, entry.length);
+
+    uint8_t iv[TLS_CACHE_IV_LEN];
+    uint8_t tag[TLS_CACHE_TAG_LEN];
+    for (size_t i = 0; i < sizeof(iv); i += 4) {
+        uint32_t r = esp_random();
+        memcpy(iv + i, &r, 4);
+    }
+
+    mbedtls_gcm_context gcm;
+    mbedtls_gcm_init(&gcm);
+    bool ok = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, fileKey, TLS_CACHE_KEY_LEN * 8) == 0 &&
+              mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, plainLen, iv, sizeof(iv),
+                                        (const uint8_t*)entry.host, strlen(entry.host),
+                                        plain, cipher, sizeof(tag), tag) == 0;
+    mbedtls_gcm_free(&gcm);
+    memset(plain, 0, plainLen);
+
+    if (ok) {
+        File f = LittleFS.open(pathFor(entry.host), "w", true);
+        if (f) {
+            f.write((const uint8_t*)TLS_CACHE_MAGIC, 4);
+            f.write(iv, sizeof(iv));
+            f.write(tag, sizeof(tag));
+            f.write(cipher, plainLen);
+            f.close();
+        }
+    }
+    free(plain);
+}
+
+void TlsSessionCache::loadFiles() {
+    File dir = LittleFS.open(TLS_CACHE_DIR);
+    if (!dir || !dir.isDirectory()) return;
+
+    const size_t header = 4 + TLS_CACHE_IV_LEN + TLS_CACHE_TAG_LEN;
+    const size_t maxSize = header + 48 + TLS_CACHE_MAX_BYTES;
+    uint8_t* buffer = (uint8_t*)malloc(maxSize * 2);
+    if (!buffer) return;
+    uint8_t* plain = buffer + maxSize;
+
+    mbedtls_gcm_context gcm;
+    mbedtls_gcm_init(&gcm);
+    mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, fileKey, TLS_CACHE_KEY_LEN * 8);
+
+    int loaded = 0;
+    int dropped = 0;
+    File f = dir.openNextFile();
+    while (f) {
+        String name = f.name();
+        size_t size = f.size();
+        bool ok = loaded < TLS_CACHE_ENTRIES && size > header + 48 && size <= maxSize &&
+                  f.read(buffer, size) == size && memcmp(buffer, TLS_CACHE_MAGIC, 4) == 0;
+        f.close();
+
+        // Dechiffre et authentifie (cle changee, fichier altere ou ancien
+        // format en clair: supprime)
+        size_t plainLen = size - header;
+        ok = ok && mbedtls_gcm_auth_decrypt(&gcm, plainLen, buffer + 4, TLS_CACHE_IV_LEN,
+                                            (const uint8_t*)name.c_str(), name.length(),
+                                            buffer + 4 + TLS_CACHE_IV_LEN, TLS_CACHE_TAG_LEN,
+                                            buffer + header, plain) == 0;
+        if (ok) {
+            Entry* entry = allocate(name.c_str());
+            if (store(*entry, plain + 48, plainLen - 48, plain)) loaded++;
+        } else if (loaded < TLS_CACHE_ENTRIES) {
+            LittleFS.remove(pathFor(name.c_str()).c_str());
+            dropped++;
+        }
+        f = dir.openNextFile();
+    }
+    mbedtls_gcm_free(&gcm);
+    memset(plain, 0, maxSize);
+    free(buffer);
+
+    Serial.printf("Cache TLS: %d sessions rechargees, %d fichiers illisibles supprimes\n", loaded, dropped);
+}
+
+void TlsSessionCache::warnPersistence() {
+    Serial.println("ATTENTION: sessions TLS sur flash = secrets maitres des connexions");
+    Serial.println("  (cles API Anthropic/Groq, cle admin LNbits dechiffrables si la cle fuit)");
+    if (esp_flash_encryption_enabled()) {
+        Serial.println("  Fichiers chiffres AES-256-GCM, flash chiffree");
+    } else {
+        Serial.println("  Fichiers chiffres AES-256-GCM, mais flash NON chiffree: la cle NVS");
+        Serial.println("  se lit avec un dump de la flash. /tlscache pour desactiver.");
+    }
+}
+
+void TlsSessionCache::setPersistent(bool persistent) {
+    this->persistent = persistent;
+
+    prefs.begin("tls", false);
+    prefs.putBool("persist", persistent);
+    prefs.end();
+
+    if (persistent && !fsReady) fsReady = LittleFS.begin(true);
+    if (!fsReady) return;
+    if (persistent) {
+        if (!loadKey()) return;
+        warnPersistence();
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int i = 0; i < TLS_CACHE_ENTRIES; i++) {
+        if (!entries[i].data) continue;
+        if (persistent) {
+            writeFile(entries[i]);
+        } else {
+            LittleFS.remove(pathFor(entries[i].host).c_str());
+        }
+    }
+    xSemaphoreGive(mutex);
+}
+
+void TlsSessionCache::clear() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int i = 0; i < TLS_CACHE_ENTRIES; i++) {
+        if (!entries[i].data) continue;
+        if (fsReady) LittleFS.remove(pathFor(entries[i].host).c_str());
+        free(entries[i].data);
+        memset(&entries[i], 0, sizeof(Entry));
+    }
+    xSemaphoreGive(mutex);
+}
+
+// ============================================================
+// Stats
+// ============================================================
+
+void TlsSessionCache::printStats() {
+    Serial.println("\n=== SESSIONS TLS ===");
+    Serial.printf("Persistance: %s\n", persistent ? "ON (LittleFS, AES-256-GCM)" : "OFF");
+    Serial.printf("Handshakes complets: %u (moy %u ms, max %u ms)\n", stats.full,
+                  stats.full ? stats.fullMsTotal / stats.full : 0, stats.fullMsMax);
+    Serial.printf("Reprises de session: %u (moy %u ms, max %u ms)\n", stats.resumed,
+                  stats.resumed ? stats.resumedMsTotal / stats.resumed : 0, stats.resumedMsMax);
+    Serial.printf("Sessions refusees par le serveur: %u\n", stats.rejected);
+
+    for (int i = 0; i < TLS_CACHE_ENTRIES; i++) {
+        if (!entries[i].data) continue;
+        Serial.printf("  %-24s %4u octets, utilisee il y a %lu s\n", entries[i].host,
+                      entries[i].length, (millis() - entries[i].lastUsed) / 1000);
+    }
+    Serial.println("====================\n");
+}
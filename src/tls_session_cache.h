@@ -0,0 +1,88 @@
+// tls_session_cache.h - Cache de sessions TLS (reprise de session)
+// Quand un socket keep-alive n'est plus utilisable (reconnexion WiFi,
+// timeout serveur), une reprise par ticket/ID evite l'echange de cles:
+// handshake abrege, sans ECDHE ni verification de certificat.
+// Une session serialisee par hote en PSRAM, copiee sur LittleFS si la
+// persistance est activee (/tlscache) pour survivre au redemarrage.
+// Une session contient le secret maitre: qui le lit dechiffre les echanges
+// enregistres (x-api-key, cle admin LNbits). Les fichiers sont donc
+// chiffres (AES-256-GCM, cle aleatoire en NVS, hote authentifie). Sans
+// chiffrement de flash/NVS la cle reste lisible en flash: /tlscache le
+// signale a l'activation, persistance OFF par defaut.
+#ifndef TLS_SESSION_CACHE_H
+#define TLS_SESSION_CACHE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <mbedtls/ssl.h>
+
+#define TLS_CACHE_ENTRIES      6
+#define TLS_CACHE_HOST_LEN     64
+#define TLS_CACHE_MAX_BYTES    4096    // Session serialisee (ticket + certificat pair)
+#define TLS_CACHE_DIR          "/tls"
+#define TLS_CACHE_MAGIC        "TLS2"  // Fichier chiffre (ancien format en clair: supprime)
+#define TLS_CACHE_KEY_LEN      32
+#define TLS_CACHE_IV_LEN       12
+#define TLS_CACHE_TAG_LEN      16
+
+struct TlsHandshakeStats {
+    uint32_t full;              // Handshakes complets
+    uint32_t resumed;           // Reprises de session
+    uint32_t rejected;          // Session proposee mais refusee par le serveur
+    uint32_t fullMsTotal;
+    uint32_t fullMsMax;
+    uint32_t resumedMsTotal;
+    uint32_t resumedMsMax;
+};
+
+class TlsSessionCache {
+public:
+    TlsSessionCache();
+
+    // Charge la preference de persistance et les sessions sauvegardees
+    void begin();
+
+    // Avant le handshake: propose la session connue pour cet hote
+    bool offer(const char* host, mbedtls_ssl_context* ssl);
+
+    // Apres le handshake: memorise la session, retourne true si reprise
+    bool save(const char* host, mbedtls_ssl_context* ssl, bool offered, uint32_t handshakeMs);
+
+    void setPersistent(bool persistent);
+    bool isPersistent() { return persistent; }
+    void clear();
+
+    TlsHandshakeStats getStats() { return stats; }
+    void printStats();
+
+private:
+    struct Entry {
+        char host[TLS_CACHE_HOST_LEN];
+        uint8_t* data;          // PSRAM
+        size_t length;
+        uint8_t master[48];     // Secret maitre: identique si la session a ete reprise
+        unsigned long lastUsed;
+    };
+
+    Entry entries[TLS_CACHE_ENTRIES];
+    TlsHandshakeStats stats;
+    SemaphoreHandle_t mutex;
+    Preferences prefs;
+    bool persistent;
+    bool fsReady;
+    uint8_t fileKey[TLS_CACHE_KEY_LEN];
+    bool keyReady;
+
+    Entry* find(const char* host);
+    Entry* allocate(const char* host);
+    bool store(Entry& entry, const uint8_t* data, size_t length, const uint8_t* master);
+    String pathFor(const char* host);
+    bool loadKey();
+    void writeFile(const Entry& entry);
+    void loadFiles();
+    void warnPersistence();
+};
+
+extern TlsSessionCache tlsSessionCache;
+
+#endif
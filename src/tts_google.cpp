@@ -1,12 +1,14 @@
 #include "tts_google.h"
 #include "config.h"
-#include <WiFiClientSecure.h>
-#include <ArduinoJson.h>
+#include "connection_pool.h"
+#include "http_response.h"
 
 // Google Cloud TTS API endpoint
 #define GOOGLE_TTS_HOST "texttospeech.googleapis.com"
 #define GOOGLE_TTS_PORT 443
 #define GOOGLE_TTS_PATH "/v1/text:synthesize"
+#define GOOGLE_TTS_MAX_PCM    1000000  // Corps chunked: taille inconnue
+#define GOOGLE_TTS_ERROR_MAX  2000
 
 // Echappe les caracteres speciaux pour JSON
 static String escapeJsonStringGoogle(const char* text) {
@@ -29,26 +31,95 @@ static String escapeJsonStringGoogle(const char* text) {
     return result;
 }
 
-bool getGoogleTTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSize) {
-    if (!text || strlen(text) == 0) {
-        Serial.println("Google TTS: texte vide");
-        return false;
-    }
+// Table de decodage base64
+static const int8_t base64_table[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63,
+    52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-1,-1,-1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,
+    15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,
+    -1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
+    41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+};
+
+enum GoogleAudioState {
+    AUDIO_SEARCH_KEY,   // Cherche "audioContent"
+    AUDIO_SEARCH_QUOTE, // ':' puis guillemet ouvrant
+    AUDIO_DECODE,       // base64 jusqu'au guillemet fermant
+    AUDIO_DONE
+};
+
+// Decodeur base64 branche sur le corps HTTP
+struct GoogleAudioDecoder {
+    GoogleAudioState state;
+    size_t keyMatch;
+    uint32_t bits;
+    int bitCount;
+    uint8_t* out;
+    size_t size;
+    size_t capacity;
+};
+
+static bool googleAudioSink(const uint8_t* data, size_t len, void* arg) {
+    static const char key[] = "\"audioContent\"";
+    GoogleAudioDecoder* d = (GoogleAudioDecoder*)arg;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        switch (d->state) {
+            case AUDIO_SEARCH_KEY:
+                if (c == (uint8_t)key[d->keyMatch]) d->keyMatch++;
+                else d->keyMatch = c == '"' ? 1 : 0;
+                if (d->keyMatch == sizeof(key) - 1) d->state = AUDIO_SEARCH_QUOTE;
+                break;
 
-    // Verifier si on a une cle API Google
-    if (strlen(configManager.config.google_tts_key) == 0) {
-        Serial.println("Google TTS: cle API manquante");
-        return false;
-    }
+            case AUDIO_SEARCH_QUOTE:
+                if (c == '"') d->state = AUDIO_DECODE;
+                break;
 
-    WiFiClientSecure client;
-    client.setInsecure();
+            case AUDIO_DECODE: {
+                if (c == '"') {
+                    d->state = AUDIO_DONE;
+                    break;
+                }
+                int8_t val = base64_table[c];
+                if (val == -1) break;  // Skip invalid chars (newlines, '=', etc)
+
+                d->bits = (d->bits << 6) | val;
+                d->bitCount += 6;
+                if (d->bitCount >= 8) {
+                    d->bitCount -= 8;
+                    if (d->size >= d->capacity) {
+                        Serial.println("Google TTS: buffer plein");
+                        return false;
+                    }
+                    d->out[d->size++] = (d->bits >> d->bitCount) & 0xFF;
+                }
+                break;
+            }
 
-    Serial.println("Google TTS: connexion...");
-    if (!client.connect(GOOGLE_TTS_HOST, GOOGLE_TTS_PORT)) {
-        Serial.println("Erreur connexion Google TTS");
-        return false;
+            case AUDIO_DONE:
+                // Fin du JSON ignoree, le reste du corps est vide par le lecteur
+                return true;
+        }
     }
+    return true;
+}
+
+// Requete sur une connexion du pool (session TLS reprise si possible)
+// keepAlive: reponse lue en entier, le socket peut etre rendu au pool.
+static bool requestGoogleTTS(PooledClient* client, const char* text, uint8_t** outBuffer, size_t* outSize,
+                             bool& keepAlive) {
+    keepAlive = false;
 
     // Construire le payload JSON
     String escapedText = escapeJsonStringGoogle(text);
@@ -68,176 +139,61 @@ bool getGoogleTTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSiz
         "Content-Length: " + payload.length() + "\r\n\r\n";
 
     Serial.println("Google TTS: envoi requete...");
-    client.print(headers);
-    client.print(payload);
+    client->print(headers);
+    client->print(payload);
 
-    // Attendre la reponse
-    unsigned long timeout = millis() + 10000;
-    while (client.connected() && !client.available() && millis() < timeout) {
-        delay(10);
+    HttpResponseReader reader(*client, 30000);
+    if (!reader.readHeaders()) {
+        Serial.printf("Erreur Google TTS: %s\n", reader.getError());
+        return false;
     }
 
-    // Lire les headers de reponse
-    String statusLine = "";
-    String responseHeaders = "";
-    bool firstLine = true;
-
-    while (client.available()) {
-        String line = client.readStringUntil('\n');
-        if (firstLine) {
-            statusLine = line;
-            firstLine = false;
-            Serial.print("Google TTS HTTP Status: ");
-            Serial.println(statusLine);
-        }
-        if (line == "\r" || line == "") break;
-        responseHeaders += line + "\n";
-    }
-
-    // Verifier le code HTTP
-    int httpCode = 0;
-    if (statusLine.startsWith("HTTP/1.1 ")) {
-        httpCode = statusLine.substring(9, 12).toInt();
-    }
+    int httpCode = reader.getStatus();
+    Serial.printf("Google TTS HTTP %d, Content-Length: %ld\n", httpCode, reader.getContentLength());
 
     if (httpCode != 200) {
         Serial.printf("Erreur Google TTS HTTP %d\n", httpCode);
         // Lire le body d'erreur
-        String errorBody = "";
-        timeout = millis() + 5000;
-        while (client.available() && errorBody.length() < 2000 && millis() < timeout) {
-            errorBody += (char)client.read();
-        }
-        if (errorBody.length() > 0) {
+        char errorBody[GOOGLE_TTS_ERROR_MAX];
+        if (reader.readText(errorBody, sizeof(errorBody)) > 0) {
             Serial.print("Erreur body: ");
             Serial.println(errorBody);
         }
+        keepAlive = reader.canReuse();
         return false;
     }
 
-    // Chercher Content-Length
-    int contentLength = -1;
-    int idx = responseHeaders.indexOf("Content-Length: ");
-    if (idx >= 0) {
-        int endIdx = responseHeaders.indexOf("\r", idx);
-        if (endIdx < 0) endIdx = responseHeaders.indexOf("\n", idx);
-        contentLength = responseHeaders.substring(idx + 16, endIdx).toInt();
-    }
-
-    Serial.printf("Google TTS Content-Length: %d\n", contentLength);
-
-    // Lire le body JSON
-    String jsonResponse = "";
-    timeout = millis() + 30000;
-
-    if (contentLength > 0) {
-        while (jsonResponse.length() < (size_t)contentLength && client.connected() && millis() < timeout) {
-            if (client.available()) {
-                jsonResponse += (char)client.read();
-            } else {
-                delay(1);
-            }
-        }
-    } else {
-        // Pas de Content-Length, lire jusqu'a fermeture
-        while (client.connected() && millis() < timeout) {
-            if (client.available()) {
-                jsonResponse += (char)client.read();
-            } else {
-                delay(10);
-            }
-        }
-    }
-
-    Serial.printf("Google TTS reponse JSON: %d bytes\n", jsonResponse.length());
-
-    // Parser le JSON pour extraire l'audio base64
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, jsonResponse);
-
-    if (error) {
-        Serial.print("Erreur JSON Google TTS: ");
-        Serial.println(error.c_str());
-        return false;
-    }
-
-    // L'audio est dans "audioContent" en base64
-    const char* audioBase64 = doc["audioContent"];
-    if (!audioBase64) {
-        Serial.println("Google TTS: audioContent manquant");
-        return false;
-    }
-
-    size_t base64Len = strlen(audioBase64);
-    Serial.printf("Google TTS audio base64: %d chars\n", base64Len);
-
-    // Decoder base64 -> PCM
-    // Taille estimee: base64 est ~33% plus grand que les donnees binaires
-    size_t estimatedSize = (base64Len * 3) / 4 + 10;
-
-    uint8_t* pcmData = (uint8_t*)ps_malloc(estimatedSize);
-    if (!pcmData) {
-        pcmData = (uint8_t*)malloc(estimatedSize);
+    // WAV alloue une fois: base64 est ~33% plus grand que les donnees binaires
+    long contentLength = reader.getContentLength();
+    size_t capacity = contentLength > 0 ? (size_t)contentLength * 3 / 4 + 10 : GOOGLE_TTS_MAX_PCM;
+    *outBuffer = (uint8_t*)ps_malloc(44 + capacity);
+    if (!*outBuffer) {
+        *outBuffer = (uint8_t*)malloc(44 + capacity);
     }
-    if (!pcmData) {
+    if (!*outBuffer) {
         Serial.println("Erreur malloc Google TTS buffer");
         return false;
     }
 
-    // Decoder base64
-    size_t decodedLen = 0;
-
-    // Table de decodage base64
-    static const int8_t base64_table[256] = {
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63,
-        52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-1,-1,-1,
-        -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,
-        15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,
-        -1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
-        41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-        -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
-    };
-
-    uint32_t buf = 0;
-    int bits = 0;
-
-    for (size_t i = 0; i < base64Len; i++) {
-        int8_t val = base64_table[(uint8_t)audioBase64[i]];
-        if (val == -1) continue;  // Skip invalid chars (newlines, etc)
-
-        buf = (buf << 6) | val;
-        bits += 6;
-
-        if (bits >= 8) {
-            bits -= 8;
-            pcmData[decodedLen++] = (buf >> bits) & 0xFF;
-        }
+    // "audioContent" decode a la volee: ni String du corps ni document JSON
+    GoogleAudioDecoder decoder;
+    memset(&decoder, 0, sizeof(decoder));
+    decoder.out = *outBuffer + 44;
+    decoder.capacity = capacity;
+
+    bool complete = reader.readBody(googleAudioSink, &decoder);
+    if (!complete || decoder.state != AUDIO_DONE || decoder.size == 0) {
+        Serial.printf("Google TTS: audioContent manquant ou incomplet (%s)\n", reader.getError());
+        free(*outBuffer);
+        *outBuffer = nullptr;
+        return false;
     }
 
-    Serial.printf("Google TTS decoded: %d bytes PCM\n", decodedLen);
+    size_t decodedLen = decoder.size;
+    Serial.printf("Google TTS decoded: %d bytes PCM (corps %u)\n", decodedLen, reader.getBodyBytes());
 
-    // Creer un header WAV
+    // WAV header devant le PCM decode
     size_t wavSize = 44 + decodedLen;
-    *outBuffer = (uint8_t*)ps_malloc(wavSize);
-    if (!*outBuffer) {
-        *outBuffer = (uint8_t*)malloc(wavSize);
-    }
-    if (!*outBuffer) {
-        free(pcmData);
-        Serial.println("Erreur malloc WAV buffer");
-        return false;
-    }
-
-    // WAV header
     uint8_t* wav = *outBuffer;
     memcpy(wav, "RIFF", 4);
     uint32_t fileSize = wavSize - 8;
@@ -269,12 +225,34 @@ bool getGoogleTTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSiz
     wav[42] = (dataSize >> 16) & 0xFF;
     wav[43] = (dataSize >> 24) & 0xFF;
 
-    // Copier les donnees PCM
-    memcpy(wav + 44, pcmData, decodedLen);
-    free(pcmData);
-
     *outSize = wavSize;
+    keepAlive = reader.canReuse();
     Serial.printf("Google TTS WAV: %d bytes\n", wavSize);
 
     return true;
 }
+
+bool getGoogleTTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSize) {
+    if (!text || strlen(text) == 0) {
+        Serial.println("Google TTS: texte vide");
+        return false;
+    }
+
+    // Verifier si on a une cle API Google
+    if (strlen(configManager.config.google_tts_key) == 0) {
+        Serial.println("Google TTS: cle API manquante");
+        return false;
+    }
+
+    Serial.println("Google TTS: connexion...");
+    PooledClient* client = connectionPool.acquire(GOOGLE_TTS_HOST, GOOGLE_TTS_PORT);
+    if (!client) {
+        Serial.println("Erreur connexion Google TTS");
+        return false;
+    }
+
+    bool keepAlive;
+    bool ok = requestGoogleTTS(client, text, outBuffer, outSize, keepAlive);
+    connectionPool.release(client, keepAlive);
+    return ok;
+}
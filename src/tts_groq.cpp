@@ -1,6 +1,8 @@
 #include "tts_groq.h"
 #include "config.h"
-#include <WiFiClientSecure.h>
+#include "connection_pool.h"
+#include "http_response.h"
+#include "http2_client.h"
 
 // Variables globales pour rate limit
 bool ttsRateLimitHit = false;
@@ -60,6 +62,9 @@ void parseRateLimitError(const String& errorBody) {
 #define GROQ_TTS_HOST "api.groq.com"
 #define GROQ_TTS_PORT 443
 #define GROQ_TTS_PATH "/openai/v1/audio/speech"
+#define TTS_MAX_AUDIO       1000000  // Reponse chunked: taille inconnue
+#define TTS_ERROR_BODY_MAX  2000
+#define TTS_H2_WEIGHT       128      // Apres la transcription (WHISPER_H2_WEIGHT)
 
 // Echappe les caracteres speciaux pour JSON
 String escapeJsonString(const char* text) {
@@ -83,19 +88,152 @@ String escapeJsonString(const char* text) {
     return result;
 }
 
-// Utilise WiFiClientSecure pour HTTPS
-bool getTTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSize) {
-    WiFiClientSecure client;
-    client.setInsecure(); // Pour test, à sécuriser en prod
-    if (!client.connect(GROQ_TTS_HOST, GROQ_TTS_PORT)) {
-        Serial.println("Erreur connexion Groq TTS");
+// Audio recu directement dans le buffer final
+struct TtsAudioTarget {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    bool full;
+};
+
+static bool ttsAudioSink(const uint8_t* data, size_t len, void* arg) {
+    TtsAudioTarget* target = (TtsAudioTarget*)arg;
+    size_t room = target->capacity - target->size;
+    if (len > room) {
+        memcpy(target->data + target->size, data, room);
+        target->size += room;
+        target->full = true;
+        Serial.println("Buffer TTS plein!");
         return false;
     }
+    memcpy(target->data + target->size, data, len);
+    target->size += len;
+    return true;
+}
 
+static String buildTTSPayload(const char* text) {
     // Groq TTS - modele Orpheus (conditions acceptees)
     String escapedText = escapeJsonString(text);
     // Voix disponibles: autumn, diana, hannah, austin, daniel, troy
-    String payload = String("{\"model\":\"canopylabs/orpheus-v1-english\",\"input\":\"") + escapedText + "\",\"voice\":\"daniel\",\"response_format\":\"wav\"}";
+    return String("{\"model\":\"canopylabs/orpheus-v1-english\",\"input\":\"") + escapedText + "\",\"voice\":\"daniel\",\"response_format\":\"wav\"}";
+}
+
+// Buffer audio a la taille annoncee, sinon (chunked) 1MB max pour audio long
+static bool allocAudioTarget(TtsAudioTarget& target, long contentLength) {
+    target.capacity = contentLength > 0 ? (size_t)contentLength : TTS_MAX_AUDIO;
+    target.size = 0;
+    target.full = false;
+    target.data = (uint8_t*)ps_malloc(target.capacity);
+    if (!target.data) {
+        target.data = (uint8_t*)malloc(target.capacity);
+    }
+    if (!target.data) {
+        Serial.println("Erreur malloc TTS buffer");
+        return false;
+    }
+    return true;
+}
+
+// Reponse HTTP/2: audio dans le buffer final, ou texte d'erreur
+struct TtsH2Response {
+    int status;
+    TtsAudioTarget target;
+    char error[TTS_ERROR_BODY_MAX];
+    size_t errorLen;
+};
+
+static bool ttsH2Headers(int status, long contentLength, void* arg) {
+    TtsH2Response* r = (TtsH2Response*)arg;
+    r->status = status;
+    Serial.printf("TTS HTTP/2 %d, content-length: %ld\n", status, contentLength);
+    if (status != 200) return true;
+    return allocAudioTarget(r->target, contentLength);
+}
+
+static bool ttsH2Sink(const uint8_t* data, size_t len, void* arg) {
+    TtsH2Response* r = (TtsH2Response*)arg;
+    if (r->status == 200) return ttsAudioSink(data, len, &r->target);
+
+    size_t room = sizeof(r->error) - 1 - r->errorLen;
+    if (len > room) len = room;
+    memcpy(r->error + r->errorLen, data, len);
+    r->errorLen += len;
+    r->error[r->errorLen] = '\0';
+    return true;
+}
+
+// Requete TTS sur la connexion HTTP/2 de Groq (partagee avec Whisper).
+// false: pas de reponse HTTP/2, repli sur le pool HTTP/1.1. Sinon ok
+// indique si l'audio est utilisable.
+static bool requestTTSHttp2(const String& payload, uint8_t** outBuffer, size_t* outSize,
+                            unsigned long timeoutMs, bool& ok) {
+    ok = false;
+    char auth[160];
+    snprintf(auth, sizeof(auth), "Bearer %s", configManager.config.groq_key);
+    HpackHeader headers[] = {
+        { "authorization", auth },
+        { "content-type", "application/json" },
+        { "accept", "audio/wav" },
+    };
+
+    TtsH2Response* r = (TtsH2Response*)malloc(sizeof(TtsH2Response));
+    if (!r) return false;
+    memset(r, 0, sizeof(TtsH2Response));
+
+    Http2Request req;
+    memset(&req, 0, sizeof(req));
+    req.method = "POST";
+    req.authority = GROQ_TTS_HOST;
+    req.path = GROQ_TTS_PATH;
+    req.headers = headers;
+    req.headerCount = 3;
+    req.contentLength = payload.length();
+    req.weight = TTS_H2_WEIGHT;
+    req.onHeaders = ttsH2Headers;
+    req.sink = ttsH2Sink;
+    req.arg = r;
+
+    Http2Call call;
+    bool answered = false;
+    if (call.begin(GROQ_TTS_HOST, GROQ_TTS_PORT, req) &&
+        call.write((const uint8_t*)payload.c_str(), payload.length()) == payload.length()) {
+        bool complete = call.finish(timeoutMs);
+        // Buffer plein: flux annule par le sink, l'audio tronque reste jouable
+        answered = complete || r->target.full;
+    }
+
+    if (!answered) {
+        Serial.printf("HTTP/2: %s, repli HTTP/1.1\n", call.getError());
+    } else if (r->status != 200) {
+        Serial.print("Erreur TTS HTTP ");
+        Serial.println(r->status);
+        if (r->errorLen > 0) {
+            Serial.print("Erreur TTS body: ");
+            Serial.println(r->error);
+            if (r->status == 429) {
+                parseRateLimitError(String(r->error));
+            }
+        }
+    } else if (r->target.size > 0) {
+        Serial.printf("TTS audio: %u bytes (HTTP/2)\n", r->target.size);
+        *outBuffer = r->target.data;
+        *outSize = r->target.size;
+        r->target.data = nullptr;
+        ok = true;
+    }
+
+    if (r->target.data) free(r->target.data);
+    free(r);
+    return answered;
+}
+
+// Requete TTS sur une connexion du pool.
+// keepAlive: reponse lue en entier, le socket peut etre rendu au pool.
+// stale: aucune reponse (socket keep-alive ferme par le serveur).
+static bool requestTTS(PooledClient* client, const String& payload, uint8_t** outBuffer, size_t* outSize,
+                       unsigned long timeoutMs, bool& keepAlive, bool& stale) {
+    keepAlive = false;
+    stale = false;
 
     String headers = String("POST ") + GROQ_TTS_PATH + " HTTP/1.1\r\n" +
         "Host: " + GROQ_TTS_HOST + "\r\n" +
@@ -104,171 +242,84 @@ bool getTTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSize) {
         "Accept: audio/wav\r\n" +
         "Content-Length: " + payload.length() + "\r\n\r\n";
 
-    client.print(headers);
-    client.print(payload);
-
-    // Attendre la réponse
-    while (client.connected() && !client.available()) delay(10);
-    String responseHeaders = "";
-    String statusLine = "";
-    bool firstLine = true;
-    while (client.available()) {
-        String line = client.readStringUntil('\n');
-        if (firstLine) {
-            statusLine = line;
-            firstLine = false;
-            Serial.print("TTS HTTP Status: ");
-            Serial.println(statusLine);
-        }
-        if (line == "\r" || line == "") break;
-        responseHeaders += line + "\n";
-    }
-
-    // Verifier le code HTTP
-    int httpCode = 0;
-    if (statusLine.startsWith("HTTP/1.1 ")) {
-        httpCode = statusLine.substring(9, 12).toInt();
-    }
+    client->print(headers);
+    client->print(payload);
 
-    // Chercher Content-Length ou Transfer-Encoding
-    int contentLength = -1;
-    bool isChunked = false;
-    int idx = responseHeaders.indexOf("Content-Length: ");
-    if (idx >= 0) {
-        int endIdx = responseHeaders.indexOf("\r", idx);
-        if (endIdx < 0) endIdx = responseHeaders.indexOf("\n", idx);
-        contentLength = responseHeaders.substring(idx + 16, endIdx).toInt();
-    }
-    if (responseHeaders.indexOf("Transfer-Encoding: chunked") >= 0 ||
-        responseHeaders.indexOf("transfer-encoding: chunked") >= 0) {
-        isChunked = true;
+    HttpResponseReader reader(*client, timeoutMs);
+    if (!reader.readHeaders()) {
+        // Aucune reponse: socket keep-alive ferme par le serveur
+        stale = reader.isStale();
+        Serial.printf("Erreur TTS: %s\n", reader.getError());
+        return false;
     }
 
-    Serial.printf("TTS Content-Length: %d, Chunked: %s\n", contentLength, isChunked ? "yes" : "no");
+    int httpCode = reader.getStatus();
+    long contentLength = reader.getContentLength();
+    Serial.printf("TTS HTTP %d, Content-Length: %ld\n", httpCode, contentLength);
 
     // Si erreur HTTP, lire et afficher le body pour debug
     if (httpCode != 200) {
         Serial.print("Erreur TTS HTTP ");
         Serial.println(httpCode);
-        String errorBody = "";
-        unsigned long timeout = millis() + 5000;
-        while (client.available() && errorBody.length() < 2000 && millis() < timeout) {
-            errorBody += (char)client.read();
-        }
-        if (errorBody.length() > 0) {
+        char errorBody[TTS_ERROR_BODY_MAX];
+        if (reader.readText(errorBody, sizeof(errorBody)) > 0) {
             Serial.print("Erreur TTS body: ");
             Serial.println(errorBody);
 
             // Parser le rate limit si erreur 429
             if (httpCode == 429) {
-                parseRateLimitError(errorBody);
+                parseRateLimitError(String(errorBody));
             }
         }
+        keepAlive = reader.canReuse();
         return false;
     }
 
-    // Lire le body (chunked ou content-length)
-    if (isChunked) {
-        // Transfer-Encoding: chunked - lire par morceaux
-        // Format: <hex size>\r\n<data>\r\n ... 0\r\n\r\n
-        Serial.println("Lecture TTS chunked...");
-
-        // Buffer dynamique (max 1MB pour audio long)
-        size_t maxSize = 1000000;
-        *outBuffer = (uint8_t*)ps_malloc(maxSize);
-        if (!*outBuffer) {
-            *outBuffer = (uint8_t*)malloc(maxSize);
-        }
-        if (!*outBuffer) {
-            Serial.println("Erreur malloc TTS buffer chunked");
-            return false;
-        }
+    TtsAudioTarget target;
+    if (!allocAudioTarget(target, contentLength)) return false;
 
-        *outSize = 0;
-        unsigned long timeout = millis() + 30000;  // 30s timeout
-
-        while (client.connected() && millis() < timeout) {
-            // Lire la taille du chunk (hex)
-            String chunkSizeLine = "";
-            while (client.connected() && millis() < timeout) {
-                if (client.available()) {
-                    char c = client.read();
-                    if (c == '\n') break;
-                    if (c != '\r') chunkSizeLine += c;
-                } else {
-                    delay(1);
-                }
-            }
+    bool complete = reader.readBody(ttsAudioSink, &target);
+    Serial.printf("TTS audio: %u bytes%s\n", target.size, complete ? "" : " (incomplet)");
 
-            // Parser la taille hex
-            int chunkSize = (int)strtol(chunkSizeLine.c_str(), NULL, 16);
-            if (chunkSize == 0) {
-                // Fin des chunks
-                Serial.printf("TTS chunked complete: %d bytes\n", *outSize);
-                break;
-            }
+    // Buffer plein: l'audio tronque reste jouable
+    if ((!complete && !target.full) || target.size == 0) {
+        Serial.printf("Erreur: audio TTS incomplet (%s)\n", reader.getError());
+        free(target.data);
+        return false;
+    }
 
-            // Lire les donnees du chunk
-            size_t chunkRead = 0;
-            while (chunkRead < chunkSize && client.connected() && millis() < timeout) {
-                if (client.available()) {
-                    int n = client.read(*outBuffer + *outSize, min((size_t)(chunkSize - chunkRead), maxSize - *outSize));
-                    if (n > 0) {
-                        chunkRead += n;
-                        *outSize += n;
-                    }
-                } else {
-                    delay(1);
-                }
+    *outBuffer = target.data;
+    *outSize = target.size;
+    keepAlive = reader.canReuse();
+    return true;
+}
 
-                if (*outSize >= maxSize) {
-                    Serial.println("Buffer TTS plein!");
-                    break;
-                }
-            }
+bool getTTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSize, TurnBudget* turn) {
+    String payload = buildTTSPayload(text);
+    unsigned long timeoutMs = turn ? turn->timeoutFor(TURN_TTS, TTS_TIMEOUT_MS) : TTS_TIMEOUT_MS;
 
-            // Lire le \r\n apres le chunk
-            while (client.connected() && client.available() < 2 && millis() < timeout) delay(1);
-            if (client.available() >= 2) {
-                client.read(); // \r
-                client.read(); // \n
-            }
-        }
+    // Flux HTTP/2 a cote d'une transcription en cours, sans second handshake
+    bool ok;
+    if (http2.handles(GROQ_TTS_HOST, GROQ_TTS_PORT) && requestTTSHttp2(payload, outBuffer, outSize, timeoutMs, ok)) {
+        return ok;
+    }
 
-        if (*outSize == 0) {
-            Serial.println("Erreur: aucune donnee TTS recue");
-            free(*outBuffer);
-            *outBuffer = nullptr;
+    // Socket keep-alive du pool (partage avec Whisper), rejoue une fois
+    // si le serveur l'a ferme pendant l'inactivite
+    for (int attempt = 0; attempt < 2; attempt++) {
+        PooledClient* client = connectionPool.acquire(GROQ_TTS_HOST, GROQ_TTS_PORT, attempt > 0);
+        if (!client) {
+            Serial.println("Erreur connexion Groq TTS");
             return false;
         }
 
-        return true;
+        bool reused = client->wasReused();
+        bool keepAlive, stale;
+        bool ok = requestTTS(client, payload, outBuffer, outSize, timeoutMs, keepAlive, stale);
+        connectionPool.release(client, keepAlive);
 
-    } else if (contentLength > 0) {
-        // Content-Length standard
-        *outBuffer = (uint8_t*)malloc(contentLength);
-        if (!*outBuffer) {
-            Serial.println("Erreur malloc TTS buffer");
-            return false;
-        }
-        *outSize = contentLength;
-        size_t received = 0;
-        unsigned long timeout = millis() + 30000;
-        while (received < (size_t)contentLength && client.connected() && millis() < timeout) {
-            int n = client.read(*outBuffer + received, contentLength - received);
-            if (n > 0) received += n;
-            else delay(1);
-        }
-        if (received != (size_t)contentLength) {
-            Serial.println("Erreur: taille audio TTS incomplete");
-            free(*outBuffer);
-            *outBuffer = nullptr;
-            *outSize = 0;
-            return false;
-        }
-        return true;
-    } else {
-        Serial.println("Erreur: ni Content-Length ni chunked");
-        return false;
+        if (stale && reused) continue;
+        return ok;
     }
+    return false;
 }
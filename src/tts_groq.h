@@ -1,12 +1,16 @@
 #pragma once
 #include <Arduino.h>
+#include "turn_budget.h"
+
+#define TTS_TIMEOUT_MS 30000    // Hors tour vocal (sinon TurnBudget)
 
 // Fonction pour récupérer un buffer WAV depuis Groq TTS
 // Nécessite la clé API Groq et l'URL du service TTS
 // Retourne true si succès, false sinon
 // Le buffer alloué doit être libéré avec free()
+// turn: timeouts tires du budget du tour vocal (nullptr: TTS_TIMEOUT_MS)
 
-bool getTTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSize);
+bool getTTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSize, TurnBudget* turn = nullptr);
 
 // Rate limit info (rempli si erreur 429)
 extern bool ttsRateLimitHit;           // true si rate limit atteint
@@ -1,6 +1,6 @@
 #include "tts_openai.h"
 #include "config.h"
-#include <WiFiClientSecure.h>
+#include "connection_pool.h"
 
 #define OPENAI_TTS_HOST "api.openai.com"
 #define OPENAI_TTS_PORT 443
@@ -43,15 +43,6 @@ bool getOpenAITTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSiz
         return false;
     }
 
-    WiFiClientSecure client;
-    client.setInsecure();
-
-    Serial.println("OpenAI TTS: connexion...");
-    if (!client.connect(OPENAI_TTS_HOST, OPENAI_TTS_PORT)) {
-        Serial.println("Erreur connexion OpenAI TTS");
-        return false;
-    }
-
     // OpenAI TTS - modele tts-1 (rapide) avec voix alloy
     // Voix disponibles: alloy, echo, fable, onyx, nova, shimmer
     String escapedText = escapeJsonStringOpenAI(text);
@@ -59,20 +50,29 @@ bool getOpenAITTSWavBuffer(const char* text, uint8_t** outBuffer, size_t* outSiz
                      "\",\"voice\":\"alloy\",\"response_format\":\"wav\",\"speed\":1.0}";
 
     // Note: Ceci utilise la cle Anthropic - en production utiliser une cle OpenAI
-    // Pour l'instant on skip OpenAI si pas de cle dediee
+    // Pour l'instant on skip OpenAI si pas de cle dediee (avant toute
+    // connexion: un handshake TLS pour rien coutait ~500 ms)
     Serial.println("OpenAI TTS: API non configuree (necessite cle OpenAI)");
     return false;
 
     /* Code pour quand on aura une cle OpenAI:
+    Serial.println("OpenAI TTS: connexion...");
+    PooledClient* client = connectionPool.acquire(OPENAI_TTS_HOST, OPENAI_TTS_PORT);
+    if (!client) {
+        Serial.println("Erreur connexion OpenAI TTS");
+        return false;
+    }
+
     String headers = String("POST ") + OPENAI_TTS_PATH + " HTTP/1.1\r\n" +
         "Host: " + OPENAI_TTS_HOST + "\r\n" +
         "Authorization: Bearer " + String(configManager.config.openai_key) + "\r\n" +
         "Content-Type: application/json\r\n" +
         "Content-Length: " + payload.length() + "\r\n\r\n";
 
-    client.print(headers);
-    client.print(payload);
+    client->print(headers);
+    client->print(payload);
 
-    // ... reste du code similaire a tts_groq.cpp
+    // ... reste du code similaire a tts_groq.cpp, puis
+    // connectionPool.release(client, keepAlive);
     */
 }
@@ -0,0 +1,151 @@
+// turn_budget.cpp - Budget de temps d'un tour vocal
+#include "turn_budget.h"
+#include "http_executor.h"
+
+static const char* stageNames[TURN_STAGE_COUNT] = { "ecoute", "STT", "Claude", "TTS" };
+
+TurnStageStats TurnBudget::stats[TURN_STAGE_COUNT];
+uint32_t TurnBudget::turns = 0;
+uint32_t TurnBudget::turnsOver = 0;
+uint32_t TurnBudget::turnMsMax = 0;
+TurnStageStats TurnBudget::firstToken;
+TurnStageStats TurnBudget::firstAudio;
+
+TurnBudget::TurnBudget(uint32_t budgetMs) {
+    start = millis();
+    this->budgetMs = budgetMs;
+    suspendedMs = 0;
+    suspendedAt = 0;
+    memset(stageStart, 0, sizeof(stageStart));
+    memset(stageAllowed, 0, sizeof(stageAllowed));
+    memset(stageMs, 0, sizeof(stageMs));
+    memset(stageOverrun, 0, sizeof(stageOverrun));
+    firstTokenMs = 0;
+    firstAudioMs = 0;
+    finished = false;
+    httpExecutor.beginInteractive(true);
+}
+
+TurnBudget::~TurnBudget() {
+    httpExecutor.endInteractive();
+}
+
+uint32_t TurnBudget::elapsed() {
+    unsigned long now = suspendedAt ? suspendedAt : millis();
+    return now - start - suspendedMs;
+}
+
+uint32_t TurnBudget::remaining() {
+    uint32_t used = elapsed();
+    return used < budgetMs ? budgetMs - used : 0;
+}
+
+uint32_t TurnBudget::reserveAfter(TurnStage stage) {
+    switch (stage) {
+        case TURN_LISTEN:
+        case TURN_STT:
+            return TURN_RESERVE_LLM_MS + TURN_RESERVE_TTS_MS;
+        case TURN_LLM:
+            return TURN_RESERVE_TTS_MS;
+        default:
+            return 0;
+    }
+}
+
+uint32_t TurnBudget::timeoutFor(TurnStage stage, uint32_t defaultMs) {
+    uint32_t left = remaining();
+    uint32_t reserve = reserveAfter(stage);
+    uint32_t allowed = left > reserve ? left - reserve : 0;
+    if (allowed > defaultMs) allowed = defaultMs;
+    if (allowed < TURN_STAGE_MIN_MS) allowed = TURN_STAGE_MIN_MS;
+    return allowed;
+}
+
+void TurnBudget::beginStage(TurnStage stage, uint32_t defaultMs) {
+    stageStart[stage] = millis();
+    stageAllowed[stage] = timeoutFor(stage, defaultMs);
+}
+
+void TurnBudget::endStage(TurnStage stage, bool ok) {
+    if (stageStart[stage] == 0) return;
+    uint32_t ms = millis() - stageStart[stage];
+    stageStart[stage] = 0;
+    // Etape rejouee dans le meme tour (wake word seul: listenForCommand
+    // relance l'ecoute et le STT): durees cumulees
+    stageMs[stage] += ms;
+
+    TurnStageStats& s = stats[stage];
+    s.runs++;
+    s.msTotal += ms;
+    if (ms > s.msMax) s.msMax = ms;
+    if (!ok) s.failures++;
+    if (ms > stageAllowed[stage]) {
+        s.overruns++;
+        stageOverrun[stage] = true;
+        Serial.printf("Tour: %s depasse son budget (%u ms sur %u)\n",
+                      stageNames[stage], ms, stageAllowed[stage]);
+    }
+}
+
+void TurnBudget::suspend() {
+    if (!suspendedAt) suspendedAt = millis();
+}
+
+void TurnBudget::resume() {
+    if (!suspendedAt) return;
+    suspendedMs += millis() - suspendedAt;
+    suspendedAt = 0;
+}
+
+void TurnBudget::markFirstToken() {
+    if (firstTokenMs) return;
+    firstTokenMs = max(elapsed(), (uint32_t)1);
+    firstToken.runs++;
+    firstToken.msTotal += firstTokenMs;
+    if (firstTokenMs > firstToken.msMax) firstToken.msMax = firstTokenMs;
+}
+
+void TurnBudget::markFirstAudio() {
+    if (firstAudioMs) return;
+    firstAudioMs = max(elapsed(), (uint32_t)1);
+    firstAudio.runs++;
+    firstAudio.msTotal += firstAudioMs;
+    if (firstAudioMs > firstAudio.msMax) firstAudio.msMax = firstAudioMs;
+}
+
+void TurnBudget::finish(bool ok) {
+    if (finished) return;
+    finished = true;
+    resume();
+
+    uint32_t total = elapsed();
+    turns++;
+    if (total > budgetMs) turnsOver++;
+    if (total > turnMsMax) turnMsMax = total;
+
+    Serial.printf("Tour %s: %u ms / %u (", ok ? "OK" : "en echec", total, budgetMs);
+    for (int i = 0; i < TURN_STAGE_COUNT; i++) {
+        Serial.printf("%s%s %u%s", i ? ", " : "", stageNames[i], stageMs[i], stageOverrun[i] ? "!" : "");
+    }
+    Serial.print(")");
+    if (firstTokenMs) Serial.printf(" 1er token %u ms", firstTokenMs);
+    if (firstAudioMs) Serial.printf(" 1er audio %u ms", firstAudioMs);
+    Serial.printf("%s\n", total > budgetMs ? " BUDGET DEPASSE" : "");
+}
+
+void TurnBudget::printStats() {
+    Serial.println("\n=== BUDGET DES TOURS ===");
+    Serial.printf("Budget: %u ms | %u tours, %u au-dela, pire %u ms\n",
+                  TURN_BUDGET_MS, turns, turnsOver, turnMsMax);
+    Serial.println("Etape    execs  moy ms  max ms  depassements  echecs");
+    for (int i = 0; i < TURN_STAGE_COUNT; i++) {
+        const TurnStageStats& s = stats[i];
+        Serial.printf("%-7s  %5u  %6u  %6u  %12u  %6u\n", stageNames[i], s.runs,
+                      s.runs ? s.msTotal / s.runs : 0, s.msMax, s.overruns, s.failures);
+    }
+    Serial.printf("1er token: %u tours, moy %u ms, max %u ms\n", firstToken.runs,
+                  firstToken.runs ? firstToken.msTotal / firstToken.runs : 0, firstToken.msMax);
+    Serial.printf("1er audio: %u tours, moy %u ms, max %u ms\n", firstAudio.runs,
+                  firstAudio.runs ? firstAudio.msTotal / firstAudio.runs : 0, firstAudio.msMax);
+    Serial.println("========================\n");
+}
@@ -0,0 +1,93 @@
+// turn_budget.h - Budget de temps d'un tour vocal (reveil -> reponse parlee)
+// Chaque etape avait son propre timeout (Whisper 60 s, Claude 30 s, TTS
+// 30 s): un tour pouvait rester bloque plus de 2 minutes. Un TurnBudget
+// est cree au reveil dans processVoiceCommand() et passe a transcribe(),
+// askClaude(), sendMessage() et speakText(). Chaque etape tire ses
+// timeouts socket du temps restant, moins une reserve pour les etapes
+// suivantes. Les depassements sont comptes par etape (/turn).
+// Tant qu'un tour existe, les requetes de fond de l'executeur HTTP
+// attendent (celles en file sont annulees).
+#ifndef TURN_BUDGET_H
+#define TURN_BUDGET_H
+
+#include <Arduino.h>
+
+#define TURN_BUDGET_MS        45000   // Reveil -> debut de la reponse audio
+#define TURN_STAGE_MIN_MS     3000    // Plancher: une etape en retard garde sa chance
+#define TURN_RESERVE_LLM_MS   8000    // Garde pour Claude pendant ecoute et STT
+#define TURN_RESERVE_TTS_MS   6000    // Garde pour le TTS jusqu'a la reponse Claude
+
+enum TurnStage {
+    TURN_LISTEN,        // Ecoute avec VAD
+    TURN_STT,           // Whisper (speculatif ou normal)
+    TURN_LLM,           // Donnees Bitcoin + Claude
+    TURN_TTS,
+    TURN_STAGE_COUNT
+};
+
+struct TurnStageStats {
+    uint32_t runs;
+    uint32_t msTotal;
+    uint32_t msMax;
+    uint32_t overruns;          // Plus long que le temps alloue a l'etape
+    uint32_t failures;
+};
+
+class TurnBudget {
+public:
+    // Demarre le chronometre et ouvre la fenetre interactive de l'executeur
+    TurnBudget(uint32_t budgetMs = TURN_BUDGET_MS);
+    ~TurnBudget();
+    TurnBudget(const TurnBudget&) = delete;
+    TurnBudget& operator=(const TurnBudget&) = delete;
+
+    uint32_t elapsed();
+    uint32_t remaining();
+
+    // Timeout d'une etape: defaultMs (celui du module), borne par le temps
+    // restant moins la reserve des etapes suivantes, jamais sous
+    // TURN_STAGE_MIN_MS
+    uint32_t timeoutFor(TurnStage stage, uint32_t defaultMs);
+
+    // Duree de chaque etape, comparee a son allocation (timeoutFor au debut)
+    void beginStage(TurnStage stage, uint32_t defaultMs);
+    void endStage(TurnStage stage, bool ok);
+
+    // Attente de l'utilisateur (QR code, confirmation): hors budget
+    void suspend();
+    void resume();
+
+    // Reponse en flux: premier texte de Claude, premier audio pret a jouer
+    // (temps depuis le reveil, hors suspensions). Appels suivants ignores.
+    void markFirstToken();
+    void markFirstAudio();
+
+    // Fin du tour: bilan par etape (une ligne) et stats globales
+    void finish(bool ok);
+
+    static void printStats();
+
+private:
+    unsigned long start;
+    uint32_t budgetMs;
+    uint32_t suspendedMs;
+    unsigned long suspendedAt;
+    unsigned long stageStart[TURN_STAGE_COUNT];
+    uint32_t stageAllowed[TURN_STAGE_COUNT];
+    uint32_t stageMs[TURN_STAGE_COUNT];
+    bool stageOverrun[TURN_STAGE_COUNT];
+    uint32_t firstTokenMs;      // 0: pas encore
+    uint32_t firstAudioMs;
+    bool finished;
+
+    static TurnStageStats stats[TURN_STAGE_COUNT];
+    static uint32_t turns;
+    static uint32_t turnsOver;          // Tours au-dela du budget
+    static uint32_t turnMsMax;
+    static TurnStageStats firstToken;   // runs, msTotal, msMax seulement
+    static TurnStageStats firstAudio;
+
+    static uint32_t reserveAfter(TurnStage stage);
+};
+
+#endif
@@ -0,0 +1,64 @@
+// vad.cpp - Detection d'activite vocale (fin de commande)
+#include "vad.h"
+#include <math.h>
+
+int vadFrameEnergy(const int16_t* samples, size_t count) {
+    if (count == 0) return 0;
+
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t s = samples[i];
+        sum += s * s;
+    }
+    return (int)sqrt((double)(sum / count));
+}
+
+CommandVad::CommandVad() {
+    begin(16000, 800, 250);
+}
+
+void CommandVad::begin(int sampleRate, int silenceMs, int tentativeMs, int threshold) {
+    this->threshold = threshold;
+    silenceFramesRequired = (silenceMs * sampleRate) / (VAD_CHUNK_SAMPLES * 1000);
+    // Pause courte pour lancer la transcription speculative (~7 frames pour 250ms)
+    tentativeFramesRequired = (tentativeMs * sampleRate) / (VAD_CHUNK_SAMPLES * 1000);
+    if (tentativeFramesRequired < 1) tentativeFramesRequired = 1;
+
+    energy = 0;
+    speech = false;
+    speechFrameCount = 0;
+    silenceFrameCount = 0;
+    speechStarted = false;
+}
+
+VadEvent CommandVad::process(const int16_t* samples, size_t count) {
+    energy = vadFrameEnergy(samples, count);
+    speech = (energy > threshold);
+
+    VadEvent event = VAD_EVENT_NONE;
+
+    if (speech) {
+        speechFrameCount++;
+        if (speechStarted && silenceFrameCount > 0) {
+            event = VAD_EVENT_RESUME;
+        }
+        silenceFrameCount = 0;
+
+        if (!speechStarted && speechFrameCount >= VAD_SPEECH_FRAMES) {
+            speechStarted = true;
+            event = VAD_EVENT_SPEECH_START;
+        }
+    } else {
+        speechFrameCount = 0;
+        if (speechStarted) {
+            silenceFrameCount++;
+            if (silenceFrameCount >= silenceFramesRequired) {
+                event = VAD_EVENT_END;
+            } else if (silenceFrameCount == 1) {
+                event = VAD_EVENT_PAUSE;
+            }
+        }
+    }
+
+    return event;
+}
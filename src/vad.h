@@ -0,0 +1,63 @@
+// vad.h - Detection d'activite vocale (fin de commande)
+// Logique frame par frame extraite de AudioManager::startRecordingWithVAD.
+// Sans dependance materielle ni horloge: les decisions ne dependent que des
+// echantillons, ce qui permet de la rejouer sur PC (tools/replay_bench).
+#ifndef VAD_H
+#define VAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define VAD_CHUNK_SAMPLES      512   // Samples par frame (32 ms a 16 kHz)
+#define VAD_ENERGY_THRESHOLD   400   // Seuil d'energie pour parole
+#define VAD_SPEECH_FRAMES      2     // Frames pour confirmer debut parole
+
+// Energie RMS d'une frame (partagee avec le wake word)
+int vadFrameEnergy(const int16_t* samples, size_t count);
+
+// Evenement produit par une frame
+enum VadEvent {
+    VAD_EVENT_NONE,
+    VAD_EVENT_SPEECH_START,  // Debut de parole confirme
+    VAD_EVENT_PAUSE,         // Premiere frame de silence apres parole
+    VAD_EVENT_RESUME,        // Parole apres une pause
+    VAD_EVENT_END            // Silence suffisant: fin de commande
+};
+
+class CommandVad {
+public:
+    CommandVad();
+
+    // silenceMs: silence de fin, tentativeMs: pause courte (STT speculatif)
+    void begin(int sampleRate, int silenceMs, int tentativeMs, int threshold = VAD_ENERGY_THRESHOLD);
+
+    VadEvent process(const int16_t* samples, size_t count);
+
+    // Etat apres la derniere frame
+    int getEnergy() { return energy; }
+    bool isSpeech() { return speech; }
+    bool hasSpeechStarted() { return speechStarted; }
+    int getThreshold() { return threshold; }
+
+    // La frame doit etre conservee dans l'enregistrement
+    bool shouldStore() { return speechStarted || speechFrameCount > 0; }
+
+    // Pause courte en cours (assez longue pour STT speculatif, pas encore la fin)
+    bool inTentativePause() {
+        return speechStarted && silenceFrameCount >= tentativeFramesRequired &&
+               silenceFrameCount < silenceFramesRequired;
+    }
+
+private:
+    int threshold;
+    int silenceFramesRequired;
+    int tentativeFramesRequired;
+
+    int energy;
+    bool speech;
+    int speechFrameCount;
+    int silenceFrameCount;
+    bool speechStarted;
+};
+
+#endif
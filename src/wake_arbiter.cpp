@@ -0,0 +1,280 @@
+// wake_arbiter.cpp - Arbitrage du wake word entre plusieurs SATOSHI
+#include "wake_arbiter.h"
+#include <string.h>
+#include <math.h>
+
+static const uint8_t ARBITER_MAGIC[4] = { 'S', 'T', 'W', 'K' };
+#define ARBITER_VERSION 1
+
+// Comparaison d'horloges robuste au debordement de millis()
+static inline int32_t timeDiff(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b);
+}
+
+static inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static inline uint16_t get16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+WakeArbiter::WakeArbiter() {
+    transport = nullptr;
+    deviceId = 0;
+    wakeSeq = 0;
+    claiming = false;
+    claimStartMs = 0;
+    lastSendMs = 0;
+    rivalBetter = false;
+    historyCount = 0;
+    historyNext = 0;
+    memset(&own, 0, sizeof(own));
+    memset(&bestRival, 0, sizeof(bestRival));
+    memset(&stats, 0, sizeof(stats));
+}
+
+void WakeArbiter::begin(ArbiterTransport* transport, uint32_t deviceId) {
+    this->transport = transport;
+    this->deviceId = deviceId;
+}
+
+// ============================================================
+// Paquet: magic(4) version(1) reserve(1) snr(2) device(4) seq(4) peak(4) age(4)
+// ============================================================
+
+size_t WakeArbiter::encode(const WakeClaim& claim, uint8_t* out) {
+    memcpy(out, ARBITER_MAGIC, 4);
+    out[4] = ARBITER_VERSION;
+    out[5] = 0;
+    put16(out + 6, claim.snrCentiDb);
+    put32(out + 8, claim.deviceId);
+    put32(out + 12, claim.wakeSeq);
+    put32(out + 16, claim.peakEnergy);
+    put32(out + 20, claim.ageMs);
+    return ARBITER_PACKET_SIZE;
+}
+
+bool WakeArbiter::decode(const uint8_t* data, size_t len, WakeClaim& claim) {
+    if (len < ARBITER_PACKET_SIZE) return false;
+    if (memcmp(data, ARBITER_MAGIC, 4) != 0) return false;
+    if (data[4] != ARBITER_VERSION) return false;
+
+    claim.snrCentiDb = get16(data + 6);
+    claim.deviceId = get32(data + 8);
+    claim.wakeSeq = get32(data + 12);
+    claim.peakEnergy = get32(data + 16);
+    claim.ageMs = get32(data + 20);
+    claim.localTimeMs = 0;
+    return true;
+}
+
+bool WakeArbiter::beats(const WakeClaim& a, const WakeClaim& b) {
+    // SNR d'abord (unite la plus proche du locuteur), puis energie crete,
+    // puis identifiant le plus petit pour departager sans ambiguite
+    if (a.snrCentiDb != b.snrCentiDb) return a.snrCentiDb > b.snrCentiDb;
+    if (a.peakEnergy != b.peakEnergy) return a.peakEnergy > b.peakEnergy;
+    return a.deviceId < b.deviceId;
+}
+
+uint16_t WakeArbiter::snrFromEnergy(uint32_t peakEnergy, uint32_t noiseFloor) {
+    if (noiseFloor < 1) noiseFloor = 1;
+    if (peakEnergy <= noiseFloor) return 0;
+    double db = 20.0 * log10((double)peakEnergy / noiseFloor);
+    if (db > 655.0) db = 655.0;
+    return (uint16_t)(db * 100.0);
+}
+
+// ============================================================
+// Reception
+// ============================================================
+
+void WakeArbiter::remember(const WakeClaim& claim) {
+    // Re-emission d'un score deja connu: garder la premiere heure de detection
+    for (int i = 0; i < historyCount; i++) {
+        if (history[i].deviceId == claim.deviceId && history[i].wakeSeq == claim.wakeSeq) {
+            return;
+        }
+    }
+
+    history[historyNext] = claim;
+    historyNext = (historyNext + 1) % ARBITER_HISTORY;
+    if (historyCount < ARBITER_HISTORY) historyCount++;
+}
+
+void WakeArbiter::consider(const WakeClaim& claim) {
+    // Meme utterance si les detections sont proches dans le temps
+    int32_t delta = timeDiff(claim.localTimeMs, own.localTimeMs);
+    if (delta < -ARBITER_MATCH_MS || delta > ARBITER_MATCH_MS) return;
+
+    if (beats(claim, own) && (!rivalBetter || beats(claim, bestRival))) {
+        rivalBetter = true;
+        bestRival = claim;
+    }
+}
+
+void WakeArbiter::drain(uint32_t nowMs) {
+    if (!transport) return;
+
+    uint8_t buf[64];
+    int len;
+    while ((len = transport->receive(buf, sizeof(buf))) > 0) {
+        stats.packetsIn++;
+
+        WakeClaim claim;
+        if (!decode(buf, len, claim)) {
+            stats.packetsBad++;
+            continue;
+        }
+        if (claim.deviceId == deviceId) continue;  // Boucle multicast locale
+
+        // Heure de detection ramenee sur notre horloge
+        claim.localTimeMs = nowMs - claim.ageMs;
+        remember(claim);
+        if (claiming) consider(claim);
+    }
+}
+
+void WakeArbiter::service(uint32_t nowMs) {
+    drain(nowMs);
+}
+
+void WakeArbiter::flush() {
+    if (!transport) return;
+
+    uint8_t buf[64];
+    while (transport->receive(buf, sizeof(buf)) > 0) {
+        stats.packetsIn++;
+    }
+    historyCount = 0;
+    historyNext = 0;
+}
+
+// ============================================================
+// Arbitrage
+// ============================================================
+
+void WakeArbiter::sendOwn(uint32_t nowMs) {
+    own.ageMs = nowMs - own.localTimeMs;
+
+    uint8_t buf[ARBITER_PACKET_SIZE];
+    size_t len = encode(own, buf);
+    transport->send(buf, len);
+    lastSendMs = nowMs;
+}
+
+void WakeArbiter::startClaim(uint16_t snrCentiDb, uint32_t peakEnergy, uint32_t detectMs, uint32_t nowMs) {
+    if (!transport) return;
+
+    // Recuperer les scores arrives juste avant
+    drain(nowMs);
+
+    own.deviceId = deviceId;
+    own.wakeSeq = ++wakeSeq;
+    own.snrCentiDb = snrCentiDb;
+    own.peakEnergy = peakEnergy;
+    own.localTimeMs = detectMs;
+
+    claiming = true;
+    claimStartMs = nowMs;
+    rivalBetter = false;
+    stats.claims++;
+
+    // Unites qui ont detecte avant nous (leur fenetre est peut-etre deja close)
+    for (int i = 0; i < historyCount; i++) {
+        consider(history[i]);
+    }
+
+    sendOwn(nowMs);
+}
+
+ArbiterResult WakeArbiter::poll(uint32_t nowMs) {
+    if (!claiming) return ARB_WON;
+
+    drain(nowMs);
+
+    int32_t elapsed = timeDiff(nowMs, claimStartMs);
+    if (elapsed < ARBITER_WINDOW_MS) {
+        // Deuxieme emission au milieu de la fenetre contre la perte UDP.
+        // On continue meme si un rival est meilleur: les unites plus lentes
+        // doivent connaitre notre score pour se classer correctement.
+        if (timeDiff(nowMs, lastSendMs) >= ARBITER_RESEND_MS) {
+            sendOwn(nowMs);
+        }
+        return ARB_PENDING;
+    }
+
+    claiming = false;
+    if (rivalBetter) {
+        stats.lost++;
+        return ARB_LOST;
+    }
+    stats.won++;
+    return ARB_WON;
+}
+
+// ============================================================
+// Transport ESP32 (WiFiUDP multicast)
+// ============================================================
+#ifdef ARDUINO
+#include <WiFi.h>
+
+WakeArbiter wakeArbiter;
+UdpArbiterTransport arbiterTransport;
+
+bool UdpArbiterTransport::begin() {
+    if (!udp.beginMulticast(IPAddress(ARBITER_GROUP_IP), ARBITER_PORT)) {
+        Serial.println("Arbitre: echec multicast UDP");
+        return false;
+    }
+    return true;
+}
+
+bool UdpArbiterTransport::send(const uint8_t* data, size_t len) {
+    if (!udp.beginPacket(IPAddress(ARBITER_GROUP_IP), ARBITER_PORT)) return false;
+    udp.write(data, len);
+    return udp.endPacket() == 1;
+}
+
+int UdpArbiterTransport::receive(uint8_t* data, size_t maxLen) {
+    int size = udp.parsePacket();
+    if (size <= 0) return 0;
+    return udp.read(data, maxLen);
+}
+
+bool arbitrateWake(uint32_t peakEnergy, uint32_t noiseFloor, unsigned long detectMs) {
+    if (!wakeArbiter.isActive() || WiFi.status() != WL_CONNECTED) {
+        return true;  // Unite seule: pas d'arbitrage
+    }
+
+    uint16_t snr = WakeArbiter::snrFromEnergy(peakEnergy, noiseFloor);
+    wakeArbiter.startClaim(snr, peakEnergy, detectMs, millis());
+
+    ArbiterResult result;
+    while ((result = wakeArbiter.poll(millis())) == ARB_PENDING) {
+        delay(5);
+    }
+
+    if (result == ARB_LOST) {
+        const WakeClaim& rival = wakeArbiter.getBestRival();
+        Serial.printf("Arbitre: perdu (SNR %.2f dB) contre %08X (SNR %.2f dB)\n",
+                      snr / 100.0f, rival.deviceId, rival.snrCentiDb / 100.0f);
+        return false;
+    }
+
+    Serial.printf("Arbitre: gagne (SNR %.2f dB)\n", snr / 100.0f);
+    return true;
+}
+#endif
@@ -0,0 +1,135 @@
+// wake_arbiter.h - Arbitrage du wake word entre plusieurs SATOSHI (UDP multicast)
+// Quand un "Satoshi" reveille plusieurs unites, chacune diffuse un score
+// (SNR + energie crete) et seule la meilleure continue vers Whisper/Claude.
+// Le coeur du protocole ne depend pas d'Arduino: il se compile aussi sous
+// Linux pour la simulation multi-noeuds (tools/wake_arbiter_sim).
+#ifndef WAKE_ARBITER_H
+#define WAKE_ARBITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ARBITER_GROUP_IP     239, 255, 42, 10  // Groupe multicast
+#define ARBITER_PORT         42420
+#define ARBITER_WINDOW_MS    150   // Attente des scores des autres unites
+#define ARBITER_RESEND_MS    50    // Re-emission du score (perte de paquets)
+#define ARBITER_MATCH_MS     600   // Ecart max entre detections d'un meme "Satoshi"
+#define ARBITER_HISTORY      8     // Scores recents memorises
+#define ARBITER_PACKET_SIZE  24
+
+// Score diffuse par une unite
+struct WakeClaim {
+    uint32_t deviceId;
+    uint32_t wakeSeq;       // Numero de detection (deduplication)
+    uint16_t snrCentiDb;    // Rapport signal/bruit en 1/100 dB
+    uint32_t peakEnergy;    // Energie RMS crete de la parole
+    uint32_t ageMs;         // Delai detection -> emission
+    uint32_t localTimeMs;   // Heure locale estimee de la detection (reception)
+};
+
+// Transport des paquets (WiFiUDP sur ESP32, socket ou bus simule sous Linux)
+class ArbiterTransport {
+public:
+    virtual ~ArbiterTransport() {}
+    virtual bool send(const uint8_t* data, size_t len) = 0;
+    // Non bloquant: taille du paquet recu, 0 si rien
+    virtual int receive(uint8_t* data, size_t maxLen) = 0;
+};
+
+enum ArbiterResult {
+    ARB_PENDING,  // Fenetre en cours
+    ARB_WON,      // Cette unite repond
+    ARB_LOST      // Une autre unite a un meilleur score
+};
+
+struct ArbiterStats {
+    uint32_t claims;
+    uint32_t won;
+    uint32_t lost;
+    uint32_t packetsIn;
+    uint32_t packetsBad;
+};
+
+class WakeArbiter {
+public:
+    WakeArbiter();
+
+    void begin(ArbiterTransport* transport, uint32_t deviceId);
+    bool isActive() { return transport != nullptr; }
+
+    // A appeler regulierement hors arbitrage: memorise les scores des autres
+    void service(uint32_t nowMs);
+
+    // Oublie les paquets en attente (reprise apres une conversation: leur
+    // heure de reception ne serait plus fiable)
+    void flush();
+
+    // Detection locale: diffuse le score et ouvre la fenetre
+    void startClaim(uint16_t snrCentiDb, uint32_t peakEnergy, uint32_t detectMs, uint32_t nowMs);
+
+    // Traite les paquets et decide a la fin de la fenetre
+    ArbiterResult poll(uint32_t nowMs);
+
+    uint32_t getDeviceId() { return deviceId; }
+    const WakeClaim& getBestRival() { return bestRival; }
+    const ArbiterStats& getStats() { return stats; }
+
+    // Ordre total identique sur toutes les unites (champs du paquet seulement)
+    static bool beats(const WakeClaim& a, const WakeClaim& b);
+
+    // Format du paquet (little endian, independant de l'alignement)
+    static size_t encode(const WakeClaim& claim, uint8_t* out);
+    static bool decode(const uint8_t* data, size_t len, WakeClaim& claim);
+
+    // Score local: SNR en 1/100 dB a partir de l'energie crete et du bruit de fond
+    static uint16_t snrFromEnergy(uint32_t peakEnergy, uint32_t noiseFloor);
+
+private:
+    ArbiterTransport* transport;
+    uint32_t deviceId;
+    uint32_t wakeSeq;
+
+    // Claim local en cours
+    bool claiming;
+    WakeClaim own;
+    uint32_t claimStartMs;
+    uint32_t lastSendMs;
+    bool rivalBetter;
+    WakeClaim bestRival;
+
+    // Scores recus recemment (detections juste avant la notre)
+    WakeClaim history[ARBITER_HISTORY];
+    int historyCount;
+    int historyNext;
+
+    ArbiterStats stats;
+
+    void sendOwn(uint32_t nowMs);
+    void drain(uint32_t nowMs);
+    void consider(const WakeClaim& claim);
+    void remember(const WakeClaim& claim);
+};
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+// Transport WiFiUDP multicast
+class UdpArbiterTransport : public ArbiterTransport {
+public:
+    bool begin();
+    bool send(const uint8_t* data, size_t len) override;
+    int receive(uint8_t* data, size_t maxLen) override;
+
+private:
+    WiFiUDP udp;
+};
+
+// Arbitrage bloquant (au plus ARBITER_WINDOW_MS) - true si cette unite repond
+bool arbitrateWake(uint32_t peakEnergy, uint32_t noiseFloor, unsigned long detectMs);
+
+extern WakeArbiter wakeArbiter;
+extern UdpArbiterTransport arbiterTransport;
+#endif
+
+#endif
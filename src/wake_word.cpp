@@ -4,6 +4,11 @@
 #include "wake_word.h"
 #include "audio.h"  // Pour accéder à i2s_audio
 #include "whisper_api.h"  // Pour transcription
+#include "wake_arbiter.h"  // Arbitrage entre plusieurs unites
+#include "corpus_recorder.h"  // Corpus audio terrain (SD)
+#include "vad.h"  // Energie RMS des frames
+#include "audio_stats.h"  // Lecture instrumentee, latences
+#include "prewarm.h"  // Connexions ouvertes pendant la phrase
 #include <math.h>
 
 WakeWordDetector wakeWord;
@@ -17,6 +22,8 @@ WakeWordDetector::WakeWordDetector() {
     speechFrameCount = 0;
     silenceFrameCount = 0;
     currentLevel = 0;
+    peakEnergy = 0;
+    noiseFloor = ENERGY_THRESHOLD / 4;
     lastDetectionTime = 0;
     speechStartTime = 0;
 }
@@ -73,6 +80,7 @@ void WakeWordDetector::pause() {
     if (listening) {
         listening = false;
         state = WW_IDLE;
+        audioStats.setCaptureActive(false);
     }
 }
 
@@ -84,17 +92,19 @@ void WakeWordDetector::resume() {
             speechFrameCount = 0;
             silenceFrameCount = 0;
             audioSize = 0;
+
+            // Scores recus pendant la conversation: perimes
+            wakeArbiter.flush();
+
+            // Les pertes DMA comptent a nouveau (le micro doit etre lu en continu)
+            audioStats.resync();
+            audioStats.setCaptureActive(true);
         }
     }
 }
 
 int WakeWordDetector::calculateEnergy(int16_t* samples, size_t count) {
-    int64_t sum = 0;
-    for (size_t i = 0; i < count; i++) {
-        int32_t sample = samples[i];
-        sum += sample * sample;
-    }
-    return (int)sqrt((double)(sum / count));
+    return vadFrameEnergy(samples, count);
 }
 
 bool WakeWordDetector::isSpeech(int energy) {
@@ -111,14 +121,17 @@ bool WakeWordDetector::detect() {
     int16_t samples[AUDIO_CHUNK_SIZE];
     size_t bytesRead = 0;
 
-    // Utiliser readBytes de I2SClass
-    bytesRead = i2s_audio.readBytes((char*)samples, sizeof(samples));
+    // Lecture instrumentee (overruns DMA, horodatage des frames)
+    bytesRead = audioStats.read(samples, sizeof(samples));
     if (bytesRead == 0) {
         return false;
     }
 
     size_t sampleCount = bytesRead / sizeof(int16_t);
 
+    // Memoriser les scores des autres unites (detections presque simultanees)
+    wakeArbiter.service(millis());
+
     // Calculer l'énergie
     int energy = calculateEnergy(samples, sampleCount);
     currentLevel = map(energy, 0, 10000, 0, 100);
@@ -134,14 +147,23 @@ bool WakeWordDetector::detect() {
 
                 // Début de parole détecté
                 if (speechFrameCount >= SPEECH_FRAMES_REQUIRED) {
+                    audioStats.markDecision(DECISION_WAKE_ONSET);
+                    prewarmer.onSpeechOnset();
                     Serial.println("Parole détectée - enregistrement...");
                     state = WW_DETECTED;
                     speechStartTime = millis();
                     audioSize = 0;
+                    peakEnergy = energy;
+
+                    corpusRecorder.beginClip(CORPUS_WAKE, ENERGY_THRESHOLD);
+                    corpusRecorder.logVad(VAD_SPEECH_START, energy);
                 }
             } else {
                 speechFrameCount = 0;
                 silenceFrameCount++;
+
+                // Bruit de fond pour le score d'arbitrage
+                noiseFloor = noiseFloor * 0.95f + energy * 0.05f;
             }
             break;
 
@@ -152,27 +174,51 @@ bool WakeWordDetector::detect() {
                 audioSize += bytesRead;
             }
 
+            if (energy > peakEnergy) {
+                peakEnergy = energy;
+            }
+
             if (hasSpeech) {
+                if (silenceFrameCount > 0) {
+                    corpusRecorder.logVad(VAD_RESUME, energy);
+                }
                 silenceFrameCount = 0;
             } else {
                 silenceFrameCount++;
+                if (silenceFrameCount == 1) {
+                    corpusRecorder.logVad(VAD_PAUSE, energy);
+                }
 
                 // Fin de parole (silence prolongé)
                 if (silenceFrameCount >= SILENCE_FRAMES_REQUIRED) {
+                    audioStats.markDecision(DECISION_WAKE_END);
                     unsigned long duration = millis() - speechStartTime;
                     Serial.printf("Fin parole - durée: %lu ms, taille: %d bytes\n",
                                   duration, audioSize);
+                    corpusRecorder.logVad(VAD_END, energy);
+                    corpusRecorder.captureAudio(audioBuffer, audioSize);
 
                     // Vérifier si c'est assez long pour être un wake word
                     // "SATOSHI" prend environ 600-2500ms à prononcer
                     if (duration >= MIN_WAKE_WORD_DURATION && duration <= MAX_WAKE_WORD_DURATION && audioSize > 10000) {
+                        // Plusieurs unites ont entendu: seule la plus proche du locuteur continue
+                        if (!arbitrateWake(peakEnergy, (uint32_t)noiseFloor, millis())) {
+                            corpusRecorder.commitClip("arb_lost");
+                            state = WW_LISTENING;
+                            audioSize = 0;
+                            speechFrameCount = 0;
+                            return false;  // Aucun appel cloud
+                        }
+
                         // Transcrire l'audio avec Whisper pour vérifier le wake word
                         Serial.println("Transcription pour détection wake word...");
                         String transcription;
+                        unsigned long sttStart = millis();
                         // Prompt strict pour guider Whisper vers "Satoshi" uniquement
                         const char* wakeWordPrompt = "Satoshi Nakamoto, hey Satoshi, OK Satoshi";
                         // Utiliser anglais ("en") car "Satoshi" est mieux reconnu en anglais
                         if (whisperAPI.transcribeWithPrompt(audioBuffer, audioSize, transcription, wakeWordPrompt, "en")) {
+                            corpusRecorder.setTranscript(transcription, millis() - sttStart);
                             transcription.toLowerCase();
                             transcription.trim();
                             Serial.printf("Wake word check: \"%s\"\n", transcription.c_str());
@@ -201,7 +247,10 @@ bool WakeWordDetector::detect() {
                                 }
                             }
 
+                            corpusRecorder.commitClip(isWakeWord ? "wake" : "not_wake");
+
                             if (isWakeWord) {
+                                audioStats.markDecision(DECISION_WAKE_CONFIRM);
                                 Serial.println("*** WAKE WORD 'SATOSHI' CONFIRMÉ! ***");
                                 state = WW_CONFIRMED;
                                 lastDetectionTime = millis();
@@ -213,6 +262,8 @@ bool WakeWordDetector::detect() {
                                 speechFrameCount = 0;
                             }
                         } else {
+                            corpusRecorder.setTranscript("", millis() - sttStart);
+                            corpusRecorder.commitClip("stt_error");
                             Serial.println("Erreur transcription wake word");
                             state = WW_LISTENING;
                             audioSize = 0;
@@ -220,6 +271,7 @@ bool WakeWordDetector::detect() {
                         }
                     } else {
                         // Trop court ou trop long, reset
+                        corpusRecorder.commitClip(duration > MAX_WAKE_WORD_DURATION ? "too_long" : "too_short");
                         if (duration < MIN_WAKE_WORD_DURATION) {
                             Serial.printf("Parole trop courte (%lu ms) - ignorée\n", duration);
                         } else if (duration > MAX_WAKE_WORD_DURATION) {
@@ -235,6 +287,9 @@ bool WakeWordDetector::detect() {
             // Timeout si parole trop longue
             if (millis() - speechStartTime > 5000) {
                 Serial.println("Timeout parole - reset");
+                corpusRecorder.logVad(VAD_TIMEOUT, energy);
+                corpusRecorder.captureAudio(audioBuffer, audioSize);
+                corpusRecorder.commitClip("timeout");
                 state = WW_LISTENING;
                 audioSize = 0;
                 speechFrameCount = 0;
@@ -62,6 +62,8 @@ private:
     int speechFrameCount;
     int silenceFrameCount;
     int currentLevel;
+    int peakEnergy;        // Energie crete de la parole en cours
+    float noiseFloor;      // Bruit de fond (moyenne glissante hors parole)
 
     // Timing
     unsigned long lastDetectionTime;
@@ -1,16 +1,88 @@
 // whisper_api.cpp - Implementation API Groq Whisper
 #include "whisper_api.h"
 #include <ArduinoJson.h>
+#include "json_stream.h"
+#include "multipart_writer.h"
+#include "http2_client.h"
 
 WhisperAPI whisperAPI;
 
+// Corps de la reponse HTTP/2, collecte par le sink du flux
+struct WhisperH2Body {
+    char* data;
+    size_t len;
+};
+
+static bool collectH2Body(const uint8_t* data, size_t len, void* arg) {
+    WhisperH2Body* body = (WhisperH2Body*)arg;
+    // Au-dela: tronque, l'erreur JSON le signalera
+    if (body->len + len > WHISPER_H2_BODY_MAX) len = WHISPER_H2_BODY_MAX - body->len;
+    memcpy(body->data + body->len, data, len);
+    body->len += len;
+    return true;
+}
+
+// Transcription sur la connexion HTTP/2 de Groq (partagee avec le TTS).
+// false sans reponse: repli HTTP/1.1, sauf si *cancelFlag.
+static bool transcribeHttp2(MultipartWriter& request, volatile bool* cancelFlag,
+                            const JsonDocument& filter, JsonDocument& doc,
+                            DeserializationError& jsonError, unsigned long timeoutMs) {
+    char auth[160];
+    char contentType[96];
+    snprintf(auth, sizeof(auth), "Bearer %s", configManager.config.groq_key);
+    snprintf(contentType, sizeof(contentType), "multipart/form-data; boundary=%s", request.getBoundary());
+    HpackHeader headers[] = {
+        { "authorization", auth },
+        { "content-type", contentType },
+    };
+
+    WhisperH2Body body;
+    body.data = (char*)malloc(WHISPER_H2_BODY_MAX);
+    body.len = 0;
+    if (!body.data) return false;
+
+    Http2Request req;
+    memset(&req, 0, sizeof(req));
+    req.method = "POST";
+    req.authority = GROQ_HOST;
+    req.path = "/openai/v1/audio/transcriptions";
+    req.headers = headers;
+    req.headerCount = 2;
+    req.contentLength = request.getContentLength();
+    req.weight = WHISPER_H2_WEIGHT;
+    req.sink = collectH2Body;
+    req.arg = &body;
+
+    Http2Call call;
+    bool ok = call.begin(GROQ_HOST, 443, req);
+    if (ok) {
+        Serial.println("Envoi requete HTTP/2...");
+        ok = request.sendBody(call, cancelFlag) && call.finish(timeoutMs, cancelFlag);
+    }
+    if (ok) {
+        jsonError = jsonReader.read(body.data, body.len, doc, &filter, "whisper");
+        Serial.printf("Reponse Groq: HTTP/2 %d, %u octets\n", call.getStatus(), call.getBodyBytes());
+    } else if (!(cancelFlag && *cancelFlag)) {
+        Serial.printf("HTTP/2: %s, repli HTTP/1.1\n", call.getError());
+    }
+    free(body.data);
+    return ok;
+}
+
 WhisperAPI::WhisperAPI() {
-    client = nullptr;
+    initialized = false;
+    specRunning = false;
+    specCancel = false;
+    specSuccess = false;
+    specAudio = nullptr;
+    specSize = 0;
+    specStartTime = 0;
+    specEndTime = 0;
+    memset(&specStats, 0, sizeof(specStats));
 }
 
 void WhisperAPI::begin() {
-    client = new WiFiClientSecure();
-    client->setInsecure();
+    initialized = true;
     Serial.println("Groq Whisper API initialisee");
 }
 
@@ -57,23 +129,38 @@ size_t WhisperAPI::createWavHeader(uint8_t* header, size_t dataSize) {
     return 44;  // Taille du header WAV
 }
 
-bool WhisperAPI::transcribe(const uint8_t* audioData, size_t audioSize, String& transcription) {
-    return transcribeWithPrompt(audioData, audioSize, transcription, nullptr);
+bool WhisperAPI::transcribe(const uint8_t* audioData, size_t audioSize, String& transcription,
+                            TurnBudget* turn) {
+    unsigned long timeoutMs = turn ? turn->timeoutFor(TURN_STT, WHISPER_TIMEOUT_MS) : WHISPER_TIMEOUT_MS;
+    return transcribeWithPrompt(audioData, audioSize, transcription, nullptr, "fr", timeoutMs);
+}
+
+bool WhisperAPI::transcribeWithPrompt(const uint8_t* audioData, size_t audioSize, String& transcription, const char* prompt, const char* language,
+                                      unsigned long timeoutMs) {
+    // Resultat speculatif devenu inutile: liberer sa connexion avant la requete
+    if (specRunning) {
+        cancelSpeculative();
+        waitSpeculativeIdle();
+    }
+    return doTranscribe(audioData, audioSize, transcription, prompt, language, nullptr, lastError, timeoutMs);
 }
 
-bool WhisperAPI::transcribeWithPrompt(const uint8_t* audioData, size_t audioSize, String& transcription, const char* prompt, const char* language) {
-    if (!client) {
-        lastError = "Client non initialise";
+bool WhisperAPI::doTranscribe(const uint8_t* audioData, size_t audioSize, String& transcription,
+                              const char* prompt, const char* language,
+                              volatile bool* cancelFlag, String& error,
+                              unsigned long timeoutMs) {
+    if (!initialized) {
+        error = "Client non initialise";
         return false;
     }
 
     if (strlen(configManager.config.groq_key) == 0) {
-        lastError = "Cle Groq manquante";
+        error = "Cle Groq manquante";
         return false;
     }
 
     if (audioSize < 1000) {
-        lastError = "Audio trop court";
+        error = "Audio trop court";
         return false;
     }
 
@@ -83,118 +170,108 @@ bool WhisperAPI::transcribeWithPrompt(const uint8_t* audioData, size_t audioSize
     uint8_t wavHeader[44];
     createWavHeader(wavHeader, audioSize);
 
-    // Generer un boundary unique
-    String boundary = "----ESP32Boundary" + String(millis());
-
-    // Construire le body multipart
-    String bodyStart = "--" + boundary + "\r\n";
-    bodyStart += "Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n";
-    bodyStart += "Content-Type: audio/wav\r\n\r\n";
-
-    String bodyMiddle = "\r\n--" + boundary + "\r\n";
-    bodyMiddle += "Content-Disposition: form-data; name=\"model\"\r\n\r\n";
-    bodyMiddle += WHISPER_MODEL;
-    bodyMiddle += "\r\n--" + boundary + "\r\n";
-    bodyMiddle += "Content-Disposition: form-data; name=\"language\"\r\n\r\n";
-    bodyMiddle += language;  // Utiliser la langue specifiee
+    // Requete decrite sans copie: en-tetes, parties, WAV header et audio
+    // pointent sur leurs buffers d'origine (voir multipart_writer.h)
+    MultipartWriter request;
+    request.setHead("POST /openai/v1/audio/transcriptions HTTP/1.1\r\n"
+                    "Host: " GROQ_HOST "\r\n"
+                    "Authorization: Bearer %s\r\n", configManager.config.groq_key);
+    request.beginFile("file", "audio.wav", "audio/wav");
+    request.addData(wavHeader, 44);
+    request.addData(audioData, audioSize);
+    request.addField("model", WHISPER_MODEL);
+    request.addField("language", language);
 
     // Ajouter le prompt si fourni (aide Whisper a reconnaitre des mots specifiques)
     if (prompt && strlen(prompt) > 0) {
-        bodyMiddle += "\r\n--" + boundary + "\r\n";
-        bodyMiddle += "Content-Disposition: form-data; name=\"prompt\"\r\n\r\n";
-        bodyMiddle += prompt;
+        request.addField("prompt", prompt);
     }
 
-    bodyMiddle += "\r\n--" + boundary + "--\r\n";
-
-    // Calculer la taille totale
-    size_t totalSize = bodyStart.length() + 44 + audioSize + bodyMiddle.length();
+    if (!request.end()) {
+        error = "Requete trop longue";
+        return false;
+    }
 
-    Serial.printf("Envoi a Groq: %d bytes total\n", totalSize);
+    Serial.printf("Envoi a Groq: %d bytes total\n", request.getContentLength());
 
-    // Connexion
-    Serial.println("Connexion a api.groq.com...");
-    client->setTimeout(60);
+    if (cancelFlag && *cancelFlag) {
+        error = "Annule";
+        return false;
+    }
 
-    if (!client->connect("api.groq.com", 443)) {
-        lastError = "Connexion echouee";
-        Serial.println("ERREUR: Connexion a api.groq.com echouee!");
+    // Socket keep-alive du pool: s'il a ete ferme par le serveur pendant
+    // l'inactivite, la requete est rejouee une fois sur un socket neuf
+    JsonDocument filter;
+    filter["text"] = true;
+    filter["error"]["message"] = true;
+    JsonDocument doc;
+    DeserializationError jsonError;
+    bool received = http2.handles(GROQ_HOST, 443) &&
+                    transcribeHttp2(request, cancelFlag, filter, doc, jsonError, timeoutMs);
+    if (!received && cancelFlag && *cancelFlag) {
+        error = "Annule";
         return false;
     }
-    Serial.println("Connecte a api.groq.com");
-
-    // Envoyer les headers HTTP
-    Serial.println("Envoi requete HTTP...");
-    client->println("POST /openai/v1/audio/transcriptions HTTP/1.1");
-    client->println("Host: api.groq.com");
-    client->print("Authorization: Bearer ");
-    client->println(configManager.config.groq_key);
-    client->print("Content-Type: multipart/form-data; boundary=");
-    client->println(boundary);
-    client->print("Content-Length: ");
-    client->println(totalSize);
-    client->println("Connection: close");
-    client->println();
-
-    // Envoyer le body
-    client->print(bodyStart);
-    client->write(wavHeader, 44);
-
-    // Envoyer l'audio par morceaux
-    size_t offset = 0;
-    size_t chunkSize = 1024;
-    while (offset < audioSize) {
-        size_t toSend = min(chunkSize, audioSize - offset);
-        client->write(audioData + offset, toSend);
-        offset += toSend;
-        yield();
-    }
-
-    client->print(bodyMiddle);
-    Serial.println("Requete envoyee, attente reponse...");
-
-    // Attendre la reponse
-    unsigned long timeout = millis() + 60000;
-    while (client->connected() && !client->available()) {
-        if (millis() > timeout) {
-            lastError = "Timeout";
-            client->stop();
+    for (int attempt = 0; attempt < 2 && !received; attempt++) {
+        PooledClient* client = connectionPool.acquire(GROQ_HOST, 443, attempt > 0);
+        if (!client) {
+            error = "Connexion echouee";
+            Serial.println("ERREUR: Connexion a api.groq.com echouee!");
+            return false;
+        }
+        bool reused = client->wasReused();
+        // Envoi et attente bornes par le budget du tour (60 s hors tour)
+        client->setTimeout((timeoutMs + 999) / 1000);
+
+        // En-tetes, corps et audio en records TLS de 16 Ko
+        Serial.println("Envoi requete HTTP...");
+        if (!request.send(*client, cancelFlag)) {
+            connectionPool.release(client, false);
+            if (cancelFlag && *cancelFlag) {
+                error = "Annule";
+                return false;
+            }
+            if (reused) continue;
+            error = "Envoi echoue";
             return false;
         }
-        delay(10);
-    }
 
-    // Lire la reponse
-    String response = "";
-    bool headersDone = false;
+        Serial.println("Requete envoyee, attente reponse...");
 
-    while (client->available()) {
-        String line = client->readStringUntil('\n');
-        if (!headersDone) {
-            if (line == "\r") {
-                headersDone = true;
+        // Statut et en-tetes: attente interruptible (annulation, timeout)
+        HttpResponseReader reader(*client, timeoutMs);
+        reader.setCancelFlag(cancelFlag);
+        if (!reader.readHeaders()) {
+            connectionPool.release(client, false);
+            if (reader.wasCancelled()) {
+                error = "Annule";
+                return false;
             }
-        } else {
-            response += line;
+            // Ferme sans reponse: socket perime
+            if (reader.isStale() && reused) continue;
+            error = reader.isStale() ? "Connexion fermee" : reader.getError();
+            return false;
         }
-    }
-
-    client->stop();
 
-    Serial.println("Reponse Groq:");
-    Serial.println(response);
+        // Corps JSON lu en flux: seuls text et error.message sont alloues
+        jsonError = jsonReader.read(reader, doc, &filter, "whisper");
+        connectionPool.release(client, !jsonError && reader.canReuse());
+        Serial.printf("Reponse Groq: HTTP %d, %u octets\n", reader.getStatus(), reader.getBodyBytes());
+        received = true;
+    }
 
-    // Parser la reponse JSON
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
+    if (!received) {
+        error = "Connexion perdue";
+        return false;
+    }
 
-    if (error) {
-        lastError = "Erreur JSON: " + String(error.c_str());
+    if (jsonError) {
+        error = "Erreur JSON: " + String(jsonError.c_str());
         return false;
     }
 
     if (doc["error"].is<JsonObject>()) {
-        lastError = doc["error"]["message"].as<String>();
+        error = doc["error"]["message"].as<String>();
         return false;
     }
 
@@ -204,6 +281,125 @@ bool WhisperAPI::transcribeWithPrompt(const uint8_t* audioData, size_t audioSize
         return true;
     }
 
-    lastError = "Format de reponse invalide";
+    error = "Format de reponse invalide";
     return false;
 }
+
+// ============================================================
+// Transcription speculative
+// ============================================================
+
+void WhisperAPI::speculativeTask(void* param) {
+    WhisperAPI* self = (WhisperAPI*)param;
+
+    String result;
+    String error;
+    bool ok = self->doTranscribe(self->specAudio, self->specSize, result,
+                                 nullptr, "fr", &self->specCancel, error);
+
+    self->specResult = result;
+    self->specError = error;
+    self->specEndTime = millis();
+    self->specSuccess = ok && !self->specCancel;
+
+    // Signaler la fin en dernier: le resultat est lisible des que specRunning == false
+    self->specRunning = false;
+    vTaskDelete(nullptr);
+}
+
+bool WhisperAPI::startSpeculative(const uint8_t* audioData, size_t audioSize) {
+    // Une requete precedente (annulee) est encore en train de se terminer
+    if (specRunning) return false;
+    if (!initialized || audioSize < 1000) return false;
+
+    specAudio = audioData;
+    specSize = audioSize;
+    specCancel = false;
+    specSuccess = false;
+    specResult = "";
+    specError = "";
+    specStartTime = millis();
+    specEndTime = 0;
+    specRunning = true;
+
+    // Core 0 (avec la pile WiFi), la capture I2S reste sur la loop (core 1)
+    if (xTaskCreatePinnedToCore(speculativeTask, "stt_spec", 10240, this, 1, nullptr, 0) != pdPASS) {
+        Serial.println("STT speculatif: creation tache echouee");
+        specRunning = false;
+        specStartTime = 0;
+        return false;
+    }
+    specStats.launched++;
+
+    Serial.printf("STT speculatif lance: %d bytes\n", audioSize);
+    return true;
+}
+
+void WhisperAPI::cancelSpeculative() {
+    if (!specRunning || specCancel) return;
+
+    specCancel = true;
+    specStats.cancelled++;
+    specStats.bytesWasted += specSize;
+    Serial.println("STT speculatif annule (reprise de parole)");
+}
+
+void WhisperAPI::waitSpeculativeIdle() {
+    while (specRunning) {
+        delay(5);
+    }
+}
+
+bool WhisperAPI::finishSpeculative(String& transcription, unsigned long waitMs) {
+    // Aucune requete valide (jamais lancee ou annulee)
+    if (specStartTime == 0 || specCancel) {
+        waitSpeculativeIdle();
+        specStartTime = 0;
+        return false;
+    }
+
+    unsigned long endpointTime = millis();
+    while (specRunning && millis() - endpointTime < waitMs) {
+        delay(5);
+    }
+
+    if (specRunning) {
+        // Trop long: abandonner et laisser la requete normale prendre le relais
+        cancelSpeculative();
+        waitSpeculativeIdle();
+        specStartTime = 0;
+        specStats.misses++;
+        return false;
+    }
+
+    if (!specSuccess) {
+        Serial.println("STT speculatif en erreur: " + specError);
+        specStats.misses++;
+        specStats.bytesWasted += specSize;
+        specStartTime = 0;
+        return false;
+    }
+
+    // Temps gagne: portion de la requete deja ecoulee a la fin de parole
+    unsigned long requestDuration = specEndTime - specStartTime;
+    unsigned long saved = endpointTime - specStartTime;
+    if (saved > requestDuration) saved = requestDuration;
+    specStartTime = 0;
+
+    specStats.hits++;
+    specStats.msSaved += saved;
+    transcription = specResult;
+
+    Serial.printf("STT speculatif utilise (%lu ms gagnes)\n", saved);
+    return true;
+}
+
+void WhisperAPI::printSpeculativeStats() {
+    Serial.println("=== STT SPECULATIF ===");
+    Serial.printf("Lances: %u, annules: %u, utilises: %u, rates: %u\n",
+                  specStats.launched, specStats.cancelled, specStats.hits, specStats.misses);
+    Serial.printf("Audio envoye pour rien: %u bytes\n", specStats.bytesWasted);
+    Serial.printf("Latence economisee: %u ms (moy. %u ms)\n", specStats.msSaved,
+                  specStats.hits > 0 ? specStats.msSaved / specStats.hits : 0);
+    Serial.println("======================");
+}
@@ -3,14 +3,30 @@
 #define WHISPER_API_H
 
 #include <Arduino.h>
-#include <WiFiClientSecure.h>
 #include <HTTPClient.h>
 #include "config.h"
+#include "connection_pool.h"
+#include "turn_budget.h"
 
 // Groq API (compatible Whisper, gratuit avec premium)
 #define GROQ_API_URL "https://api.groq.com/openai/v1/audio/transcriptions"
+#define GROQ_HOST "api.groq.com"
 // Whisper large-v3-turbo: 8x plus rapide que large-v3, qualite similaire
 #define WHISPER_MODEL "whisper-large-v3-turbo"
+#define WHISPER_TIMEOUT_MS 60000    // Hors tour vocal (sinon TurnBudget)
+// HTTP/2: la transcription passe avant le TTS sur la connexion partagee
+#define WHISPER_H2_WEIGHT 256
+#define WHISPER_H2_BODY_MAX 4096    // Reponse JSON (texte transcrit)
+
+// Statistiques de la transcription speculative (lancee sur pause courte)
+struct SpeculativeSTTStats {
+    uint32_t launched;      // Requetes speculatives lancees
+    uint32_t cancelled;     // Annulees (reprise de parole)
+    uint32_t hits;          // Resultat speculatif utilise
+    uint32_t misses;        // Resultat absent ou en erreur -> requete normale
+    uint32_t bytesWasted;   // Audio envoye pour rien (requetes annulees/ratees)
+    uint32_t msSaved;       // Latence STT economisee (cumul)
+};
 
 class WhisperAPI {
 public:
@@ -19,17 +35,53 @@ public:
     void begin();
 
     // Transcrire l'audio en texte (francais par defaut)
-    bool transcribe(const uint8_t* audioData, size_t audioSize, String& transcription);
+    // turn: timeouts tires du budget du tour vocal (nullptr: WHISPER_TIMEOUT_MS)
+    bool transcribe(const uint8_t* audioData, size_t audioSize, String& transcription,
+                    TurnBudget* turn = nullptr);
 
     // Transcrire avec un prompt hint et langue specifiee (pour wake word)
-    bool transcribeWithPrompt(const uint8_t* audioData, size_t audioSize, String& transcription, const char* prompt, const char* language = "fr");
+    bool transcribeWithPrompt(const uint8_t* audioData, size_t audioSize, String& transcription, const char* prompt, const char* language = "fr",
+                              unsigned long timeoutMs = WHISPER_TIMEOUT_MS);
+
+    // === Transcription speculative ===
+    // Lance la transcription en tache de fond pendant que la capture continue.
+    // L'audio doit rester valide (seul l'ajout en fin de buffer est permis).
+    bool startSpeculative(const uint8_t* audioData, size_t audioSize);
+    // Annule la requete en cours (non bloquant, la tache se termine seule)
+    void cancelSpeculative();
+    bool isSpeculativeBusy() { return specRunning; }
+    // Recupere le resultat speculatif (attend la fin de la requete si besoin)
+    bool finishSpeculative(String& transcription, unsigned long waitMs = 30000);
+    SpeculativeSTTStats getSpeculativeStats() { return specStats; }
+    void printSpeculativeStats();
 
     String getLastError() { return lastError; }
 
 private:
-    WiFiClientSecure* client;
+    bool initialized;
     String lastError;
 
+    // Etat de la requete speculative (partage avec la tache de fond)
+    volatile bool specRunning;
+    volatile bool specCancel;
+    volatile bool specSuccess;
+    const uint8_t* specAudio;
+    size_t specSize;
+    String specResult;
+    String specError;
+    unsigned long specStartTime;
+    unsigned long specEndTime;
+    SpeculativeSTTStats specStats;
+
+    static void speculativeTask(void* param);
+    void waitSpeculativeIdle();
+
+    // Requete Groq complete, interruptible via cancelFlag
+    bool doTranscribe(const uint8_t* audioData, size_t audioSize, String& transcription,
+                      const char* prompt, const char* language,
+                      volatile bool* cancelFlag, String& error,
+                      unsigned long timeoutMs = WHISPER_TIMEOUT_MS);
+
     // Creer un fichier WAV en memoire
     size_t createWavHeader(uint8_t* header, size_t dataSize);
 };
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# gen_ca_bundle.py - Genere src/ca_bundle.h (bundle CA compact en flash)
+# Format x509_crt_bundle d'ESP-IDF (esp_crt_bundle.c, repris par
+# NetworkClientSecure::setCACertBundle):
+#   nb_certs (2 octets BE), puis pour chaque racine triee par sujet DER:
+#   len_sujet (2), len_cle (2), sujet DER, SubjectPublicKeyInfo DER
+# Seuls le sujet et la cle publique sont gardes: ~300 octets par racine
+# au lieu de ~1,4 Ko pour le certificat complet.
+#
+# Usage (depuis tools/ca_bundle):
+#   python3 gen_ca_bundle.py roots/*.pem > ../../src/ca_bundle.h
+# Sans dependance: lecture DER minimale, python3 standard suffit.
+import base64
+import os
+import struct
+import sys
+
+
+def read_tlv(data, pos):
+    tag = data[pos]
+    length = data[pos + 1]
+    header = 2
+    if length & 0x80:
+        count = length & 0x7F
+        length = int.from_bytes(data[pos + 2:pos + 2 + count], 'big')
+        header += count
+    return tag, pos + header, pos + header + length
+
+
+def children(data, start, end):
+    items = []
+    pos = start
+    while pos < end:
+        tag, body, nxt = read_tlv(data, pos)
+        items.append((tag, pos, body, nxt))
+        pos = nxt
+    return items
+
+
+def subject_and_key(der):
+    # Certificate -> tbsCertificate -> [version] serial sigAlg issuer validity subject spki
+    _, cert_body, cert_end = read_tlv(der, 0)
+    _, tbs_body, tbs_end = read_tlv(der, cert_body)
+    fields = children(der, tbs_body, tbs_end)
+    if fields[0][0] == 0xA0:
+        fields = fields[1:]
+    subject = fields[4]
+    spki = fields[5]
+    return der[subject[1]:subject[3]], der[spki[1]:spki[3]]
+
+
+def load_pem(path):
+    with open(path) as f:
+        text = f.read()
+    certs = []
+    for block in text.split('-----BEGIN CERTIFICATE-----')[1:]:
+        b64 = block.split('-----END CERTIFICATE-----')[0]
+        certs.append(base64.b64decode(''.join(b64.split())))
+    return certs
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit('usage: gen_ca_bundle.py racine.pem ...')
+
+    entries = []
+    names = []
+    for path in sys.argv[1:]:
+        for der in load_pem(path):
+            entries.append(subject_and_key(der))
+            names.append(os.path.splitext(os.path.basename(path))[0])
+
+    # Recherche dichotomique sur le sujet cote firmware: tri obligatoire
+    order = sorted(range(len(entries)), key=lambda i: entries[i][0])
+
+    bundle = struct.pack('>H', len(entries))
+    for i in order:
+        subject, key = entries[i]
+        bundle += struct.pack('>HH', len(subject), len(key)) + subject + key
+
+    out = sys.stdout
+    out.write('// ca_bundle.h - Racines CA compactes (genere par tools/ca_bundle/gen_ca_bundle.py)\n')
+    out.write('// Ne pas modifier a la main: ajouter le .pem dans tools/ca_bundle/roots\n')
+    out.write('// puis regenerer.\n')
+    for i in order:
+        out.write('//   %s\n' % names[i])
+    out.write('// const: reste en flash (rodata), pas de copie en RAM\n')
+    out.write('#ifndef CA_BUNDLE_H\n#define CA_BUNDLE_H\n\n#include <Arduino.h>\n\n')
+    out.write('#define CA_BUNDLE_CERTS %d\n\n' % len(entries))
+    out.write('static const uint8_t CA_BUNDLE[] = {\n')
+    for pos in range(0, len(bundle), 16):
+        chunk = bundle[pos:pos + 16]
+        out.write('    ' + ', '.join('0x%02x' % b for b in chunk) + ',\n')
+    out.write('};\n\n#endif\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,360 @@
+// http_replay.cpp - Rejeu PC de reponses HTTP enregistrees
+// Compile le meme automate que le firmware (src/http_response.cpp) et lui
+// fait lire des reponses brutes (statut + en-tetes + corps, tels que recus
+// sur le socket) decoupees de plusieurs facons: d'un bloc, octet par
+// octet, en blocs de 7, en enregistrements TLS (1436) et aleatoirement.
+// Chaque decoupage doit donner le resultat attendu.
+//
+// Build (depuis tools/http_replay):
+//   g++ -std=c++17 -O2 -I../../src -o http_replay http_replay.cpp ../../src/http_response.cpp
+//
+// Usage:
+//   http_replay [fichiers.http|dossiers]  verifie les reponses (defaut: responses/)
+//   http_replay --bench [MO]         debit de l'automate (defaut 8 Mo)
+//
+// Attendu, a cote de chaque reponse: <nom>.expect, lignes cle=valeur
+//   status, complete (0/1), error (0/1), keepalive, chunked, body_len,
+//   body_fnv (FNV-1a 32 bits du corps decode, hexa), leftover (octets
+//   apres la fin du message), header.<nom>=valeur (en-tete ou trailer)
+// Code retour 0 si toutes les reponses passent.
+#include "http_response.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define WATCH_VALUE_MAX 64
+
+static uint32_t fnv1a(uint32_t hash, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+struct BodyCapture {
+    uint32_t fnv = 2166136261u;
+    size_t len = 0;
+};
+
+static bool captureSink(const uint8_t* data, size_t len, void* arg) {
+    BodyCapture* body = (BodyCapture*)arg;
+    body->fnv = fnv1a(body->fnv, data, len);
+    body->len += len;
+    return true;
+}
+
+static std::vector<uint8_t> readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+static std::map<std::string, std::string> readExpect(const std::string& path) {
+    std::map<std::string, std::string> expect;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        expect[line.substr(0, eq)] = line.substr(eq + 1);
+    }
+    return expect;
+}
+
+// Rejoue la reponse avec des blocs de taille donnee par nextSize()
+template <typename SizeFn>
+static std::map<std::string, std::string> replay(const std::vector<uint8_t>& raw,
+                                                 const std::vector<std::string>& watchNames,
+                                                 SizeFn nextSize) {
+    HttpResponseParser parser;
+    BodyCapture body;
+    char values[HTTP_WATCH_MAX][WATCH_VALUE_MAX];
+    for (size_t i = 0; i < watchNames.size() && i < HTTP_WATCH_MAX; i++) {
+        parser.watchHeader(watchNames[i].c_str(), values[i], WATCH_VALUE_MAX);
+    }
+
+    size_t pos = 0;
+    size_t leftover = 0;
+    while (pos < raw.size()) {
+        size_t n = nextSize();
+        if (n > raw.size() - pos) n = raw.size() - pos;
+
+        // Comme HttpResponseReader: rappeler feed() avec le reste du bloc
+        size_t off = 0;
+        while (off < n) {
+            if (parser.headersDone() && !parser.isComplete() && !parser.hasError()) {
+                parser.setSink(captureSink, &body);
+            }
+            size_t used = parser.feed(raw.data() + pos + off, n - off);
+            off += used;
+            if (parser.isComplete() || parser.hasError()) break;
+        }
+        if (parser.isComplete() || parser.hasError()) {
+            leftover = raw.size() - pos - off;
+            break;
+        }
+        pos += n;
+    }
+    // Fin du fichier = fermeture du socket par le serveur
+    if (!parser.isComplete() && !parser.hasError()) parser.finish();
+
+    std::map<std::string, std::string> got;
+    char hex[16];
+    snprintf(hex, sizeof(hex), "%08x", body.fnv);
+    got["status"] = std::to_string(parser.getStatus());
+    got["complete"] = parser.isComplete() ? "1" : "0";
+    got["error"] = parser.hasError() ? "1" : "0";
+    got["keepalive"] = parser.isKeepAlive() ? "1" : "0";
+    got["chunked"] = parser.isChunked() ? "1" : "0";
+    got["body_len"] = std::to_string(body.len);
+    got["body_fnv"] = hex;
+    got["leftover"] = std::to_string(leftover);
+    for (size_t i = 0; i < watchNames.size() && i < HTTP_WATCH_MAX; i++) {
+        got["header." + watchNames[i]] = values[i];
+    }
+    if (parser.hasError()) got["reason"] = parser.getError();
+    return got;
+}
+
+static bool endsWith(const std::string& text, const char* suffix) {
+    size_t n = strlen(suffix);
+    return text.size() > n && text.compare(text.size() - n, n, suffix) == 0;
+}
+
+// Reponses *.http d'un dossier, triees. false si le dossier est illisible.
+static bool listResponses(const std::string& dirPath, std::vector<std::string>& files) {
+    DIR* dir = opendir(dirPath.c_str());
+    if (!dir) return false;
+    std::string prefix = dirPath.back() == '/' ? dirPath : dirPath + "/";
+    std::vector<std::string> found;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (endsWith(name, ".http")) found.push_back(prefix + name);
+    }
+    closedir(dir);
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+    return true;
+}
+
+static bool checkFile(const std::string& path) {
+    std::string base = path.substr(0, path.size() - 5);
+    std::vector<uint8_t> raw = readFile(path);
+    std::map<std::string, std::string> expect = readExpect(base + ".expect");
+    if (raw.empty() || expect.empty()) {
+        printf("%-36s ILLISIBLE (reponse ou .expect manquant)\n", path.c_str());
+        return false;
+    }
+
+    std::vector<std::string> watchNames;
+    for (auto& kv : expect) {
+        if (kv.first.compare(0, 7, "header.") == 0) watchNames.push_back(kv.first.substr(7));
+    }
+
+    std::mt19937 rng(1234);
+    struct Split {
+        const char* name;
+        std::function<size_t()> next;
+    };
+    std::vector<Split> splits = {
+        { "bloc", [&]() { return raw.size(); } },
+        { "octet", []() { return (size_t)1; } },
+        { "7", []() { return (size_t)7; } },
+        { "tls", []() { return (size_t)1436; } },
+        { "alea", [&]() { return (size_t)(1 + rng() % 300); } },
+    };
+
+    bool ok = true;
+    std::string failures;
+    for (auto& split : splits) {
+        std::map<std::string, std::string> got = replay(raw, watchNames, split.next);
+        for (auto& kv : expect) {
+            auto it = got.find(kv.first);
+            std::string value = it == got.end() ? "?" : it->second;
+            if (value != kv.second) {
+                ok = false;
+                failures += std::string("  [") + split.name + "] " + kv.first + ": attendu " +
+                            kv.second + ", obtenu " + value + "\n";
+            }
+        }
+    }
+
+    printf("%-36s %s\n", path.c_str(), ok ? "OK" : "ECHEC");
+    if (!ok) printf("%s", failures.c_str());
+    return ok;
+}
+
+// ============================================================
+// Debit
+// ============================================================
+
+// Sink type tampon audio: copie dans un buffer (circulaire ici)
+struct BenchTarget {
+    std::vector<uint8_t> buffer = std::vector<uint8_t>(1 << 20);
+    size_t total = 0;
+};
+
+static bool copySink(const uint8_t* data, size_t len, void* arg) {
+    BenchTarget* target = (BenchTarget*)arg;
+    size_t at = target->total % target->buffer.size();
+    size_t n = std::min(len, target->buffer.size() - at);
+    memcpy(target->buffer.data() + at, data, n);
+    memcpy(target->buffer.data(), data + n, len - n);
+    target->total += len;
+    return true;
+}
+
+static std::vector<uint8_t> syntheticResponse(size_t bodySize, bool chunked, size_t chunkSize) {
+    std::string head = "HTTP/1.1 200 OK\r\nContent-Type: audio/wav\r\nServer: bench\r\n";
+    if (chunked) head += "Transfer-Encoding: chunked\r\n\r\n";
+    else head += "Content-Length: " + std::to_string(bodySize) + "\r\n\r\n";
+
+    std::vector<uint8_t> out(head.begin(), head.end());
+    std::mt19937 rng(42);
+    size_t written = 0;
+    while (written < bodySize) {
+        size_t n = chunked ? std::min(chunkSize, bodySize - written) : bodySize - written;
+        if (chunked) {
+            char line[16];
+            snprintf(line, sizeof(line), "%zx\r\n", n);
+            out.insert(out.end(), line, line + strlen(line));
+        }
+        for (size_t i = 0; i < n; i++) out.push_back((uint8_t)rng());
+        if (chunked) {
+            out.push_back('\r');
+            out.push_back('\n');
+        }
+        written += n;
+    }
+    if (chunked) {
+        const char* last = "0\r\n\r\n";
+        out.insert(out.end(), last, last + 5);
+    }
+    return out;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchOne(const char* label, const std::vector<uint8_t>& raw, size_t slice, size_t bodySize) {
+    const int runs = 5;
+    double best = 1e9;
+    for (int r = 0; r < runs; r++) {
+        auto start = std::chrono::steady_clock::now();
+        HttpResponseParser parser;
+        BenchTarget target;
+        size_t pos = 0;
+        while (pos < raw.size() && !parser.isComplete()) {
+            size_t n = std::min(slice, raw.size() - pos);
+            size_t off = 0;
+            while (off < n && !parser.isComplete() && !parser.hasError()) {
+                if (parser.headersDone()) parser.setSink(copySink, &target);
+                off += parser.feed(raw.data() + pos + off, n - off);
+            }
+            pos += n;
+        }
+        double s = secondsSince(start);
+        if (s < best) best = s;
+        if (target.total != bodySize || !parser.isComplete()) {
+            printf("%-34s ERREUR (%zu/%zu octets)\n", label, target.total, bodySize);
+            return;
+        }
+    }
+    printf("%-34s %8.1f Mo/s\n", label, bodySize / best / 1e6);
+}
+
+// Ancien chemin: body += (char)c octet par octet dans une String
+static void benchLegacy(const std::vector<uint8_t>& raw, size_t bodySize) {
+    auto start = std::chrono::steady_clock::now();
+    std::string headers;
+    size_t pos = 0;
+    std::string lineText;
+    while (pos < raw.size()) {
+        char c = raw[pos++];
+        if (c == '\n') {
+            if (lineText == "\r" || lineText.empty()) break;
+            headers += lineText + "\n";
+            lineText.clear();
+        } else {
+            lineText += c;
+        }
+    }
+    size_t idx = headers.find("Content-Length: ");
+    long length = idx == std::string::npos ? -1 : atol(headers.c_str() + idx + 16);
+    std::string body;
+    body.reserve(length > 0 ? length : 0);
+    while (pos < raw.size() && (long)body.size() < length) body += (char)raw[pos++];
+    double s = secondsSince(start);
+    printf("%-34s %8.1f Mo/s (corps en RAM: %zu octets)\n", "ancien: String octet par octet",
+           bodySize / s / 1e6, body.size());
+}
+
+static void bench(size_t megabytes) {
+    size_t bodySize = megabytes * 1000000;
+    std::vector<uint8_t> plain = syntheticResponse(bodySize, false, 0);
+    std::vector<uint8_t> chunked4k = syntheticResponse(bodySize, true, 4096);
+    std::vector<uint8_t> chunked256 = syntheticResponse(bodySize, true, 256);
+
+    printf("Corps de %zu Mo, meilleur de 5 passes\n", megabytes);
+    benchOne("Content-Length, blocs 512", plain, HTTP_READ_CHUNK, bodySize);
+    benchOne("Content-Length, blocs 1436", plain, 1436, bodySize);
+    benchOne("chunked 4 Ko, blocs 512", chunked4k, HTTP_READ_CHUNK, bodySize);
+    benchOne("chunked 256 o, blocs 512", chunked256, HTTP_READ_CHUNK, bodySize);
+    benchOne("chunked 4 Ko, octet par octet", chunked4k, 1, bodySize);
+    benchLegacy(plain, bodySize);
+}
+
+static int usage(const char* arg, const char* reason) {
+    printf("%s: %s\n", arg, reason);
+    printf("Usage: http_replay [fichiers.http|dossiers]  (defaut: responses/)\n");
+    printf("       http_replay --bench [MO]\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            size_t mb = (i + 1 < argc) ? (size_t)atoi(argv[i + 1]) : 8;
+            bench(mb > 0 ? mb : 8);
+            return 0;
+        }
+        // Dossier: ses reponses *.http; fichier: une reponse .http
+        struct stat st;
+        if (stat(argv[i], &st) != 0) return usage(argv[i], "introuvable");
+        if (S_ISDIR(st.st_mode)) {
+            if (!listResponses(argv[i], files)) return usage(argv[i], "dossier illisible");
+        } else if (S_ISREG(st.st_mode) && endsWith(argv[i], ".http")) {
+            files.push_back(argv[i]);
+        } else {
+            return usage(argv[i], "ni dossier ni reponse .http");
+        }
+    }
+
+    if (argc == 1 && !listResponses("responses", files)) {
+        printf("Dossier responses/ introuvable (lancer depuis tools/http_replay)\n");
+        return 1;
+    }
+
+    int failed = 0;
+    for (auto& path : files) {
+        if (!checkFile(path)) failed++;
+    }
+    printf("%zu reponses, %d en echec\n", files.size(), failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,593 @@
+// replay_bench.cpp - Banc de rejeu PC du front-end audio
+// Lie le vrai WakeWordDetector (src/wake_word.cpp), la VAD de commande
+// (src/vad.cpp) et l'arbitrage (src/wake_arbiter.cpp) derriere un
+// I2SClass::readBytes simule qui lit des fichiers WAV.
+//
+// Build (depuis tools/replay_bench):
+//   g++ -std=gnu++17 -O2 -DARDUINO=10800 -Ishim -I../../src -o replay_bench replay_bench.cpp
+//       ../../src/wake_word.cpp ../../src/vad.cpp ../../src/wake_arbiter.cpp
+//
+// Usage:
+//   replay_bench [options] fichier.wav|dossier ...
+//     --mode wake|command|auto  auto: "_command" dans le nom (fichiers du corpus SD)
+//     --realtime                lecture au rythme reel (defaut: vitesse max)
+//     --silence MS              silence de fin de commande (defaut 800)
+//     --pause MS                pause courte STT speculatif (defaut SPECULATIVE_STT_PAUSE_MS)
+//     --assume-wake             Whisper simule repond "satoshi" a chaque appel
+//     --verbose                 logs Serial du firmware
+//
+// Verite terrain (optionnelle), a cote du WAV:
+//   <nom>.txt   labels Audacity "debut<TAB>fin<TAB>texte" en secondes
+//               (texte contenant "satoshi" = wake word attendu)
+//   <nom>.json  annexe du corpus SD (transcription Whisper d'origine)
+#include <Arduino.h>
+#include <ESP_I2S.h>
+#include <WiFi.h>
+#include "config.h"
+#include "wake_word.h"
+#include "whisper_api.h"
+#include "corpus_recorder.h"
+#include "audio_stats.h"
+#include "vad.h"
+#include "prewarm.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ============================================================
+// Environnement simule
+// ============================================================
+
+HardwareSerial Serial;
+WiFiClass WiFi;
+I2SClass i2s_audio;
+
+static uint64_t virtualUs = 0;     // Horloge virtuelle (avance avec l'audio lu)
+static bool realtime = false;
+static uint64_t wallStartUs = 0;
+
+static std::vector<int16_t> feed;  // Audio du fichier en cours
+static size_t feedPos = 0;
+
+static uint64_t wallUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static double cpuSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void advance(uint64_t us) {
+    virtualUs += us;
+    if (realtime) {
+        // Rythme reel: attendre que l'horloge murale rattrape l'audio
+        uint64_t target = wallStartUs + virtualUs;
+        uint64_t now = wallUs();
+        if (target > now) {
+            struct timespec ts = { (time_t)((target - now) / 1000000), (long)((target - now) % 1000000) * 1000 };
+            nanosleep(&ts, nullptr);
+        }
+    }
+}
+
+unsigned long millis() { return (unsigned long)(virtualUs / 1000); }
+unsigned long micros() { return (unsigned long)virtualUs; }
+void delay(unsigned long ms) { advance((uint64_t)ms * 1000); }
+
+size_t I2SClass::readBytes(char* buffer, size_t size) {
+    size_t samples = std::min(size / 2, feed.size() - feedPos);
+    if (samples == 0) return 0;
+    memcpy(buffer, feed.data() + feedPos, samples * 2);
+    feedPos += samples;
+    advance((uint64_t)samples * 1000000ULL / AUDIO_SAMPLE_RATE);
+    return samples * 2;
+}
+
+static bool feedDone() {
+    return feedPos >= feed.size();
+}
+
+// ============================================================
+// Verite terrain
+// ============================================================
+
+struct Label {
+    double startMs;
+    double endMs;
+    std::string text;
+    bool wake;
+    bool hit;  // Wake word accepte / commande terminee sur ce label
+};
+
+static std::vector<Label> labels;
+static std::string corpusTranscript;  // Transcription Whisper d'origine (annexe corpus)
+static bool assumeWake = false;
+
+static std::string lower(std::string s) {
+    for (auto& c : s) c = tolower((unsigned char)c);
+    return s;
+}
+
+static double overlap(double a0, double a1, double b0, double b1) {
+    return std::max(0.0, std::min(a1, b1) - std::max(a0, b0));
+}
+
+// Label le plus recouvert par [startMs, endMs], -1 si aucun
+static int bestLabel(double startMs, double endMs) {
+    int best = -1;
+    double bestOverlap = 0;
+    for (size_t i = 0; i < labels.size(); i++) {
+        double o = overlap(startMs, endMs, labels[i].startMs, labels[i].endMs);
+        if (o > bestOverlap) {
+            bestOverlap = o;
+            best = (int)i;
+        }
+    }
+    return best;
+}
+
+static void loadLabels(const std::string& base) {
+    labels.clear();
+    corpusTranscript.clear();
+
+    std::ifstream txt(base + ".txt");
+    std::string line;
+    while (std::getline(txt, line)) {
+        std::istringstream in(line);
+        double s, e;
+        if (!(in >> s >> e)) continue;
+        std::string text;
+        std::getline(in, text);
+        text.erase(0, text.find_first_not_of(" \t"));
+        labels.push_back({ s * 1000, e * 1000, text, lower(text).find("satoshi") != std::string::npos, false });
+    }
+
+    // Annexe corpus: on ne lit que "transcript" (texte JSON simple)
+    std::ifstream json(base + ".json");
+    std::string doc((std::istreambuf_iterator<char>(json)), std::istreambuf_iterator<char>());
+    size_t p = doc.find("\"transcript\":\"");
+    if (p != std::string::npos) {
+        for (p += 14; p < doc.size() && doc[p] != '"'; p++) {
+            if (doc[p] == '\\' && p + 1 < doc.size()) p++;
+            corpusTranscript += doc[p];
+        }
+    }
+}
+
+// ============================================================
+// Whisper simule: compte les appels, repond selon la verite terrain
+// ============================================================
+
+static int sttCalls = 0;
+
+WhisperAPI whisperAPI;
+
+WhisperAPI::WhisperAPI() {
+    initialized = true;
+    specRunning = false;
+    specCancel = false;
+    specSuccess = false;
+    specAudio = nullptr;
+    specSize = 0;
+    specStartTime = 0;
+    specEndTime = 0;
+    memset(&specStats, 0, sizeof(specStats));
+}
+
+bool WhisperAPI::transcribeWithPrompt(const uint8_t*, size_t audioSize, String& transcription,
+                                      const char*, const char*, unsigned long) {
+    sttCalls++;
+
+    double endMs = virtualUs / 1000.0;
+    double startMs = endMs - audioSize / 2 * 1000.0 / AUDIO_SAMPLE_RATE;
+    int l = bestLabel(startMs, endMs);
+
+    if (assumeWake) transcription = "satoshi";
+    else if (l >= 0) transcription = labels[l].text.c_str();
+    else transcription = corpusTranscript.c_str();
+    return true;
+}
+
+// ============================================================
+// Corpus simule: les issues des candidats wake word sont comptees ici
+// ============================================================
+
+struct WakeDecision {
+    std::string outcome;
+    double startMs;
+    double endMs;
+};
+
+static std::vector<WakeDecision> decisions;
+static double clipStartMs = 0;
+static double clipEndMs = 0;
+
+CorpusRecorder corpusRecorder;
+
+CorpusRecorder::CorpusRecorder() {
+    enabled = true;
+    mounted = true;
+    current = nullptr;
+}
+
+void CorpusRecorder::beginClip(CorpusSource, int) {
+    clipStartMs = clipEndMs = virtualUs / 1000.0;
+}
+
+void CorpusRecorder::logVad(CorpusVadEvent, int) {}
+
+void CorpusRecorder::captureAudio(const uint8_t*, size_t) {
+    clipEndMs = virtualUs / 1000.0;
+}
+
+void CorpusRecorder::setTranscript(const String&, unsigned long, bool) {}
+
+void CorpusRecorder::commitClip(const char* outcome) {
+    if (clipEndMs <= clipStartMs) clipEndMs = virtualUs / 1000.0;
+    decisions.push_back({ outcome, clipStartMs, clipEndMs });
+}
+
+void CorpusRecorder::discardClip() {}
+
+// ============================================================
+// Stats I2S: pas de DMA, lecture directe du flux
+// ============================================================
+
+AudioStats audioStats;
+
+AudioStats::AudioStats() {
+    attached = false;
+    captureActive = false;
+    playbackActive = false;
+}
+
+size_t AudioStats::read(void* buffer, size_t size) {
+    return i2s_audio.readBytes((char*)buffer, size);
+}
+
+void AudioStats::resync() {}
+void AudioStats::markDecision(AudioDecision) {}
+
+// ============================================================
+// Pre-chauffage reseau: sans objet hors ligne
+// ============================================================
+
+ConnectionPrewarmer prewarmer;
+
+ConnectionPrewarmer::ConnectionPrewarmer() {
+    targetCount = 0;
+    enabled = false;
+}
+
+void ConnectionPrewarmer::onSpeechOnset() {}
+
+// ============================================================
+// Lecture WAV (PCM 16 bits, converti en 16 kHz mono)
+// ============================================================
+
+static bool loadWav(const std::string& path, std::vector<int16_t>& out) {
+    std::ifstream f(path, std::ios::binary);
+    std::vector<uint8_t> d((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    if (d.size() < 44 || memcmp(d.data(), "RIFF", 4) || memcmp(d.data() + 8, "WAVE", 4)) return false;
+
+    int channels = 0, rate = 0, bits = 0;
+    size_t pos = 12;
+    const uint8_t* pcm = nullptr;
+    size_t pcmSize = 0;
+    while (pos + 8 <= d.size()) {
+        uint32_t size = d[pos + 4] | (d[pos + 5] << 8) | (d[pos + 6] << 16) | ((uint32_t)d[pos + 7] << 24);
+        if (!memcmp(d.data() + pos, "fmt ", 4) && pos + 24 <= d.size()) {
+            channels = d[pos + 10] | (d[pos + 11] << 8);
+            rate = d[pos + 12] | (d[pos + 13] << 8) | (d[pos + 14] << 16) | (d[pos + 15] << 24);
+            bits = d[pos + 22] | (d[pos + 23] << 8);
+        } else if (!memcmp(d.data() + pos, "data", 4)) {
+            pcm = d.data() + pos + 8;
+            pcmSize = std::min((size_t)size, d.size() - pos - 8);
+            break;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    if (!pcm || bits != 16 || channels < 1 || rate <= 0) return false;
+
+    size_t frames = pcmSize / (2 * channels);
+    const int16_t* src = (const int16_t*)pcm;
+
+    // Canal gauche, re-echantillonnage lineaire si besoin
+    size_t outCount = (size_t)((uint64_t)frames * AUDIO_SAMPLE_RATE / rate);
+    out.resize(outCount);
+    for (size_t i = 0; i < outCount; i++) {
+        double p = (double)i * rate / AUDIO_SAMPLE_RATE;
+        size_t idx = (size_t)p;
+        double frac = p - idx;
+        int16_t a = src[idx * channels];
+        int16_t b = idx + 1 < frames ? src[(idx + 1) * channels] : a;
+        out[i] = (int16_t)(a + (b - a) * frac);
+    }
+    if (rate != AUDIO_SAMPLE_RATE) {
+        fprintf(stderr, "%s: %d Hz re-echantillonne en %d Hz\n", path.c_str(), rate, AUDIO_SAMPLE_RATE);
+    }
+    return true;
+}
+
+// ============================================================
+// Resultats
+// ============================================================
+
+struct Totals {
+    int files = 0;
+    double audioSec = 0;
+    double cpuSec = 0;
+    int sttCalls = 0;
+
+    // Wake word
+    int candidates = 0;
+    int accepts = 0;
+    int truePositives = 0;
+    int falseAccepts = 0;
+    int misses = 0;
+    int wakeLabels = 0;
+    std::map<std::string, int> outcomes;
+
+    // Commandes
+    int utterances = 0;
+    int timeouts = 0;
+    int speculative = 0;
+    int speculativeCancelled = 0;
+    int premature = 0;            // Fin detectee avant la fin reelle de parole
+    std::vector<double> endpointErrors;
+};
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[(size_t)((v.size() - 1) * p)];
+}
+
+// ============================================================
+// Rejeu wake word: vrai WakeWordDetector::detect()
+// ============================================================
+
+static void runWake(Totals& t) {
+    decisions.clear();
+    wakeWord.pause();
+
+    while (!feedDone()) {
+        wakeWord.detect();
+    }
+
+    for (const WakeDecision& d : decisions) {
+        t.candidates++;
+        t.outcomes[d.outcome]++;
+        if (d.outcome != "wake") continue;
+
+        t.accepts++;
+        int l = bestLabel(d.startMs, d.endMs);
+        if (l >= 0 && labels[l].wake) {
+            t.truePositives++;
+            labels[l].hit = true;
+        } else if (!labels.empty()) {
+            t.falseAccepts++;
+        }
+    }
+    for (const Label& l : labels) {
+        if (!l.wake) continue;
+        t.wakeLabels++;
+        if (!l.hit) t.misses++;
+    }
+}
+
+// ============================================================
+// Rejeu commande: meme enchainement que startRecordingWithVAD
+// ============================================================
+
+static void runCommand(Totals& t, int silenceMs, int pauseMs, int maxDurationMs) {
+    int16_t samples[VAD_CHUNK_SAMPLES];
+
+    while (!feedDone()) {
+        CommandVad vad;
+        vad.begin(AUDIO_SAMPLE_RATE, silenceMs, pauseMs);
+
+        unsigned long recordStart = millis();
+        unsigned long speechStart = 0;
+        size_t recordSize = 0;
+        bool launched = false;
+        bool endpointed = false;
+
+        while (millis() - recordStart < (unsigned long)maxDurationMs) {
+            size_t bytesRead = i2s_audio.readBytes((char*)samples, sizeof(samples));
+            if (bytesRead == 0) break;
+
+            VadEvent event = vad.process(samples, bytesRead / 2);
+            if (event == VAD_EVENT_SPEECH_START) speechStart = millis();
+
+            if (vad.isSpeech() && launched) {
+                t.speculativeCancelled++;
+                launched = false;
+            }
+            if (vad.shouldStore()) recordSize += bytesRead;
+            if (!launched && vad.inTentativePause()) {
+                launched = true;
+                t.speculative++;
+                t.sttCalls++;
+            }
+            if (event == VAD_EVENT_END) {
+                endpointed = true;
+                break;
+            }
+        }
+
+        if (!vad.hasSpeechStarted()) continue;  // Silence: pas d'enregistrement
+
+        t.utterances++;
+        if (!endpointed) t.timeouts++;
+
+        // Requete finale si la speculative ne couvre pas l'enregistrement
+        if (recordSize >= 2000 && !launched) t.sttCalls++;
+
+        if (endpointed) {
+            // Fin reelle: le dernier label recouvert (une commande peut contenir des pauses)
+            double endMs = millis();
+            int l = -1;
+            for (size_t i = 0; i < labels.size(); i++) {
+                if (overlap(speechStart, endMs, labels[i].startMs, labels[i].endMs) > 0 &&
+                    (l < 0 || labels[i].endMs > labels[l].endMs)) {
+                    l = (int)i;
+                }
+            }
+            if (l >= 0) {
+                double error = endMs - labels[l].endMs;
+                t.endpointErrors.push_back(error);
+                if (error < 0) t.premature++;
+            }
+        }
+    }
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+static void collect(const std::string& path, std::vector<std::string>& files) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return;
+    if (!S_ISDIR(st.st_mode)) {
+        files.push_back(path);
+        return;
+    }
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return;
+    std::vector<std::string> found;
+    while (struct dirent* e = readdir(dir)) {
+        std::string name = e->d_name;
+        if (name.size() > 4 && lower(name.substr(name.size() - 4)) == ".wav") {
+            found.push_back(path + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+int main(int argc, char** argv) {
+    std::string mode = "auto";
+    int silenceMs = 800;
+    int pauseMs = SPECULATIVE_STT_PAUSE_MS;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--mode" && i + 1 < argc) mode = argv[++i];
+        else if (a == "--realtime") realtime = true;
+        else if (a == "--silence" && i + 1 < argc) silenceMs = atoi(argv[++i]);
+        else if (a == "--pause" && i + 1 < argc) pauseMs = atoi(argv[++i]);
+        else if (a == "--assume-wake") assumeWake = true;
+        else if (a == "--verbose") Serial.enabled = true;
+        else if (a[0] == '-') {
+            fprintf(stderr, "option inconnue: %s\n", a.c_str());
+            return 2;
+        }
+        else collect(a, files);
+    }
+    if (files.empty()) {
+        fprintf(stderr, "usage: replay_bench [--mode wake|command|auto] [--realtime] [--silence MS]\n"
+                        "                    [--pause MS] [--assume-wake] [--verbose] fichier.wav|dossier ...\n");
+        return 2;
+    }
+
+    wakeWord.begin();
+
+    Totals wake, command;
+    printf("%-40s %-7s %7s %6s %s\n", "fichier", "mode", "audio s", "STT", "resultat");
+
+    for (const std::string& path : files) {
+        if (!loadWav(path, feed)) {
+            fprintf(stderr, "%s: WAV PCM 16 bits illisible\n", path.c_str());
+            continue;
+        }
+        feedPos = 0;
+        std::string base = path.substr(0, path.size() - 4);
+        loadLabels(base);
+
+        bool isCommand = mode == "command" ||
+                         (mode == "auto" && path.find("_command") != std::string::npos);
+        Totals& t = isCommand ? command : wake;
+
+        // Chaque fichier repart a t=0 (les labels sont relatifs au fichier)
+        virtualUs = 0;
+        wallStartUs = wallUs();
+        sttCalls = 0;
+
+        int beforeAccepts = t.accepts, beforeUtterances = t.utterances;
+        int beforeStt = t.sttCalls;
+        double cpu0 = cpuSeconds();
+
+        if (isCommand) runCommand(t, silenceMs, pauseMs, 10000);
+        else runWake(t);
+
+        double audioSec = (double)feed.size() / AUDIO_SAMPLE_RATE;
+        t.cpuSec += cpuSeconds() - cpu0;
+        t.audioSec += audioSec;
+        t.sttCalls += sttCalls;
+        t.files++;
+
+        std::string name = path.size() > 40 ? "..." + path.substr(path.size() - 37) : path;
+        if (isCommand) {
+            printf("%-40s %-7s %7.1f %6d %d commande(s)\n", name.c_str(), "command", audioSec,
+                   t.sttCalls - beforeStt, t.utterances - beforeUtterances);
+        } else {
+            printf("%-40s %-7s %7.1f %6d %d accepte(s)\n", name.c_str(), "wake", audioSec,
+                   t.sttCalls - beforeStt, t.accepts - beforeAccepts);
+        }
+    }
+
+    if (wake.files > 0) {
+        printf("\n=== WAKE WORD (%d fichiers, %.1f s) ===\n", wake.files, wake.audioSec);
+        printf("Candidats:        %d\n", wake.candidates);
+        for (auto& o : wake.outcomes) {
+            printf("  %-14s  %d\n", o.first.c_str(), o.second);
+        }
+        printf("Acceptes:         %d\n", wake.accepts);
+        if (wake.wakeLabels > 0) {
+            printf("Vrais positifs:   %d / %d labels\n", wake.truePositives, wake.wakeLabels);
+            printf("Fausses alertes:  %d\n", wake.falseAccepts);
+            printf("Manques:          %d\n", wake.misses);
+        }
+        printf("Appels STT:       %d (%.1f / min d'audio)\n", wake.sttCalls,
+               wake.audioSec > 0 ? wake.sttCalls * 60.0 / wake.audioSec : 0);
+        printf("CPU:              %.3f ms / s d'audio\n",
+               wake.audioSec > 0 ? wake.cpuSec * 1000.0 / wake.audioSec : 0);
+    }
+
+    if (command.files > 0) {
+        printf("\n=== COMMANDES (%d fichiers, %.1f s) ===\n", command.files, command.audioSec);
+        printf("Enregistrements:  %d (timeouts %d)\n", command.utterances, command.timeouts);
+        printf("Appels STT:       %d (speculatifs %d, annules %d)\n",
+               command.sttCalls, command.speculative, command.speculativeCancelled);
+        if (!command.endpointErrors.empty()) {
+            double sum = 0;
+            for (double e : command.endpointErrors) sum += e;
+            printf("Fin de parole - fin reelle (silence configure %d ms):\n", silenceMs);
+            printf("  moyenne %.0f ms, p50 %.0f ms, p95 %.0f ms, coupures prematurees %d\n",
+                   sum / command.endpointErrors.size(),
+                   percentile(command.endpointErrors, 0.5),
+                   percentile(command.endpointErrors, 0.95),
+                   command.premature);
+        }
+        printf("CPU:              %.3f ms / s d'audio\n",
+               command.audioSec > 0 ? command.cpuSec * 1000.0 / command.audioSec : 0);
+    }
+
+    return 0;
+}
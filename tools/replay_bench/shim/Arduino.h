@@ -0,0 +1,138 @@
+// Arduino.h - Sous-ensemble Arduino pour compiler le front-end audio sur PC
+// (replay_bench). Horloge virtuelle avancee par le flux audio rejoue.
+#ifndef REPLAY_ARDUINO_H
+#define REPLAY_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <ctype.h>
+#include <string>
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+#define OUTPUT 1
+#define INPUT 0
+#define LOW 0
+#define HIGH 1
+
+// ============================================================
+// Horloge (replay_bench.cpp)
+// ============================================================
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+inline void yield() {}
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+
+inline bool psramFound() { return true; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+
+// FreeRTOS: types seulement (declarations de membres)
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef struct { int owner; } portMUX_TYPE;
+#define IRAM_ATTR
+
+// ============================================================
+// String
+// ============================================================
+class String {
+public:
+    String() {}
+    String(const char* s) : s(s ? s : "") {}
+    String(const std::string& s) : s(s) {}
+    String(char c) : s(1, c) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned int v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+
+    int indexOf(const String& what, unsigned int from = 0) const {
+        size_t p = s.find(what.s, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t p = s.find(c, from);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    bool startsWith(const String& p) const { return s.compare(0, p.s.size(), p.s) == 0; }
+    bool endsWith(const String& p) const {
+        return s.size() >= p.s.size() && s.compare(s.size() - p.s.size(), p.s.size(), p.s) == 0;
+    }
+    String substring(unsigned int from, unsigned int to = (unsigned int)-1) const {
+        if (from > s.size()) return String();
+        if (to > s.size()) to = s.size();
+        return String(s.substr(from, to > from ? to - from : 0));
+    }
+
+    void toLowerCase() { for (auto& c : s) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (auto& c : s) c = toupper((unsigned char)c); }
+    void trim() {
+        size_t a = s.find_first_not_of(" \t\r\n");
+        size_t b = s.find_last_not_of(" \t\r\n");
+        s = a == std::string::npos ? "" : s.substr(a, b - a + 1);
+    }
+
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o) { s += o; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator==(const char* o) const { return s == o; }
+    bool operator!=(const String& o) const { return s != o.s; }
+
+private:
+    std::string s;
+};
+
+// ============================================================
+// Serial: muet par defaut (--verbose pour voir les logs du firmware)
+// ============================================================
+class HardwareSerial {
+public:
+    bool enabled = false;
+
+    void begin(unsigned long) {}
+    int printf(const char* fmt, ...) {
+        if (!enabled) return 0;
+        va_list args;
+        va_start(args, fmt);
+        int n = vprintf(fmt, args);
+        va_end(args);
+        return n;
+    }
+    void print(const String& s) { if (enabled) fputs(s.c_str(), stdout); }
+    void print(const char* s) { if (enabled) fputs(s, stdout); }
+    void print(long v) { if (enabled) ::printf("%ld", v); }
+    void println() { if (enabled) fputs("\n", stdout); }
+    void println(const String& s) { if (enabled) ::printf("%s\n", s.c_str()); }
+    void println(const char* s) { if (enabled) ::printf("%s\n", s); }
+    void println(long v) { if (enabled) ::printf("%ld\n", v); }
+};
+
+extern HardwareSerial Serial;
+
+#endif
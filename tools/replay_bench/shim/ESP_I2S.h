@@ -0,0 +1,18 @@
+// ESP_I2S.h - I2SClass simule: readBytes() lit le WAV rejoue (replay_bench)
+#ifndef REPLAY_ESP_I2S_H
+#define REPLAY_ESP_I2S_H
+
+#include <Arduino.h>
+
+// Types du driver IDF (declarations de AudioStats)
+typedef void* i2s_chan_handle_t;
+typedef struct { void* data; size_t size; } i2s_event_data_t;
+
+class I2SClass {
+public:
+    // Implemente dans replay_bench.cpp (flux WAV, avance l'horloge virtuelle)
+    size_t readBytes(char* buffer, size_t size);
+    size_t write(const uint8_t*, size_t size) { return size; }
+};
+
+#endif
@@ -0,0 +1,5 @@
+// HTTPClient.h - Non utilise pendant le rejeu (Whisper simule)
+#ifndef REPLAY_HTTPCLIENT_H
+#define REPLAY_HTTPCLIENT_H
+
+#endif
@@ -0,0 +1,17 @@
+// Preferences.h - NVS simule (aucune persistance)
+#ifndef REPLAY_PREFERENCES_H
+#define REPLAY_PREFERENCES_H
+
+#include <Arduino.h>
+
+class Preferences {
+public:
+    bool begin(const char*, bool = false) { return true; }
+    void end() {}
+    bool getBool(const char*, bool def = false) { return def; }
+    uint32_t getUInt(const char*, uint32_t def = 0) { return def; }
+    size_t putBool(const char*, bool) { return 1; }
+    size_t putUInt(const char*, uint32_t) { return 4; }
+};
+
+#endif
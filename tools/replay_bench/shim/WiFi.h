@@ -0,0 +1,22 @@
+// WiFi.h - Pas de reseau pendant le rejeu: l'arbitrage LAN est court-circuite
+#ifndef REPLAY_WIFI_H
+#define REPLAY_WIFI_H
+
+#include <Arduino.h>
+
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+
+class IPAddress {
+public:
+    IPAddress(uint8_t, uint8_t, uint8_t, uint8_t) {}
+};
+
+class WiFiClass {
+public:
+    int status() { return WL_DISCONNECTED; }
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,19 @@
+// WiFiClientSecure.h - Client TLS inerte (Whisper simule pendant le rejeu)
+#ifndef REPLAY_WIFICLIENTSECURE_H
+#define REPLAY_WIFICLIENTSECURE_H
+
+#include <Arduino.h>
+
+class WiFiClientSecure {
+public:
+    virtual ~WiFiClientSecure() {}
+    virtual void stop() {}
+    virtual int read() { return -1; }
+    virtual int read(uint8_t*, size_t) { return 0; }
+    virtual int available() { return 0; }
+    virtual size_t write(uint8_t) { return 0; }
+    virtual size_t write(const uint8_t*, size_t) { return 0; }
+    void setInsecure() {}
+};
+
+#endif
@@ -0,0 +1,17 @@
+// WiFiUdp.h - UDP inerte (replay_bench)
+#ifndef REPLAY_WIFIUDP_H
+#define REPLAY_WIFIUDP_H
+
+#include <WiFi.h>
+
+class WiFiUDP {
+public:
+    uint8_t beginMulticast(IPAddress, uint16_t) { return 0; }
+    int beginPacket(IPAddress, uint16_t) { return 0; }
+    size_t write(const uint8_t*, size_t len) { return len; }
+    int endPacket() { return 0; }
+    int parsePacket() { return 0; }
+    int read(uint8_t*, size_t) { return 0; }
+};
+
+#endif
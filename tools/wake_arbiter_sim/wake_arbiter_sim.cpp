@@ -0,0 +1,420 @@
+// wake_arbiter_sim.cpp - Simulation Linux de l'arbitrage wake word multi-unites
+// Compile le meme coeur que le firmware (src/wake_arbiter.cpp) et fait tourner
+// N unites virtuelles qui entendent le meme "Satoshi".
+//
+// Build:
+//   g++ -std=c++17 -O2 -I../../src wake_arbiter_sim.cpp ../../src/wake_arbiter.cpp -o wake_arbiter_sim
+//
+// Modes:
+//   (defaut)  bus simule en temps virtuel: latence, gigue, perte, horloges decalees
+//   --udp     vraies sockets multicast sur loopback, temps reel
+//
+// Options: --nodes N --trials T --loss P --latency MS --jitter MS --miss P --seed S
+// Code retour 0 si, sans perte de paquets, chaque essai a exactement un gagnant
+// et que c'est l'unite au meilleur score.
+#include "wake_arbiter.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define FRAME_MS        32   // Une frame VAD (512 echantillons a 16 kHz)
+#define POLL_MS         5    // Pas de poll pendant la fenetre (delay(5) sur ESP32)
+#define TRIAL_GAP_MS    3000 // Silence entre deux essais
+
+struct Options {
+    int nodes = 4;
+    int trials = 1000;
+    double loss = 0.0;
+    int latency = 3;
+    int jitter = 8;
+    double miss = 0.0;   // Probabilite qu'une unite ne detecte pas
+    unsigned seed = 42;
+    bool udp = false;
+};
+
+static std::mt19937 rng;
+
+static double uniform(double a, double b) {
+    return std::uniform_real_distribution<double>(a, b)(rng);
+}
+
+// ============================================================
+// Bus simule (temps virtuel)
+// ============================================================
+
+struct Packet {
+    uint64_t deliverAt;
+    std::vector<uint8_t> data;
+};
+
+class SimBus;
+
+class BusTransport : public ArbiterTransport {
+public:
+    SimBus* bus = nullptr;
+    std::deque<Packet> inbox;
+
+    bool send(const uint8_t* data, size_t len) override;
+    int receive(uint8_t* data, size_t maxLen) override;
+};
+
+class SimBus {
+public:
+    uint64_t now = 0;
+    const Options* opt = nullptr;
+    std::vector<BusTransport*> members;
+
+    void broadcast(const uint8_t* data, size_t len) {
+        // Multicast: boucle locale comprise (filtree par deviceId)
+        for (BusTransport* m : members) {
+            if (uniform(0, 1) < opt->loss) continue;
+            Packet p;
+            p.deliverAt = now + opt->latency + (uint64_t)uniform(0, opt->jitter);
+            p.data.assign(data, data + len);
+            // Gigue: l'ordre d'arrivee peut differer de l'ordre d'emission
+            auto it = m->inbox.begin();
+            while (it != m->inbox.end() && it->deliverAt <= p.deliverAt) ++it;
+            m->inbox.insert(it, p);
+        }
+    }
+};
+
+bool BusTransport::send(const uint8_t* data, size_t len) {
+    bus->broadcast(data, len);
+    return true;
+}
+
+int BusTransport::receive(uint8_t* data, size_t maxLen) {
+    if (inbox.empty() || inbox.front().deliverAt > bus->now) return 0;
+    Packet p = inbox.front();
+    inbox.pop_front();
+    size_t n = p.data.size() < maxLen ? p.data.size() : maxLen;
+    memcpy(data, p.data.data(), n);
+    return (int)n;
+}
+
+// ============================================================
+// Transport UDP multicast reel (loopback)
+// ============================================================
+
+class UdpTransport : public ArbiterTransport {
+public:
+    int fd = -1;
+    sockaddr_in group{};
+
+    bool open() {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) return false;
+
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(ARBITER_PORT);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) return false;
+
+        ip_mreq mreq{};
+        inet_pton(AF_INET, "239.255.42.10", &mreq.imr_multiaddr);
+        mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) return false;
+
+        in_addr iface{};
+        iface.s_addr = htonl(INADDR_LOOPBACK);
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+        unsigned char loop = 1;
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        group.sin_family = AF_INET;
+        group.sin_port = htons(ARBITER_PORT);
+        group.sin_addr = mreq.imr_multiaddr;
+        return true;
+    }
+
+    ~UdpTransport() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool send(const uint8_t* data, size_t len) override {
+        return sendto(fd, data, len, 0, (sockaddr*)&group, sizeof(group)) == (ssize_t)len;
+    }
+
+    int receive(uint8_t* data, size_t maxLen) override {
+        ssize_t n = recv(fd, data, maxLen, 0);
+        return n > 0 ? (int)n : 0;
+    }
+};
+
+// ============================================================
+// Unites simulees
+// ============================================================
+
+struct Node {
+    WakeArbiter arbiter;
+    ArbiterTransport* transport = nullptr;
+    uint32_t clockOffset = 0;  // Horloges non synchronisees (millis() differents)
+
+    // Essai en cours
+    bool hears = false;
+    uint64_t detectAt = 0;     // Fin de parole detectee (temps global)
+    uint32_t peak = 0;
+    uint32_t noise = 0;
+    bool claiming = false;
+    bool done = false;
+    ArbiterResult result = ARB_PENDING;
+    uint64_t decidedAt = 0;
+    uint64_t nextService = 0;
+
+    uint32_t clock(uint64_t globalMs) const {
+        return (uint32_t)(globalMs + clockOffset);
+    }
+};
+
+struct Totals {
+    int trials = 0;
+    int correct = 0;      // Exactement un gagnant, le meilleur
+    int multiple = 0;     // Plusieurs unites repondent (appels cloud en double)
+    int none = 0;         // Personne ne repond alors qu'au moins une a entendu
+    int wrong = 0;        // Un seul gagnant mais pas le meilleur
+    int silent = 0;       // Aucune unite n'a entendu
+    double decisionMs = 0;
+    int decisions = 0;
+};
+
+// Prepare un essai: position du locuteur -> energie, SNR et instant de detection
+static void setupTrial(std::vector<Node>& nodes, const Options& opt, uint64_t start) {
+    for (size_t i = 0; i < nodes.size(); i++) {
+        Node& n = nodes[i];
+        double distance = uniform(0.5, 8.0);  // metres
+
+        n.hears = uniform(0, 1) >= opt.miss;
+        n.noise = (uint32_t)uniform(150, 400);
+        n.peak = (uint32_t)(12000.0 / distance * uniform(0.8, 1.2));
+
+        // Propagation du son + quantification VAD + fin de parole par frames de silence
+        double delay = distance * 2.9 + uniform(0, FRAME_MS) + uniform(0, 3 * FRAME_MS);
+        n.detectAt = start + (uint64_t)delay;
+
+        n.claiming = false;
+        n.done = !n.hears;
+        n.result = ARB_PENDING;
+        n.decidedAt = 0;
+        n.nextService = start;
+    }
+}
+
+static bool stepNode(Node& n, uint64_t now) {
+    if (n.done) {
+        // Hors arbitrage: service() a chaque frame VAD comme dans detect()
+        if (now >= n.nextService) {
+            n.arbiter.service(n.clock(now));
+            n.nextService = now + FRAME_MS;
+        }
+        return false;
+    }
+
+    if (!n.claiming) {
+        if (now >= n.nextService) {
+            n.arbiter.service(n.clock(now));
+            n.nextService = now + FRAME_MS;
+        }
+        if (now >= n.detectAt) {
+            uint16_t snr = WakeArbiter::snrFromEnergy(n.peak, n.noise);
+            n.arbiter.startClaim(snr, n.peak, n.clock(now), n.clock(now));
+            n.claiming = true;
+            n.nextService = now + POLL_MS;
+        }
+        return true;
+    }
+
+    if (now >= n.nextService) {
+        n.result = n.arbiter.poll(n.clock(now));
+        n.nextService = now + POLL_MS;
+        if (n.result != ARB_PENDING) {
+            n.done = true;
+            n.decidedAt = now;
+        }
+    }
+    return !n.done;
+}
+
+static void scoreTrial(std::vector<Node>& nodes, Totals& t, bool verbose) {
+    t.trials++;
+
+    int best = -1;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i].hears) continue;
+        WakeClaim a{}, b{};
+        a.deviceId = nodes[i].arbiter.getDeviceId();
+        a.snrCentiDb = WakeArbiter::snrFromEnergy(nodes[i].peak, nodes[i].noise);
+        a.peakEnergy = nodes[i].peak;
+        if (best >= 0) {
+            b.deviceId = nodes[best].arbiter.getDeviceId();
+            b.snrCentiDb = WakeArbiter::snrFromEnergy(nodes[best].peak, nodes[best].noise);
+            b.peakEnergy = nodes[best].peak;
+        }
+        if (best < 0 || WakeArbiter::beats(a, b)) best = (int)i;
+    }
+
+    int winners = 0, winner = -1;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].result == ARB_WON) {
+            winners++;
+            winner = (int)i;
+        }
+        if (nodes[i].hears && nodes[i].decidedAt > nodes[i].detectAt) {
+            t.decisionMs += nodes[i].decidedAt - nodes[i].detectAt;
+            t.decisions++;
+        }
+    }
+
+    if (best < 0) t.silent++;
+    else if (winners == 0) t.none++;
+    else if (winners > 1) t.multiple++;
+    else if (winner != best) t.wrong++;
+    else t.correct++;
+
+    if (verbose) {
+        printf("essai %d:", t.trials);
+        for (size_t i = 0; i < nodes.size(); i++) {
+            const char* r = !nodes[i].hears ? "-" : nodes[i].result == ARB_WON ? "GAGNE" : "perdu";
+            printf("  [%zu] %.1fdB %s", i, WakeArbiter::snrFromEnergy(nodes[i].peak, nodes[i].noise) / 100.0, r);
+        }
+        printf("%s\n", (int)best == winner && winners == 1 ? "" : "  <-- ECART");
+    }
+}
+
+static uint64_t realNowMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool runTrials(std::vector<Node>& nodes, const Options& opt, SimBus* bus, Totals& t) {
+    bool verbose = opt.trials <= 20;
+
+    for (int trial = 0; trial < opt.trials; trial++) {
+        uint64_t start = bus ? bus->now : realNowMs();
+        setupTrial(nodes, opt, start);
+
+        bool running = true;
+        while (running) {
+            uint64_t now = bus ? bus->now : realNowMs();
+            running = false;
+            for (Node& n : nodes) {
+                if (stepNode(n, now)) running = true;
+            }
+            if (bus) bus->now++;
+            else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        scoreTrial(nodes, t, verbose);
+
+        // Silence entre deux "Satoshi": au-dela de ARBITER_MATCH_MS pour que
+        // les scores de l'essai precedent ne soient pas confondus
+        uint64_t until = (bus ? bus->now : realNowMs()) + (bus ? TRIAL_GAP_MS : 2 * ARBITER_MATCH_MS);
+        while ((bus ? bus->now : realNowMs()) < until) {
+            uint64_t now = bus ? bus->now : realNowMs();
+            for (Node& n : nodes) stepNode(n, now);
+            if (bus) bus->now++;
+            else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
+static void usage() {
+    printf("usage: wake_arbiter_sim [--nodes N] [--trials T] [--loss P] [--latency MS]\n"
+           "                        [--jitter MS] [--miss P] [--seed S] [--udp]\n");
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&](void) -> const char* {
+            if (i + 1 >= argc) { usage(); exit(2); }
+            return argv[++i];
+        };
+        if (a == "--nodes") opt.nodes = atoi(next());
+        else if (a == "--trials") opt.trials = atoi(next());
+        else if (a == "--loss") opt.loss = atof(next());
+        else if (a == "--latency") opt.latency = atoi(next());
+        else if (a == "--jitter") opt.jitter = atoi(next());
+        else if (a == "--miss") opt.miss = atof(next());
+        else if (a == "--seed") opt.seed = (unsigned)atoi(next());
+        else if (a == "--udp") opt.udp = true;
+        else { usage(); return 2; }
+    }
+    if (opt.nodes < 1) opt.nodes = 1;
+    if (opt.udp && opt.trials == 1000) opt.trials = 20;
+
+    rng.seed(opt.seed);
+
+    std::vector<Node> nodes(opt.nodes);
+    SimBus bus;
+    bus.opt = &opt;
+    std::vector<BusTransport> busTransports(opt.nodes);
+    std::vector<UdpTransport> udpTransports(opt.udp ? opt.nodes : 0);
+
+    for (int i = 0; i < opt.nodes; i++) {
+        if (opt.udp) {
+            if (!udpTransports[i].open()) {
+                perror("socket multicast");
+                return 1;
+            }
+            nodes[i].transport = &udpTransports[i];
+        } else {
+            busTransports[i].bus = &bus;
+            bus.members.push_back(&busTransports[i]);
+            nodes[i].transport = &busTransports[i];
+        }
+        // Decalage d'horloge arbitraire, y compris pres du debordement 32 bits
+        nodes[i].clockOffset = (uint32_t)rng();
+        nodes[i].arbiter.begin(nodes[i].transport, 0x1000 + (uint32_t)rng() % 0xF000 * 16 + i);
+    }
+
+    Totals t;
+    runTrials(nodes, opt, opt.udp ? nullptr : &bus, t);
+
+    printf("\n=== Arbitrage wake word: %d unites, %d essais (%s) ===\n",
+           opt.nodes, t.trials, opt.udp ? "UDP multicast loopback" : "bus simule");
+    printf("perte %.1f%%  latence %d ms  gigue %d ms  non-detection %.1f%%\n",
+           opt.loss * 100, opt.latency, opt.jitter, opt.miss * 100);
+    printf("un seul gagnant (le meilleur): %d\n", t.correct);
+    printf("plusieurs gagnants:            %d\n", t.multiple);
+    printf("aucun gagnant:                 %d\n", t.none);
+    printf("mauvais gagnant:               %d\n", t.wrong);
+    printf("personne n'a entendu:          %d\n", t.silent);
+    if (t.decisions > 0) {
+        printf("delai de decision moyen:       %.1f ms\n", t.decisionMs / t.decisions);
+    }
+
+    uint32_t bad = 0;
+    for (Node& n : nodes) bad += n.arbiter.getStats().packetsBad;
+    if (bad) printf("paquets invalides:             %u\n", bad);
+
+    // Sans perte, le protocole doit toujours elire exactement le meilleur
+    if (opt.loss == 0.0 && (t.multiple || t.none || t.wrong)) {
+        printf("ECHEC\n");
+        return 1;
+    }
+    return 0;
+}